@@ -0,0 +1,308 @@
+/*--------------------------------------------------------------------*/
+/* benchconc.c                                                        */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include <pthread.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key, including the terminating '\0'. */
+enum {MAX_KEY_SIZE = 16};
+
+/* The most threads that the benchmark runs at once. */
+enum {MAX_THREAD_COUNT = 64};
+
+/*--------------------------------------------------------------------*/
+
+/* A Mix is the share of each kind of operation in a workload, in
+   percent.  The shares of gets and puts are given; removes take the
+   rest. */
+
+struct Mix
+{
+   /* The name of the mix. */
+   const char *pcName;
+
+   /* The percentage of gets. */
+   int iGetPercent;
+
+   /* The percentage of puts. */
+   int iPutPercent;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A Worker describes the share of one thread in a benchmark run. */
+
+struct Worker
+{
+   /* The table. */
+   SymTable_T oSymTable;
+
+   /* The keys, which the threads share. */
+   char **apcKeys;
+
+   /* The number of keys. */
+   int iKeyCount;
+
+   /* The number of operations that the thread performs. */
+   long lOpCount;
+
+   /* The mix of operations. */
+   const struct Mix *psMix;
+
+   /* If nonzero, every call holds the global mutex, as a program that
+      shares an unsynchronized table would. */
+   int iGlobalLock;
+
+   /* The state of the thread's random number generator. */
+   unsigned long ulState;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* The lock that serializes every call in the global mutex runs. */
+static pthread_mutex_t sGlobalMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*--------------------------------------------------------------------*/
+
+/* Exit with EXIT_FAILURE if pv is NULL. */
+
+static void checkMemory(const void *pv)
+{
+   if (pv == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of seconds on a clock that never goes back. */
+
+static double now(void)
+{
+   struct timespec sTime;
+
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double)sTime.tv_sec + (double)sTime.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Advance the xorshift generator whose state is *pulState and return
+   its next output. */
+
+static unsigned long nextRandom(unsigned long *pulState)
+{
+   unsigned long ulState;
+
+   assert(pulState != NULL);
+
+   ulState = *pulState;
+   ulState ^= ulState << 13;
+   ulState ^= ulState >> 7;
+   ulState ^= ulState << 17;
+   *pulState = ulState;
+   return ulState;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Perform the operations of pvWorker, a Worker, on its table.  Return
+   NULL. */
+
+static void *runWorker(void *pvWorker)
+{
+   struct Worker *psWorker;
+   unsigned long ulRandom;
+   const char *pcKey;
+   int iPercent;
+   long l;
+
+   assert(pvWorker != NULL);
+
+   psWorker = (struct Worker*)pvWorker;
+   for (l = 0; l < psWorker->lOpCount; l++)
+   {
+      ulRandom = nextRandom(&psWorker->ulState);
+      pcKey = psWorker->apcKeys[(ulRandom >> 8)
+                                % (unsigned long)psWorker->iKeyCount];
+      iPercent = (int)(ulRandom % 100);
+
+      if (psWorker->iGlobalLock)
+         pthread_mutex_lock(&sGlobalMutex);
+      if (iPercent < psWorker->psMix->iGetPercent)
+         (void)SymTable_get(psWorker->oSymTable, pcKey);
+      else if (iPercent < psWorker->psMix->iGetPercent
+               + psWorker->psMix->iPutPercent)
+         (void)SymTable_put(psWorker->oSymTable, pcKey, pcKey);
+      else
+         (void)SymTable_remove(psWorker->oSymTable, pcKey);
+      if (psWorker->iGlobalLock)
+         pthread_mutex_unlock(&sGlobalMutex);
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count the binding whose key is pcKey in pvCount, a size_t.  pvValue
+   is unused. */
+
+static void countBinding(const char *pcKey, void *pvValue, void *pvCount)
+{
+   assert(pcKey != NULL && pvCount != NULL);
+   (void)pvValue;
+
+   (*(size_t*)pvCount)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the millions of operations per second that iThreadCount
+   threads reach, together performing lOpCount operations of mix
+   *psMix on a table that starts with every other one of the iKeyCount
+   keys in apcKeys.  If iGlobalLock is nonzero, every call holds one
+   global mutex.  Write a message to stdout if the table's length
+   disagrees with its bindings afterwards. */
+
+static double benchRun(char **apcKeys, int iKeyCount, long lOpCount,
+                       const struct Mix *psMix, int iThreadCount,
+                       int iGlobalLock)
+{
+   struct Worker asWorkers[MAX_THREAD_COUNT];
+   pthread_t asThreads[MAX_THREAD_COUNT];
+   SymTable_T oSymTable;
+   size_t uCount = 0;
+   double dStart;
+   double dSeconds;
+   int i;
+
+   assert(apcKeys != NULL && psMix != NULL);
+   assert(iThreadCount > 0 && iThreadCount <= MAX_THREAD_COUNT);
+
+   oSymTable = SymTable_new();
+   checkMemory(oSymTable);
+   for (i = 0; i < iKeyCount; i += 2)
+      SymTable_put(oSymTable, apcKeys[i], apcKeys[i]);
+
+   for (i = 0; i < iThreadCount; i++)
+   {
+      asWorkers[i].oSymTable = oSymTable;
+      asWorkers[i].apcKeys = apcKeys;
+      asWorkers[i].iKeyCount = iKeyCount;
+      asWorkers[i].lOpCount = lOpCount / iThreadCount;
+      asWorkers[i].psMix = psMix;
+      asWorkers[i].iGlobalLock = iGlobalLock;
+      asWorkers[i].ulState = 0x9e3779b9UL * (unsigned long)(i + 1);
+   }
+
+   dStart = now();
+   for (i = 0; i < iThreadCount; i++)
+      if (pthread_create(&asThreads[i], NULL, runWorker,
+                         &asWorkers[i]) != 0)
+      {
+         fprintf(stderr, "Cannot create thread\n");
+         exit(EXIT_FAILURE);
+      }
+   for (i = 0; i < iThreadCount; i++)
+      pthread_join(asThreads[i], NULL);
+   dSeconds = now() - dStart;
+
+   SymTable_map(oSymTable, countBinding, &uCount);
+   if (uCount != SymTable_getLength(oSymTable))
+      printf("Length %lu disagrees with %lu bindings.\n",
+             (unsigned long)SymTable_getLength(oSymTable),
+             (unsigned long)uCount);
+   SymTable_free(oSymTable);
+
+   return (double)(lOpCount / iThreadCount * iThreadCount)
+      / dSeconds / 1e6;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Measure the throughput of a shared SymTable object from 1 to
+   MAX_THREAD_COUNT threads under a read-mostly and a write-heavy mix,
+   both with every call behind one global mutex and with the table's
+   own synchronization.  As always, argc is the command-line argument
+   count and argv contains the command-line arguments.  argv[1] is the
+   number of distinct keys and argv[2] the total number of operations
+   per run.  Exit with EXIT_FAILURE if either is missing or not a
+   positive number.  Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   static const struct Mix asMixes[] = {
+      {"read-mostly", 90, 5},
+      {"write-heavy", 50, 25}};
+   enum {MIX_COUNT = sizeof(asMixes) / sizeof(asMixes[0])};
+
+   char acKey[MAX_KEY_SIZE];
+   char **apcKeys;
+   int iKeyCount;
+   long lOpCount;
+   int iMix;
+   int iThreadCount;
+   int i;
+
+   if (argc != 3)
+   {
+      fprintf(stderr, "Usage: %s keycount opcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iKeyCount) != 1 || iKeyCount <= 0 ||
+       sscanf(argv[2], "%ld", &lOpCount) != 1 || lOpCount <= 0)
+   {
+      fprintf(stderr, "keycount and opcount must be positive numbers\n");
+      exit(EXIT_FAILURE);
+   }
+
+   apcKeys = (char**)malloc((size_t)iKeyCount * sizeof(char*));
+   checkMemory(apcKeys);
+   for (i = 0; i < iKeyCount; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      apcKeys[i] = (char*)malloc(strlen(acKey) + 1);
+      checkMemory(apcKeys[i]);
+      strcpy(apcKeys[i], acKey);
+   }
+
+   printf("%d keys, %ld operations per run, in Mops/s\n", iKeyCount,
+          lOpCount);
+   for (iMix = 0; iMix < MIX_COUNT; iMix++)
+   {
+      printf("------------------------------------------------------\n");
+      printf("%s: %d%% get, %d%% put, %d%% remove\n",
+             asMixes[iMix].pcName, asMixes[iMix].iGetPercent,
+             asMixes[iMix].iPutPercent,
+             100 - asMixes[iMix].iGetPercent - asMixes[iMix].iPutPercent);
+      for (iThreadCount = 1; iThreadCount <= MAX_THREAD_COUNT;
+           iThreadCount *= 2)
+      {
+         printf("%2d threads  global mutex: %8.2f  table: %8.2f\n",
+                iThreadCount,
+                benchRun(apcKeys, iKeyCount, lOpCount, &asMixes[iMix],
+                         iThreadCount, 1),
+                benchRun(apcKeys, iKeyCount, lOpCount, &asMixes[iMix],
+                         iThreadCount, 0));
+         fflush(stdout);
+      }
+   }
+
+   for (i = 0; i < iKeyCount; i++)
+      free(apcKeys[i]);
+   free(apcKeys);
+   return 0;
+}
@@ -0,0 +1,299 @@
+/*--------------------------------------------------------------------*/
+/* benchflood.c                                                       */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "strhash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The longest benign or bucket-flooding key, including the terminating
+   '\0'. */
+enum {MAX_KEY_SIZE = 32};
+
+/* The length of a Thue-Morse block.  The polynomial hashes of a block
+   and of its complement differ by a product of eleven factors
+   B^(2^j) - 1, which 2^64 divides for every odd multiplier B. */
+enum {BLOCK_LENGTH = 2048};
+
+/* The number of blocks in a Thue-Morse key.  The benchmark builds
+   2^BLOCK_COUNT such keys. */
+enum {BLOCK_COUNT = 9};
+
+/*--------------------------------------------------------------------*/
+
+/* A HashFunction pairs a hash function with its SymTable option. */
+
+struct HashFunction
+{
+   /* The name of the hash function. */
+   const char *pcName;
+
+   /* The hash function. */
+   StrHash_T pfHash;
+
+   /* The option that selects it in a SymTable object. */
+   enum SymTableHash eHash;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Exit with EXIT_FAILURE if pv is NULL. */
+
+static void checkMemory(const void *pv)
+{
+   if (pv == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a copy of pcKey in new memory. */
+
+static char *copyKey(const char *pcKey)
+{
+   char *pcCopy;
+
+   assert(pcKey != NULL);
+
+   pcCopy = (char*)malloc(strlen(pcKey) + 1);
+   if (pcCopy == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   strcpy(pcCopy, pcKey);
+   return pcCopy;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of seconds between iInitialClock and
+   iFinalClock. */
+
+static double seconds(clock_t iInitialClock, clock_t iFinalClock)
+{
+   return ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store in apcKeys iKeyCount distinct keys that an attacker who knows
+   pfHash and the seed 0 would choose: each hashes to a code whose low
+   iBits bits are 0, so while a table has at most 2^iBits buckets they
+   all fall into bucket 0. */
+
+static void makeFloodKeys(StrHash_T pfHash, int iBits, char **apcKeys,
+                          int iKeyCount)
+{
+   char acKey[MAX_KEY_SIZE];
+   size_t uMask = ((size_t)1 << iBits) - 1;
+   unsigned long ulCandidate = 0;
+   int i;
+
+   assert(pfHash != NULL && apcKeys != NULL);
+
+   for (i = 0; i < iKeyCount; i++)
+   {
+      do
+         sprintf(acKey, "k%lx", ulCandidate++);
+      while (((*pfHash)(acKey, strlen(acKey), 0) & uMask) != 0);
+      apcKeys[i] = copyKey(acKey);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store in apcKeys the 2^BLOCK_COUNT keys that concatenate BLOCK_COUNT
+   blocks, each either the Thue-Morse block or its complement.  Their
+   multiplicative hashes collide in all 64 bits under every seed. */
+
+static void makeThueMorseKeys(char **apcKeys)
+{
+   int iKey;
+   int iBlock;
+   int iParity;
+   int iBits;
+   int i;
+
+   assert(apcKeys != NULL);
+
+   for (iKey = 0; iKey < (1 << BLOCK_COUNT); iKey++)
+   {
+      apcKeys[iKey] = (char*)malloc(BLOCK_COUNT * BLOCK_LENGTH + 1);
+      checkMemory(apcKeys[iKey]);
+      for (iBlock = 0; iBlock < BLOCK_COUNT; iBlock++)
+         for (i = 0; i < BLOCK_LENGTH; i++)
+         {
+            /* The parity of the bits of i, flipped in complemented
+               blocks. */
+            iParity = (iKey >> iBlock) & 1;
+            for (iBits = i; iBits != 0; iBits &= iBits - 1)
+               iParity ^= 1;
+            apcKeys[iKey][iBlock * BLOCK_LENGTH + i] =
+               (char)(iParity ? 'B' : 'A');
+         }
+      apcKeys[iKey][BLOCK_COUNT * BLOCK_LENGTH] = '\0';
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the iKeyCount keys in apcKeys. */
+
+static void freeKeys(char **apcKeys, int iKeyCount)
+{
+   int i;
+
+   assert(apcKeys != NULL);
+
+   for (i = 0; i < iKeyCount; i++)
+      free(apcKeys[i]);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the nanoseconds per operation that a SymTable object using
+   hash function eHash takes to put, then get, the iKeyCount keys in
+   apcKeys.  If iFixedSeed is nonzero, the table uses the seed 0, which
+   the attacker knows; otherwise it draws its own. */
+
+static double benchTable(enum SymTableHash eHash, int iFixedSeed,
+                         char **apcKeys, int iKeyCount)
+{
+   struct SymTableOptions sOptions;
+   SymTable_T oSymTable;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+   int i;
+
+   assert(apcKeys != NULL);
+
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.eHash = eHash;
+   sOptions.iFixedSeed = iFixedSeed;
+
+   iInitialClock = clock();
+   oSymTable = SymTable_newWithOptions(&sOptions);
+   checkMemory(oSymTable);
+   for (i = 0; i < iKeyCount; i++)
+      SymTable_put(oSymTable, apcKeys[i], apcKeys[i]);
+   for (i = 0; i < iKeyCount; i++)
+      if (SymTable_get(oSymTable, apcKeys[i]) != apcKeys[i])
+         printf("Lookup of key %d failed.\n", i);
+   SymTable_free(oSymTable);
+   iFinalClock = clock();
+
+   return seconds(iInitialClock, iFinalClock) * 1e9 / (2.0 * iKeyCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout the nanoseconds per operation of hash function eHash
+   on the iKeyCount keys in apcKeys, with a known seed and with a
+   random seed. */
+
+static void benchSeeds(const char *pcName, enum SymTableHash eHash,
+                       char **apcKeys, int iKeyCount)
+{
+   assert(pcName != NULL && apcKeys != NULL);
+
+   printf("%-15s  known seed: %10.2f ns/op  random seed: %10.2f ns/op\n",
+          pcName, benchTable(eHash, 1, apcKeys, iKeyCount),
+          benchTable(eHash, 0, apcKeys, iKeyCount));
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Measure how the hash functions of strhash.h hold up against keys
+   chosen to collide.  As always, argc is the command-line argument
+   count and argv contains the command-line arguments.  argv[1] is the
+   number of keys per bucket-flooding key set.  Exit with EXIT_FAILURE
+   if argv[1] is missing or not a positive number.  Otherwise return
+   0. */
+
+int main(int argc, char *argv[])
+{
+   static const struct HashFunction asHashes[] = {
+      {"multiplicative", StrHash_multiplicative,
+       SYMTABLE_HASH_MULTIPLICATIVE},
+      {"wyhash", StrHash_wyhash, SYMTABLE_HASH_WYHASH},
+      {"siphash", StrHash_siphash, SYMTABLE_HASH_SIPHASH}};
+   enum {HASH_COUNT = sizeof(asHashes) / sizeof(asHashes[0])};
+   enum {THUE_MORSE_COUNT = 1 << BLOCK_COUNT};
+
+   char acKey[MAX_KEY_SIZE];
+   char **apcKeys;
+   int iKeyCount;
+   int iBits = 1;
+   int iHash;
+   int i;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s keycount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iKeyCount) != 1 || iKeyCount <= 0)
+   {
+      fprintf(stderr, "keycount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   /* A table at load factor 1 never has more than 2 * iKeyCount
+      buckets. */
+   while (((size_t)1 << iBits) < 2 * (size_t)iKeyCount)
+      iBits++;
+
+   apcKeys = (char**)malloc((iKeyCount > THUE_MORSE_COUNT ?
+                             (size_t)iKeyCount : THUE_MORSE_COUNT)
+                            * sizeof(char*));
+   checkMemory(apcKeys);
+
+   printf("------------------------------------------------------\n");
+   printf("%d benign keys, e.g. \"k%x\"\n", iKeyCount,
+          (unsigned)(iKeyCount - 1));
+   for (i = 0; i < iKeyCount; i++)
+   {
+      sprintf(acKey, "k%x", (unsigned)i);
+      apcKeys[i] = copyKey(acKey);
+   }
+   for (iHash = 0; iHash < HASH_COUNT; iHash++)
+      benchSeeds(asHashes[iHash].pcName, asHashes[iHash].eHash,
+                 apcKeys, iKeyCount);
+   freeKeys(apcKeys, iKeyCount);
+
+   printf("------------------------------------------------------\n");
+   printf("%d keys per hash whose codes under seed 0 end in %d zero "
+          "bits\n", iKeyCount, iBits);
+   for (iHash = 0; iHash < HASH_COUNT; iHash++)
+   {
+      makeFloodKeys(asHashes[iHash].pfHash, iBits, apcKeys, iKeyCount);
+      benchSeeds(asHashes[iHash].pcName, asHashes[iHash].eHash,
+                 apcKeys, iKeyCount);
+      freeKeys(apcKeys, iKeyCount);
+   }
+
+   printf("------------------------------------------------------\n");
+   printf("%d Thue-Morse keys of length %d, whose multiplicative "
+          "hashes collide under every seed\n", THUE_MORSE_COUNT,
+          BLOCK_COUNT * BLOCK_LENGTH);
+   makeThueMorseKeys(apcKeys);
+   for (iHash = 0; iHash < HASH_COUNT; iHash++)
+      benchSeeds(asHashes[iHash].pcName, asHashes[iHash].eHash,
+                 apcKeys, THUE_MORSE_COUNT);
+   freeKeys(apcKeys, THUE_MORSE_COUNT);
+
+   free(apcKeys);
+   return 0;
+}
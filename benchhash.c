@@ -0,0 +1,324 @@
+/*--------------------------------------------------------------------*/
+/* benchhash.c                                                        */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "strhash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key that any key family generates, including the
+   terminating '\0'. */
+enum {MAX_KEY_SIZE = 128};
+
+/* The number of times the speed benchmark hashes every key. */
+enum {HASH_ROUNDS = 20};
+
+/* The longest chain length that the histogram counts separately. */
+enum {MAX_CHAIN_BIN = 8};
+
+/*--------------------------------------------------------------------*/
+
+/* A KeyFamily names a kind of key and writes the key with index i to
+   pcKey. */
+
+struct KeyFamily
+{
+   /* The name of the family. */
+   const char *pcName;
+
+   /* The function that writes key i of the family. */
+   void (*pfMake)(char *pcKey, int i);
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A HashFunction pairs a hash function with its SymTable option. */
+
+struct HashFunction
+{
+   /* The name of the hash function. */
+   const char *pcName;
+
+   /* The hash function. */
+   StrHash_T pfHash;
+
+   /* The option that selects it in a SymTable object. */
+   enum SymTableHash eHash;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Write to pcKey the decimal digits of i, like testLargeTable. */
+
+static void makeDecimal(char *pcKey, int i)
+{
+   sprintf(pcKey, "%d", i);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to pcKey a short identifier made from i. */
+
+static void makeIdentifier(char *pcKey, int i)
+{
+   sprintf(pcKey, "sym_%x", (unsigned)i);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to pcKey a namespaced symbol name made from i, such as
+   "pkg3.module14.Class15.method9". */
+
+static void makeDotted(char *pcKey, int i)
+{
+   sprintf(pcKey, "pkg%d.module%d.Class%d.method%d",
+           i / 4096, i / 256 % 16, i / 16 % 16, i % 16);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to pcKey a long path-like key made from i. */
+
+static void makeLong(char *pcKey, int i)
+{
+   sprintf(pcKey, "com.example.service.internal.generated."
+           "handlers.RequestHandler%d.process", i);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of seconds between iInitialClock and
+   iFinalClock. */
+
+static double seconds(clock_t iInitialClock, clock_t iFinalClock)
+{
+   return ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout the nanoseconds per key that pfHash takes to hash
+   the iKeyCount keys in apcKeys, whose lengths are auLengths. */
+
+static void benchSpeed(StrHash_T pfHash, char **apcKeys,
+                       const size_t *auLengths, int iKeyCount)
+{
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+   size_t uSink = 0;
+   int iRound;
+   int i;
+
+   assert(pfHash != NULL && apcKeys != NULL && auLengths != NULL);
+
+   iInitialClock = clock();
+   for (iRound = 0; iRound < HASH_ROUNDS; iRound++)
+      for (i = 0; i < iKeyCount; i++)
+         uSink += (*pfHash)(apcKeys[i], auLengths[i], 0);
+   iFinalClock = clock();
+
+   printf("  hash: %7.2f ns/key",
+          seconds(iInitialClock, iFinalClock) * 1e9
+          / ((double)HASH_ROUNDS * iKeyCount));
+
+   /* Print nothing visible, but keep the compiler from discarding the
+      loop. */
+   if (uSink == 1)
+      printf(" ");
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Distribute the iKeyCount keys in apcKeys, whose lengths are
+   auLengths, over a power-of-two number of buckets at load factor 1
+   using the low bits of pfHash, as symtablehash.c does.  Write to
+   stdout the longest chain, the mean number of key comparisons for a
+   successful search relative to a perfectly uniform hash, and the
+   histogram of chain lengths. */
+
+static void benchQuality(StrHash_T pfHash, char **apcKeys,
+                         const size_t *auLengths, int iKeyCount)
+{
+   size_t *auChains;
+   size_t auHistogram[MAX_CHAIN_BIN + 1];
+   size_t uBucketCount = 1;
+   size_t uMaxChain = 0;
+   double dProbes = 0.0;
+   double dIdeal;
+   size_t u;
+   int i;
+
+   assert(pfHash != NULL && apcKeys != NULL && auLengths != NULL);
+
+   while (uBucketCount < (size_t)iKeyCount)
+      uBucketCount *= 2;
+
+   auChains = (size_t*)calloc(uBucketCount, sizeof(size_t));
+   if (auChains == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   for (i = 0; i < iKeyCount; i++)
+      auChains[(*pfHash)(apcKeys[i], auLengths[i], 0)
+               & (uBucketCount - 1)]++;
+
+   memset(auHistogram, 0, sizeof(auHistogram));
+   for (u = 0; u < uBucketCount; u++)
+   {
+      if (auChains[u] > uMaxChain)
+         uMaxChain = auChains[u];
+      auHistogram[auChains[u] < MAX_CHAIN_BIN ?
+                  auChains[u] : MAX_CHAIN_BIN]++;
+      /* Finding every key of a chain of length n takes
+         1 + 2 + ... + n comparisons. */
+      dProbes += (double)auChains[u] * (double)(auChains[u] + 1) / 2.0;
+   }
+   free(auChains);
+
+   /* A uniform hash needs 1 + alpha/2 comparisons per search. */
+   dIdeal = 1.0 + ((double)iKeyCount / (double)uBucketCount) / 2.0;
+
+   printf("  max chain: %3lu  probes/ideal: %5.3f  chains:",
+          (unsigned long)uMaxChain, dProbes / iKeyCount / dIdeal);
+   for (u = 0; u <= MAX_CHAIN_BIN; u++)
+      printf(" %lu", (unsigned long)auHistogram[u]);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to stdout the nanoseconds per operation that a SymTable object
+   using hash function eHash takes to put, then get, the iKeyCount keys
+   in apcKeys. */
+
+static void benchTable(enum SymTableHash eHash, char **apcKeys,
+                       int iKeyCount)
+{
+   struct SymTableOptions sOptions;
+   SymTable_T oSymTable;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+   int i;
+
+   assert(apcKeys != NULL);
+
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.eHash = eHash;
+
+   iInitialClock = clock();
+   oSymTable = SymTable_newWithOptions(&sOptions);
+   if (oSymTable == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iKeyCount; i++)
+      SymTable_put(oSymTable, apcKeys[i], apcKeys[i]);
+   for (i = 0; i < iKeyCount; i++)
+      if (SymTable_get(oSymTable, apcKeys[i]) != apcKeys[i])
+         printf("Lookup of %s failed.\n", apcKeys[i]);
+   SymTable_free(oSymTable);
+   iFinalClock = clock();
+
+   printf("  table: %7.2f ns/op\n",
+          seconds(iInitialClock, iFinalClock) * 1e9 / (2.0 * iKeyCount));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the hash functions of strhash.h on each key family.  As
+   always, argc is the command-line argument count and argv contains
+   the command-line arguments.  argv[1] is the number of keys per
+   family.  Exit with EXIT_FAILURE if argv[1] is missing or not a
+   positive number.  Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   static const struct KeyFamily asFamilies[] = {
+      {"decimal", makeDecimal},
+      {"identifier", makeIdentifier},
+      {"dotted", makeDotted},
+      {"long", makeLong}};
+   static const struct HashFunction asHashes[] = {
+      {"multiplicative", StrHash_multiplicative,
+       SYMTABLE_HASH_MULTIPLICATIVE},
+      {"wyhash", StrHash_wyhash, SYMTABLE_HASH_WYHASH},
+      {"siphash", StrHash_siphash, SYMTABLE_HASH_SIPHASH}};
+   enum {FAMILY_COUNT = sizeof(asFamilies) / sizeof(asFamilies[0])};
+   enum {HASH_COUNT = sizeof(asHashes) / sizeof(asHashes[0])};
+
+   char acKey[MAX_KEY_SIZE];
+   char **apcKeys;
+   size_t *auLengths;
+   int iKeyCount;
+   int iFamily;
+   int iHash;
+   int i;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s keycount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iKeyCount) != 1 || iKeyCount <= 0)
+   {
+      fprintf(stderr, "keycount must be a positive number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   apcKeys = (char**)malloc((size_t)iKeyCount * sizeof(char*));
+   auLengths = (size_t*)malloc((size_t)iKeyCount * sizeof(size_t));
+   if (apcKeys == NULL || auLengths == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   printf("%d keys per family; chains: histogram of chain lengths "
+          "0..%d+ at load factor <= 1\n", iKeyCount, MAX_CHAIN_BIN);
+
+   for (iFamily = 0; iFamily < FAMILY_COUNT; iFamily++)
+   {
+      for (i = 0; i < iKeyCount; i++)
+      {
+         (*asFamilies[iFamily].pfMake)(acKey, i);
+         auLengths[i] = strlen(acKey);
+         apcKeys[i] = (char*)malloc(auLengths[i] + 1);
+         if (apcKeys[i] == NULL)
+         {
+            fprintf(stderr, "Insufficient memory\n");
+            exit(EXIT_FAILURE);
+         }
+         strcpy(apcKeys[i], acKey);
+      }
+
+      printf("------------------------------------------------------\n");
+      printf("%s keys, e.g. \"%s\"\n", asFamilies[iFamily].pcName,
+             apcKeys[iKeyCount - 1]);
+      for (iHash = 0; iHash < HASH_COUNT; iHash++)
+      {
+         printf("%-15s", asHashes[iHash].pcName);
+         benchSpeed(asHashes[iHash].pfHash, apcKeys, auLengths,
+                    iKeyCount);
+         benchQuality(asHashes[iHash].pfHash, apcKeys, auLengths,
+                      iKeyCount);
+         benchTable(asHashes[iHash].eHash, apcKeys, iKeyCount);
+      }
+      fflush(stdout);
+
+      for (i = 0; i < iKeyCount; i++)
+         free(apcKeys[i]);
+   }
+
+   free(auLengths);
+   free(apcKeys);
+   return 0;
+}
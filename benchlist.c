@@ -0,0 +1,260 @@
+/*--------------------------------------------------------------------*/
+/* benchlist.c                                                        */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key, including the terminating '\0'. */
+enum {MAX_KEY_SIZE = 16};
+
+/*--------------------------------------------------------------------*/
+
+/* A Reorder pairs a list reordering with its name. */
+
+struct Reorder
+{
+   /* The name of the reordering. */
+   const char *pcName;
+
+   /* The option that selects it in a SymTable object. */
+   enum SymTableReorder eReorder;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Exit with EXIT_FAILURE if pv is NULL. */
+
+static void checkMemory(const void *pv)
+{
+   if (pv == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of seconds between iInitialClock and
+   iFinalClock. */
+
+static double seconds(clock_t iInitialClock, clock_t iFinalClock)
+{
+   return ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Advance the xorshift generator whose state is *pulState and return
+   its next output. */
+
+static unsigned long nextRandom(unsigned long *pulState)
+{
+   unsigned long ulState;
+
+   assert(pulState != NULL);
+
+   ulState = *pulState;
+   ulState ^= ulState << 13;
+   ulState ^= ulState >> 7;
+   ulState ^= ulState << 17;
+   *pulState = ulState;
+   return ulState;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store in aiLookups lLookupCount key indexes less than iKeyCount
+   drawn from a Zipf distribution with exponent dExponent: the key of
+   popularity rank r is drawn in proportion to 1 / r^dExponent, so an
+   exponent of 0 draws uniformly.  The ranks are shuffled among the
+   keys, so the hot keys are not the ones added last, which a list
+   would find first anyway. */
+
+static void makeLookups(int *aiLookups, long lLookupCount, int iKeyCount,
+                        double dExponent)
+{
+   unsigned long ulState = 0x2545f491UL;
+   double *adCumulative;
+   int *aiKeyOfRank;
+   double dTotal = 0.0;
+   double dTarget;
+   int iLow;
+   int iHigh;
+   int iMid;
+   int iSwap;
+   int i;
+   long l;
+
+   assert(aiLookups != NULL && iKeyCount > 0);
+
+   adCumulative = (double*)malloc((size_t)iKeyCount * sizeof(double));
+   checkMemory(adCumulative);
+   aiKeyOfRank = (int*)malloc((size_t)iKeyCount * sizeof(int));
+   checkMemory(aiKeyOfRank);
+
+   for (i = 0; i < iKeyCount; i++)
+   {
+      dTotal += 1.0 / pow((double)(i + 1), dExponent);
+      adCumulative[i] = dTotal;
+      aiKeyOfRank[i] = i;
+   }
+   for (i = iKeyCount - 1; i > 0; i--)
+   {
+      iSwap = (int)(nextRandom(&ulState) % (unsigned long)(i + 1));
+      iMid = aiKeyOfRank[i];
+      aiKeyOfRank[i] = aiKeyOfRank[iSwap];
+      aiKeyOfRank[iSwap] = iMid;
+   }
+
+   /* Draw each rank by binary search of the cumulative weights. */
+   for (l = 0; l < lLookupCount; l++)
+   {
+      dTarget = (double)(nextRandom(&ulState) >> 11)
+         / 9007199254740992.0 * dTotal;
+      iLow = 0;
+      iHigh = iKeyCount - 1;
+      while (iLow < iHigh)
+      {
+         iMid = iLow + (iHigh - iLow) / 2;
+         if (adCumulative[iMid] <= dTarget)
+            iLow = iMid + 1;
+         else
+            iHigh = iMid;
+      }
+      aiLookups[l] = aiKeyOfRank[iLow];
+   }
+
+   free(aiKeyOfRank);
+   free(adCumulative);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the nanoseconds per lookup that a SymTable object reordering
+   as eReorder directs takes to get the keys of apcKeys whose indexes
+   are the lLookupCount entries of aiLookups, after adding all
+   iKeyCount keys.  Write a message to stdout if a lookup fails. */
+
+static double benchTable(enum SymTableReorder eReorder, char **apcKeys,
+                         int iKeyCount, const int *aiLookups,
+                         long lLookupCount)
+{
+   struct SymTableOptions sOptions;
+   SymTable_T oSymTable;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+   const char *pcKey;
+   int i;
+   long l;
+
+   assert(apcKeys != NULL && aiLookups != NULL);
+
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.eReorder = eReorder;
+   oSymTable = SymTable_newWithOptions(&sOptions);
+   checkMemory(oSymTable);
+   for (i = 0; i < iKeyCount; i++)
+      SymTable_put(oSymTable, apcKeys[i], apcKeys[i]);
+
+   iInitialClock = clock();
+   for (l = 0; l < lLookupCount; l++)
+   {
+      pcKey = apcKeys[aiLookups[l]];
+      if (SymTable_get(oSymTable, pcKey) != pcKey)
+         printf("Lookup of key %d failed.\n", aiLookups[l]);
+   }
+   iFinalClock = clock();
+
+   SymTable_free(oSymTable);
+   return seconds(iInitialClock, iFinalClock) * 1e9
+      / (double)lLookupCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Measure the lookups of a list SymTable object under each reordering
+   for key popularities from uniform to heavily skewed.  As always,
+   argc is the command-line argument count and argv contains the
+   command-line arguments.  argv[1] is the number of keys and argv[2]
+   the number of lookups per run.  Exit with EXIT_FAILURE if either is
+   missing or not a positive number.  Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   static const struct Reorder asReorders[] = {
+      {"none", SYMTABLE_REORDER_NONE},
+      {"move-to-front", SYMTABLE_REORDER_MOVE_TO_FRONT},
+      {"transpose", SYMTABLE_REORDER_TRANSPOSE}};
+   enum {REORDER_COUNT = sizeof(asReorders) / sizeof(asReorders[0])};
+   static const double adExponents[] = {0.0, 0.8, 1.0, 1.2, 1.5};
+   enum {EXPONENT_COUNT = sizeof(adExponents) / sizeof(double)};
+
+   char acKey[MAX_KEY_SIZE];
+   char **apcKeys;
+   int *aiLookups;
+   int iKeyCount;
+   long lLookupCount;
+   int iExponent;
+   int iReorder;
+   int i;
+
+   if (argc != 3)
+   {
+      fprintf(stderr, "Usage: %s keycount lookupcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iKeyCount) != 1 || iKeyCount <= 0 ||
+       sscanf(argv[2], "%ld", &lLookupCount) != 1 || lLookupCount <= 0)
+   {
+      fprintf(stderr,
+              "keycount and lookupcount must be positive numbers\n");
+      exit(EXIT_FAILURE);
+   }
+
+   apcKeys = (char**)malloc((size_t)iKeyCount * sizeof(char*));
+   checkMemory(apcKeys);
+   for (i = 0; i < iKeyCount; i++)
+   {
+      sprintf(acKey, "id%d", i);
+      apcKeys[i] = (char*)malloc(strlen(acKey) + 1);
+      checkMemory(apcKeys[i]);
+      strcpy(apcKeys[i], acKey);
+   }
+   aiLookups = (int*)malloc((size_t)lLookupCount * sizeof(int));
+   checkMemory(aiLookups);
+
+   printf("%d keys, %ld lookups per run, in ns per lookup\n", iKeyCount,
+          lLookupCount);
+   printf("zipf exponent");
+   for (iReorder = 0; iReorder < REORDER_COUNT; iReorder++)
+      printf("  %13s", asReorders[iReorder].pcName);
+   printf("\n");
+   for (iExponent = 0; iExponent < EXPONENT_COUNT; iExponent++)
+   {
+      makeLookups(aiLookups, lLookupCount, iKeyCount,
+                  adExponents[iExponent]);
+      printf("%13.1f", adExponents[iExponent]);
+      for (iReorder = 0; iReorder < REORDER_COUNT; iReorder++)
+         printf("  %13.1f",
+                benchTable(asReorders[iReorder].eReorder, apcKeys,
+                           iKeyCount, aiLookups, lLookupCount));
+      printf("\n");
+      fflush(stdout);
+   }
+
+   free(aiLookups);
+   for (i = 0; i < iKeyCount; i++)
+      free(apcKeys[i]);
+   free(apcKeys);
+   return 0;
+}
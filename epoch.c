@@ -0,0 +1,441 @@
+/*--------------------------------------------------------------------*/
+/* epoch.c                                                            */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include "epoch.h"
+
+#if ! defined(__GNUC__)
+#error "epoch.c needs the GCC __atomic builtins and __thread"
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* The size, in bytes, of a cache line, by which thread records are
+   kept apart. */
+enum {CACHE_LINE_SIZE = 64};
+
+/* The number of objects that a thread retires before it publishes
+   them for collection. */
+enum {EPOCH_BATCH_SIZE = 64};
+
+/* The number of outermost Epoch_exit calls, a power of two, between
+   the attempts of a thread to collect retired objects. */
+enum {COLLECT_INTERVAL = 64};
+
+/*--------------------------------------------------------------------*/
+
+/* An EpochObject is a retired object that waits to be freed. */
+
+struct EpochObject
+{
+   /* The object. */
+   void *pv;
+
+   /* The function that frees the object. */
+   void (*pfFree)(void *pv);
+};
+
+/*--------------------------------------------------------------------*/
+
+/* An EpochBatch holds objects that one thread retired.  A thread fills
+   a private batch without locking and then publishes it to the limbo
+   list, where EpochBatches are linked to form a list, newest first. */
+
+struct EpochBatch
+{
+   /* The global epoch at which the batch was published, which is no
+      earlier than the retirement of any of its objects. */
+   size_t uEpoch;
+
+   /* The number of objects. */
+   size_t uCount;
+
+   /* The address of the next EpochBatch. */
+   struct EpochBatch *psNextBatch;
+
+   /* The objects. */
+   struct EpochObject asObjects[EPOCH_BATCH_SIZE];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* An EpochRecord holds the reading state of one thread.  EpochRecords
+   are linked to form a list that only grows; the record of a thread
+   that exits is reused by the next thread to register. */
+
+struct EpochRecord
+{
+   /* The global epoch that the thread saw when it began reading, or 0
+      if it is not reading.  Written only by its thread. */
+   size_t uEpoch;
+
+   /* The number of Epoch_enter calls of the thread that have not been
+      matched by Epoch_exit. */
+   int iDepth;
+
+   /* 1 (TRUE) if a live thread owns the record.  Guarded by
+      sRecordMutex. */
+   int iInUse;
+
+   /* The objects that the thread has retired but not published, or
+      NULL.  Used only by its thread. */
+   struct EpochBatch *psBatch;
+
+   /* The number of outermost Epoch_exit calls of the thread, which
+      paces its attempts to collect. */
+   size_t uExitCount;
+
+   /* The address of the next EpochRecord. */
+   struct EpochRecord *psNextRecord;
+
+   /* Unused space that keeps the next record off this record's cache
+      line. */
+   char acPadding[CACHE_LINE_SIZE];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* The global epoch.  It starts at 1, so that 0 can mark a thread that
+   is not reading, and only a thread that holds sLimboMutex advances
+   it. */
+static size_t uGlobalEpoch = 1;
+
+/* The thread records, newest first, and the lock that guards adding
+   and reusing them. */
+static struct EpochRecord *psRecords = NULL;
+static pthread_mutex_t sRecordMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* The record of the calling thread, or NULL until it registers. */
+static __thread struct EpochRecord *psThreadRecord = NULL;
+
+/* The key whose destructor releases the record of an exiting
+   thread. */
+static pthread_key_t iRecordKey;
+static pthread_once_t iRecordKeyOnce = PTHREAD_ONCE_INIT;
+
+/* The published batches of retired objects, and the lock that guards
+   them.  psLimbo is written atomically, so that a thread may check
+   without the lock whether there is anything to collect. */
+static struct EpochBatch *psLimbo = NULL;
+static pthread_mutex_t sLimboMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*--------------------------------------------------------------------*/
+
+/* Advance the global epoch if every reading thread has seen its
+   current value.  The caller must hold sLimboMutex.  Return the global
+   epoch. */
+
+static size_t Epoch_tryAdvance(void)
+{
+   struct EpochRecord *psRecord;
+   size_t uEpoch;
+   size_t uSeen;
+
+   /* Order the caller's unlinking before the scan of the records. */
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+   uEpoch = __atomic_load_n(&uGlobalEpoch, __ATOMIC_RELAXED);
+   for (psRecord = __atomic_load_n(&psRecords, __ATOMIC_ACQUIRE);
+        psRecord != NULL; psRecord = psRecord->psNextRecord)
+   {
+      uSeen = __atomic_load_n(&psRecord->uEpoch, __ATOMIC_ACQUIRE);
+      if (uSeen != 0 && uSeen != uEpoch)
+         return uEpoch;
+   }
+
+   __atomic_store_n(&uGlobalEpoch, uEpoch + 1, __ATOMIC_RELEASE);
+   return uEpoch + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Try to advance the global epoch, then remove from the limbo list
+   every batch that no reader can still see.  The caller must hold
+   sLimboMutex.  Return the removed batches as a list. */
+
+static struct EpochBatch *Epoch_collect(void)
+{
+   struct EpochBatch **ppsLink;
+   struct EpochBatch *psBatch;
+   struct EpochBatch *psFreed = NULL;
+   size_t uEpoch;
+
+   /* An object retired at epoch e may be seen only by readers that saw
+      e - 1 or e, and the epoch passes e + 1 only after they exit.  Two
+      attempts to advance free the newest objects at once when no
+      reader is active. */
+   (void)Epoch_tryAdvance();
+   uEpoch = Epoch_tryAdvance();
+   ppsLink = &psLimbo;
+   while ((psBatch = *ppsLink) != NULL)
+   {
+      if (psBatch->uEpoch + 2 <= uEpoch)
+      {
+         __atomic_store_n(ppsLink, psBatch->psNextBatch,
+                          __ATOMIC_RELAXED);
+         psBatch->psNextBatch = psFreed;
+         psFreed = psBatch;
+      }
+      else
+         ppsLink = &psBatch->psNextBatch;
+   }
+   return psFreed;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the objects of psBatches, a list of EpochBatches, and the
+   batches themselves. */
+
+static void Epoch_freeBatches(struct EpochBatch *psBatches)
+{
+   struct EpochBatch *psNextBatch;
+   size_t u;
+
+   for (; psBatches != NULL; psBatches = psNextBatch)
+   {
+      psNextBatch = psBatches->psNextBatch;
+      for (u = 0; u < psBatches->uCount; u++)
+         (*psBatches->asObjects[u].pfFree)(psBatches->asObjects[u].pv);
+      free(psBatches);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the unpublished batch of psRecord, if any, to the limbo list.
+   The caller must hold sLimboMutex. */
+
+static void Epoch_publish(struct EpochRecord *psRecord)
+{
+   struct EpochBatch *psBatch;
+
+   assert(psRecord != NULL);
+
+   psBatch = psRecord->psBatch;
+   if (psBatch == NULL)
+      return;
+
+   /* Order the unlinking of the objects before the load of the epoch,
+      so that the batch's epoch is no earlier than any of theirs. */
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   psBatch->uEpoch = __atomic_load_n(&uGlobalEpoch, __ATOMIC_RELAXED);
+   psBatch->psNextBatch = psLimbo;
+   __atomic_store_n(&psLimbo, psBatch, __ATOMIC_RELAXED);
+   psRecord->psBatch = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Publish the unpublished batch of psRecord, if psRecord is not NULL,
+   and free every retired object that no reader can still see.  If
+   iWait is 0 (FALSE) and another thread holds sLimboMutex, do
+   nothing. */
+
+static void Epoch_flushRecord(struct EpochRecord *psRecord, int iWait)
+{
+   struct EpochBatch *psFreed;
+
+   if (iWait)
+      pthread_mutex_lock(&sLimboMutex);
+   else if (pthread_mutex_trylock(&sLimboMutex) != 0)
+      return;
+   if (psRecord != NULL)
+      Epoch_publish(psRecord);
+   psFreed = Epoch_collect();
+   pthread_mutex_unlock(&sLimboMutex);
+
+   Epoch_freeBatches(psFreed);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Release pvRecord, the EpochRecord of an exiting thread, for reuse by
+   another thread. */
+
+static void Epoch_releaseRecord(void *pvRecord)
+{
+   struct EpochRecord *psRecord;
+
+   assert(pvRecord != NULL);
+
+   psRecord = (struct EpochRecord*)pvRecord;
+
+   /* Leave the thread's retired objects to the other threads. */
+   Epoch_flushRecord(psRecord, 1);
+
+   pthread_mutex_lock(&sRecordMutex);
+   __atomic_store_n(&psRecord->uEpoch, 0, __ATOMIC_RELEASE);
+   psRecord->iDepth = 0;
+   psRecord->iInUse = 0;
+   pthread_mutex_unlock(&sRecordMutex);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Create the key that releases thread records. */
+
+static void Epoch_createKey(void)
+{
+   (void)pthread_key_create(&iRecordKey, Epoch_releaseRecord);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Give the calling thread a record, reusing a released one if there
+   is one.  Return the record, or NULL if insufficient memory is
+   available. */
+
+static struct EpochRecord *Epoch_register(void)
+{
+   struct EpochRecord *psRecord;
+
+   pthread_once(&iRecordKeyOnce, Epoch_createKey);
+
+   pthread_mutex_lock(&sRecordMutex);
+   for (psRecord = psRecords; psRecord != NULL;
+        psRecord = psRecord->psNextRecord)
+      if (! psRecord->iInUse)
+         break;
+
+   if (psRecord == NULL)
+   {
+      psRecord = (struct EpochRecord*)
+         calloc(1, sizeof(struct EpochRecord));
+      if (psRecord == NULL)
+      {
+         pthread_mutex_unlock(&sRecordMutex);
+         return NULL;
+      }
+      psRecord->psNextRecord = psRecords;
+      /* Publish the record to threads that scan without the lock. */
+      __atomic_store_n(&psRecords, psRecord, __ATOMIC_RELEASE);
+   }
+   psRecord->iInUse = 1;
+   pthread_mutex_unlock(&sRecordMutex);
+
+   (void)pthread_setspecific(iRecordKey, psRecord);
+   psThreadRecord = psRecord;
+   return psRecord;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Epoch_enter(void)
+{
+   struct EpochRecord *psRecord = psThreadRecord;
+
+   if (psRecord == NULL)
+   {
+      psRecord = Epoch_register();
+      if (psRecord == NULL)
+         return 0;
+   }
+
+   if (psRecord->iDepth++ == 0)
+   {
+      __atomic_store_n(&psRecord->uEpoch,
+                       __atomic_load_n(&uGlobalEpoch, __ATOMIC_RELAXED),
+                       __ATOMIC_RELAXED);
+      /* Make the epoch visible before any shared pointer is read. */
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Epoch_exit(void)
+{
+   struct EpochRecord *psRecord = psThreadRecord;
+
+   assert(psRecord != NULL && psRecord->iDepth > 0);
+
+   if (--psRecord->iDepth > 0)
+      return;
+   __atomic_store_n(&psRecord->uEpoch, 0, __ATOMIC_RELEASE);
+
+   /* Now and then, collect what this thread or any other has retired,
+      so that objects do not wait for the next retirement.  A reader
+      never waits for the limbo lock. */
+   if ((++psRecord->uExitCount & (COLLECT_INTERVAL - 1)) == 0 &&
+       (psRecord->psBatch != NULL ||
+        __atomic_load_n(&psLimbo, __ATOMIC_RELAXED) != NULL))
+      Epoch_flushRecord(psRecord, 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+void Epoch_retire(void *pv, void (*pfFree)(void *pv))
+{
+   struct EpochRecord *psRecord = psThreadRecord;
+   struct EpochBatch *psBatch;
+
+   assert(pfFree != NULL);
+
+   if (psRecord == NULL)
+      psRecord = Epoch_register();
+   if (psRecord != NULL && psRecord->psBatch == NULL)
+   {
+      psBatch = (struct EpochBatch*)malloc(sizeof(struct EpochBatch));
+      if (psBatch != NULL)
+         psBatch->uCount = 0;
+      psRecord->psBatch = psBatch;
+   }
+   if (psRecord == NULL || psRecord->psBatch == NULL)
+   {
+      /* Without a batch, wait for the readers instead. */
+      Epoch_synchronize();
+      (*pfFree)(pv);
+      return;
+   }
+
+   /* Only this thread uses its batch, so retiring takes no lock until
+      the batch is full. */
+   psBatch = psRecord->psBatch;
+   psBatch->asObjects[psBatch->uCount].pv = pv;
+   psBatch->asObjects[psBatch->uCount].pfFree = pfFree;
+   if (++psBatch->uCount == EPOCH_BATCH_SIZE)
+      Epoch_flushRecord(psRecord, 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+void Epoch_flush(void)
+{
+   Epoch_flushRecord(psThreadRecord, 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+void Epoch_synchronize(void)
+{
+   struct EpochBatch *psFreed;
+   size_t uTarget;
+
+   pthread_mutex_lock(&sLimboMutex);
+   uTarget = __atomic_load_n(&uGlobalEpoch, __ATOMIC_RELAXED) + 2;
+   for (;;)
+   {
+      psFreed = Epoch_collect();
+      if (psFreed != NULL)
+      {
+         pthread_mutex_unlock(&sLimboMutex);
+         Epoch_freeBatches(psFreed);
+         pthread_mutex_lock(&sLimboMutex);
+      }
+      if (__atomic_load_n(&uGlobalEpoch, __ATOMIC_RELAXED) >= uTarget)
+         break;
+      pthread_mutex_unlock(&sLimboMutex);
+      sched_yield();
+      pthread_mutex_lock(&sLimboMutex);
+   }
+   pthread_mutex_unlock(&sLimboMutex);
+}
@@ -0,0 +1,67 @@
+/*--------------------------------------------------------------------*/
+/* epoch.h                                                            */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef EPOCH_INCLUDED
+#define EPOCH_INCLUDED
+
+/*--------------------------------------------------------------------*/
+/* Epoch-based reclamation lets threads read a shared linked structure
+without locks while other threads unlink and free parts of it. A
+reader brackets each traversal with Epoch_enter and Epoch_exit. A
+writer that unlinks an object passes it to Epoch_retire instead of
+freeing it, and the object is freed once every reader that might
+still see it has exited. Entering and exiting write only to a record
+of the calling thread, so readers never contend for a cache line. */
+
+/*--------------------------------------------------------------------*/
+
+/* Mark the calling thread as reading shared objects, and return 1
+(TRUE). Return 0 (FALSE) if the thread could not be registered for
+lack of memory, in which case the caller must not read without some
+other protection and must not call Epoch_exit. Calls may nest. */
+
+int Epoch_enter(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Mark the calling thread as no longer reading shared objects, ending
+the most recent Epoch_enter. */
+
+void Epoch_exit(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Call (*pfFree)(pv) once no thread that was reading when pv was
+unlinked is still reading. The caller must already have unlinked pv so
+that no new reader can reach it, and must not be reading itself.
+Retiring takes no lock: each thread gathers the objects it retires in
+a private batch, and publishes the batch for collection when it fills,
+when the thread exits, or when the thread calls Epoch_flush. Published
+objects are freed during later calls of Epoch_retire, Epoch_exit,
+Epoch_flush and Epoch_synchronize on any thread. (*pfFree) may be
+called on any thread. */
+
+void Epoch_retire(void *pv, void (*pfFree)(void *pv));
+
+/*--------------------------------------------------------------------*/
+
+/* Publish the objects that the calling thread has retired, so that
+any thread may free them, and free every published object that no
+reader can still see. Call it after retiring a large object, which
+would otherwise wait for the rest of the batch. The caller must not be
+reading. */
+
+void Epoch_flush(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Wait until every thread that was reading at the time of the call
+has stopped reading. The caller must not be reading itself. */
+
+void Epoch_synchronize(void);
+
+/*--------------------------------------------------------------------*/
+
+#endif
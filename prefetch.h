@@ -0,0 +1,23 @@
+/*--------------------------------------------------------------------*/
+/* prefetch.h                                                         */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef PREFETCH_INCLUDED
+#define PREFETCH_INCLUDED
+
+/*--------------------------------------------------------------------*/
+
+/* Ask the processor to start loading the cache line at pv, which may
+be NULL. A prefetch never faults, and compiles to nothing where the
+compiler has no way to ask for one. */
+
+#if defined(__GNUC__)
+#define PREFETCH(pv) __builtin_prefetch(pv)
+#else
+#define PREFETCH(pv) ((void)(pv))
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#endif
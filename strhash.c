@@ -0,0 +1,331 @@
+/*--------------------------------------------------------------------*/
+/* strhash.c                                                          */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "strhash.h"
+
+#if ! defined(__GNUC__)
+#error "strhash.c needs the GCC __atomic builtins"
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* The secret constants of wyhash: odd 64-bit numbers whose bytes each
+   have four bits set. */
+static const uint64_t auWySecret[4] = {
+   0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+   0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL};
+
+/* The increment of the splitmix64 generator: 2^64 divided by the
+   golden ratio. */
+static const uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ULL;
+
+/* The state of the splitmix64 generator of StrHash_randomSeed, which
+   sSeedOnce initializes and which is then only advanced
+   atomically. */
+static pthread_once_t sSeedOnce = PTHREAD_ONCE_INIT;
+static uint64_t uSeedState;
+
+/*--------------------------------------------------------------------*/
+
+/* Return the 64-bit MurmurHash3 finalization of uHash. */
+
+static uint64_t StrHash_finalize(uint64_t uHash)
+{
+   uHash ^= uHash >> 33;
+   uHash *= 0xff51afd7ed558ccdULL;
+   uHash ^= uHash >> 33;
+   uHash *= 0xc4ceb9fe1a85ec53ULL;
+   uHash ^= uHash >> 33;
+   return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Multiply *puA by *puB as 128-bit numbers, and store the low 64 bits
+   of the product in *puA and the high 64 bits in *puB. */
+
+static void StrHash_multiply(uint64_t *puA, uint64_t *puB)
+{
+#if defined(__SIZEOF_INT128__)
+   __uint128_t uProduct = (__uint128_t)*puA * *puB;
+   *puA = (uint64_t)uProduct;
+   *puB = (uint64_t)(uProduct >> 64);
+#else
+   /* Multiply 32-bit halves and recombine. */
+   uint64_t uAHi = *puA >> 32, uALo = (uint32_t)*puA;
+   uint64_t uBHi = *puB >> 32, uBLo = (uint32_t)*puB;
+   uint64_t uHiHi = uAHi * uBHi, uHiLo = uAHi * uBLo;
+   uint64_t uLoHi = uALo * uBHi, uLoLo = uALo * uBLo;
+   uint64_t uMid = uHiLo + (uLoLo >> 32) + (uint32_t)uLoHi;
+   *puA = (uMid << 32) | (uint32_t)uLoLo;
+   *puB = uHiHi + (uMid >> 32) + (uLoHi >> 32);
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the low 64 bits of the 128-bit product uA * uB xor-ed with
+   its high 64 bits. */
+
+static uint64_t StrHash_mix(uint64_t uA, uint64_t uB)
+{
+   StrHash_multiply(&uA, &uB);
+   return uA ^ uB;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the 8 bytes at pcBytes as a 64-bit number.  memcpy permits
+   unaligned keys and compiles to a single load. */
+
+static uint64_t StrHash_read8(const char *pcBytes)
+{
+   uint64_t uWord;
+   memcpy(&uWord, pcBytes, sizeof(uWord));
+   return uWord;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the 4 bytes at pcBytes as a 64-bit number. */
+
+static uint64_t StrHash_read4(const char *pcBytes)
+{
+   uint32_t uWord;
+   memcpy(&uWord, pcBytes, sizeof(uWord));
+   return uWord;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t StrHash_multiplicative(const char *pcKey, size_t uLength,
+                              size_t uSeed)
+{
+   const uint64_t HASH_MULTIPLIER = 65599;
+   uint64_t uHash = (uint64_t)uSeed;
+   size_t u;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; u < uLength; u++)
+      uHash = uHash * HASH_MULTIPLIER + (uint64_t)pcKey[u];
+
+   return (size_t)StrHash_finalize(uHash);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t StrHash_wyhash(const char *pcKey, size_t uLength, size_t uSeed)
+{
+   uint64_t uSeed1;
+   uint64_t uSeed2;
+   uint64_t uA;
+   uint64_t uB;
+   size_t uLeft = uLength;
+   const char *pc = pcKey;
+
+   assert(pcKey != NULL);
+
+   uSeed ^= StrHash_mix((uint64_t)uSeed ^ auWySecret[0], auWySecret[1]);
+
+   if (uLength <= 16)
+   {
+      /* Short keys: read overlapping words covering every byte. */
+      if (uLength >= 4)
+      {
+         uA = (StrHash_read4(pc) << 32) |
+            StrHash_read4(pc + ((uLength >> 3) << 2));
+         uB = (StrHash_read4(pc + uLength - 4) << 32) |
+            StrHash_read4(pc + uLength - 4 - ((uLength >> 3) << 2));
+      }
+      else if (uLength > 0)
+      {
+         uA = ((uint64_t)(unsigned char)pc[0] << 16) |
+            ((uint64_t)(unsigned char)pc[uLength >> 1] << 8) |
+            (uint64_t)(unsigned char)pc[uLength - 1];
+         uB = 0;
+      }
+      else
+         uA = uB = 0;
+   }
+   else
+   {
+      /* Long keys: consume 48 bytes per round in three independent
+         lanes, then 16 bytes per round. */
+      if (uLeft > 48)
+      {
+         uSeed1 = uSeed;
+         uSeed2 = uSeed;
+         do
+         {
+            uSeed = StrHash_mix(StrHash_read8(pc) ^ auWySecret[1],
+                                StrHash_read8(pc + 8) ^ uSeed);
+            uSeed1 = StrHash_mix(StrHash_read8(pc + 16) ^ auWySecret[2],
+                                 StrHash_read8(pc + 24) ^ uSeed1);
+            uSeed2 = StrHash_mix(StrHash_read8(pc + 32) ^ auWySecret[3],
+                                 StrHash_read8(pc + 40) ^ uSeed2);
+            pc += 48;
+            uLeft -= 48;
+         } while (uLeft > 48);
+         uSeed ^= uSeed1 ^ uSeed2;
+      }
+      while (uLeft > 16)
+      {
+         uSeed = StrHash_mix(StrHash_read8(pc) ^ auWySecret[1],
+                             StrHash_read8(pc + 8) ^ uSeed);
+         pc += 16;
+         uLeft -= 16;
+      }
+      uA = StrHash_read8(pc + uLeft - 16);
+      uB = StrHash_read8(pc + uLeft - 8);
+   }
+
+   uA ^= auWySecret[1];
+   uB ^= uSeed;
+   StrHash_multiply(&uA, &uB);
+   return (size_t)StrHash_mix(uA ^ auWySecret[0] ^ (uint64_t)uLength,
+                              uB ^ auWySecret[1]);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return uWord rotated left by iBits bits. */
+
+static uint64_t StrHash_rotate(uint64_t uWord, int iBits)
+{
+   return (uWord << iBits) | (uWord >> (64 - iBits));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply one SipRound to the state auV. */
+
+static void StrHash_sipRound(uint64_t auV[4])
+{
+   auV[0] += auV[1];
+   auV[1] = StrHash_rotate(auV[1], 13);
+   auV[1] ^= auV[0];
+   auV[0] = StrHash_rotate(auV[0], 32);
+   auV[2] += auV[3];
+   auV[3] = StrHash_rotate(auV[3], 16);
+   auV[3] ^= auV[2];
+   auV[0] += auV[3];
+   auV[3] = StrHash_rotate(auV[3], 21);
+   auV[3] ^= auV[0];
+   auV[2] += auV[1];
+   auV[1] = StrHash_rotate(auV[1], 17);
+   auV[1] ^= auV[2];
+   auV[2] = StrHash_rotate(auV[2], 32);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t StrHash_siphash(const char *pcKey, size_t uLength, size_t uSeed)
+{
+   uint64_t auV[4];
+   uint64_t uK0;
+   uint64_t uK1;
+   uint64_t uWord;
+   size_t uLeft = uLength;
+   const char *pc = pcKey;
+   int i;
+
+   assert(pcKey != NULL);
+
+   /* Stretch the seed into a 128-bit key. */
+   uK0 = StrHash_finalize((uint64_t)uSeed + GOLDEN_GAMMA);
+   uK1 = StrHash_finalize((uint64_t)uSeed + 2 * GOLDEN_GAMMA);
+
+   auV[0] = uK0 ^ 0x736f6d6570736575ULL;
+   auV[1] = uK1 ^ 0x646f72616e646f6dULL;
+   auV[2] = uK0 ^ 0x6c7967656e657261ULL;
+   auV[3] = uK1 ^ 0x7465646279746573ULL;
+
+   /* Compress each full word with one round. */
+   for (; uLeft >= 8; uLeft -= 8, pc += 8)
+   {
+      uWord = StrHash_read8(pc);
+      auV[3] ^= uWord;
+      StrHash_sipRound(auV);
+      auV[0] ^= uWord;
+   }
+
+   /* Compress the last 0-7 bytes together with the length. */
+   uWord = (uint64_t)uLength << 56;
+   for (i = (int)uLeft - 1; i >= 0; i--)
+      uWord |= (uint64_t)(unsigned char)pc[i] << (8 * i);
+   auV[3] ^= uWord;
+   StrHash_sipRound(auV);
+   auV[0] ^= uWord;
+
+   /* Finalize with three rounds. */
+   auV[2] ^= 0xff;
+   StrHash_sipRound(auV);
+   StrHash_sipRound(auV);
+   StrHash_sipRound(auV);
+   return (size_t)(auV[0] ^ auV[1] ^ auV[2] ^ auV[3]);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Initialize uSeedState from a secret that varies between runs. */
+
+static void StrHash_initSeed(void)
+{
+   FILE *psFile;
+   int iLocal;
+
+   psFile = fopen("/dev/urandom", "rb");
+   if (psFile == NULL ||
+       fread(&uSeedState, sizeof(uSeedState), 1, psFile) != 1)
+   {
+      /* Fall back on sources that vary between runs. */
+      uSeedState = (uint64_t)time(NULL) ^ ((uint64_t)clock() << 32) ^
+         (uint64_t)(size_t)&iLocal;
+   }
+   if (psFile != NULL)
+      fclose(psFile);
+}
+
+/*--------------------------------------------------------------------*/
+
+StrHash_T StrHash_forOption(enum SymTableHash eHash)
+{
+   switch (eHash)
+   {
+      case SYMTABLE_HASH_MULTIPLICATIVE:
+         return StrHash_multiplicative;
+      case SYMTABLE_HASH_SIPHASH:
+         return StrHash_siphash;
+      case SYMTABLE_HASH_WYHASH:
+      case SYMTABLE_HASH_DEFAULT:
+      default:
+         return StrHash_wyhash;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t StrHash_randomSeed(void)
+{
+   uint64_t uState;
+
+   pthread_once(&sSeedOnce, StrHash_initSeed);
+
+   /* Draw the next output of a splitmix64 generator.  Concurrent
+      callers each advance the state once, so no two of them draw the
+      same seed. */
+   uState = __atomic_add_fetch(&uSeedState, GOLDEN_GAMMA,
+                               __ATOMIC_RELAXED);
+   return (size_t)StrHash_finalize(uState);
+}
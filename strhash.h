@@ -0,0 +1,66 @@
+/*--------------------------------------------------------------------*/
+/* strhash.h                                                          */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef STRHASH_INCLUDED
+#define STRHASH_INCLUDED
+#include <stddef.h>
+#include "symtable.h"
+
+/*--------------------------------------------------------------------*/
+
+/* A StrHash_T is a function that returns a full-width hash code for
+the uLength bytes at pcKey under seed uSeed. Every bit of the hash code
+is well mixed, so a table may use its low bits as a bucket index. */
+
+typedef size_t (*StrHash_T)(const char *pcKey, size_t uLength,
+                            size_t uSeed);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash code of the uLength bytes at pcKey under seed uSeed,
+computed one byte at a time by multiplying by 65599, then finalized
+with the 64-bit mixer from MurmurHash3. Keys of equal length that
+collide under one seed collide under every seed, so the seed does not
+protect this hash from collision flooding. */
+
+size_t StrHash_multiplicative(const char *pcKey, size_t uLength,
+                              size_t uSeed);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash code of the uLength bytes at pcKey under seed uSeed,
+computed eight bytes at a time with wyhash-style 64x64->128-bit
+multiply folding. */
+
+size_t StrHash_wyhash(const char *pcKey, size_t uLength, size_t uSeed);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the SipHash-1-3 code of the uLength bytes at pcKey under a
+128-bit key derived from uSeed. SipHash is a keyed pseudorandom
+function, so an attacker who does not know uSeed cannot construct
+colliding keys. */
+
+size_t StrHash_siphash(const char *pcKey, size_t uLength, size_t uSeed);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash function that option eHash of a SymTableOptions
+selects, which for SYMTABLE_HASH_DEFAULT is StrHash_wyhash. */
+
+StrHash_T StrHash_forOption(enum SymTableHash eHash);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new seed that is unpredictable to an attacker. Successive
+calls return different seeds, even when made from several threads
+at once. The first call reads a secret from /dev/urandom, or falls
+back to the time and address-space layout if it cannot. */
+
+size_t StrHash_randomSeed(void);
+
+/*--------------------------------------------------------------------*/
+
+#endif
@@ -0,0 +1,99 @@
+/*--------------------------------------------------------------------*/
+/* stripe.c                                                           */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "stripe.h"
+
+#if ! defined(__GNUC__)
+#error "stripe.c needs the GCC __atomic builtins"
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* The largest bucket count that can double without its bucket array
+   of pointers overflowing the address space. */
+static const size_t MAX_DOUBLING_COUNT = ((size_t)-1) / sizeof(void*) / 2;
+
+/*--------------------------------------------------------------------*/
+
+size_t Stripe_load(const size_t *puValue)
+{
+   assert(puValue != NULL);
+
+   return __atomic_load_n(puValue, __ATOMIC_RELAXED);
+}
+
+/*--------------------------------------------------------------------*/
+
+void Stripe_store(size_t *puValue, size_t uValue)
+{
+   assert(puValue != NULL);
+
+   __atomic_store_n(puValue, uValue, __ATOMIC_RELAXED);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Stripe_add(size_t *puValue, size_t uDelta)
+{
+   assert(puValue != NULL);
+
+   return __atomic_add_fetch(puValue, uDelta, __ATOMIC_RELAXED);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Stripe_expandAt(size_t uBucketCount, double dMaxLoadFactor)
+{
+   double dExpandAt = (double)uBucketCount * dMaxLoadFactor;
+
+   if (dExpandAt >= (double)(size_t)-1)
+      return (size_t)-1;
+   if (dExpandAt < 1.0)
+      return 1;
+   return (size_t)dExpandAt;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t Stripe_bucketCountFor(size_t uCount, double dMaxLoadFactor)
+{
+   size_t uBucketCount = STRIPE_COUNT;
+
+   while (Stripe_expandAt(uBucketCount, dMaxLoadFactor) < uCount &&
+          uBucketCount <= MAX_DOUBLING_COUNT)
+      uBucketCount *= 2;
+   return uBucketCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Stripe_grow(pthread_mutex_t *psResizeLock, const size_t *puCount,
+                 size_t *puExpandAt, const size_t *puBucketCount,
+                 int (*pfResize)(void *pvTable, size_t uNewCount),
+                 void *pvTable)
+{
+   assert(psResizeLock != NULL && puCount != NULL);
+   assert(puExpandAt != NULL && puBucketCount != NULL);
+   assert(pfResize != NULL && pvTable != NULL);
+
+   if (pthread_mutex_trylock(psResizeLock) != 0)
+      return;
+
+   if (Stripe_load(puCount) > Stripe_load(puExpandAt))
+   {
+      /* Stop growing once the bucket array cannot double. */
+      if (*puBucketCount > MAX_DOUBLING_COUNT)
+         Stripe_store(puExpandAt, (size_t)-1);
+      else
+         (void)(*pfResize)(pvTable, *puBucketCount * 2);
+   }
+
+   pthread_mutex_unlock(psResizeLock);
+}
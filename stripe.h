@@ -0,0 +1,82 @@
+/*--------------------------------------------------------------------*/
+/* stripe.h                                                           */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef STRIPE_INCLUDED
+#define STRIPE_INCLUDED
+
+#include <stddef.h>
+#include <pthread.h>
+
+/*--------------------------------------------------------------------*/
+/* The sizing shared by the SymTable implementations whose buckets are
+guarded by lock stripes (symtableconc.c and symtableepoch.c). Bucket
+counts are powers of two of at least STRIPE_COUNT, so the stripe of a
+bucket, its index modulo STRIPE_COUNT, does not change when a table
+resizes. Binding counts and expansion thresholds are read and written
+atomically, so that threads may add bindings concurrently. */
+
+/*--------------------------------------------------------------------*/
+
+/* The number of lock stripes, a power of two. */
+enum {STRIPE_COUNT = 64};
+
+/* The size, in bytes, of a cache line, the padding by which adjacent
+stripes are kept apart so that their locks do not share a line. */
+enum {STRIPE_PADDING_SIZE = 64};
+
+/*--------------------------------------------------------------------*/
+
+/* Return *puValue, read atomically. */
+
+size_t Stripe_load(const size_t *puValue);
+
+/*--------------------------------------------------------------------*/
+
+/* Store uValue in *puValue atomically. */
+
+void Stripe_store(size_t *puValue, size_t uValue);
+
+/*--------------------------------------------------------------------*/
+
+/* Add uDelta, which may be (size_t)-1, to *puValue atomically and
+return the sum. */
+
+size_t Stripe_add(size_t *puValue, size_t uDelta);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bindings at which a bucket array of
+uBucketCount buckets grows under load factor dMaxLoadFactor. */
+
+size_t Stripe_expandAt(size_t uBucketCount, double dMaxLoadFactor);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the smallest power-of-two bucket count, at least
+STRIPE_COUNT, that holds uCount bindings under load factor
+dMaxLoadFactor without growing. */
+
+size_t Stripe_bucketCountFor(size_t uCount, double dMaxLoadFactor);
+
+/*--------------------------------------------------------------------*/
+
+/* Double the bucket count *puBucketCount of the table pvTable by
+calling (*pfResize)(pvTable, 2 * *puBucketCount) if its binding count
+*puCount exceeds its expansion threshold *puExpandAt, unless another
+thread holds its resize lock *psResizeLock, in which case leave the
+growth to that thread. (*pfResize) runs with *psResizeLock held, must
+update *puBucketCount and *puExpandAt if it succeeds, and must keep
+the old bucket array if insufficient memory is available. Once the
+bucket count cannot double, set *puExpandAt to its maximum instead. The
+caller must hold no stripe lock. */
+
+void Stripe_grow(pthread_mutex_t *psResizeLock, const size_t *puCount,
+                 size_t *puExpandAt, const size_t *puBucketCount,
+                 int (*pfResize)(void *pvTable, size_t uNewCount),
+                 void *pvTable);
+
+/*--------------------------------------------------------------------*/
+
+#endif
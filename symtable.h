@@ -22,6 +22,130 @@ SymTable_T SymTable_new(void);
 
 /*--------------------------------------------------------------------*/
 
+/* The hash functions that a hashing SymTable object may use. */
+
+enum SymTableHash
+{
+   /* The implementation's default hash function. */
+   SYMTABLE_HASH_DEFAULT,
+
+   /* The classic hash that multiplies by 65599 one byte at a time. */
+   SYMTABLE_HASH_MULTIPLICATIVE,
+
+   /* A wyhash-style hash that reads the key eight bytes at a time. */
+   SYMTABLE_HASH_WYHASH,
+
+   /* SipHash-1-3, a keyed hash that is slower than wyhash but resists
+   collision flooding by attackers who see the table's behavior. */
+   SYMTABLE_HASH_SIPHASH
+};
+
+/*--------------------------------------------------------------------*/
+
+/* The ways in which a list SymTable object may reorder its bindings
+when a lookup finds one, so that frequently sought keys drift toward
+the front of the search. */
+
+enum SymTableReorder
+{
+   /* Keep the bindings in the order they were added. */
+   SYMTABLE_REORDER_NONE,
+
+   /* Move a binding that is found to the front. Hot keys are found
+   at once, but a single lookup of a cold key also moves it past every
+   hot one. */
+   SYMTABLE_REORDER_MOVE_TO_FRONT,
+
+   /* Swap a binding that is found with the one before it. Keys climb
+   one step per lookup, so the order settles more slowly but resists
+   occasional lookups of cold keys. */
+   SYMTABLE_REORDER_TRANSPOSE
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableOptions tunes a new SymTable object.  A zero-filled
+SymTableOptions selects the default for every field, and each
+implementation ignores the fields that do not apply to it. */
+
+struct SymTableOptions
+{
+   /* The maximum average number of bindings per bucket (or per slot)
+   before the table grows, or 0 for the default. */
+   double dMaxLoadFactor;
+
+   /* The number of old buckets that each later operation migrates
+   while the table grows, or 0 to migrate every bucket at once when
+   the table grows. A nonzero step bounds the latency of SymTable_put
+   at the cost of searching two bucket arrays during growth. A step
+   of at most 1 / dMaxLoadFactor could leave buckets unmigrated when
+   the table next grows, so it is raised to the next integer above
+   that. */
+   size_t uRehashStep;
+
+   /* If nonzero, the table carves its bindings out of large slabs
+   that it owns, reuses the memory of removed bindings, and releases
+   all slabs at once in SymTable_free. */
+   int iUseArena;
+
+   /* The hash function, or SYMTABLE_HASH_DEFAULT. */
+   enum SymTableHash eHash;
+
+   /* If nonzero, the table hashes with uSeed, so that runs with the
+   same bindings lay them out identically. Otherwise the table draws
+   its own random seed, so that keys chosen to collide in one table
+   do not collide in another. */
+   int iFixedSeed;
+
+   /* The seed of the hash function if iFixedSeed is nonzero. */
+   size_t uSeed;
+
+   /* The number of bindings the table holds before it first grows,
+   or 0 for the default. */
+   size_t uCapacity;
+
+   /* How a list reorders its bindings on a successful SymTable_get or
+   SymTable_contains. A reordering table changes on every lookup, so
+   lookups must not be made from within SymTable_map, and they end an
+   iteration. */
+   enum SymTableReorder eReorder;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new SymTable object that contains no bindings and is tuned
+by *psOptions, or NULL if insufficient memory is available. If 
+psOptions is NULL, use the defaults. */
+
+SymTable_T SymTable_newWithOptions(const struct SymTableOptions *psOptions);
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new SymTable object that contains no bindings and holds
+uCapacity bindings before it first grows, or NULL if insufficient
+memory is available. */
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity);
+
+/*--------------------------------------------------------------------*/
+
+/* Make room in oSymTable for uCount bindings in all, so that adding
+bindings up to that count never grows the table, and return 1 (TRUE).
+Return 0 (FALSE) if insufficient memory is available, in which case
+oSymTable is unchanged. */
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Release the room in oSymTable that its current bindings do not
+need, for example after many bindings were removed. If insufficient
+memory is available, leave oSymTable unchanged. */
+
+void SymTable_shrink(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+
 /* Free all memory occupied by oSymTable. */
 
 void SymTable_free(SymTable_T oSymTable);
@@ -42,6 +166,14 @@ int SymTable_put(SymTable_T oSymTable, const char *pcKey,
 
 /*--------------------------------------------------------------------*/
 
+/* Like SymTable_put, but the key is the uLength bytes at pcKey, which
+need not be followed by '\0' but must not contain it. */
+
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                  const void *pvValue);
+
+/*--------------------------------------------------------------------*/
+
 /* Replace existing binding with key pcKey in oSymTable with pvValue
 and return the old value. Otherwise, return NULL. */
 
@@ -50,6 +182,30 @@ void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
 
 /*--------------------------------------------------------------------*/
 
+/* If oSymTable contains a binding with key pcKey, replace its value
+with pvValue and return the old value. Otherwise add a new binding
+consisting of key pcKey and value pvValue and return NULL. The key is
+hashed and searched for only once. If insufficient memory is available,
+leave oSymTable unchanged and return NULL; use SymTable_getOrPut to
+tell that case apart. */
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                      const void *pvValue);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the address of the value of the binding within oSymTable
+whose key is pcKey, first adding a binding consisting of key pcKey and
+value pvValue if there is none. Return NULL if insufficient memory is
+available. The caller may read or update the value through the
+address until the next call that adds or removes a binding of
+oSymTable. */
+
+const void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                               const void *pvValue);
+
+/*--------------------------------------------------------------------*/
+
 /* Return 1 (TRUE) if oSymTable contains a binding whose key is pcKey.
 Otherwise, return 0 (FALSE). */
 
@@ -57,6 +213,14 @@ int SymTable_contains(SymTable_T oSymTable, const char *pcKey);
 
 /*--------------------------------------------------------------------*/
 
+/* Like SymTable_contains, but the key is the uLength bytes at pcKey,
+which need not be followed by '\0' but must not contain it. */
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
 /* Return the value of the binding within oSymTable whose key is pcKey,
 or NULL if no such bindign exists. */
 
@@ -64,6 +228,35 @@ void *SymTable_get(SymTable_T oSymTable, const char *pcKey);
 
 /*--------------------------------------------------------------------*/
 
+/* Like SymTable_get, but the key is the uLength bytes at pcKey, which
+need not be followed by '\0' but must not contain it. */
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+                    size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
+/* For each i less than uCount, store in apvValues[i] the value of the
+binding within oSymTable whose key is apcKeys[i], or NULL if no such
+binding exists. Looking up many keys in one call lets the table
+overlap their memory accesses. */
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+                       size_t uCount, void **apvValues);
+
+/*--------------------------------------------------------------------*/
+
+/* For each i less than uCount in turn, add a new binding to oSymTable
+consisting of key apcKeys[i] and value apvValues[i] if oSymTable does
+not already contain a binding with that key. Return the number of
+bindings added, which is less than uCount if some keys were already
+present or insufficient memory is available. */
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+                         size_t uCount, const void **apvValues);
+
+/*--------------------------------------------------------------------*/
+
 /* Remove existing binding with key pcKey from oSymTable and return the 
 binding's value. Otherwise, return NULL. */
 
@@ -71,8 +264,18 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey);
 
 /*--------------------------------------------------------------------*/
 
+/* Like SymTable_remove, but the key is the uLength bytes at pcKey,
+which need not be followed by '\0' but must not contain it. */
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength);
+
+/*--------------------------------------------------------------------*/
+
 /* Apply function *pfApply to each binding in oSymTable, passing 
-pvExtra as an extra parameter. */
+pvExtra as an extra parameter. *pfApply may look up the bindings of
+oSymTable, unless it is a list that reorders them, but must not add or
+remove any. */
 
 void SymTable_map(SymTable_T oSymTable,
     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
@@ -80,4 +283,57 @@ void SymTable_map(SymTable_T oSymTable,
 
 /*--------------------------------------------------------------------*/
 
+/* A SymTableIter is a cursor over the bindings of a SymTable object.
+The caller allocates it, typically as a local variable, so iterating
+needs no memory. Its fields are private to the implementation. */
+
+struct SymTableIter
+{
+   /* The SymTable object. */
+   SymTable_T oSymTable;
+
+   /* The position within the SymTable object. */
+   size_t uIndex;
+
+   /* The number of bindings that the cursor has yet to visit. */
+   size_t uRemaining;
+
+   /* The binding at the cursor, or NULL before the first one. */
+   void *pvPosition;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Position *psIter before the first binding of oSymTable. Adding or
+removing a binding of oSymTable, or reserving or shrinking it, ends
+the iteration; looking up and replacing values does not, unless the
+table reorders its bindings on lookup. */
+
+void SymTable_iterBegin(SymTable_T oSymTable, struct SymTableIter *psIter);
+
+/*--------------------------------------------------------------------*/
+
+/* Advance *psIter to the next binding of its SymTable object. Return 1
+(TRUE) if there is one, or 0 (FALSE) once every binding has been
+visited. Bindings are visited in no particular order, and the caller
+may stop at any time. */
+
+int SymTable_iterNext(struct SymTableIter *psIter);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the key of the binding at *psIter, which SymTable_iterNext
+must have advanced to a binding. */
+
+const char *SymTable_iterKey(const struct SymTableIter *psIter);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the value of the binding at *psIter, which SymTable_iterNext
+must have advanced to a binding. */
+
+void *SymTable_iterValue(const struct SymTableIter *psIter);
+
+/*--------------------------------------------------------------------*/
+
 #endif
\ No newline at end of file
@@ -0,0 +1,1511 @@
+/*--------------------------------------------------------------------*/
+/* symtableart.c                                                      */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtableordered.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* The kinds of node.  An inner node of kind NODE_n has room for n
+   children, and changes kind as it gains or loses them. */
+enum {NODE_LEAF, NODE_4, NODE_16, NODE_48, NODE_256};
+
+/* The number of leading bytes of its compressed path that an inner
+   node stores.  Longer paths are read from a leaf below the node. */
+enum {MAX_PREFIX_SIZE = 8};
+
+/* The number of children below which an inner node shrinks to the
+   next smaller kind.  They lie below the capacity of that kind, so
+   that a node that gains and loses one child does not change kind
+   each time. */
+enum {SHRINK_256 = 37, SHRINK_48 = 12, SHRINK_16 = 3};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableNode begins every node of the adaptive radix tree.  Each
+   byte of a key selects one child of an inner node, and the bytes
+   that all keys below an inner node share are compressed into a path
+   kept in the node itself.  A key that has no sibling left is kept in
+   a leaf as high in the tree as it can be, so the tree is only as
+   deep as it needs to be to tell the keys apart.  Each key is followed
+   by its '\0', which no key contains, so that no key is a path to
+   another. */
+
+struct SymTableNode
+{
+   /* The kind of node. */
+   int iType;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableLeaf is a node that holds a binding. */
+
+struct SymTableLeaf
+{
+   /* The common part of all nodes. */
+   struct SymTableNode sNode;
+
+   /* The length of the key. */
+   size_t uLength;
+
+   /* The value. */
+   const void *pvValue;
+
+   /* The key, a defensive copy of the caller's key, and its '\0'. */
+   char acKey[];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableInner begins every inner node. */
+
+struct SymTableInner
+{
+   /* The common part of all nodes. */
+   struct SymTableNode sNode;
+
+   /* The number of children. */
+   int iCount;
+
+   /* The length of the compressed path, the bytes that every key
+      below the node shares after the bytes that select the node. */
+   size_t uPrefixLength;
+
+   /* The first MAX_PREFIX_SIZE bytes of the compressed path. */
+   unsigned char aucPrefix[MAX_PREFIX_SIZE];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableNode4 is an inner node with at most 4 children, kept in
+   ascending order of the bytes that select them. */
+
+struct SymTableNode4
+{
+   /* The common part of all inner nodes. */
+   struct SymTableInner sInner;
+
+   /* The bytes that select the children. */
+   unsigned char aucKeys[4];
+
+   /* The children. */
+   struct SymTableNode *apsChildren[4];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableNode16 is an inner node with at most 16 children, kept in
+   ascending order of the bytes that select them. */
+
+struct SymTableNode16
+{
+   /* The common part of all inner nodes. */
+   struct SymTableInner sInner;
+
+   /* The bytes that select the children. */
+   unsigned char aucKeys[16];
+
+   /* The children. */
+   struct SymTableNode *apsChildren[16];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableNode48 is an inner node with at most 48 children, which
+   a table of all bytes locates. */
+
+struct SymTableNode48
+{
+   /* The common part of all inner nodes. */
+   struct SymTableInner sInner;
+
+   /* For each byte, 1 more than the index of its child, or 0 if there
+      is none. */
+   unsigned char aucIndexes[256];
+
+   /* The children, in no particular order, with NULL in unused
+      slots. */
+   struct SymTableNode *apsChildren[48];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableNode256 is an inner node with a child for each byte. */
+
+struct SymTableNode256
+{
+   /* The common part of all inner nodes. */
+   struct SymTableInner sInner;
+
+   /* The child of each byte, or NULL if there is none. */
+   struct SymTableNode *apsChildren[256];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTable is a "dummy" node that points to the root of the tree
+and stores the number of bindings in the SymTable. */
+
+struct SymTable
+{
+   /* The root, or NULL while the SymTable is empty. */
+   struct SymTableNode *psRoot;
+
+   /* The number of bindings. */
+   size_t num;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return byte uDepth of the key of length uLength at pcKey, counting
+   the '\0' that follows it, which pcKey need not hold. */
+
+static unsigned char SymTable_keyByte(const char *pcKey, size_t uLength,
+                                      size_t uDepth)
+{
+   assert(pcKey != NULL);
+
+   if (uDepth >= uLength)
+      return 0;
+   return (unsigned char)pcKey[uDepth];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new leaf that binds a copy of the key of length uLength at
+   pcKey to pvValue, or NULL if insufficient memory is available. */
+
+static struct SymTableLeaf *SymTable_newLeaf(const char *pcKey,
+                                             size_t uLength,
+                                             const void *pvValue)
+{
+   struct SymTableLeaf *psLeaf;
+
+   assert(pcKey != NULL);
+
+   psLeaf = (struct SymTableLeaf*)
+      malloc(sizeof(struct SymTableLeaf) + uLength + 1);
+   if (psLeaf == NULL)
+      return NULL;
+
+   psLeaf->sNode.iType = NODE_LEAF;
+   psLeaf->uLength = uLength;
+   psLeaf->pvValue = pvValue;
+   memcpy(psLeaf->acKey, pcKey, uLength);
+   psLeaf->acKey[uLength] = '\0';
+   return psLeaf;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new inner node of kind iType with no children and no
+   compressed path, or NULL if insufficient memory is available. */
+
+static struct SymTableInner *SymTable_newInner(int iType)
+{
+   struct SymTableInner *psInner;
+   size_t uSize;
+
+   switch (iType)
+   {
+      case NODE_4:
+         uSize = sizeof(struct SymTableNode4);
+         break;
+      case NODE_16:
+         uSize = sizeof(struct SymTableNode16);
+         break;
+      case NODE_48:
+         uSize = sizeof(struct SymTableNode48);
+         break;
+      default:
+         assert(iType == NODE_256);
+         uSize = sizeof(struct SymTableNode256);
+         break;
+   }
+
+   /* Zeroed memory holds no children in every kind. */
+   psInner = (struct SymTableInner*)calloc(1, uSize);
+   if (psInner == NULL)
+      return NULL;
+
+   psInner->sNode.iType = iType;
+   return psInner;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the address of the slot of the child of psInner that byte
+   uc selects, or NULL if there is none. */
+
+static struct SymTableNode **SymTable_findChild(struct SymTableInner
+                                                *psInner,
+                                                unsigned char uc)
+{
+   struct SymTableNode4 *psNode4;
+   struct SymTableNode16 *psNode16;
+   struct SymTableNode48 *psNode48;
+   struct SymTableNode256 *psNode256;
+#if defined(__SSE2__)
+   unsigned int uMask;
+#endif
+   int i;
+
+   assert(psInner != NULL);
+
+   switch (psInner->sNode.iType)
+   {
+      case NODE_4:
+         psNode4 = (struct SymTableNode4*)psInner;
+         for (i = 0; i < psInner->iCount; i++)
+            if (psNode4->aucKeys[i] == uc)
+               return &psNode4->apsChildren[i];
+         return NULL;
+
+      case NODE_16:
+         psNode16 = (struct SymTableNode16*)psInner;
+#if defined(__SSE2__)
+         /* Compare all 16 bytes at once, ignoring unused ones. */
+         uMask = (unsigned int)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(
+               _mm_loadu_si128((const __m128i*)psNode16->aucKeys),
+               _mm_set1_epi8((char)uc)));
+         uMask &= (1u << psInner->iCount) - 1;
+         if (uMask == 0)
+            return NULL;
+         return &psNode16->apsChildren[__builtin_ctz(uMask)];
+#else
+         for (i = 0; i < psInner->iCount; i++)
+            if (psNode16->aucKeys[i] == uc)
+               return &psNode16->apsChildren[i];
+         return NULL;
+#endif
+
+      case NODE_48:
+         psNode48 = (struct SymTableNode48*)psInner;
+         i = psNode48->aucIndexes[uc];
+         if (i == 0)
+            return NULL;
+         return &psNode48->apsChildren[i - 1];
+
+      default:
+         assert(psInner->sNode.iType == NODE_256);
+         psNode256 = (struct SymTableNode256*)psInner;
+         if (psNode256->apsChildren[uc] == NULL)
+            return NULL;
+         return &psNode256->apsChildren[uc];
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the child of psInner whose selecting byte is the least that
+   is at least iByte, and store that byte in *piByte, or return NULL if
+   there is none.  iByte may be 256. */
+
+static struct SymTableNode *SymTable_nextChild(struct SymTableInner
+                                               *psInner,
+                                               int iByte, int *piByte)
+{
+   struct SymTableNode4 *psNode4;
+   struct SymTableNode16 *psNode16;
+   struct SymTableNode48 *psNode48;
+   struct SymTableNode256 *psNode256;
+   int i;
+
+   assert(psInner != NULL && piByte != NULL);
+
+   switch (psInner->sNode.iType)
+   {
+      case NODE_4:
+         psNode4 = (struct SymTableNode4*)psInner;
+         for (i = 0; i < psInner->iCount; i++)
+            if (psNode4->aucKeys[i] >= iByte)
+            {
+               *piByte = psNode4->aucKeys[i];
+               return psNode4->apsChildren[i];
+            }
+         return NULL;
+
+      case NODE_16:
+         psNode16 = (struct SymTableNode16*)psInner;
+         for (i = 0; i < psInner->iCount; i++)
+            if (psNode16->aucKeys[i] >= iByte)
+            {
+               *piByte = psNode16->aucKeys[i];
+               return psNode16->apsChildren[i];
+            }
+         return NULL;
+
+      case NODE_48:
+         psNode48 = (struct SymTableNode48*)psInner;
+         for (; iByte < 256; iByte++)
+            if (psNode48->aucIndexes[iByte] != 0)
+            {
+               *piByte = iByte;
+               return psNode48->apsChildren[
+                  psNode48->aucIndexes[iByte] - 1];
+            }
+         return NULL;
+
+      default:
+         assert(psInner->sNode.iType == NODE_256);
+         psNode256 = (struct SymTableNode256*)psInner;
+         for (; iByte < 256; iByte++)
+            if (psNode256->apsChildren[iByte] != NULL)
+            {
+               *piByte = iByte;
+               return psNode256->apsChildren[iByte];
+            }
+         return NULL;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the child of psInner whose selecting byte is the greatest. */
+
+static struct SymTableNode *SymTable_lastChild(struct SymTableInner
+                                               *psInner)
+{
+   struct SymTableNode48 *psNode48;
+   struct SymTableNode256 *psNode256;
+   int i;
+
+   assert(psInner != NULL && psInner->iCount > 0);
+
+   switch (psInner->sNode.iType)
+   {
+      case NODE_4:
+         return ((struct SymTableNode4*)psInner)
+            ->apsChildren[psInner->iCount - 1];
+
+      case NODE_16:
+         return ((struct SymTableNode16*)psInner)
+            ->apsChildren[psInner->iCount - 1];
+
+      case NODE_48:
+         psNode48 = (struct SymTableNode48*)psInner;
+         for (i = 255; psNode48->aucIndexes[i] == 0; i--)
+            ;
+         return psNode48->apsChildren[psNode48->aucIndexes[i] - 1];
+
+      default:
+         assert(psInner->sNode.iType == NODE_256);
+         psNode256 = (struct SymTableNode256*)psInner;
+         for (i = 255; psNode256->apsChildren[i] == NULL; i--)
+            ;
+         return psNode256->apsChildren[i];
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the leaf below psNode with the least key. */
+
+static struct SymTableLeaf *SymTable_minimum(struct SymTableNode *psNode)
+{
+   int iByte;
+
+   assert(psNode != NULL);
+
+   while (psNode->iType != NODE_LEAF)
+      psNode = SymTable_nextChild((struct SymTableInner*)psNode, 0,
+                                  &iByte);
+   return (struct SymTableLeaf*)psNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the leaf below psNode with the greatest key. */
+
+static struct SymTableLeaf *SymTable_maximum(struct SymTableNode *psNode)
+{
+   assert(psNode != NULL);
+
+   while (psNode->iType != NODE_LEAF)
+      psNode = SymTable_lastChild((struct SymTableInner*)psNode);
+   return (struct SymTableLeaf*)psNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the address of the whole compressed path of psInner, which
+   the keys below it begin at byte uDepth.  A path longer than
+   MAX_PREFIX_SIZE is read from the key of a leaf below psInner. */
+
+static const unsigned char *SymTable_prefix(struct SymTableInner
+                                            *psInner, size_t uDepth)
+{
+   assert(psInner != NULL);
+
+   if (psInner->uPrefixLength <= MAX_PREFIX_SIZE)
+      return psInner->aucPrefix;
+   return (const unsigned char*)
+      SymTable_minimum(&psInner->sNode)->acKey + uDepth;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bytes of the compressed path of psInner, which
+   begins at byte uDepth, that match the key of length uLength at
+   pcKey. */
+
+static size_t SymTable_matchPrefix(struct SymTableInner *psInner,
+                                   const char *pcKey, size_t uLength,
+                                   size_t uDepth)
+{
+   const unsigned char *pucPrefix;
+   size_t u;
+
+   assert(psInner != NULL && pcKey != NULL);
+
+   pucPrefix = SymTable_prefix(psInner, uDepth);
+   for (u = 0; u < psInner->uPrefixLength; u++)
+      if (pucPrefix[u] != SymTable_keyByte(pcKey, uLength, uDepth + u))
+         break;
+   return u;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add psChild to the inner node at *ppsLink as the child that byte uc
+   selects, which must have none.  If the node is full, replace it by
+   a node of the next larger kind.  Return 1 (TRUE) if successful, or
+   0 (FALSE) if insufficient memory is available, in which case leave
+   the node unchanged. */
+
+static int SymTable_addChild(struct SymTableNode **ppsLink,
+                             unsigned char uc,
+                             struct SymTableNode *psChild)
+{
+   struct SymTableInner *psInner;
+   struct SymTableInner *psGrown;
+   struct SymTableNode4 *psNode4;
+   struct SymTableNode16 *psNode16;
+   struct SymTableNode48 *psNode48;
+   struct SymTableNode48 *psGrown48;
+   struct SymTableNode256 *psGrown256;
+   int i;
+
+   assert(ppsLink != NULL && *ppsLink != NULL && psChild != NULL);
+
+   psInner = (struct SymTableInner*)*ppsLink;
+   assert(SymTable_findChild(psInner, uc) == NULL);
+
+   switch (psInner->sNode.iType)
+   {
+      case NODE_4:
+         psNode4 = (struct SymTableNode4*)psInner;
+         if (psInner->iCount < 4)
+         {
+            for (i = psInner->iCount; i > 0 && psNode4->aucKeys[i - 1] > uc;
+                 i--)
+            {
+               psNode4->aucKeys[i] = psNode4->aucKeys[i - 1];
+               psNode4->apsChildren[i] = psNode4->apsChildren[i - 1];
+            }
+            psNode4->aucKeys[i] = uc;
+            psNode4->apsChildren[i] = psChild;
+            psInner->iCount++;
+            return 1;
+         }
+         psGrown = SymTable_newInner(NODE_16);
+         if (psGrown == NULL)
+            return 0;
+         psNode16 = (struct SymTableNode16*)psGrown;
+         memcpy(psNode16->aucKeys, psNode4->aucKeys, 4);
+         memcpy(psNode16->apsChildren, psNode4->apsChildren,
+                4 * sizeof(struct SymTableNode*));
+         break;
+
+      case NODE_16:
+         psNode16 = (struct SymTableNode16*)psInner;
+         if (psInner->iCount < 16)
+         {
+            for (i = psInner->iCount;
+                 i > 0 && psNode16->aucKeys[i - 1] > uc; i--)
+            {
+               psNode16->aucKeys[i] = psNode16->aucKeys[i - 1];
+               psNode16->apsChildren[i] = psNode16->apsChildren[i - 1];
+            }
+            psNode16->aucKeys[i] = uc;
+            psNode16->apsChildren[i] = psChild;
+            psInner->iCount++;
+            return 1;
+         }
+         psGrown = SymTable_newInner(NODE_48);
+         if (psGrown == NULL)
+            return 0;
+         psGrown48 = (struct SymTableNode48*)psGrown;
+         for (i = 0; i < 16; i++)
+         {
+            psGrown48->aucIndexes[psNode16->aucKeys[i]] =
+               (unsigned char)(i + 1);
+            psGrown48->apsChildren[i] = psNode16->apsChildren[i];
+         }
+         break;
+
+      case NODE_48:
+         psNode48 = (struct SymTableNode48*)psInner;
+         if (psInner->iCount < 48)
+         {
+            for (i = 0; psNode48->apsChildren[i] != NULL; i++)
+               ;
+            psNode48->aucIndexes[uc] = (unsigned char)(i + 1);
+            psNode48->apsChildren[i] = psChild;
+            psInner->iCount++;
+            return 1;
+         }
+         psGrown = SymTable_newInner(NODE_256);
+         if (psGrown == NULL)
+            return 0;
+         psGrown256 = (struct SymTableNode256*)psGrown;
+         for (i = 0; i < 256; i++)
+            if (psNode48->aucIndexes[i] != 0)
+               psGrown256->apsChildren[i] =
+                  psNode48->apsChildren[psNode48->aucIndexes[i] - 1];
+         break;
+
+      default:
+         assert(psInner->sNode.iType == NODE_256);
+         ((struct SymTableNode256*)psInner)->apsChildren[uc] = psChild;
+         psInner->iCount++;
+         return 1;
+   }
+
+   /* The node was full and its children were copied to psGrown, which
+      has room for one more. */
+   psGrown->iCount = psInner->iCount;
+   psGrown->uPrefixLength = psInner->uPrefixLength;
+   memcpy(psGrown->aucPrefix, psInner->aucPrefix, MAX_PREFIX_SIZE);
+   free(psInner);
+   *ppsLink = &psGrown->sNode;
+   return SymTable_addChild(ppsLink, uc, psChild);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Replace the inner node at *ppsLink, which has a single child, by
+   that child, prepending the node's compressed path and the byte
+   that selects the child to the child's compressed path. */
+
+static void SymTable_collapse(struct SymTableNode **ppsLink)
+{
+   struct SymTableNode4 *psNode4;
+   struct SymTableInner *psChild;
+   unsigned char aucPrefix[MAX_PREFIX_SIZE];
+   size_t uLength;
+   size_t u;
+
+   assert(ppsLink != NULL && *ppsLink != NULL);
+   assert((*ppsLink)->iType == NODE_4);
+
+   psNode4 = (struct SymTableNode4*)*ppsLink;
+   assert(psNode4->sInner.iCount == 1);
+
+   /* A leaf holds its whole key and needs no path. */
+   if (psNode4->apsChildren[0]->iType != NODE_LEAF)
+   {
+      psChild = (struct SymTableInner*)psNode4->apsChildren[0];
+
+      /* Only the first MAX_PREFIX_SIZE bytes of the joined path are
+         stored, so the parts of it past them need not be known. */
+      uLength = psNode4->sInner.uPrefixLength;
+      memcpy(aucPrefix, psNode4->sInner.aucPrefix, MAX_PREFIX_SIZE);
+      if (uLength < MAX_PREFIX_SIZE)
+         aucPrefix[uLength] = psNode4->aucKeys[0];
+      for (u = 0; uLength + 1 + u < MAX_PREFIX_SIZE &&
+              u < psChild->uPrefixLength; u++)
+         aucPrefix[uLength + 1 + u] = psChild->aucPrefix[u];
+
+      psChild->uPrefixLength += uLength + 1;
+      memcpy(psChild->aucPrefix, aucPrefix, MAX_PREFIX_SIZE);
+   }
+
+   *ppsLink = psNode4->apsChildren[0];
+   free(psNode4);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the child that byte uc selects from the inner node at
+   *ppsLink.  If that leaves the node with few enough children, replace
+   it by a node of the next smaller kind, or by its child if it has
+   only one.  A node that cannot be replaced for lack of memory stays
+   as it is. */
+
+static void SymTable_removeChild(struct SymTableNode **ppsLink,
+                                 unsigned char uc)
+{
+   struct SymTableInner *psInner;
+   struct SymTableInner *psShrunk;
+   struct SymTableNode4 *psNode4;
+   struct SymTableNode16 *psNode16;
+   struct SymTableNode48 *psNode48;
+   struct SymTableNode256 *psNode256;
+   int iType;
+   int i;
+   int j;
+
+   assert(ppsLink != NULL && *ppsLink != NULL);
+
+   psInner = (struct SymTableInner*)*ppsLink;
+   iType = psInner->sNode.iType;
+   switch (iType)
+   {
+      case NODE_4:
+         psNode4 = (struct SymTableNode4*)psInner;
+         for (i = 0; psNode4->aucKeys[i] != uc; i++)
+            ;
+         memmove(&psNode4->aucKeys[i], &psNode4->aucKeys[i + 1],
+                 (size_t)(psInner->iCount - i - 1));
+         memmove(&psNode4->apsChildren[i], &psNode4->apsChildren[i + 1],
+                 (size_t)(psInner->iCount - i - 1)
+                 * sizeof(struct SymTableNode*));
+         psInner->iCount--;
+         if (psInner->iCount == 1)
+            SymTable_collapse(ppsLink);
+         return;
+
+      case NODE_16:
+         psNode16 = (struct SymTableNode16*)psInner;
+         for (i = 0; psNode16->aucKeys[i] != uc; i++)
+            ;
+         memmove(&psNode16->aucKeys[i], &psNode16->aucKeys[i + 1],
+                 (size_t)(psInner->iCount - i - 1));
+         memmove(&psNode16->apsChildren[i], &psNode16->apsChildren[i + 1],
+                 (size_t)(psInner->iCount - i - 1)
+                 * sizeof(struct SymTableNode*));
+         psInner->iCount--;
+         if (psInner->iCount > SHRINK_16)
+            return;
+         psShrunk = SymTable_newInner(NODE_4);
+         if (psShrunk == NULL)
+            return;
+         psNode4 = (struct SymTableNode4*)psShrunk;
+         memcpy(psNode4->aucKeys, psNode16->aucKeys,
+                (size_t)psInner->iCount);
+         memcpy(psNode4->apsChildren, psNode16->apsChildren,
+                (size_t)psInner->iCount * sizeof(struct SymTableNode*));
+         break;
+
+      case NODE_48:
+         psNode48 = (struct SymTableNode48*)psInner;
+         psNode48->apsChildren[psNode48->aucIndexes[uc] - 1] = NULL;
+         psNode48->aucIndexes[uc] = 0;
+         psInner->iCount--;
+         if (psInner->iCount > SHRINK_48)
+            return;
+         psShrunk = SymTable_newInner(NODE_16);
+         if (psShrunk == NULL)
+            return;
+         psNode16 = (struct SymTableNode16*)psShrunk;
+         for (i = 0, j = 0; i < 256; i++)
+            if (psNode48->aucIndexes[i] != 0)
+            {
+               psNode16->aucKeys[j] = (unsigned char)i;
+               psNode16->apsChildren[j] =
+                  psNode48->apsChildren[psNode48->aucIndexes[i] - 1];
+               j++;
+            }
+         break;
+
+      default:
+         assert(iType == NODE_256);
+         psNode256 = (struct SymTableNode256*)psInner;
+         psNode256->apsChildren[uc] = NULL;
+         psInner->iCount--;
+         if (psInner->iCount > SHRINK_256)
+            return;
+         psShrunk = SymTable_newInner(NODE_48);
+         if (psShrunk == NULL)
+            return;
+         psNode48 = (struct SymTableNode48*)psShrunk;
+         for (i = 0, j = 0; i < 256; i++)
+            if (psNode256->apsChildren[i] != NULL)
+            {
+               psNode48->aucIndexes[i] = (unsigned char)(j + 1);
+               psNode48->apsChildren[j] = psNode256->apsChildren[i];
+               j++;
+            }
+         break;
+   }
+
+   psShrunk->iCount = psInner->iCount;
+   psShrunk->uPrefixLength = psInner->uPrefixLength;
+   memcpy(psShrunk->aucPrefix, psInner->aucPrefix, MAX_PREFIX_SIZE);
+   free(psInner);
+   *ppsLink = &psShrunk->sNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free psNode and all of its descendants. */
+
+static void SymTable_freeNode(struct SymTableNode *psNode)
+{
+   struct SymTableNode *psChild;
+   int iByte;
+
+   assert(psNode != NULL);
+
+   if (psNode->iType != NODE_LEAF)
+      for (psChild = SymTable_nextChild((struct SymTableInner*)psNode, 0,
+                                        &iByte);
+           psChild != NULL;
+           psChild = SymTable_nextChild((struct SymTableInner*)psNode,
+                                        iByte + 1, &iByte))
+         SymTable_freeNode(psChild);
+   free(psNode);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the leaf of oSymTable whose key is the key of length uLength
+   at pcKey, or NULL if there is none. */
+
+static struct SymTableLeaf *SymTable_find(SymTable_T oSymTable,
+                                          const char *pcKey,
+                                          size_t uLength)
+{
+   struct SymTableNode *psNode;
+   struct SymTableInner *psInner;
+   struct SymTableNode **ppsChild;
+   struct SymTableLeaf *psLeaf;
+   size_t uDepth = 0;
+   size_t uStored;
+   size_t u;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   /* Check only the stored bytes of long compressed paths on the way
+      down, and the whole key once at the leaf. */
+   for (psNode = oSymTable->psRoot; psNode != NULL; psNode = *ppsChild)
+   {
+      if (psNode->iType == NODE_LEAF)
+      {
+         psLeaf = (struct SymTableLeaf*)psNode;
+         if (psLeaf->uLength != uLength ||
+             memcmp(psLeaf->acKey, pcKey, uLength) != 0)
+            return NULL;
+         return psLeaf;
+      }
+
+      psInner = (struct SymTableInner*)psNode;
+      uStored = psInner->uPrefixLength < MAX_PREFIX_SIZE ?
+         psInner->uPrefixLength : MAX_PREFIX_SIZE;
+      for (u = 0; u < uStored; u++)
+         if (psInner->aucPrefix[u] !=
+             SymTable_keyByte(pcKey, uLength, uDepth + u))
+            return NULL;
+      uDepth += psInner->uPrefixLength;
+
+      ppsChild = SymTable_findChild(psInner,
+                                    SymTable_keyByte(pcKey, uLength,
+                                                     uDepth));
+      if (ppsChild == NULL)
+         return NULL;
+      uDepth++;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the leaf of oSymTable whose key is the key of length uLength
+   at pcKey, first adding a leaf that binds that key to pvValue if
+   there is none.  Store 1 (TRUE) in *piAdded if the leaf is new, or 0
+   (FALSE) if not.  Return NULL if insufficient memory is available, in
+   which case oSymTable is unchanged. */
+
+static struct SymTableLeaf *SymTable_findOrAdd(SymTable_T oSymTable,
+                                               const char *pcKey,
+                                               size_t uLength,
+                                               const void *pvValue,
+                                               int *piAdded)
+{
+   struct SymTableNode **ppsLink;
+   struct SymTableNode **ppsChild;
+   struct SymTableLeaf *psLeaf;
+   struct SymTableLeaf *psOld;
+   struct SymTableInner *psInner;
+   struct SymTableInner *psSplit;
+   const unsigned char *pucPrefix;
+   unsigned char ucEdge;
+   size_t uDepth = 0;
+   size_t uMatched;
+   size_t u;
+
+   assert(oSymTable != NULL && pcKey != NULL && piAdded != NULL);
+
+   *piAdded = 0;
+   ppsLink = &oSymTable->psRoot;
+   for (;;)
+   {
+      if (*ppsLink == NULL)
+      {
+         psLeaf = SymTable_newLeaf(pcKey, uLength, pvValue);
+         if (psLeaf == NULL)
+            return NULL;
+         *ppsLink = &psLeaf->sNode;
+         break;
+      }
+
+      if ((*ppsLink)->iType == NODE_LEAF)
+      {
+         psOld = (struct SymTableLeaf*)*ppsLink;
+         if (psOld->uLength == uLength &&
+             memcmp(psOld->acKey, pcKey, uLength) == 0)
+            return psOld;
+
+         /* Split the leaf into a node whose path is the bytes that
+            the two keys share.  Their '\0's make them differ before
+            either ends. */
+         for (uMatched = 0;
+              (unsigned char)psOld->acKey[uDepth + uMatched] ==
+                 SymTable_keyByte(pcKey, uLength, uDepth + uMatched);
+              uMatched++)
+            ;
+         psSplit = SymTable_newInner(NODE_4);
+         psLeaf = SymTable_newLeaf(pcKey, uLength, pvValue);
+         if (psSplit == NULL || psLeaf == NULL)
+         {
+            free(psSplit);
+            free(psLeaf);
+            return NULL;
+         }
+         psSplit->uPrefixLength = uMatched;
+         memcpy(psSplit->aucPrefix, psOld->acKey + uDepth,
+                uMatched < MAX_PREFIX_SIZE ? uMatched : MAX_PREFIX_SIZE);
+         *ppsLink = &psSplit->sNode;
+         (void)SymTable_addChild(ppsLink,
+            (unsigned char)psOld->acKey[uDepth + uMatched], &psOld->sNode);
+         (void)SymTable_addChild(ppsLink,
+            SymTable_keyByte(pcKey, uLength, uDepth + uMatched),
+            &psLeaf->sNode);
+         break;
+      }
+
+      psInner = (struct SymTableInner*)*ppsLink;
+      uMatched = SymTable_matchPrefix(psInner, pcKey, uLength, uDepth);
+      if (uMatched < psInner->uPrefixLength)
+      {
+         /* Split the compressed path where the key leaves it.  The
+            node keeps the part of its path after the split. */
+         psSplit = SymTable_newInner(NODE_4);
+         psLeaf = SymTable_newLeaf(pcKey, uLength, pvValue);
+         if (psSplit == NULL || psLeaf == NULL)
+         {
+            free(psSplit);
+            free(psLeaf);
+            return NULL;
+         }
+         pucPrefix = SymTable_prefix(psInner, uDepth);
+         psSplit->uPrefixLength = uMatched;
+         memcpy(psSplit->aucPrefix, pucPrefix,
+                uMatched < MAX_PREFIX_SIZE ? uMatched : MAX_PREFIX_SIZE);
+         ucEdge = pucPrefix[uMatched];
+         psInner->uPrefixLength -= uMatched + 1;
+         u = psInner->uPrefixLength;
+         memmove(psInner->aucPrefix, pucPrefix + uMatched + 1,
+                 u < MAX_PREFIX_SIZE ? u : MAX_PREFIX_SIZE);
+
+         *ppsLink = &psSplit->sNode;
+         (void)SymTable_addChild(ppsLink, ucEdge, &psInner->sNode);
+         (void)SymTable_addChild(ppsLink,
+            SymTable_keyByte(pcKey, uLength, uDepth + uMatched),
+            &psLeaf->sNode);
+         break;
+      }
+
+      uDepth += psInner->uPrefixLength;
+      ppsChild = SymTable_findChild(psInner,
+                                    SymTable_keyByte(pcKey, uLength,
+                                                     uDepth));
+      if (ppsChild == NULL)
+      {
+         psLeaf = SymTable_newLeaf(pcKey, uLength, pvValue);
+         if (psLeaf == NULL)
+            return NULL;
+         if (! SymTable_addChild(ppsLink,
+                                 SymTable_keyByte(pcKey, uLength,
+                                                  uDepth),
+                                 &psLeaf->sNode))
+         {
+            free(psLeaf);
+            return NULL;
+         }
+         break;
+      }
+      ppsLink = ppsChild;
+      uDepth++;
+   }
+
+   oSymTable->num++;
+   *piAdded = 1;
+   return psLeaf;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+   SymTable_T oSymTable;
+
+   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->psRoot = NULL;
+   oSymTable->num = 0;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithOptions(const struct SymTableOptions *psOptions)
+{
+   /* A radix tree neither hashes nor reorders, so no option
+      applies. */
+   (void)psOptions;
+   return SymTable_new();
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+   /* A radix tree allocates its nodes as it grows, so there is no
+      room to reserve. */
+   (void)uCapacity;
+   return SymTable_new();
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount)
+{
+   assert(oSymTable != NULL);
+
+   (void)uCount;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_shrink(SymTable_T oSymTable)
+{
+   /* A radix tree shrinks its nodes as bindings are removed. */
+   assert(oSymTable != NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+
+   if (oSymTable->psRoot != NULL)
+      SymTable_freeNode(oSymTable->psRoot);
+   free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+   return oSymTable->num;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+                 const void *pvValue)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                  const void *pvValue)
+{
+   int iAdded;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   (void)SymTable_findOrAdd(oSymTable, pcKey, uLength, pvValue, &iAdded);
+   return iAdded;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+                       const void *pvValue)
+{
+   struct SymTableLeaf *psLeaf;
+   void *pvOldValue;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   psLeaf = SymTable_find(oSymTable, pcKey, strlen(pcKey));
+   if (psLeaf == NULL)
+      return NULL;
+
+   pvOldValue = (void*)psLeaf->pvValue;
+   psLeaf->pvValue = pvValue;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                      const void *pvValue)
+{
+   struct SymTableLeaf *psLeaf;
+   void *pvOldValue;
+   int iAdded;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   psLeaf = SymTable_findOrAdd(oSymTable, pcKey, strlen(pcKey), pvValue,
+                               &iAdded);
+   if (psLeaf == NULL || iAdded)
+      return NULL;
+
+   pvOldValue = (void*)psLeaf->pvValue;
+   psLeaf->pvValue = pvValue;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+const void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                               const void *pvValue)
+{
+   struct SymTableLeaf *psLeaf;
+   int iAdded;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   psLeaf = SymTable_findOrAdd(oSymTable, pcKey, strlen(pcKey), pvValue,
+                               &iAdded);
+   if (psLeaf == NULL)
+      return NULL;
+   return &psLeaf->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_find(oSymTable, pcKey, uLength) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+                    size_t uLength)
+{
+   struct SymTableLeaf *psLeaf;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   psLeaf = SymTable_find(oSymTable, pcKey, uLength);
+   if (psLeaf == NULL)
+      return NULL;
+   return (void*)psLeaf->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+                       size_t uCount, void **apvValues)
+{
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL && apvValues != NULL);
+
+   /* Each level of a descent depends on the one above, so there are
+      no independent memory accesses to overlap. */
+   for (u = 0; u < uCount; u++)
+      apvValues[u] = SymTable_get(oSymTable, apcKeys[u]);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+                         size_t uCount, const void **apvValues)
+{
+   size_t uAdded = 0;
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL && apvValues != NULL);
+
+   for (u = 0; u < uCount; u++)
+      uAdded += (size_t)SymTable_put(oSymTable, apcKeys[u], apvValues[u]);
+   return uAdded;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   struct SymTableNode **ppsLink;
+   struct SymTableNode **ppsParentLink = NULL;
+   struct SymTableInner *psInner;
+   struct SymTableLeaf *psLeaf;
+   void *pvOldValue;
+   unsigned char ucEdge = 0;
+   size_t uDepth = 0;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   ppsLink = &oSymTable->psRoot;
+   while (*ppsLink != NULL && (*ppsLink)->iType != NODE_LEAF)
+   {
+      psInner = (struct SymTableInner*)*ppsLink;
+      if (SymTable_matchPrefix(psInner, pcKey, uLength, uDepth)
+          < psInner->uPrefixLength)
+         return NULL;
+      uDepth += psInner->uPrefixLength;
+
+      ucEdge = SymTable_keyByte(pcKey, uLength, uDepth);
+      ppsParentLink = ppsLink;
+      ppsLink = SymTable_findChild(psInner, ucEdge);
+      if (ppsLink == NULL)
+         return NULL;
+      uDepth++;
+   }
+   if (*ppsLink == NULL)
+      return NULL;
+
+   psLeaf = (struct SymTableLeaf*)*ppsLink;
+   if (psLeaf->uLength != uLength ||
+       memcmp(psLeaf->acKey, pcKey, uLength) != 0)
+      return NULL;
+
+   pvOldValue = (void*)psLeaf->pvValue;
+   if (ppsParentLink == NULL)
+      oSymTable->psRoot = NULL;
+   else
+      SymTable_removeChild(ppsParentLink, ucEdge);
+   free(psLeaf);
+   oSymTable->num--;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each binding below psNode in ascending
+   key order, passing pvExtra as an extra parameter. */
+
+static void SymTable_mapNode(struct SymTableNode *psNode,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   struct SymTableLeaf *psLeaf;
+   struct SymTableNode *psChild;
+   int iByte;
+
+   assert(psNode != NULL && pfApply != NULL);
+
+   if (psNode->iType == NODE_LEAF)
+   {
+      psLeaf = (struct SymTableLeaf*)psNode;
+      (*pfApply)(psLeaf->acKey, (void*)psLeaf->pvValue, (void*)pvExtra);
+      return;
+   }
+
+   for (psChild = SymTable_nextChild((struct SymTableInner*)psNode, 0,
+                                     &iByte);
+        psChild != NULL;
+        psChild = SymTable_nextChild((struct SymTableInner*)psNode,
+                                     iByte + 1, &iByte))
+      SymTable_mapNode(psChild, pfApply, pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   assert(oSymTable != NULL && pfApply != NULL);
+
+   if (oSymTable->psRoot != NULL)
+      SymTable_mapNode(oSymTable->psRoot, pfApply, pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each binding below psNode whose key is
+   at least pcLow and less than pcHigh, in ascending key order, passing
+   pvExtra as an extra parameter.  A NULL pcLow or pcHigh leaves that
+   end of the range open.  Return 1 (TRUE) if a key below psNode is at
+   least pcHigh, so that no later key is in the range, or 0 (FALSE) if
+   not. */
+
+static int SymTable_mapRangeNode(struct SymTableNode *psNode,
+    const char *pcLow, const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   struct SymTableNode *psChild;
+   const char *pcMin;
+   const char *pcMax;
+   int iByte;
+
+   assert(psNode != NULL && pfApply != NULL);
+
+   /* Skip a subtree that lies wholly below the range, and visit one
+      that lies wholly within it without further comparisons. */
+   pcMin = SymTable_minimum(psNode)->acKey;
+   pcMax = SymTable_maximum(psNode)->acKey;
+   if (pcHigh != NULL && strcmp(pcMin, pcHigh) >= 0)
+      return 1;
+   if (pcLow != NULL && strcmp(pcMax, pcLow) < 0)
+      return 0;
+   if ((pcLow == NULL || strcmp(pcMin, pcLow) >= 0) &&
+       (pcHigh == NULL || strcmp(pcMax, pcHigh) < 0))
+   {
+      SymTable_mapNode(psNode, pfApply, pvExtra);
+      return 0;
+   }
+
+   /* A leaf is decided by the comparisons above. */
+   assert(psNode->iType != NODE_LEAF);
+   for (psChild = SymTable_nextChild((struct SymTableInner*)psNode, 0,
+                                     &iByte);
+        psChild != NULL;
+        psChild = SymTable_nextChild((struct SymTableInner*)psNode,
+                                     iByte + 1, &iByte))
+      if (SymTable_mapRangeNode(psChild, pcLow, pcHigh, pfApply,
+                                pvExtra))
+         return 1;
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+    const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   assert(oSymTable != NULL && pfApply != NULL);
+
+   if (oSymTable->psRoot != NULL)
+      (void)SymTable_mapRangeNode(oSymTable->psRoot, pcLow, pcHigh,
+                                  pfApply, pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   struct SymTableNode *psNode;
+   struct SymTableNode **ppsChild;
+   struct SymTableInner *psInner;
+   struct SymTableLeaf *psLeaf;
+   const unsigned char *pucPrefix;
+   size_t uLength;
+   size_t uDepth = 0;
+   size_t u;
+
+   assert(oSymTable != NULL && pcPrefix != NULL && pfApply != NULL);
+
+   /* Follow pcPrefix down to the node below which every key begins
+      with it. */
+   uLength = strlen(pcPrefix);
+   psNode = oSymTable->psRoot;
+   while (psNode != NULL && psNode->iType != NODE_LEAF)
+   {
+      psInner = (struct SymTableInner*)psNode;
+      pucPrefix = SymTable_prefix(psInner, uDepth);
+      for (u = 0; u < psInner->uPrefixLength && uDepth + u < uLength;
+           u++)
+         if (pucPrefix[u] != (unsigned char)pcPrefix[uDepth + u])
+            return;
+      uDepth += psInner->uPrefixLength;
+      if (uDepth >= uLength)
+         break;
+
+      ppsChild = SymTable_findChild(psInner,
+                                    (unsigned char)pcPrefix[uDepth]);
+      if (ppsChild == NULL)
+         return;
+      psNode = *ppsChild;
+      uDepth++;
+   }
+   if (psNode == NULL)
+      return;
+
+   if (psNode->iType == NODE_LEAF)
+   {
+      psLeaf = (struct SymTableLeaf*)psNode;
+      if (psLeaf->uLength < uLength ||
+          memcmp(psLeaf->acKey, pcPrefix, uLength) != 0)
+         return;
+   }
+   SymTable_mapNode(psNode, pfApply, pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the leaf below psNode with the least key that is greater
+   than pcKey, or NULL if there is none.  The keys below psNode match
+   pcKey in their first uDepth bytes. */
+
+static struct SymTableLeaf *SymTable_successor(struct SymTableNode
+                                               *psNode,
+                                               const char *pcKey,
+                                               size_t uLength,
+                                               size_t uDepth)
+{
+   struct SymTableInner *psInner;
+   struct SymTableNode **ppsChild;
+   struct SymTableNode *psChild;
+   struct SymTableLeaf *psLeaf;
+   const unsigned char *pucPrefix;
+   unsigned char ucKey;
+   int iByte;
+   size_t u;
+
+   assert(psNode != NULL && pcKey != NULL);
+
+   if (psNode->iType == NODE_LEAF)
+   {
+      psLeaf = (struct SymTableLeaf*)psNode;
+      return strcmp(psLeaf->acKey, pcKey) > 0 ? psLeaf : NULL;
+   }
+
+   /* If the compressed path departs from pcKey, every key below the
+      node lies on one side of it. */
+   psInner = (struct SymTableInner*)psNode;
+   pucPrefix = SymTable_prefix(psInner, uDepth);
+   for (u = 0; u < psInner->uPrefixLength; u++)
+   {
+      ucKey = SymTable_keyByte(pcKey, uLength, uDepth + u);
+      if (pucPrefix[u] != ucKey)
+         return pucPrefix[u] > ucKey ? SymTable_minimum(psNode) : NULL;
+   }
+   uDepth += psInner->uPrefixLength;
+
+   ucKey = SymTable_keyByte(pcKey, uLength, uDepth);
+   ppsChild = SymTable_findChild(psInner, ucKey);
+   if (ppsChild != NULL)
+   {
+      psLeaf = SymTable_successor(*ppsChild, pcKey, uLength, uDepth + 1);
+      if (psLeaf != NULL)
+         return psLeaf;
+   }
+   psChild = SymTable_nextChild(psInner, ucKey + 1, &iByte);
+   if (psChild == NULL)
+      return NULL;
+   return SymTable_minimum(psChild);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_iterBegin(SymTable_T oSymTable, struct SymTableIter *psIter)
+{
+   assert(oSymTable != NULL && psIter != NULL);
+
+   psIter->oSymTable = oSymTable;
+   psIter->uIndex = 0;
+   psIter->uRemaining = oSymTable->num;
+   psIter->pvPosition = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_iterNext(struct SymTableIter *psIter)
+{
+   struct SymTableLeaf *psLeaf;
+
+   assert(psIter != NULL && psIter->oSymTable != NULL);
+
+   if (psIter->uRemaining == 0)
+      return 0;
+
+   /* Bindings are visited in ascending key order.  The nodes do not
+      record their parents, so each step searches from the root for
+      the least key after the current one. */
+   psLeaf = (struct SymTableLeaf*)psIter->pvPosition;
+   if (psLeaf == NULL)
+      psLeaf = SymTable_minimum(psIter->oSymTable->psRoot);
+   else
+      psLeaf = SymTable_successor(psIter->oSymTable->psRoot,
+                                  psLeaf->acKey, psLeaf->uLength, 0);
+   assert(psLeaf != NULL);
+
+   psIter->uRemaining--;
+   psIter->pvPosition = psLeaf;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *SymTable_iterKey(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   return ((const struct SymTableLeaf*)psIter->pvPosition)->acKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_iterValue(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   return (void*)((const struct SymTableLeaf*)psIter->pvPosition)
+      ->pvValue;
+}
@@ -0,0 +1,848 @@
+/*--------------------------------------------------------------------*/
+/* symtableconc.c                                                     */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+/* A SymTable that many threads may use at once.  Every function except
+   SymTable_free and the SymTable_iter functions may be called
+   concurrently with any other; SymTable_free and iteration require
+   that no other thread uses the table.  The function that SymTable_map
+   applies may only look bindings up, since the map holds a stripe
+   lock that any change to the table would wait for. */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "symtable.h"
+#include "strhash.h"
+#include "stripe.h"
+
+#if ! defined(__GNUC__)
+#error "symtableconc.c needs the GCC __atomic builtins and __thread"
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* The default maximum number of bindings per bucket. */
+static const double DEFAULT_MAX_LOAD_FACTOR = 1.0;
+
+/* The table that the calling thread is mapping, or NULL, so that a
+   debug build can catch a change made from within the map. */
+static __thread SymTable_T oMappedTable = NULL;
+
+/*--------------------------------------------------------------------*/
+
+/* Each key and value is stored in a SymTableNode.  SymTableNodes are
+   linked to form a list.  The key is stored inline at the end of its
+   SymTableNode, so a node and its key take a single allocation.  */
+
+struct SymTableNode
+{
+   /* The value. */
+   const void *pvValue;
+
+   /* The full-width hash code of the key. */
+   size_t uHash;
+
+   /* The length of the key. */
+   size_t uLength;
+
+   /* The address of the next SymtableNode. */
+   struct SymTableNode *psNextNode;
+
+   /* The key, a defensive copy of the caller's key. */
+   char acKey[];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableStripe guards every bucket whose index is congruent to its
+   own index modulo STRIPE_COUNT.  While the table resizes, some
+   stripes have moved their buckets to the new bucket array and others
+   have not, so each stripe records which array holds its buckets. */
+
+struct SymTableStripe
+{
+   /* The lock that readers of the stripe's buckets share and writers
+      hold alone. */
+   pthread_rwlock_t sLock;
+
+   /* The bucket array that holds the stripe's buckets. */
+   struct SymTableNode **psBuckets;
+
+   /* The number of buckets in that array. */
+   size_t uBucketCount;
+
+   /* Unused space that keeps the next stripe's lock off this stripe's
+      cache line. */
+   char acPadding[STRIPE_PADDING_SIZE];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTable is an array of buckets divided among lock stripes.  Only
+   one thread at a time resizes it, moving one stripe at a time to the
+   new bucket array, so readers of the other stripes never wait. */
+
+struct SymTable
+{
+   /* The stripes. */
+   struct SymTableStripe asStripes[STRIPE_COUNT];
+
+   /* The lock held by the thread that resizes the table.  It guards
+      psBuckets, uBucketCount and every write to uExpandAt. */
+   pthread_mutex_t sResizeLock;
+
+   /* The bucket array of the most recent resize. */
+   struct SymTableNode **psBuckets;
+
+   /* The number of buckets, a power of two. */
+   size_t uBucketCount;
+
+   /* The maximum number of bindings per bucket. */
+   double dMaxLoadFactor;
+
+   /* The number of bindings at which the bucket array grows, read and
+      written atomically. */
+   size_t uExpandAt;
+
+   /* The hash function. */
+   StrHash_T pfHash;
+
+   /* The seed of the hash function. */
+   size_t uSeed;
+
+   /* The number of bindings, read and written atomically. */
+   size_t num;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash code of the key of length uLength at pcKey under the
+   hash function and seed of oSymTable. */
+
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+                            size_t uLength)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return (*oSymTable->pfHash)(pcKey, uLength, oSymTable->uSeed);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the stripe of oSymTable that guards keys whose hash code is
+   uHash. */
+
+static struct SymTableStripe *SymTable_stripeOf(SymTable_T oSymTable,
+                                               size_t uHash)
+{
+   assert(oSymTable != NULL);
+
+   return &oSymTable->asStripes[uHash & (STRIPE_COUNT - 1)];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Search the stripe psStripe, which the caller has locked, for the
+   node whose key is pcKey, whose hash code is uHash and whose length is
+   uLength.  Return the address of the link (the bucket itself or a
+   psNextNode field) that points to that node, or NULL if there is no
+   such node. */
+
+static struct SymTableNode **SymTable_findLink(
+   struct SymTableStripe *psStripe, const char *pcKey, size_t uHash,
+   size_t uLength)
+{
+   struct SymTableNode **ppsLink;
+   struct SymTableNode *psNode;
+
+   assert(psStripe != NULL && pcKey != NULL);
+
+   ppsLink = &psStripe->psBuckets[uHash & (psStripe->uBucketCount - 1)];
+   for (psNode = *ppsLink; psNode != NULL; psNode = *ppsLink)
+   {
+      if (psNode->uHash == uHash && psNode->uLength == uLength &&
+          memcmp(psNode->acKey, pcKey, uLength) == 0)
+         return ppsLink;
+      ppsLink = &psNode->psNextNode;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move every node of stripe iStripe of oSymTable, which the caller has
+   locked for writing, to psNewBuckets, an array of uNewCount
+   buckets, and make it the stripe's bucket array. */
+
+static void SymTable_moveStripe(SymTable_T oSymTable, int iStripe,
+                                struct SymTableNode **psNewBuckets,
+                                size_t uNewCount)
+{
+   struct SymTableStripe *psStripe;
+   struct SymTableNode *psNode;
+   struct SymTableNode *psNextNode;
+   size_t uIndex;
+   size_t u;
+
+   assert(oSymTable != NULL && psNewBuckets != NULL);
+
+   psStripe = &oSymTable->asStripes[iStripe];
+   for (u = (size_t)iStripe; u < psStripe->uBucketCount;
+        u += STRIPE_COUNT)
+      for (psNode = psStripe->psBuckets[u]; psNode != NULL;
+           psNode = psNextNode)
+      {
+         psNextNode = psNode->psNextNode;
+         uIndex = psNode->uHash & (uNewCount - 1);
+         psNode->psNextNode = psNewBuckets[uIndex];
+         psNewBuckets[uIndex] = psNode;
+      }
+
+   psStripe->psBuckets = psNewBuckets;
+   psStripe->uBucketCount = uNewCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Give the SymTable pvTable, whose resize lock the caller holds, a
+   bucket array of uNewCount buckets, which may be more or fewer than
+   it has now.  Lock one stripe at a time, so that every other stripe
+   stays available while its buckets wait to move or after they have
+   moved.  Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient
+   memory is available, in which case leave the table unchanged. */
+
+static int SymTable_resize(void *pvTable, size_t uNewCount)
+{
+   SymTable_T oSymTable = (SymTable_T)pvTable;
+   struct SymTableNode **psNewBuckets;
+   int i;
+
+   assert(oSymTable != NULL && uNewCount >= STRIPE_COUNT);
+
+   psNewBuckets = (struct SymTableNode**)
+      calloc(uNewCount, sizeof(struct SymTableNode*));
+   if (psNewBuckets == NULL)
+      return 0;
+
+   for (i = 0; i < STRIPE_COUNT; i++)
+   {
+      pthread_rwlock_wrlock(&oSymTable->asStripes[i].sLock);
+      SymTable_moveStripe(oSymTable, i, psNewBuckets, uNewCount);
+      pthread_rwlock_unlock(&oSymTable->asStripes[i].sLock);
+   }
+
+   /* No stripe refers to the old bucket array any more, and every
+      reader of it held a stripe lock, so none remains. */
+   free(oSymTable->psBuckets);
+   oSymTable->psBuckets = psNewBuckets;
+   oSymTable->uBucketCount = uNewCount;
+   Stripe_store(&oSymTable->uExpandAt,
+                Stripe_expandAt(uNewCount, oSymTable->dMaxLoadFactor));
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count a binding just added to oSymTable, and grow oSymTable if that
+   takes it past its expansion threshold.  The caller must hold no
+   stripe lock. */
+
+static void SymTable_countAdded(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+
+   if (Stripe_add(&oSymTable->num, 1) >
+       Stripe_load(&oSymTable->uExpandAt))
+      Stripe_grow(&oSymTable->sResizeLock, &oSymTable->num,
+                  &oSymTable->uExpandAt, &oSymTable->uBucketCount,
+                  SymTable_resize, oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new node holding the key of length uLength at pcKey, whose
+   hash code is uHash, and value pvValue, or NULL if insufficient
+   memory is available. */
+
+static struct SymTableNode *SymTable_newNode(const char *pcKey,
+                                             size_t uHash,
+                                             size_t uLength,
+                                             const void *pvValue)
+{
+   struct SymTableNode *psNode;
+
+   assert(pcKey != NULL);
+
+   psNode = (struct SymTableNode*)
+      malloc(sizeof(struct SymTableNode) + uLength + 1);
+   if (psNode == NULL)
+      return NULL;
+
+   /* Make a defensive copy of pcKey, which need not end in '\0'. */
+   memcpy(psNode->acKey, pcKey, uLength);
+   psNode->acKey[uLength] = '\0';
+   psNode->pvValue = pvValue;
+   psNode->uHash = uHash;
+   psNode->uLength = uLength;
+   psNode->psNextNode = NULL;
+   return psNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the node of oSymTable whose key is the uLength bytes at
+   pcKey, first adding a node with value pvValue if there is none.
+   Set *piAdded to 1 (TRUE) if a node was added, or to 0 (FALSE)
+   otherwise.  Return NULL if insufficient memory is available. */
+
+static struct SymTableNode *SymTable_findOrAdd(SymTable_T oSymTable,
+                                               const char *pcKey,
+                                               size_t uLength,
+                                               const void *pvValue,
+                                               int *piAdded)
+{
+   struct SymTableStripe *psStripe;
+   struct SymTableNode **ppsLink;
+   struct SymTableNode **ppsBucket;
+   struct SymTableNode *psNode;
+   size_t uHash;
+
+   assert(oSymTable != NULL && pcKey != NULL && piAdded != NULL);
+   assert(oMappedTable != oSymTable);
+
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   psStripe = SymTable_stripeOf(oSymTable, uHash);
+   *piAdded = 0;
+
+   pthread_rwlock_wrlock(&psStripe->sLock);
+   ppsLink = SymTable_findLink(psStripe, pcKey, uHash, uLength);
+   if (ppsLink != NULL)
+      psNode = *ppsLink;
+   else
+   {
+      psNode = SymTable_newNode(pcKey, uHash, uLength, pvValue);
+      if (psNode != NULL)
+      {
+         ppsBucket = &psStripe->psBuckets[uHash
+                                          & (psStripe->uBucketCount - 1)];
+         psNode->psNextNode = *ppsBucket;
+         *ppsBucket = psNode;
+         *piAdded = 1;
+      }
+   }
+   pthread_rwlock_unlock(&psStripe->sLock);
+
+   if (*piAdded)
+      SymTable_countAdded(oSymTable);
+   return psNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look up the binding of oSymTable whose key is the uLength bytes at
+   pcKey.  Return 1 (TRUE) and store its value in *ppvValue if there is
+   one.  Otherwise return 0 (FALSE). */
+
+static int SymTable_lookup(SymTable_T oSymTable, const char *pcKey,
+                           size_t uLength, void **ppvValue)
+{
+   struct SymTableStripe *psStripe;
+   struct SymTableNode **ppsLink;
+   size_t uHash;
+
+   assert(oSymTable != NULL && pcKey != NULL && ppvValue != NULL);
+
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   psStripe = SymTable_stripeOf(oSymTable, uHash);
+
+   pthread_rwlock_rdlock(&psStripe->sLock);
+   ppsLink = SymTable_findLink(psStripe, pcKey, uHash, uLength);
+   if (ppsLink != NULL)
+      *ppvValue = (void*)(*ppsLink)->pvValue;
+   pthread_rwlock_unlock(&psStripe->sLock);
+
+   return ppsLink != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+   return SymTable_newWithOptions(NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithOptions(const struct SymTableOptions *psOptions)
+{
+   SymTable_T oSymTable;
+   int i;
+
+   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->dMaxLoadFactor = DEFAULT_MAX_LOAD_FACTOR;
+   oSymTable->pfHash = StrHash_forOption(SYMTABLE_HASH_DEFAULT);
+   oSymTable->uBucketCount = STRIPE_COUNT;
+   if (psOptions != NULL)
+   {
+      if (psOptions->dMaxLoadFactor > 0.0)
+         oSymTable->dMaxLoadFactor = psOptions->dMaxLoadFactor;
+      oSymTable->pfHash = StrHash_forOption(psOptions->eHash);
+      if (psOptions->uCapacity > 0)
+         oSymTable->uBucketCount = Stripe_bucketCountFor(
+            psOptions->uCapacity, oSymTable->dMaxLoadFactor);
+   }
+   if (psOptions != NULL && psOptions->iFixedSeed)
+      oSymTable->uSeed = psOptions->uSeed;
+   else
+      oSymTable->uSeed = StrHash_randomSeed();
+
+   oSymTable->psBuckets = (struct SymTableNode**)
+      calloc(oSymTable->uBucketCount, sizeof(struct SymTableNode*));
+   if (oSymTable->psBuckets == NULL)
+   {
+      free(oSymTable);
+      return NULL;
+   }
+
+   pthread_mutex_init(&oSymTable->sResizeLock, NULL);
+   for (i = 0; i < STRIPE_COUNT; i++)
+   {
+      pthread_rwlock_init(&oSymTable->asStripes[i].sLock, NULL);
+      oSymTable->asStripes[i].psBuckets = oSymTable->psBuckets;
+      oSymTable->asStripes[i].uBucketCount = oSymTable->uBucketCount;
+   }
+   oSymTable->uExpandAt = Stripe_expandAt(oSymTable->uBucketCount,
+                                          oSymTable->dMaxLoadFactor);
+   oSymTable->num = 0;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+   struct SymTableOptions sOptions;
+
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.uCapacity = uCapacity;
+   return SymTable_newWithOptions(&sOptions);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount)
+{
+   size_t uNewCount;
+   int iSuccessful = 1;
+
+   assert(oSymTable != NULL);
+   assert(oMappedTable != oSymTable);
+
+   pthread_mutex_lock(&oSymTable->sResizeLock);
+   if (uCount > oSymTable->uExpandAt)
+   {
+      uNewCount = Stripe_bucketCountFor(uCount,
+                                        oSymTable->dMaxLoadFactor);
+      if (uNewCount > oSymTable->uBucketCount)
+         iSuccessful = SymTable_resize(oSymTable, uNewCount);
+   }
+   pthread_mutex_unlock(&oSymTable->sResizeLock);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_shrink(SymTable_T oSymTable)
+{
+   size_t uNewCount;
+
+   assert(oSymTable != NULL);
+   assert(oMappedTable != oSymTable);
+
+   pthread_mutex_lock(&oSymTable->sResizeLock);
+   uNewCount = Stripe_bucketCountFor(Stripe_load(&oSymTable->num),
+                                     oSymTable->dMaxLoadFactor);
+   if (uNewCount < oSymTable->uBucketCount)
+      (void)SymTable_resize(oSymTable, uNewCount);
+   pthread_mutex_unlock(&oSymTable->sResizeLock);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+   struct SymTableNode *psNode;
+   struct SymTableNode *psNextNode;
+   size_t u;
+   int i;
+
+   if (oSymTable == NULL)
+      return;
+
+   for (u = 0; u < oSymTable->uBucketCount; u++)
+      for (psNode = oSymTable->psBuckets[u]; psNode != NULL;
+           psNode = psNextNode)
+      {
+         psNextNode = psNode->psNextNode;
+         free(psNode);
+      }
+
+   for (i = 0; i < STRIPE_COUNT; i++)
+      pthread_rwlock_destroy(&oSymTable->asStripes[i].sLock);
+   pthread_mutex_destroy(&oSymTable->sResizeLock);
+   free(oSymTable->psBuckets);
+   free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+
+   return Stripe_load(&oSymTable->num);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+                 const void *pvValue)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                  const void *pvValue)
+{
+   int iAdded;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   (void)SymTable_findOrAdd(oSymTable, pcKey, uLength, pvValue, &iAdded);
+   return iAdded;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+                       const void *pvValue)
+{
+   struct SymTableStripe *psStripe;
+   struct SymTableNode **ppsLink;
+   void *pvOldValue = NULL;
+   size_t uHash;
+   size_t uLength;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+   assert(oMappedTable != oSymTable);
+
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   psStripe = SymTable_stripeOf(oSymTable, uHash);
+
+   pthread_rwlock_wrlock(&psStripe->sLock);
+   ppsLink = SymTable_findLink(psStripe, pcKey, uHash, uLength);
+   if (ppsLink != NULL)
+   {
+      pvOldValue = (void*)(*ppsLink)->pvValue;
+      (*ppsLink)->pvValue = pvValue;
+   }
+   pthread_rwlock_unlock(&psStripe->sLock);
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                      const void *pvValue)
+{
+   struct SymTableStripe *psStripe;
+   struct SymTableNode **ppsLink;
+   struct SymTableNode **ppsBucket;
+   struct SymTableNode *psNode;
+   void *pvOldValue = NULL;
+   size_t uHash;
+   size_t uLength;
+   int iAdded = 0;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+   assert(oMappedTable != oSymTable);
+
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   psStripe = SymTable_stripeOf(oSymTable, uHash);
+
+   pthread_rwlock_wrlock(&psStripe->sLock);
+   ppsLink = SymTable_findLink(psStripe, pcKey, uHash, uLength);
+   if (ppsLink != NULL)
+   {
+      pvOldValue = (void*)(*ppsLink)->pvValue;
+      (*ppsLink)->pvValue = pvValue;
+   }
+   else
+   {
+      psNode = SymTable_newNode(pcKey, uHash, uLength, pvValue);
+      if (psNode != NULL)
+      {
+         ppsBucket = &psStripe->psBuckets[uHash
+                                          & (psStripe->uBucketCount - 1)];
+         psNode->psNextNode = *ppsBucket;
+         *ppsBucket = psNode;
+         iAdded = 1;
+      }
+   }
+   pthread_rwlock_unlock(&psStripe->sLock);
+
+   if (iAdded)
+      SymTable_countAdded(oSymTable);
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+const void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                               const void *pvValue)
+{
+   struct SymTableNode *psNode;
+   int iAdded;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   psNode = SymTable_findOrAdd(oSymTable, pcKey, strlen(pcKey), pvValue,
+                               &iAdded);
+   if (psNode == NULL)
+      return NULL;
+   return &psNode->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   void *pvValue;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_lookup(oSymTable, pcKey, uLength, &pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+                    size_t uLength)
+{
+   void *pvValue;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (! SymTable_lookup(oSymTable, pcKey, uLength, &pvValue))
+      return NULL;
+   return pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+                       size_t uCount, void **apvValues)
+{
+   size_t u;
+
+   assert(oSymTable != NULL);
+   assert(apcKeys != NULL || uCount == 0);
+   assert(apvValues != NULL || uCount == 0);
+
+   for (u = 0; u < uCount; u++)
+      apvValues[u] = SymTable_get(oSymTable, apcKeys[u]);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+                         size_t uCount, const void **apvValues)
+{
+   size_t uAdded = 0;
+   size_t u;
+
+   assert(oSymTable != NULL);
+   assert(apcKeys != NULL || uCount == 0);
+   assert(apvValues != NULL || uCount == 0);
+
+   for (u = 0; u < uCount; u++)
+      uAdded += (size_t)SymTable_put(oSymTable, apcKeys[u], apvValues[u]);
+   return uAdded;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   struct SymTableStripe *psStripe;
+   struct SymTableNode **ppsLink;
+   struct SymTableNode *psNode = NULL;
+   void *pvValue = NULL;
+   size_t uHash;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+   assert(oMappedTable != oSymTable);
+
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   psStripe = SymTable_stripeOf(oSymTable, uHash);
+
+   pthread_rwlock_wrlock(&psStripe->sLock);
+   ppsLink = SymTable_findLink(psStripe, pcKey, uHash, uLength);
+   if (ppsLink != NULL)
+   {
+      psNode = *ppsLink;
+      *ppsLink = psNode->psNextNode;
+   }
+   pthread_rwlock_unlock(&psStripe->sLock);
+
+   if (psNode == NULL)
+      return NULL;
+   (void)Stripe_add(&oSymTable->num, (size_t)-1);
+   pvValue = (void*)psNode->pvValue;
+   free(psNode);
+   return pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   struct SymTableStripe *psStripe;
+   struct SymTableNode *psNode;
+   SymTable_T oOuterTable;
+   size_t u;
+   int i;
+
+   assert(oSymTable != NULL && pfApply != NULL);
+
+   /* Hold one stripe at a time, so that writers to other stripes
+      proceed.  *pfApply may look up bindings, which shares the stripe
+      lock, but must not change oSymTable in any way, even by
+      SymTable_replace, since a change waits for the lock to be free.
+      A map from within *pfApply restores the outer one's mark. */
+   oOuterTable = oMappedTable;
+   oMappedTable = oSymTable;
+   for (i = 0; i < STRIPE_COUNT; i++)
+   {
+      psStripe = &oSymTable->asStripes[i];
+      pthread_rwlock_rdlock(&psStripe->sLock);
+      for (u = (size_t)i; u < psStripe->uBucketCount; u += STRIPE_COUNT)
+         for (psNode = psStripe->psBuckets[u]; psNode != NULL;
+              psNode = psNode->psNextNode)
+            (*pfApply)(psNode->acKey, (void*)psNode->pvValue,
+                       (void*)pvExtra);
+      pthread_rwlock_unlock(&psStripe->sLock);
+   }
+   oMappedTable = oOuterTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_iterBegin(SymTable_T oSymTable, struct SymTableIter *psIter)
+{
+   assert(oSymTable != NULL && psIter != NULL);
+
+   psIter->oSymTable = oSymTable;
+   psIter->uIndex = 0;
+   psIter->uRemaining = Stripe_load(&oSymTable->num);
+   psIter->pvPosition = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_iterNext(struct SymTableIter *psIter)
+{
+   struct SymTableNode **psBuckets;
+   struct SymTableNode *psNode;
+   size_t uIndex;
+
+   assert(psIter != NULL && psIter->oSymTable != NULL);
+
+   if (psIter->uRemaining == 0)
+      return 0;
+
+   psNode = (struct SymTableNode*)psIter->pvPosition;
+   if (psNode != NULL && psNode->psNextNode != NULL)
+      psNode = psNode->psNextNode;
+   else
+   {
+      /* Some later bucket is nonempty, so the scan needs no bounds
+         check. */
+      psBuckets = psIter->oSymTable->psBuckets;
+      uIndex = psIter->uIndex;
+      if (psNode != NULL)
+         uIndex++;
+      while (psBuckets[uIndex] == NULL)
+         uIndex++;
+      assert(uIndex < psIter->oSymTable->uBucketCount);
+      psIter->uIndex = uIndex;
+      psNode = psBuckets[uIndex];
+   }
+
+   psIter->uRemaining--;
+   psIter->pvPosition = psNode;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *SymTable_iterKey(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   return ((const struct SymTableNode*)psIter->pvPosition)->acKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_iterValue(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   return (void*)((const struct SymTableNode*)psIter->pvPosition)->pvValue;
+}
@@ -0,0 +1,1233 @@
+/*--------------------------------------------------------------------*/
+/* symtablecuckoo.c                                                   */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "strhash.h"
+#include "prefetch.h"
+
+/*--------------------------------------------------------------------*/
+
+/* The number of slots in a bucket. */
+enum {BUCKET_SIZE = 4};
+
+/* The size, in bytes, of a cache line, on which buckets are
+   aligned. */
+enum {CACHE_LINE_SIZE = 64};
+
+/* The number of buckets in a new SymTable. */
+enum {INITIAL_BUCKET_COUNT = 2};
+
+/* The most buckets that a search for an eviction path examines. */
+enum {MAX_PATH_NODES = 256};
+
+/* The number of keys that a batch operation hashes and prefetches
+   before it resolves any of them. */
+enum {BATCH_SIZE = 16};
+
+/* The most entries that the overflow array may hold. */
+enum {MAX_STASH_COUNT = 8};
+
+/* The highest fraction of slots that may be filled.  With two
+   choices of four slots, eviction paths stay short up to about 0.95. */
+static const double MAX_LOAD_FACTOR = 0.9;
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableEntry holds a binding in one allocation, so that a lookup
+   that matches a tag reads the key and the value together. */
+
+struct SymTableEntry
+{
+   /* The hash code of the key, from which the entry's buckets are
+      found again when the table grows. */
+   size_t uHash;
+
+   /* The value. */
+   const void *pvValue;
+
+   /* The key, a defensive copy of the caller's key, and its '\0'. */
+   char acKey[];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableBucket holds BUCKET_SIZE slots in one cache line.  Each
+   slot has a 32-bit tag taken from its key's hash code, always odd, or
+   0 if the slot is empty, so that a lookup reads an entry only when
+   its tag matches. */
+
+struct SymTableBucket
+{
+   /* The tags of the slots. */
+   uint32_t auTags[BUCKET_SIZE];
+
+   /* The entries of the slots, or NULL in empty slots. */
+   struct SymTableEntry *apsEntries[BUCKET_SIZE];
+
+   /* Unused space that fills out the cache line. */
+   char acPadding[CACHE_LINE_SIZE - BUCKET_SIZE * sizeof(uint32_t)
+                  - BUCKET_SIZE * sizeof(struct SymTableEntry*)];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTablePathNode is a bucket that the search for an eviction path
+   reaches, and the step that reached it. */
+
+struct SymTablePathNode
+{
+   /* The index of the bucket. */
+   size_t uBucket;
+
+   /* The index of the node whose entry would move into this bucket,
+      or -1 for the new key's own buckets. */
+   int iParent;
+
+   /* The slot of that entry within the parent's bucket. */
+   int iSlot;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTable is an array of SymTableBuckets.  Each key may live in
+   either of two buckets: its home bucket, which the low bits of its
+   hash code select, and an alternate one, which is the home bucket
+   XORed with a mix of its tag.  Either bucket can be found from the
+   other and the tag alone, so entries move between their buckets
+   without reading their keys.  A lookup reads at most the two buckets
+   and the one entry whose tag matches.  An insertion into two full
+   buckets searches breadth first for a short path of entries that can
+   each move to their other bucket, and shifts them along it.  Keys
+   that no pair of buckets can take, because too many share their
+   hash codes, are kept in a small overflow array of at most
+   MAX_STASH_COUNT entries.  When it is full, the table rebuilds itself
+   under a new random seed, and under wyhash if the keys collided under
+   the multiplicative hash, whose collisions do not depend on the seed.
+   An insertion fails if even that leaves too many keys without a
+   place.  So a lookup reads at most two buckets and MAX_STASH_COUNT
+   overflow entries, whatever the keys. */
+
+struct SymTable
+{
+   /* The buckets, aligned on a cache line. */
+   struct SymTableBucket *psBuckets;
+
+   /* The memory block that holds the buckets. */
+   void *pvBlock;
+
+   /* The number of buckets, a power of two that is at least 2. */
+   size_t uBucketCount;
+
+   /* The overflow entries, at most MAX_STASH_COUNT of them. */
+   struct SymTableEntry **ppsStash;
+
+   /* The number of overflow entries. */
+   size_t uStashCount;
+
+   /* The number of overflow entries that ppsStash has room for. */
+   size_t uStashCapacity;
+
+   /* The maximum fraction of slots that may be filled. */
+   double dMaxLoadFactor;
+
+   /* The hash function. */
+   StrHash_T pfHash;
+
+   /* The seed of the hash function. */
+   size_t uSeed;
+
+   /* The number of bindings. */
+   size_t num;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash code for the key of length uLength at pcKey under
+   the hash function and seed of oSymTable. */
+
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+                            size_t uLength)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return (*oSymTable->pfHash)(pcKey, uLength, oSymTable->uSeed);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the tag of a key whose hash code is uHash.  The tag comes
+   from the high bits, which do not choose the home bucket, and is odd,
+   so that it differs from the tag of an empty slot. */
+
+static uint32_t SymTable_tagOf(size_t uHash)
+{
+   return (uint32_t)(uHash >> (sizeof(size_t) * 4)) | 1u;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the other bucket of a key whose tag is uTag and that may
+   live in bucket uBucket, in a table of uBucketCount buckets.  The
+   result differs from uBucket, and applying the function to it gives
+   uBucket back. */
+
+static size_t SymTable_altBucket(size_t uBucket, uint32_t uTag,
+                                 size_t uBucketCount)
+{
+   size_t uOffset;
+
+   assert(uBucketCount >= 2);
+
+   uOffset = (size_t)(uint32_t)(uTag * 0x5bd1e995u) & (uBucketCount - 1);
+   if (uOffset == 0)
+      uOffset = 1;
+   return uBucket ^ uOffset;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bindings oSymTable may hold in uBucketCount
+   buckets before it must grow, which is at least 1. */
+
+static size_t SymTable_maxLoad(SymTable_T oSymTable, size_t uBucketCount)
+{
+   size_t uMaxLoad;
+
+   assert(oSymTable != NULL);
+
+   uMaxLoad = (size_t)(oSymTable->dMaxLoadFactor
+                       * (double)(uBucketCount * BUCKET_SIZE));
+   if (uMaxLoad == 0)
+      uMaxLoad = 1;
+   return uMaxLoad;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the smallest bucket count, a power of two that is at least
+   INITIAL_BUCKET_COUNT, in which oSymTable may hold uCount
+   bindings. */
+
+static size_t SymTable_bucketCountFor(SymTable_T oSymTable,
+                                      size_t uCount)
+{
+   size_t uBucketCount = INITIAL_BUCKET_COUNT;
+
+   assert(oSymTable != NULL);
+
+   while (SymTable_maxLoad(oSymTable, uBucketCount) < uCount &&
+          uBucketCount <= ((size_t)-1) / sizeof(struct SymTableBucket) / 4)
+      uBucketCount *= 2;
+   return uBucketCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Allocate uBucketCount empty buckets aligned on a cache line.  Store
+   the buckets in *ppsBuckets and the block that holds them, which the
+   caller must free, in *ppvBlock.  Return 1 (TRUE) if successful, or 0
+   (FALSE) if insufficient memory is available. */
+
+static int SymTable_allocBuckets(size_t uBucketCount,
+                                 struct SymTableBucket **ppsBuckets,
+                                 void **ppvBlock)
+{
+   uintptr_t uAddress;
+
+   assert(ppsBuckets != NULL && ppvBlock != NULL);
+
+   /* Zeroed memory holds only empty slots. */
+   *ppvBlock = calloc(1, uBucketCount * sizeof(struct SymTableBucket)
+                      + CACHE_LINE_SIZE - 1);
+   if (*ppvBlock == NULL)
+      return 0;
+
+   uAddress = ((uintptr_t)*ppvBlock + CACHE_LINE_SIZE - 1)
+      & ~(uintptr_t)(CACHE_LINE_SIZE - 1);
+   *ppsBuckets = (struct SymTableBucket*)uAddress;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Search psBuckets, an array of uBucketCount buckets, for the shortest
+   path of entries that frees a slot in bucket uFirst or bucket
+   uSecond, each entry moving to its other bucket, and move the entries
+   along it.  Return the index of the bucket of uFirst and uSecond that
+   has a free slot and store that slot in *piSlot, or return
+   uBucketCount if no path was found.  Either way every entry stays in
+   one of its buckets. */
+
+static size_t SymTable_makeRoom(struct SymTableBucket *psBuckets,
+                                size_t uBucketCount, size_t uFirst,
+                                size_t uSecond, int *piSlot)
+{
+   struct SymTablePathNode asNodes[MAX_PATH_NODES];
+   struct SymTableBucket *psFrom;
+   struct SymTableBucket *psTo;
+   int iHead;
+   int iTail = 2;
+   int iNode;
+   int iParent;
+   int iFree;
+   int i;
+
+   assert(psBuckets != NULL && piSlot != NULL);
+
+   asNodes[0].uBucket = uFirst;
+   asNodes[0].iParent = -1;
+   asNodes[1].uBucket = uSecond;
+   asNodes[1].iParent = -1;
+
+   /* Search breadth first for a bucket with an empty slot. */
+   for (iHead = 0; iHead < iTail; iHead++)
+   {
+      psFrom = &psBuckets[asNodes[iHead].uBucket];
+      for (i = 0; i < BUCKET_SIZE; i++)
+         if (psFrom->apsEntries[i] == NULL)
+            break;
+      if (i < BUCKET_SIZE)
+         break;
+      for (i = 0; i < BUCKET_SIZE && iTail < MAX_PATH_NODES; i++)
+      {
+         asNodes[iTail].uBucket =
+            SymTable_altBucket(asNodes[iHead].uBucket,
+                               psFrom->auTags[i], uBucketCount);
+         asNodes[iTail].iParent = iHead;
+         asNodes[iTail].iSlot = i;
+         iTail++;
+      }
+   }
+   if (iHead == iTail)
+      return uBucketCount;
+
+   /* Move the entries along the path, last first, so that each moves
+      into the slot that the one after it has just left.  A bucket that
+      appears twice on the path may have changed since the search, so
+      check each move and give up on a stale path. */
+   iNode = iHead;
+   iFree = i;
+   while (asNodes[iNode].iParent >= 0)
+   {
+      iParent = asNodes[iNode].iParent;
+      psFrom = &psBuckets[asNodes[iParent].uBucket];
+      psTo = &psBuckets[asNodes[iNode].uBucket];
+      i = asNodes[iNode].iSlot;
+      if (psFrom->apsEntries[i] == NULL ||
+          psTo->apsEntries[iFree] != NULL ||
+          SymTable_altBucket(asNodes[iParent].uBucket, psFrom->auTags[i],
+                             uBucketCount) != asNodes[iNode].uBucket)
+         return uBucketCount;
+
+      psTo->auTags[iFree] = psFrom->auTags[i];
+      psTo->apsEntries[iFree] = psFrom->apsEntries[i];
+      psFrom->auTags[i] = 0;
+      psFrom->apsEntries[i] = NULL;
+      iFree = i;
+      iNode = iParent;
+   }
+
+   *piSlot = iFree;
+   return asNodes[iNode].uBucket;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Place psEntry in one of its two buckets within psBuckets, an array
+   of uBucketCount buckets, evicting other entries to their other
+   buckets if need be.  psEntry's key must not be present.  Return 1
+   (TRUE) if successful, or 0 (FALSE) if no room was found. */
+
+static int SymTable_place(struct SymTableBucket *psBuckets,
+                          size_t uBucketCount,
+                          struct SymTableEntry *psEntry)
+{
+   enum {MAX_ATTEMPT_COUNT = 4};
+   uint32_t uTag;
+   size_t uFirst;
+   size_t uSecond;
+   size_t uBucket;
+   int iAttempt;
+   int iSlot;
+
+   assert(psBuckets != NULL && psEntry != NULL);
+
+   uTag = SymTable_tagOf(psEntry->uHash);
+   uFirst = psEntry->uHash & (uBucketCount - 1);
+   uSecond = SymTable_altBucket(uFirst, uTag, uBucketCount);
+
+   /* A stale path leaves the entries valid, so the search can simply
+      start again. */
+   for (iAttempt = 0; iAttempt < MAX_ATTEMPT_COUNT; iAttempt++)
+   {
+      uBucket = SymTable_makeRoom(psBuckets, uBucketCount, uFirst,
+                                  uSecond, &iSlot);
+      if (uBucket != uBucketCount)
+      {
+         psBuckets[uBucket].auTags[iSlot] = uTag;
+         psBuckets[uBucket].apsEntries[iSlot] = psEntry;
+         return 1;
+      }
+   }
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append psEntry to the overflow array *pppsStash, which holds
+   *puCount entries and has room for *puCapacity.  Return 1 (TRUE) if
+   successful, or 0 (FALSE) if insufficient memory is available, in
+   which case the array is unchanged. */
+
+static int SymTable_stash(struct SymTableEntry ***pppsStash,
+                          size_t *puCount, size_t *puCapacity,
+                          struct SymTableEntry *psEntry)
+{
+   struct SymTableEntry **ppsNewStash;
+   size_t uNewCapacity;
+
+   assert(pppsStash != NULL && puCount != NULL && puCapacity != NULL);
+
+   if (*puCount == *puCapacity)
+   {
+      uNewCapacity = *puCapacity == 0 ? 4 : *puCapacity * 2;
+      ppsNewStash = (struct SymTableEntry**)
+         realloc(*pppsStash, uNewCapacity * sizeof(struct SymTableEntry*));
+      if (ppsNewStash == NULL)
+         return 0;
+      *pppsStash = ppsNewStash;
+      *puCapacity = uNewCapacity;
+   }
+   (*pppsStash)[(*puCount)++] = psEntry;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store in each entry of oSymTable the hash code of its key under
+   hash function pfHash and seed uSeed. */
+
+static void SymTable_hashEntries(SymTable_T oSymTable, StrHash_T pfHash,
+                                 size_t uSeed)
+{
+   struct SymTableEntry *psEntry;
+   size_t u;
+   int i;
+
+   assert(oSymTable != NULL && pfHash != NULL);
+
+   for (u = 0; u < oSymTable->uBucketCount + oSymTable->uStashCount; u++)
+   {
+      for (i = 0; i < BUCKET_SIZE; i++)
+      {
+         if (u < oSymTable->uBucketCount)
+            psEntry = oSymTable->psBuckets[u].apsEntries[i];
+         else if (i == 0)
+            psEntry = oSymTable->ppsStash[u - oSymTable->uBucketCount];
+         else
+            break;
+         if (psEntry != NULL)
+            psEntry->uHash =
+               (*pfHash)(psEntry->acKey, strlen(psEntry->acKey), uSeed);
+      }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Rebuild oSymTable with uBucketCount buckets under hash function
+   pfHash and seed uSeed.  Return 1 (TRUE) if successful, or 0 (FALSE)
+   if insufficient memory is available or more than MAX_STASH_COUNT
+   entries find no place, in which case oSymTable is unchanged. */
+
+static int SymTable_rebuild(SymTable_T oSymTable, size_t uBucketCount,
+                            StrHash_T pfHash, size_t uSeed)
+{
+   struct SymTableBucket *psNewBuckets;
+   struct SymTableEntry **ppsNewStash = NULL;
+   struct SymTableEntry *psEntry;
+   size_t uNewStashCount = 0;
+   size_t uNewStashCapacity = 0;
+   void *pvNewBlock;
+   int iNewHash;
+   size_t u;
+   int i;
+
+   assert(oSymTable != NULL && pfHash != NULL);
+
+   if (! SymTable_allocBuckets(uBucketCount, &psNewBuckets, &pvNewBlock))
+      return 0;
+   iNewHash = pfHash != oSymTable->pfHash || uSeed != oSymTable->uSeed;
+   if (iNewHash)
+      SymTable_hashEntries(oSymTable, pfHash, uSeed);
+
+   /* Placing entries in the new buckets leaves the old ones intact
+      until every entry has a place. */
+   for (u = 0; u < oSymTable->uBucketCount + oSymTable->uStashCount; u++)
+   {
+      for (i = 0; i < BUCKET_SIZE; i++)
+      {
+         if (u < oSymTable->uBucketCount)
+            psEntry = oSymTable->psBuckets[u].apsEntries[i];
+         else if (i == 0)
+            psEntry = oSymTable->ppsStash[u - oSymTable->uBucketCount];
+         else
+            break;
+         if (psEntry == NULL ||
+             SymTable_place(psNewBuckets, uBucketCount, psEntry))
+            continue;
+         if (uNewStashCount == MAX_STASH_COUNT ||
+             ! SymTable_stash(&ppsNewStash, &uNewStashCount,
+                              &uNewStashCapacity, psEntry))
+         {
+            if (iNewHash)
+               SymTable_hashEntries(oSymTable, oSymTable->pfHash,
+                                    oSymTable->uSeed);
+            free(ppsNewStash);
+            free(pvNewBlock);
+            return 0;
+         }
+      }
+   }
+
+   free(oSymTable->pvBlock);
+   free(oSymTable->ppsStash);
+   oSymTable->psBuckets = psNewBuckets;
+   oSymTable->pvBlock = pvNewBlock;
+   oSymTable->uBucketCount = uBucketCount;
+   oSymTable->ppsStash = ppsNewStash;
+   oSymTable->uStashCount = uNewStashCount;
+   oSymTable->uStashCapacity = uNewStashCapacity;
+   oSymTable->pfHash = pfHash;
+   oSymTable->uSeed = uSeed;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Rebuild oSymTable with uBucketCount buckets under a new random seed,
+   and under wyhash in place of the multiplicative hash, whose
+   collisions no seed separates.  Return 1 (TRUE) if successful, or 0
+   (FALSE) if not, in which case oSymTable is unchanged. */
+
+static int SymTable_reseed(SymTable_T oSymTable, size_t uBucketCount)
+{
+   StrHash_T pfHash;
+
+   assert(oSymTable != NULL);
+
+   pfHash = oSymTable->pfHash;
+   if (pfHash == StrHash_multiplicative)
+      pfHash = StrHash_wyhash;
+   return SymTable_rebuild(oSymTable, uBucketCount, pfHash,
+                           StrHash_randomSeed());
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Rebuild oSymTable with uBucketCount buckets, under a new seed if
+   too many keys collide under the current one.  Return 1 (TRUE) if
+   successful, or 0 (FALSE) if not, in which case oSymTable is
+   unchanged. */
+
+static int SymTable_rehash(SymTable_T oSymTable, size_t uBucketCount)
+{
+   assert(oSymTable != NULL);
+
+   if (SymTable_rebuild(oSymTable, uBucketCount, oSymTable->pfHash,
+                        oSymTable->uSeed))
+      return 1;
+   return SymTable_reseed(oSymTable, uBucketCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Search oSymTable for a binding whose key is the uLength bytes at
+   pcKey and whose key has hash code uHash.  Return the address of the
+   slot that holds its entry, and store the address of the slot's tag
+   in *ppuTag, or NULL if the entry is in the overflow array.  Return
+   NULL if there is no such binding. */
+
+static struct SymTableEntry **SymTable_find(SymTable_T oSymTable,
+                                            const char *pcKey,
+                                            size_t uLength, size_t uHash,
+                                            uint32_t **ppuTag)
+{
+   struct SymTableBucket *psBucket;
+   struct SymTableEntry *psEntry;
+   uint32_t uTag;
+   size_t uFirst;
+   size_t uBucket;
+   size_t u;
+   int iBucket;
+   int i;
+
+   assert(oSymTable != NULL && pcKey != NULL && ppuTag != NULL);
+
+   uTag = SymTable_tagOf(uHash);
+   uFirst = uHash & (oSymTable->uBucketCount - 1);
+   uBucket = uFirst;
+   for (iBucket = 0; iBucket < 2; iBucket++)
+   {
+      psBucket = &oSymTable->psBuckets[uBucket];
+      for (i = 0; i < BUCKET_SIZE; i++)
+      {
+         /* strncmp stops at the end of the stored key, so the stored
+            key is at least uLength bytes long when it returns 0. */
+         psEntry = psBucket->apsEntries[i];
+         if (psBucket->auTags[i] == uTag && psEntry->uHash == uHash &&
+             strncmp(psEntry->acKey, pcKey, uLength) == 0 &&
+             psEntry->acKey[uLength] == '\0')
+         {
+            *ppuTag = &psBucket->auTags[i];
+            return &psBucket->apsEntries[i];
+         }
+      }
+      uBucket = SymTable_altBucket(uFirst, uTag, oSymTable->uBucketCount);
+   }
+
+   for (u = 0; u < oSymTable->uStashCount; u++)
+   {
+      psEntry = oSymTable->ppsStash[u];
+      if (psEntry->uHash == uHash &&
+          strncmp(psEntry->acKey, pcKey, uLength) == 0 &&
+          psEntry->acKey[uLength] == '\0')
+      {
+         *ppuTag = NULL;
+         return &oSymTable->ppsStash[u];
+      }
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+   return SymTable_newWithOptions(NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithOptions(const struct SymTableOptions *psOptions)
+{
+   SymTable_T oSymTable;
+
+   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->dMaxLoadFactor = MAX_LOAD_FACTOR;
+   if (psOptions != NULL && psOptions->dMaxLoadFactor > 0.0 &&
+       psOptions->dMaxLoadFactor < MAX_LOAD_FACTOR)
+      oSymTable->dMaxLoadFactor = psOptions->dMaxLoadFactor;
+
+   oSymTable->uBucketCount = INITIAL_BUCKET_COUNT;
+   if (psOptions != NULL && psOptions->uCapacity > 0)
+      oSymTable->uBucketCount =
+         SymTable_bucketCountFor(oSymTable, psOptions->uCapacity);
+
+   if (! SymTable_allocBuckets(oSymTable->uBucketCount,
+                               &oSymTable->psBuckets, &oSymTable->pvBlock))
+   {
+      free(oSymTable);
+      return NULL;
+   }
+   oSymTable->ppsStash = NULL;
+   oSymTable->uStashCount = 0;
+   oSymTable->uStashCapacity = 0;
+
+   oSymTable->pfHash = StrHash_forOption(
+      psOptions != NULL ? psOptions->eHash : SYMTABLE_HASH_DEFAULT);
+   if (psOptions != NULL && psOptions->iFixedSeed)
+      oSymTable->uSeed = psOptions->uSeed;
+   else
+      oSymTable->uSeed = StrHash_randomSeed();
+
+   oSymTable->num = 0;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+   struct SymTableOptions sOptions;
+
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.uCapacity = uCapacity;
+   return SymTable_newWithOptions(&sOptions);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount)
+{
+   size_t uBucketCount;
+
+   assert(oSymTable != NULL);
+
+   uBucketCount = SymTable_bucketCountFor(oSymTable, uCount);
+   if (uBucketCount <= oSymTable->uBucketCount)
+      return 1;
+   return SymTable_rehash(oSymTable, uBucketCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_shrink(SymTable_T oSymTable)
+{
+   size_t uBucketCount;
+
+   assert(oSymTable != NULL);
+
+   uBucketCount = SymTable_bucketCountFor(oSymTable, oSymTable->num);
+   if (uBucketCount < oSymTable->uBucketCount)
+      (void)SymTable_rehash(oSymTable, uBucketCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+   size_t u;
+   int i;
+
+   assert(oSymTable != NULL);
+
+   for (u = 0; u < oSymTable->uBucketCount; u++)
+      for (i = 0; i < BUCKET_SIZE; i++)
+         free(oSymTable->psBuckets[u].apsEntries[i]);
+   for (u = 0; u < oSymTable->uStashCount; u++)
+      free(oSymTable->ppsStash[u]);
+
+   free(oSymTable->pvBlock);
+   free(oSymTable->ppsStash);
+   free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+   return oSymTable->num;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add a binding to oSymTable consisting of the key of length uLength
+   at pcKey, whose hash code is uHash, and value pvValue, without
+   checking whether oSymTable already contains that key.  Return the
+   new entry, or NULL if insufficient memory is available or the key
+   collides with too many others under every seed tried, in which case
+   the bindings of oSymTable are unchanged. */
+
+static struct SymTableEntry *SymTable_addEntry(SymTable_T oSymTable,
+                                               const char *pcKey,
+                                               size_t uLength,
+                                               size_t uHash,
+                                               const void *pvValue)
+{
+   struct SymTableEntry *psEntry;
+   int iReseeded = 0;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   /* Make a defensive copy of pcKey, which need not end in '\0'. */
+   psEntry = (struct SymTableEntry*)
+      malloc(offsetof(struct SymTableEntry, acKey) + uLength + 1);
+   if (psEntry == NULL)
+      return NULL;
+   psEntry->uHash = uHash;
+   psEntry->pvValue = pvValue;
+   memcpy(psEntry->acKey, pcKey, uLength);
+   psEntry->acKey[uLength] = '\0';
+
+   if (oSymTable->num >= SymTable_maxLoad(oSymTable,
+                                          oSymTable->uBucketCount))
+   {
+      if (! SymTable_rehash(oSymTable, oSymTable->uBucketCount * 2))
+      {
+         free(psEntry);
+         return NULL;
+      }
+      psEntry->uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   }
+
+   /* Growing cannot separate keys whose hash codes are equal, and is
+      not worth its memory while the table is mostly empty, so an entry
+      that finds no room then goes to the overflow array.  A full
+      overflow array calls for a new seed instead, but only once, since
+      keys that still collide then would collide under any other.  Any
+      rebuild may change the seed, and so the hash code of the new
+      key. */
+   while (! SymTable_place(oSymTable->psBuckets, oSymTable->uBucketCount,
+                           psEntry))
+   {
+      if (oSymTable->num < oSymTable->uBucketCount * BUCKET_SIZE / 2)
+      {
+         if (oSymTable->uStashCount < MAX_STASH_COUNT)
+         {
+            if (! SymTable_stash(&oSymTable->ppsStash,
+                                 &oSymTable->uStashCount,
+                                 &oSymTable->uStashCapacity, psEntry))
+            {
+               free(psEntry);
+               return NULL;
+            }
+            break;
+         }
+         if (iReseeded ||
+             ! SymTable_reseed(oSymTable, oSymTable->uBucketCount))
+         {
+            free(psEntry);
+            return NULL;
+         }
+         iReseeded = 1;
+      }
+      else if (! SymTable_rehash(oSymTable, oSymTable->uBucketCount * 2))
+      {
+         free(psEntry);
+         return NULL;
+      }
+      psEntry->uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   }
+
+   oSymTable->num++;
+   return psEntry;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add a new binding to oSymTable consisting of the key of length
+   uLength at pcKey, whose hash code is uHash, and value pvValue and
+   return 1 (TRUE).  Return 0 (FALSE) if oSymTable already contains a
+   binding with that key, insufficient memory is available, or the key
+   collides with too many others. */
+
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+                           size_t uLength, size_t uHash,
+                           const void *pvValue)
+{
+   uint32_t *puTag;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (SymTable_find(oSymTable, pcKey, uLength, uHash, &puTag) != NULL)
+      return 0;
+
+   return SymTable_addEntry(oSymTable, pcKey, uLength, uHash,
+                            pvValue) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+                 const void *pvValue)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                  const void *pvValue)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_insert(oSymTable, pcKey, uLength,
+                          SymTable_hash(oSymTable, pcKey, uLength),
+                          pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+                       const void *pvValue)
+{
+   struct SymTableEntry **ppsEntry;
+   uint32_t *puTag;
+   void *pvOldValue;
+   size_t uLength;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   ppsEntry = SymTable_find(oSymTable, pcKey, uLength,
+                            SymTable_hash(oSymTable, pcKey, uLength),
+                            &puTag);
+   if (ppsEntry == NULL)
+      return NULL;
+
+   pvOldValue = (void*)(*ppsEntry)->pvValue;
+   (*ppsEntry)->pvValue = pvValue;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                      const void *pvValue)
+{
+   struct SymTableEntry **ppsEntry;
+   uint32_t *puTag;
+   void *pvOldValue;
+   size_t uLength;
+   size_t uHash;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   ppsEntry = SymTable_find(oSymTable, pcKey, uLength, uHash, &puTag);
+   if (ppsEntry == NULL)
+   {
+      (void)SymTable_addEntry(oSymTable, pcKey, uLength, uHash, pvValue);
+      return NULL;
+   }
+
+   pvOldValue = (void*)(*ppsEntry)->pvValue;
+   (*ppsEntry)->pvValue = pvValue;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+const void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                               const void *pvValue)
+{
+   struct SymTableEntry **ppsEntry;
+   struct SymTableEntry *psEntry;
+   uint32_t *puTag;
+   size_t uLength;
+   size_t uHash;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   /* Entries do not move in memory when their slots do, so the address
+      of a value stays valid until its binding is removed. */
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   ppsEntry = SymTable_find(oSymTable, pcKey, uLength, uHash, &puTag);
+   if (ppsEntry != NULL)
+      return &(*ppsEntry)->pvValue;
+
+   psEntry = SymTable_addEntry(oSymTable, pcKey, uLength, uHash,
+                               pvValue);
+   if (psEntry == NULL)
+      return NULL;
+   return &psEntry->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   uint32_t *puTag;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_find(oSymTable, pcKey, uLength,
+                        SymTable_hash(oSymTable, pcKey, uLength),
+                        &puTag) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+                    size_t uLength)
+{
+   struct SymTableEntry **ppsEntry;
+   uint32_t *puTag;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   ppsEntry = SymTable_find(oSymTable, pcKey, uLength,
+                            SymTable_hash(oSymTable, pcKey, uLength),
+                            &puTag);
+   if (ppsEntry == NULL)
+      return NULL;
+   return (void*)(*ppsEntry)->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Hash the uCount keys in apcKeys, at most BATCH_SIZE of them, into
+   auHashes and auLengths, and prefetch both buckets of each key, so
+   that the memory accesses of all the keys overlap. */
+
+static void SymTable_prefetchBatch(SymTable_T oSymTable,
+                                   const char **apcKeys, size_t uCount,
+                                   size_t *auHashes, size_t *auLengths)
+{
+   size_t uFirst;
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL);
+   assert(auHashes != NULL && auLengths != NULL);
+   assert(uCount <= BATCH_SIZE);
+
+   for (u = 0; u < uCount; u++)
+   {
+      auLengths[u] = strlen(apcKeys[u]);
+      auHashes[u] = SymTable_hash(oSymTable, apcKeys[u], auLengths[u]);
+      uFirst = auHashes[u] & (oSymTable->uBucketCount - 1);
+      PREFETCH(&oSymTable->psBuckets[uFirst]);
+      PREFETCH(&oSymTable->psBuckets[
+         SymTable_altBucket(uFirst, SymTable_tagOf(auHashes[u]),
+                            oSymTable->uBucketCount)]);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+                       size_t uCount, void **apvValues)
+{
+   struct SymTableEntry **ppsEntry;
+   size_t auHashes[BATCH_SIZE];
+   size_t auLengths[BATCH_SIZE];
+   uint32_t *puTag;
+   size_t uStart;
+   size_t uBatch;
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL && apvValues != NULL);
+
+   for (uStart = 0; uStart < uCount; uStart += uBatch)
+   {
+      uBatch = uCount - uStart < BATCH_SIZE ? uCount - uStart : BATCH_SIZE;
+      SymTable_prefetchBatch(oSymTable, apcKeys + uStart, uBatch,
+                             auHashes, auLengths);
+      for (u = 0; u < uBatch; u++)
+      {
+         ppsEntry = SymTable_find(oSymTable, apcKeys[uStart + u],
+                                  auLengths[u], auHashes[u], &puTag);
+         apvValues[uStart + u] =
+            ppsEntry != NULL ? (void*)(*ppsEntry)->pvValue : NULL;
+      }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+                         size_t uCount, const void **apvValues)
+{
+   size_t auHashes[BATCH_SIZE];
+   size_t auLengths[BATCH_SIZE];
+   StrHash_T pfHash;
+   size_t uSeed;
+   size_t uAdded = 0;
+   size_t uStart;
+   size_t uBatch;
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL && apvValues != NULL);
+
+   for (uStart = 0; uStart < uCount; uStart += uBatch)
+   {
+      uBatch = uCount - uStart < BATCH_SIZE ? uCount - uStart : BATCH_SIZE;
+      SymTable_prefetchBatch(oSymTable, apcKeys + uStart, uBatch,
+                             auHashes, auLengths);
+      pfHash = oSymTable->pfHash;
+      uSeed = oSymTable->uSeed;
+
+      /* Insert in order, so that a key repeated within the batch is
+         added once.  An insertion that reseeds the table leaves the
+         rest of the batch to be hashed again. */
+      for (u = 0; u < uBatch; u++)
+      {
+         if (oSymTable->pfHash != pfHash || oSymTable->uSeed != uSeed)
+            auHashes[u] = SymTable_hash(oSymTable, apcKeys[uStart + u],
+                                        auLengths[u]);
+         uAdded += (size_t)SymTable_insert(oSymTable, apcKeys[uStart + u],
+                                           auLengths[u], auHashes[u],
+                                           apvValues[uStart + u]);
+      }
+   }
+   return uAdded;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   struct SymTableEntry **ppsEntry;
+   struct SymTableEntry *psEntry;
+   uint32_t *puTag;
+   void *pvOldValue;
+   size_t u;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   ppsEntry = SymTable_find(oSymTable, pcKey, uLength,
+                            SymTable_hash(oSymTable, pcKey, uLength),
+                            &puTag);
+   if (ppsEntry == NULL)
+      return NULL;
+
+   psEntry = *ppsEntry;
+   pvOldValue = (void*)psEntry->pvValue;
+   free(psEntry);
+   oSymTable->num--;
+   if (puTag == NULL)
+   {
+      *ppsEntry = oSymTable->ppsStash[--oSymTable->uStashCount];
+      return pvOldValue;
+   }
+   *puTag = 0;
+   *ppsEntry = NULL;
+
+   /* The freed slot may take one overflow entry back into a bucket, so
+      that lookups skip the overflow array again once it empties. */
+   for (u = 0; u < oSymTable->uStashCount; u++)
+      if (SymTable_place(oSymTable->psBuckets, oSymTable->uBucketCount,
+                         oSymTable->ppsStash[u]))
+      {
+         oSymTable->ppsStash[u] =
+            oSymTable->ppsStash[--oSymTable->uStashCount];
+         break;
+      }
+
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   struct SymTableEntry *psEntry;
+   size_t u;
+   int i;
+
+   assert(oSymTable != NULL && pfApply != NULL);
+
+   for (u = 0; u < oSymTable->uBucketCount; u++)
+      for (i = 0; i < BUCKET_SIZE; i++)
+      {
+         psEntry = oSymTable->psBuckets[u].apsEntries[i];
+         if (psEntry != NULL)
+            (*pfApply)(psEntry->acKey, (void*)psEntry->pvValue,
+                       (void*)pvExtra);
+      }
+   for (u = 0; u < oSymTable->uStashCount; u++)
+   {
+      psEntry = oSymTable->ppsStash[u];
+      (*pfApply)(psEntry->acKey, (void*)psEntry->pvValue,
+                 (void*)pvExtra);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_iterBegin(SymTable_T oSymTable, struct SymTableIter *psIter)
+{
+   assert(oSymTable != NULL && psIter != NULL);
+
+   /* uIndex is the first slot that the cursor has yet to examine,
+      counting the slots of the buckets and then the overflow
+      entries. */
+   psIter->oSymTable = oSymTable;
+   psIter->uIndex = 0;
+   psIter->uRemaining = oSymTable->num;
+   psIter->pvPosition = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_iterNext(struct SymTableIter *psIter)
+{
+   SymTable_T oSymTable;
+   struct SymTableEntry *psEntry;
+   size_t uSlotCount;
+   size_t uIndex;
+
+   assert(psIter != NULL && psIter->oSymTable != NULL);
+
+   if (psIter->uRemaining == 0)
+      return 0;
+
+   /* Some later slot or overflow entry is full, so the scan needs no
+      bounds check. */
+   oSymTable = psIter->oSymTable;
+   uSlotCount = oSymTable->uBucketCount * BUCKET_SIZE;
+   for (uIndex = psIter->uIndex; ; uIndex++)
+   {
+      if (uIndex >= uSlotCount)
+      {
+         assert(uIndex - uSlotCount < oSymTable->uStashCount);
+         psEntry = oSymTable->ppsStash[uIndex - uSlotCount];
+         break;
+      }
+      psEntry = oSymTable->psBuckets[uIndex / BUCKET_SIZE]
+         .apsEntries[uIndex % BUCKET_SIZE];
+      if (psEntry != NULL)
+         break;
+   }
+
+   psIter->uIndex = uIndex + 1;
+   psIter->uRemaining--;
+   psIter->pvPosition = psEntry;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *SymTable_iterKey(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   return ((const struct SymTableEntry*)psIter->pvPosition)->acKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_iterValue(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   return (void*)((const struct SymTableEntry*)psIter->pvPosition)
+      ->pvValue;
+}
@@ -0,0 +1,1039 @@
+/*--------------------------------------------------------------------*/
+/* symtableepoch.c                                                    */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+/* A SymTable that many threads may use at once, whose readers take no
+   locks.  SymTable_get, SymTable_getN, SymTable_getBatch,
+   SymTable_contains, SymTable_containsN and SymTable_map only load
+   shared pointers; writers serialize on striped mutexes, publish with
+   release stores, and free unlinked nodes and bucket arrays through
+   epoch-based reclamation (epoch.h).  Every function except SymTable_free and the
+   SymTable_iter functions may be called concurrently with any other;
+   SymTable_free and iteration require that no other thread uses the
+   table.  A resize moves bindings to new nodes, so the address that
+   SymTable_getOrPut returns stays valid only while no thread adds a
+   binding. */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "symtable.h"
+#include "strhash.h"
+#include "stripe.h"
+#include "epoch.h"
+
+#if ! defined(__GNUC__)
+#error "symtableepoch.c needs the GCC __atomic builtins and __thread"
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* The default maximum number of bindings per bucket. */
+static const double DEFAULT_MAX_LOAD_FACTOR = 1.0;
+
+/* The stripe whose writer lock the calling thread holds while it maps
+   a table without having registered as a reader, or NULL, so that its
+   lookups from within the map do not wait for that lock. */
+static __thread struct SymTableStripe *psMappedStripe = NULL;
+
+/*--------------------------------------------------------------------*/
+
+/* Each key and value is stored in a SymTableNode.  SymTableNodes are
+   linked to form a list.  The key is stored inline at the end of its
+   SymTableNode, so a node and its key take a single allocation.  Only
+   pvValue and psNextNode change after a node is published, and both
+   are accessed atomically. */
+
+struct SymTableNode
+{
+   /* The value. */
+   const void *pvValue;
+
+   /* The full-width hash code of the key. */
+   size_t uHash;
+
+   /* The length of the key. */
+   size_t uLength;
+
+   /* The address of the next SymtableNode. */
+   struct SymTableNode *psNextNode;
+
+   /* The key, a defensive copy of the caller's key. */
+   char acKey[];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableBuckets is a bucket array together with its size, so that
+   a reader gets both with one load. */
+
+struct SymTableBuckets
+{
+   /* The number of buckets, a power of two of at least
+      STRIPE_COUNT. */
+   size_t uBucketCount;
+
+   /* The buckets. */
+   struct SymTableNode *apsBuckets[];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableStripe is the lock that writers to every bucket whose
+   index is congruent to the stripe's index modulo STRIPE_COUNT
+   hold. */
+
+struct SymTableStripe
+{
+   /* The lock. */
+   pthread_mutex_t sLock;
+
+   /* Unused space that keeps the next stripe's lock off this stripe's
+      cache line. */
+   char acPadding[STRIPE_PADDING_SIZE];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTable is a bucket array divided among writer lock stripes.
+   Growing copies the nodes of one stripe at a time into a new bucket
+   array and then points the stripe at it, so the old chains stay
+   intact for readers that are still walking them until the old array
+   and its nodes are retired together. */
+
+struct SymTable
+{
+   /* The bucket array of each stripe, read by readers without locks.
+      These change only during a resize, so writers do not dirty the
+      cache lines that readers load. */
+   struct SymTableBuckets *apsStripeBuckets[STRIPE_COUNT];
+
+   /* The writer locks. */
+   struct SymTableStripe asStripes[STRIPE_COUNT];
+
+   /* The lock held by the thread that resizes the table.  It guards
+      psBuckets, uBucketCount, psOldBuckets, iMovedCount and every
+      write to uExpandAt. */
+   pthread_mutex_t sResizeLock;
+
+   /* The newest bucket array. */
+   struct SymTableBuckets *psBuckets;
+
+   /* The number of buckets of psBuckets. */
+   size_t uBucketCount;
+
+   /* The bucket array that the stripes at or above iMovedCount still
+      use, if a resize ran out of memory part way, or NULL. */
+   struct SymTableBuckets *psOldBuckets;
+
+   /* The number of stripes that use psBuckets while psOldBuckets is
+      not NULL. */
+   int iMovedCount;
+
+   /* The maximum number of bindings per bucket. */
+   double dMaxLoadFactor;
+
+   /* The number of bindings at which the bucket array grows, read and
+      written atomically. */
+   size_t uExpandAt;
+
+   /* The hash function. */
+   StrHash_T pfHash;
+
+   /* The seed of the hash function. */
+   size_t uSeed;
+
+   /* The number of bindings, read and written atomically. */
+   size_t num;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return *ppsNode, a link that writers may change concurrently. */
+
+static struct SymTableNode *SymTable_loadLink(
+   struct SymTableNode *const *ppsNode)
+{
+   assert(ppsNode != NULL);
+
+   return __atomic_load_n(ppsNode, __ATOMIC_ACQUIRE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Publish psNode, whose fields are all set, in the link *ppsNode. */
+
+static void SymTable_storeLink(struct SymTableNode **ppsNode,
+                               struct SymTableNode *psNode)
+{
+   assert(ppsNode != NULL);
+
+   __atomic_store_n(ppsNode, psNode, __ATOMIC_RELEASE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash code of the key of length uLength at pcKey under the
+   hash function and seed of oSymTable. */
+
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+                            size_t uLength)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return (*oSymTable->pfHash)(pcKey, uLength, oSymTable->uSeed);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new bucket array of uBucketCount empty buckets, or NULL if
+   insufficient memory is available. */
+
+static struct SymTableBuckets *SymTable_newBuckets(size_t uBucketCount)
+{
+   struct SymTableBuckets *psBuckets;
+
+   psBuckets = (struct SymTableBuckets*)
+      calloc(1, sizeof(struct SymTableBuckets)
+             + uBucketCount * sizeof(struct SymTableNode*));
+   if (psBuckets == NULL)
+      return NULL;
+   psBuckets->uBucketCount = uBucketCount;
+   return psBuckets;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free pvBuckets, a SymTableBuckets, and every node in it. */
+
+static void SymTable_freeBuckets(void *pvBuckets)
+{
+   struct SymTableBuckets *psBuckets;
+   struct SymTableNode *psNode;
+   struct SymTableNode *psNextNode;
+   size_t u;
+
+   assert(pvBuckets != NULL);
+
+   psBuckets = (struct SymTableBuckets*)pvBuckets;
+   for (u = 0; u < psBuckets->uBucketCount; u++)
+      for (psNode = psBuckets->apsBuckets[u]; psNode != NULL;
+           psNode = psNextNode)
+      {
+         psNextNode = psNode->psNextNode;
+         free(psNode);
+      }
+   free(psBuckets);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the bucket of psBuckets that holds keys whose hash code is
+   uHash. */
+
+static struct SymTableNode **SymTable_bucketOf(
+   struct SymTableBuckets *psBuckets, size_t uHash)
+{
+   assert(psBuckets != NULL);
+
+   return &psBuckets->apsBuckets[uHash & (psBuckets->uBucketCount - 1)];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Search the stripe of oSymTable that holds keys with hash code
+   uHash, whose writer lock the caller holds, for the node whose key is
+   pcKey and whose length is uLength.  Return the address of the link
+   (the bucket itself or a psNextNode field) that points to that node,
+   or NULL if there is no such node. */
+
+static struct SymTableNode **SymTable_findLink(SymTable_T oSymTable,
+                                               const char *pcKey,
+                                               size_t uHash,
+                                               size_t uLength)
+{
+   struct SymTableNode **ppsLink;
+   struct SymTableNode *psNode;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   ppsLink = SymTable_bucketOf(
+      oSymTable->apsStripeBuckets[uHash & (STRIPE_COUNT - 1)], uHash);
+   for (psNode = *ppsLink; psNode != NULL; psNode = *ppsLink)
+   {
+      if (psNode->uHash == uHash && psNode->uLength == uLength &&
+          memcmp(psNode->acKey, pcKey, uLength) == 0)
+         return ppsLink;
+      ppsLink = &psNode->psNextNode;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Copy every node of stripe iStripe of oSymTable, whose writer lock
+   the caller holds, into psNewBuckets, and point the stripe at
+   psNewBuckets.  The stripe's old chains are left intact for readers.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
+   is available, in which case leave the stripe unchanged. */
+
+static int SymTable_copyStripe(SymTable_T oSymTable, int iStripe,
+                               struct SymTableBuckets *psNewBuckets)
+{
+   struct SymTableBuckets *psOldBuckets;
+   struct SymTableNode **ppsBucket;
+   struct SymTableNode *psNode;
+   struct SymTableNode *psCopy = NULL;
+   size_t uSize;
+   size_t u;
+   int iSuccessful = 1;
+
+   assert(oSymTable != NULL && psNewBuckets != NULL);
+
+   psOldBuckets = oSymTable->apsStripeBuckets[iStripe];
+   for (u = (size_t)iStripe;
+        iSuccessful && u < psOldBuckets->uBucketCount; u += STRIPE_COUNT)
+      for (psNode = psOldBuckets->apsBuckets[u];
+           iSuccessful && psNode != NULL; psNode = psNode->psNextNode)
+      {
+         uSize = sizeof(struct SymTableNode) + psNode->uLength + 1;
+         psCopy = (struct SymTableNode*)malloc(uSize);
+         iSuccessful = psCopy != NULL;
+         if (iSuccessful)
+         {
+            memcpy(psCopy, psNode, uSize);
+            ppsBucket = SymTable_bucketOf(psNewBuckets, psNode->uHash);
+            psCopy->psNextNode = *ppsBucket;
+            *ppsBucket = psCopy;
+         }
+      }
+
+   if (! iSuccessful)
+   {
+      /* Discard the copies made so far.  No reader can see them. */
+      for (u = (size_t)iStripe; u < psNewBuckets->uBucketCount;
+           u += STRIPE_COUNT)
+         for (psCopy = psNewBuckets->apsBuckets[u]; psCopy != NULL;
+              psCopy = psNode)
+         {
+            psNode = psCopy->psNextNode;
+            free(psCopy);
+         }
+      for (u = (size_t)iStripe; u < psNewBuckets->uBucketCount;
+           u += STRIPE_COUNT)
+         psNewBuckets->apsBuckets[u] = NULL;
+      return 0;
+   }
+
+   __atomic_store_n(&oSymTable->apsStripeBuckets[iStripe], psNewBuckets,
+                    __ATOMIC_RELEASE);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move the stripes of oSymTable, whose resize lock the caller holds,
+   that still use psOldBuckets to psBuckets, one stripe at a time, and
+   then retire psOldBuckets.  Return 1 (TRUE) if successful, or 0
+   (FALSE) if insufficient memory is available, in which case the
+   stripes moved so far stay moved. */
+
+static int SymTable_finishResize(SymTable_T oSymTable)
+{
+   struct SymTableStripe *psStripe;
+   int iSuccessful;
+
+   assert(oSymTable != NULL);
+
+   while (oSymTable->iMovedCount < STRIPE_COUNT)
+   {
+      psStripe = &oSymTable->asStripes[oSymTable->iMovedCount];
+      pthread_mutex_lock(&psStripe->sLock);
+      iSuccessful = SymTable_copyStripe(oSymTable, oSymTable->iMovedCount,
+                                        oSymTable->psBuckets);
+      pthread_mutex_unlock(&psStripe->sLock);
+      if (! iSuccessful)
+         return 0;
+      oSymTable->iMovedCount++;
+   }
+
+   /* Readers may still walk the old array's chains, which hold the
+      originals of every copied node.  Those are as large as the
+      table, so publish them at once for any thread to free. */
+   Epoch_retire(oSymTable->psOldBuckets, SymTable_freeBuckets);
+   Epoch_flush();
+   oSymTable->psOldBuckets = NULL;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Give the SymTable pvTable, whose resize lock the caller holds, a
+   bucket array of uNewCount buckets, which may be more or fewer than
+   it has now.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available.  A resize that runs out of memory
+   part way is finished by the next one. */
+
+static int SymTable_resize(void *pvTable, size_t uNewCount)
+{
+   SymTable_T oSymTable = (SymTable_T)pvTable;
+   struct SymTableBuckets *psNewBuckets;
+
+   assert(oSymTable != NULL && uNewCount >= STRIPE_COUNT);
+
+   if (oSymTable->psOldBuckets != NULL &&
+       ! SymTable_finishResize(oSymTable))
+      return 0;
+
+   psNewBuckets = SymTable_newBuckets(uNewCount);
+   if (psNewBuckets == NULL)
+      return 0;
+
+   oSymTable->psOldBuckets = oSymTable->psBuckets;
+   oSymTable->psBuckets = psNewBuckets;
+   oSymTable->uBucketCount = uNewCount;
+   oSymTable->iMovedCount = 0;
+   Stripe_store(&oSymTable->uExpandAt,
+                Stripe_expandAt(uNewCount, oSymTable->dMaxLoadFactor));
+   return SymTable_finishResize(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count a binding just added to oSymTable, and grow oSymTable if that
+   takes it past its expansion threshold.  The caller must hold no
+   stripe lock. */
+
+static void SymTable_countAdded(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+
+   if (Stripe_add(&oSymTable->num, 1) >
+       Stripe_load(&oSymTable->uExpandAt))
+      Stripe_grow(&oSymTable->sResizeLock, &oSymTable->num,
+                  &oSymTable->uExpandAt, &oSymTable->uBucketCount,
+                  SymTable_resize, oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add to oSymTable, whose writer lock for keys with hash code uHash
+   the caller holds, a new node holding the key of length uLength at
+   pcKey and value pvValue.  Return the node, or NULL if insufficient
+   memory is available. */
+
+static struct SymTableNode *SymTable_addNode(SymTable_T oSymTable,
+                                             const char *pcKey,
+                                             size_t uHash,
+                                             size_t uLength,
+                                             const void *pvValue)
+{
+   struct SymTableNode **ppsBucket;
+   struct SymTableNode *psNode;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   psNode = (struct SymTableNode*)
+      malloc(sizeof(struct SymTableNode) + uLength + 1);
+   if (psNode == NULL)
+      return NULL;
+
+   /* Make a defensive copy of pcKey, which need not end in '\0'. */
+   memcpy(psNode->acKey, pcKey, uLength);
+   psNode->acKey[uLength] = '\0';
+   psNode->pvValue = pvValue;
+   psNode->uHash = uHash;
+   psNode->uLength = uLength;
+
+   ppsBucket = SymTable_bucketOf(
+      oSymTable->apsStripeBuckets[uHash & (STRIPE_COUNT - 1)], uHash);
+   psNode->psNextNode = *ppsBucket;
+   SymTable_storeLink(ppsBucket, psNode);
+   return psNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Search oSymTable for the binding whose key is the uLength bytes at
+   pcKey.  If there is one, set its value to pvValue if iReplace is
+   nonzero, and return its node.  Otherwise add a binding with value
+   pvValue if iAdd is nonzero, and return its node, or NULL if iAdd is
+   zero or insufficient memory is available.  Store the binding's old
+   value, or NULL, in *ppvOldValue, and store 1 (TRUE) in *piAdded if
+   a binding was added or 0 (FALSE) otherwise.  The node may be
+   removed by another thread as soon as this function returns. */
+
+static struct SymTableNode *SymTable_write(SymTable_T oSymTable,
+                                           const char *pcKey,
+                                           size_t uLength,
+                                           const void *pvValue,
+                                           int iAdd, int iReplace,
+                                           void **ppvOldValue,
+                                           int *piAdded)
+{
+   struct SymTableStripe *psStripe;
+   struct SymTableNode **ppsLink;
+   struct SymTableNode *psNode = NULL;
+   size_t uHash;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+   assert(ppvOldValue != NULL && piAdded != NULL);
+
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   psStripe = &oSymTable->asStripes[uHash & (STRIPE_COUNT - 1)];
+   *ppvOldValue = NULL;
+   *piAdded = 0;
+
+   pthread_mutex_lock(&psStripe->sLock);
+   ppsLink = SymTable_findLink(oSymTable, pcKey, uHash, uLength);
+   if (ppsLink != NULL)
+   {
+      psNode = *ppsLink;
+      *ppvOldValue = (void*)psNode->pvValue;
+      if (iReplace)
+         __atomic_store_n(&psNode->pvValue, pvValue, __ATOMIC_RELEASE);
+   }
+   else if (iAdd)
+   {
+      psNode = SymTable_addNode(oSymTable, pcKey, uHash, uLength,
+                                pvValue);
+      *piAdded = psNode != NULL;
+   }
+   pthread_mutex_unlock(&psStripe->sLock);
+
+   if (*piAdded)
+      SymTable_countAdded(oSymTable);
+   return psNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look up the binding of oSymTable whose key is the uLength bytes at
+   pcKey without taking a lock.  Return 1 (TRUE) and store its value
+   in *ppvValue if there is one.  Otherwise return 0 (FALSE). */
+
+static int SymTable_lookup(SymTable_T oSymTable, const char *pcKey,
+                           size_t uLength, void **ppvValue)
+{
+   struct SymTableStripe *psStripe;
+   struct SymTableBuckets *psBuckets;
+   struct SymTableNode *psNode;
+   size_t uHash;
+   int iReading;
+   int iLocked = 0;
+
+   assert(oSymTable != NULL && pcKey != NULL && ppvValue != NULL);
+
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+
+   /* A thread that cannot register for lack of memory reads under its
+      stripe's writer lock instead, which keeps the stripe's array and
+      nodes alive, unless it already holds that lock to map the
+      stripe. */
+   psStripe = &oSymTable->asStripes[uHash & (STRIPE_COUNT - 1)];
+   iReading = Epoch_enter();
+   if (! iReading && psStripe != psMappedStripe)
+   {
+      pthread_mutex_lock(&psStripe->sLock);
+      iLocked = 1;
+   }
+
+   psBuckets = __atomic_load_n(
+      &oSymTable->apsStripeBuckets[uHash & (STRIPE_COUNT - 1)],
+      __ATOMIC_ACQUIRE);
+   for (psNode = SymTable_loadLink(SymTable_bucketOf(psBuckets, uHash));
+        psNode != NULL;
+        psNode = SymTable_loadLink(&psNode->psNextNode))
+      if (psNode->uHash == uHash && psNode->uLength == uLength &&
+          memcmp(psNode->acKey, pcKey, uLength) == 0)
+      {
+         *ppvValue = (void*)__atomic_load_n(&psNode->pvValue,
+                                            __ATOMIC_ACQUIRE);
+         break;
+      }
+
+   if (iLocked)
+      pthread_mutex_unlock(&psStripe->sLock);
+   if (iReading)
+      Epoch_exit();
+   return psNode != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+   return SymTable_newWithOptions(NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithOptions(const struct SymTableOptions *psOptions)
+{
+   SymTable_T oSymTable;
+   size_t uBucketCount = STRIPE_COUNT;
+   int i;
+
+   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->dMaxLoadFactor = DEFAULT_MAX_LOAD_FACTOR;
+   oSymTable->pfHash = StrHash_forOption(SYMTABLE_HASH_DEFAULT);
+   if (psOptions != NULL)
+   {
+      if (psOptions->dMaxLoadFactor > 0.0)
+         oSymTable->dMaxLoadFactor = psOptions->dMaxLoadFactor;
+      oSymTable->pfHash = StrHash_forOption(psOptions->eHash);
+      if (psOptions->uCapacity > 0)
+         uBucketCount = Stripe_bucketCountFor(psOptions->uCapacity,
+                                              oSymTable->dMaxLoadFactor);
+   }
+   if (psOptions != NULL && psOptions->iFixedSeed)
+      oSymTable->uSeed = psOptions->uSeed;
+   else
+      oSymTable->uSeed = StrHash_randomSeed();
+
+   oSymTable->psBuckets = SymTable_newBuckets(uBucketCount);
+   if (oSymTable->psBuckets == NULL)
+   {
+      free(oSymTable);
+      return NULL;
+   }
+
+   pthread_mutex_init(&oSymTable->sResizeLock, NULL);
+   for (i = 0; i < STRIPE_COUNT; i++)
+   {
+      pthread_mutex_init(&oSymTable->asStripes[i].sLock, NULL);
+      oSymTable->apsStripeBuckets[i] = oSymTable->psBuckets;
+   }
+   oSymTable->uBucketCount = uBucketCount;
+   oSymTable->psOldBuckets = NULL;
+   oSymTable->iMovedCount = STRIPE_COUNT;
+   oSymTable->uExpandAt = Stripe_expandAt(uBucketCount,
+                                          oSymTable->dMaxLoadFactor);
+   oSymTable->num = 0;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+   struct SymTableOptions sOptions;
+
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.uCapacity = uCapacity;
+   return SymTable_newWithOptions(&sOptions);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount)
+{
+   size_t uNewCount;
+   int iSuccessful = 1;
+
+   assert(oSymTable != NULL);
+
+   pthread_mutex_lock(&oSymTable->sResizeLock);
+   if (oSymTable->psOldBuckets != NULL)
+      iSuccessful = SymTable_finishResize(oSymTable);
+   if (iSuccessful && uCount > Stripe_load(&oSymTable->uExpandAt))
+   {
+      uNewCount = Stripe_bucketCountFor(uCount,
+                                        oSymTable->dMaxLoadFactor);
+      if (uNewCount > oSymTable->uBucketCount)
+         iSuccessful = SymTable_resize(oSymTable, uNewCount);
+   }
+   pthread_mutex_unlock(&oSymTable->sResizeLock);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_shrink(SymTable_T oSymTable)
+{
+   size_t uNewCount;
+
+   assert(oSymTable != NULL);
+
+   pthread_mutex_lock(&oSymTable->sResizeLock);
+   uNewCount = Stripe_bucketCountFor(Stripe_load(&oSymTable->num),
+                                     oSymTable->dMaxLoadFactor);
+   if (uNewCount < oSymTable->uBucketCount)
+      (void)SymTable_resize(oSymTable, uNewCount);
+   pthread_mutex_unlock(&oSymTable->sResizeLock);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+   int i;
+
+   if (oSymTable == NULL)
+      return;
+
+   /* During an unfinished resize, the unmoved stripes' nodes are only
+      in the old array and the moved stripes' nodes are in both, as
+      originals and copies, so freeing both arrays frees each node
+      once. */
+   if (oSymTable->psOldBuckets != NULL)
+      SymTable_freeBuckets(oSymTable->psOldBuckets);
+   SymTable_freeBuckets(oSymTable->psBuckets);
+
+   for (i = 0; i < STRIPE_COUNT; i++)
+      pthread_mutex_destroy(&oSymTable->asStripes[i].sLock);
+   pthread_mutex_destroy(&oSymTable->sResizeLock);
+   free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+
+   return Stripe_load(&oSymTable->num);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+                 const void *pvValue)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                  const void *pvValue)
+{
+   void *pvOldValue;
+   int iAdded;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   (void)SymTable_write(oSymTable, pcKey, uLength, pvValue, 1, 0,
+                        &pvOldValue, &iAdded);
+   return iAdded;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+                       const void *pvValue)
+{
+   void *pvOldValue;
+   int iAdded;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   (void)SymTable_write(oSymTable, pcKey, strlen(pcKey), pvValue, 0, 1,
+                        &pvOldValue, &iAdded);
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                      const void *pvValue)
+{
+   void *pvOldValue;
+   int iAdded;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   (void)SymTable_write(oSymTable, pcKey, strlen(pcKey), pvValue, 1, 1,
+                        &pvOldValue, &iAdded);
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+const void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                               const void *pvValue)
+{
+   struct SymTableNode *psNode;
+   void *pvOldValue;
+   int iAdded;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   psNode = SymTable_write(oSymTable, pcKey, strlen(pcKey), pvValue, 1, 0,
+                           &pvOldValue, &iAdded);
+   if (psNode == NULL)
+      return NULL;
+   return &psNode->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   void *pvValue;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_lookup(oSymTable, pcKey, uLength, &pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+                    size_t uLength)
+{
+   void *pvValue;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (! SymTable_lookup(oSymTable, pcKey, uLength, &pvValue))
+      return NULL;
+   return pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+                       size_t uCount, void **apvValues)
+{
+   size_t u;
+
+   assert(oSymTable != NULL);
+   assert(apcKeys != NULL || uCount == 0);
+   assert(apvValues != NULL || uCount == 0);
+
+   for (u = 0; u < uCount; u++)
+      apvValues[u] = SymTable_get(oSymTable, apcKeys[u]);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+                         size_t uCount, const void **apvValues)
+{
+   size_t uAdded = 0;
+   size_t u;
+
+   assert(oSymTable != NULL);
+   assert(apcKeys != NULL || uCount == 0);
+   assert(apvValues != NULL || uCount == 0);
+
+   for (u = 0; u < uCount; u++)
+      uAdded += (size_t)SymTable_put(oSymTable, apcKeys[u], apvValues[u]);
+   return uAdded;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   struct SymTableStripe *psStripe;
+   struct SymTableNode **ppsLink;
+   struct SymTableNode *psNode = NULL;
+   void *pvValue;
+   size_t uHash;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   psStripe = &oSymTable->asStripes[uHash & (STRIPE_COUNT - 1)];
+
+   pthread_mutex_lock(&psStripe->sLock);
+   ppsLink = SymTable_findLink(oSymTable, pcKey, uHash, uLength);
+   if (ppsLink != NULL)
+   {
+      psNode = *ppsLink;
+      SymTable_storeLink(ppsLink, psNode->psNextNode);
+   }
+   pthread_mutex_unlock(&psStripe->sLock);
+
+   if (psNode == NULL)
+      return NULL;
+
+   /* Readers may still be on the node, so retire it rather than free
+      it.  Its value is no longer written once it is unlinked. */
+   (void)Stripe_add(&oSymTable->num, (size_t)-1);
+   pvValue = (void*)psNode->pvValue;
+   Epoch_retire(psNode, free);
+   return pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Advance the bucket index *puIndex of oSymTable to the next bucket in
+   stripe order: every bucket of stripe 0, then every bucket of stripe
+   1, and so on.  Return 0 (FALSE) if there is no next bucket. */
+
+static int SymTable_nextBucket(SymTable_T oSymTable, size_t *puIndex)
+{
+   size_t uStripe;
+
+   assert(oSymTable != NULL && puIndex != NULL);
+
+   uStripe = *puIndex & (STRIPE_COUNT - 1);
+   *puIndex += STRIPE_COUNT;
+   if (*puIndex < oSymTable->apsStripeBuckets[uStripe]->uBucketCount)
+      return 1;
+   *puIndex = uStripe + 1;
+   return uStripe + 1 < STRIPE_COUNT;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   struct SymTableStripe *psStripe;
+   struct SymTableStripe *psOuterStripe;
+   struct SymTableBuckets *psBuckets;
+   struct SymTableNode *psNode;
+   size_t u;
+   int i;
+   int iReading;
+   int iLocked;
+
+   assert(oSymTable != NULL && pfApply != NULL);
+
+   /* Walk the stripes as a reader, like a lookup, so that writers
+      proceed and lookups from *pfApply take no lock.  A thread that
+      cannot register for lack of memory walks each stripe under its
+      writer lock instead, and marks the stripe so that its own lookups
+      do not wait for that lock.  *pfApply may look up bindings but
+      must not add or remove them. */
+   iReading = Epoch_enter();
+   psOuterStripe = psMappedStripe;
+   for (i = 0; i < STRIPE_COUNT; i++)
+   {
+      psStripe = &oSymTable->asStripes[i];
+      iLocked = ! iReading && psStripe != psOuterStripe;
+      if (iLocked)
+      {
+         pthread_mutex_lock(&psStripe->sLock);
+         psMappedStripe = psStripe;
+      }
+      psBuckets = __atomic_load_n(&oSymTable->apsStripeBuckets[i],
+                                  __ATOMIC_ACQUIRE);
+      for (u = (size_t)i; u < psBuckets->uBucketCount; u += STRIPE_COUNT)
+         for (psNode = SymTable_loadLink(&psBuckets->apsBuckets[u]);
+              psNode != NULL;
+              psNode = SymTable_loadLink(&psNode->psNextNode))
+            (*pfApply)(psNode->acKey,
+                       (void*)__atomic_load_n(&psNode->pvValue,
+                                              __ATOMIC_ACQUIRE),
+                       (void*)pvExtra);
+      if (iLocked)
+      {
+         psMappedStripe = psOuterStripe;
+         pthread_mutex_unlock(&psStripe->sLock);
+      }
+   }
+   if (iReading)
+      Epoch_exit();
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_iterBegin(SymTable_T oSymTable, struct SymTableIter *psIter)
+{
+   assert(oSymTable != NULL && psIter != NULL);
+
+   psIter->oSymTable = oSymTable;
+   psIter->uIndex = 0;
+   psIter->uRemaining = Stripe_load(&oSymTable->num);
+   psIter->pvPosition = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_iterNext(struct SymTableIter *psIter)
+{
+   SymTable_T oSymTable;
+   struct SymTableNode *psNode;
+   size_t uIndex;
+
+   assert(psIter != NULL && psIter->oSymTable != NULL);
+
+   if (psIter->uRemaining == 0)
+      return 0;
+
+   oSymTable = psIter->oSymTable;
+   psNode = (struct SymTableNode*)psIter->pvPosition;
+   if (psNode != NULL && psNode->psNextNode != NULL)
+      psNode = psNode->psNextNode;
+   else
+   {
+      /* Visit buckets in stripe order, because during an unfinished
+         resize the stripes use different bucket arrays.  Some later
+         bucket is nonempty. */
+      uIndex = psIter->uIndex;
+      if (psNode != NULL)
+         (void)SymTable_nextBucket(oSymTable, &uIndex);
+      while (oSymTable->apsStripeBuckets[uIndex & (STRIPE_COUNT - 1)]
+             ->apsBuckets[uIndex] == NULL)
+         (void)SymTable_nextBucket(oSymTable, &uIndex);
+      psIter->uIndex = uIndex;
+      psNode = oSymTable->apsStripeBuckets[uIndex & (STRIPE_COUNT - 1)]
+         ->apsBuckets[uIndex];
+   }
+
+   psIter->uRemaining--;
+   psIter->pvPosition = psNode;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *SymTable_iterKey(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   return ((const struct SymTableNode*)psIter->pvPosition)->acKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_iterValue(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   return (void*)((const struct SymTableNode*)psIter->pvPosition)->pvValue;
+}
@@ -3,381 +3,3106 @@
 /* Author: Kok Wei Pua                                                */
 /*--------------------------------------------------------------------*/
 
+#define _POSIX_C_SOURCE 200112L
+
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "symtable.h"
+#include "symtablehash.h"
+#include "strhash.h"
+#include "prefetch.h"
+#include "threadpool.h"
+
+#if ! defined(__GNUC__)
+#error "symtablehash.c needs __thread"
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* The number of bindings that a small SymTable holds in the single
+   bucket inside its struct before it allocates a bucket array.  Bucket
+   counts are always powers of two, so a bucket index is the low bits
+   of a hash code, and a count of 1 always means the inline bucket. */
+enum {SMALL_TABLE_SIZE = 8};
+
+/* The number of keys that a batch operation hashes and prefetches
+   before it resolves any of them. */
+enum {BATCH_SIZE = 16};
+
+/* The number of buckets in each task of a parallel map.  Tables with
+   no more buckets than this are mapped on the calling thread. */
+enum {MAP_CHUNK_SIZE = 4096};
+
+/* The most shards that a sharded SymTable has. */
+enum {MAX_SHARD_COUNT = 1024};
+
+/* The size, in bytes, of a cache line, by which adjacent shards are
+   kept apart so that their locks do not share a line. */
+enum {CACHE_LINE_SIZE = 64};
+
+/* The most keys per displacement group of a frozen SymTable, on
+   average.  The group count is a power of two, so the average is
+   between half this and this. */
+enum {FROZEN_GROUP_SIZE = 4};
+
+/* The most displacements that a freeze tries for one group before it
+   starts over with another seed, and the most seeds it tries. */
+enum {MAX_DISPLACEMENT_COUNT = 1 << 20};
+enum {MAX_FREEZE_ATTEMPT_COUNT = 8};
+
+/* The default maximum number of bindings per bucket. */
+static const double DEFAULT_MAX_LOAD_FACTOR = 1.0;
+
+/* The top bit of a size_t, which marks the displacement of a frozen
+   group that holds the slot of its only key. */
+static const size_t DIRECT_SLOT = ((size_t)-1 >> 1) + 1;
+
+/* The alignment, in bytes, of each section of a snapshot file and of
+   each serialized value. */
+enum {SNAPSHOT_ALIGNMENT = 16};
+
+/* The first bytes of a snapshot file, which are followed by the
+   version of its layout and the size of a size_t. */
+static const char SNAPSHOT_MAGIC[] = "SYMTAB";
+enum {SNAPSHOT_VERSION = 1};
+
+/* A value that reads differently on a machine of another byte
+   order. */
+static const size_t BYTE_ORDER_MARK = (size_t)0x0102030405060708ULL;
+
+/* The alignment, in bytes, of every node that an arena carves from
+   its slabs, and the size of the headers of slabs and big nodes. */
+enum {ARENA_ALIGNMENT = 16};
+
+/* The size, in bytes, of the largest node that an arena carves from
+   its slabs.  Larger nodes are allocated individually. */
+enum {ARENA_MAX_POOLED_SIZE = 512};
+
+/* The number of free lists of an arena, one per pooled node size. */
+enum {ARENA_CLASS_COUNT = ARENA_MAX_POOLED_SIZE / ARENA_ALIGNMENT};
+
+/* The sizes, in bytes, of the first slab and of the largest slab. */
+enum {ARENA_FIRST_SLAB_SIZE = 4096};
+enum {ARENA_MAX_SLAB_SIZE = 1048576};
+
+/*--------------------------------------------------------------------*/
+
+/* Each key and value is stored in a SymTableNode.  SymTableNodes are
+   linked to form a list.  The key is stored inline at the end of its
+   SymTableNode, so a node and its key take a single allocation.  */
+
+struct SymTableNode
+{
+   /* The value. */
+   const void *pvValue;
+
+   /* The full-width hash code of the key. */
+   size_t uHash;
+
+   /* The length of the key. */
+   size_t uLength;
+
+   /* The address of the next SymtableNode. */
+   struct SymTableNode *psNextNode;
+
+   /* The key, a defensive copy of the caller's key. */
+   char acKey[];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableSlab is a large block of memory from which an arena carves
+   nodes.  Its header is padded to ARENA_ALIGNMENT bytes.  SymTableSlabs
+   are linked to form a list. */
+
+struct SymTableSlab
+{
+   /* The address of the next SymTableSlab. */
+   struct SymTableSlab *psNextSlab;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableBigNode heads a node that is too large to be carved from a
+   slab.  Its header is padded to ARENA_ALIGNMENT bytes.
+   SymTableBigNodes are linked to form a doubly-linked list. */
+
+struct SymTableBigNode
+{
+   /* The address of the previous SymTableBigNode. */
+   struct SymTableBigNode *psPrevBig;
+
+   /* The address of the next SymTableBigNode. */
+   struct SymTableBigNode *psNextBig;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableArena owns the memory of the nodes of one SymTable.  Nodes
+   are carved from slabs in multiples of ARENA_ALIGNMENT bytes, and
+   removed nodes wait on a free list per size until they are reused. */
+
+struct SymTableArena
+{
+   /* The slabs, newest first. */
+   struct SymTableSlab *psSlabs;
+
+   /* The first unused byte of the newest slab. */
+   char *pcSlabFree;
+
+   /* The end of the newest slab. */
+   char *pcSlabEnd;
+
+   /* The size of the next slab. */
+   size_t uNextSlabSize;
+
+   /* The free lists, linked through psNextNode.  List i holds nodes
+   of (i + 1) * ARENA_ALIGNMENT bytes. */
+   struct SymTableNode *apsFreeNodes[ARENA_CLASS_COUNT];
+
+   /* The nodes too large for the slabs. */
+   struct SymTableBigNode *psBigNodes;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableShard is one of the independent tables of a sharded
+   SymTable, together with the lock that guards it. */
+
+struct SymTableShard
+{
+   /* The lock that lookups and maps of the shard share and every other
+      operation on it holds alone.  A shard grows all at once, so a
+      lookup changes nothing. */
+   pthread_rwlock_t sLock;
+
+   /* The table of the shard. */
+   struct SymTable *oSymTable;
+
+   /* Unused space that keeps the next shard's lock off this shard's
+      cache line. */
+   char acPadding[CACHE_LINE_SIZE];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableMapFrame records a shard whose lock a map holds while it
+   applies its function, so that the function, and the workers that
+   apply it in parallel, use the shard without locking it again.  The
+   frames of nested maps are linked, innermost first. */
+
+struct SymTableMapFrame
+{
+   /* The shard. */
+   struct SymTableShard *psShard;
+
+   /* The frame of the enclosing map, or NULL. */
+   const struct SymTableMapFrame *psOuterFrame;
+};
+
+/* The innermost frame of the maps whose function the calling thread
+   applies, or NULL. */
+static __thread const struct SymTableMapFrame *psMapFrame = NULL;
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableSlot is a binding of a frozen SymTable.  Its value shares
+   a cache line with the offset of its key, so a lookup reads one slot
+   and one key. */
+
+struct SymTableSlot
+{
+   /* The offset of the key in the pool of keys. */
+   size_t uKeyOffset;
+
+   /* The value. */
+   const void *pvValue;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableFileSlot is a binding of a SymTable snapshot, in which the
+   value is the offset of its serialized bytes. */
+
+struct SymTableFileSlot
+{
+   /* The offset of the key in the pool of keys. */
+   size_t uKeyOffset;
+
+   /* The offset of the value's bytes in the pool of values. */
+   size_t uValueOffset;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableSnapshotHeader begins a snapshot file.  A snapshot holds
+   the sections of a SymTableFrozen, each at an offset aligned to
+   SNAPSHOT_ALIGNMENT: the displacements, the pool of keys, the pool of
+   serialized values, and the SymTableFileSlots.  Every number is a
+   size_t in the byte order of the machine that wrote it, and nothing
+   is a pointer, so a mapping of the file serves lookups in place. */
+
+struct SymTableSnapshotHeader
+{
+   /* SNAPSHOT_MAGIC without its '\0', SNAPSHOT_VERSION, and the size
+   of a size_t. */
+   char acMagic[8];
+
+   /* BYTE_ORDER_MARK. */
+   size_t uByteOrderMark;
+
+   /* The hash function, an enum SymTableHash. */
+   size_t uHash;
+
+   /* The seed of the hash function. */
+   size_t uSeed;
+
+   /* The number of bindings. */
+   size_t uCount;
+
+   /* The number of displacement groups. */
+   size_t uGroupCount;
+
+   /* The offsets of the sections. */
+   size_t uDisplacementsOffset;
+   size_t uKeysOffset;
+   size_t uValuesOffset;
+   size_t uSlotsOffset;
+
+   /* The size of the file. */
+   size_t uFileSize;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableFrozen is the immutable form of a frozen SymTable.  Its
+   bindings fill exactly as many slots as there are bindings, and a
+   minimal perfect hash function, built by compressed hash and
+   displace, maps each key to its own slot: the key's group, chosen by
+   its hash code, holds a displacement that, mixed with the hash code,
+   gives the slot.  The keys are packed end to end in one pool, and the
+   slots in a dense array, both in slot order.  A table opened from a
+   snapshot reads all of these from the mapped file. */
+
+struct SymTableFrozen
+{
+   /* The number of displacement groups, a power of two, so that the
+   low bits of a hash code choose the group. */
+   size_t uGroupCount;
+
+   /* The displacement of each group, or the slot itself, marked by
+   DIRECT_SLOT, for a group of one key. */
+   size_t *auDisplacements;
+
+   /* The slots, followed by one whose key offset is the size of
+   pcKeys, so that the next offset always bounds a key, or NULL if the
+   table was opened from a snapshot. */
+   struct SymTableSlot *psSlots;
+
+   /* The keys, each followed by its '\0', in slot order. */
+   char *pcKeys;
+
+   /* The size of pcKeys, which bounds every key offset. */
+   size_t uKeysSize;
+
+   /* The slots of a table opened from a snapshot, followed by one like
+   that of psSlots, or NULL. */
+   struct SymTableFileSlot *psFileSlots;
+
+   /* The serialized values of a table opened from a snapshot, or
+   NULL. */
+   char *pcValues;
+
+   /* The size of pcValues, which bounds every value offset. */
+   size_t uValuesSize;
+
+   /* The mapping of the snapshot file, which holds all of the above,
+   or NULL. */
+   void *pvMapping;
+
+   /* The size of the mapping. */
+   size_t uMappingSize;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTable is a "dummy" node that points to the first SymtableNode,
+store the current bucket counts, and number of bindings in the SymTable.
+While the SymTable grows incrementally, it also points to the old
+bucket array, whose buckets migrate a few at a time. */
+
+struct SymTable
+{
+   /* The pointer to the bucket array of pointers to nodes. */
+   struct SymTableNode **psBuckets;
+
+   /* The number of buckets, a power of two. */
+   size_t uBucketCount;
+
+   /* The old bucket array while growing incrementally, or NULL. */
+   struct SymTableNode **psOldBuckets;
+
+   /* The number of buckets in the old bucket array. */
+   size_t uOldBucketCount;
+
+   /* The index of the next old bucket to migrate. Old buckets below
+   this index are empty. */
+   size_t uRehashIndex;
+
+   /* The number of old buckets each operation migrates, or 0 if the
+   SymTable grows all at once. */
+   size_t uRehashStep;
+
+   /* The maximum number of bindings per bucket. */
+   double dMaxLoadFactor;
+
+   /* The number of bindings at which the bucket array grows. */
+   size_t uExpandAt;
+
+   /* The arena that owns the nodes, or NULL if each node is allocated
+   individually. */
+   struct SymTableArena *psArena;
+
+   /* The hash function. */
+   StrHash_T pfHash;
+
+   /* The seed of the hash function. */
+   size_t uSeed;
+
+   /* The only bucket while the SymTable is small, so that a small
+   SymTable needs no bucket array. */
+   struct SymTableNode *psSmallBucket;
+
+   /* The shards of a sharded SymTable, which holds no bindings itself,
+   or NULL. */
+   struct SymTableShard *psShards;
+
+   /* The number of shards, a power of two, or 0. */
+   size_t uShardCount;
+
+   /* The shift that turns a hash code into a shard index, so that the
+   shard depends on the high bits and the bucket on the low bits. */
+   int iShardShift;
+
+   /* The immutable form of a frozen SymTable, which has no nodes, or
+   NULL. */
+   struct SymTableFrozen *psFrozen;
+
+   /* The number of bindings. */
+   size_t num;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the full-width hash code for the key of length uLength at
+   pcKey under the hash function and seed of oSymTable. */
+
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+                            size_t uLength)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return (*oSymTable->pfHash)(pcKey, uLength, oSymTable->uSeed);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bytes in a node whose key has length uLength. */
+
+static size_t SymTable_nodeSize(size_t uLength)
+{
+   return sizeof(struct SymTableNode) + uLength + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new arena that owns no memory, or NULL if insufficient
+   memory is available. */
+
+static struct SymTableArena *SymTable_newArena(void)
+{
+   struct SymTableArena *psArena;
+
+   assert(sizeof(struct SymTableSlab) <= ARENA_ALIGNMENT);
+   assert(sizeof(struct SymTableBigNode) <= ARENA_ALIGNMENT);
+
+   psArena = (struct SymTableArena*)calloc(1, sizeof(struct SymTableArena));
+   if (psArena == NULL)
+      return NULL;
+
+   psArena->uNextSlabSize = ARENA_FIRST_SLAB_SIZE;
+   return psArena;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free psArena and all memory that it owns. */
+
+static void SymTable_freeArena(struct SymTableArena *psArena)
+{
+   struct SymTableSlab *psSlab;
+   struct SymTableSlab *psNextSlab;
+   struct SymTableBigNode *psBig;
+   struct SymTableBigNode *psNextBig;
+
+   assert(psArena != NULL);
+
+   for (psSlab = psArena->psSlabs; psSlab != NULL; psSlab = psNextSlab)
+   {
+      psNextSlab = psSlab->psNextSlab;
+      free(psSlab);
+   }
+   for (psBig = psArena->psBigNodes; psBig != NULL; psBig = psNextBig)
+   {
+      psNextBig = psBig->psNextBig;
+      free(psBig);
+   }
+   free(psArena);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return uSize bytes of memory owned by psArena, or NULL if
+   insufficient memory is available. */
+
+static void *SymTable_arenaAlloc(struct SymTableArena *psArena,
+                                 size_t uSize)
+{
+   struct SymTableBigNode *psBig;
+   struct SymTableSlab *psSlab;
+   struct SymTableNode *psNode;
+   size_t uClass;
+
+   assert(psArena != NULL && uSize > 0);
+
+   /* Allocate a big node individually, and link it into the list of
+      big nodes. */
+   if (uSize > ARENA_MAX_POOLED_SIZE)
+   {
+      psBig = (struct SymTableBigNode*)malloc(ARENA_ALIGNMENT + uSize);
+      if (psBig == NULL)
+         return NULL;
+      psBig->psPrevBig = NULL;
+      psBig->psNextBig = psArena->psBigNodes;
+      if (psArena->psBigNodes != NULL)
+         psArena->psBigNodes->psPrevBig = psBig;
+      psArena->psBigNodes = psBig;
+      return (char*)psBig + ARENA_ALIGNMENT;
+   }
+
+   /* Reuse a removed node of the same size class if there is one. */
+   uClass = (uSize - 1) / ARENA_ALIGNMENT;
+   psNode = psArena->apsFreeNodes[uClass];
+   if (psNode != NULL)
+   {
+      psArena->apsFreeNodes[uClass] = psNode->psNextNode;
+      return psNode;
+   }
+
+   /* Otherwise carve the node from the newest slab, starting a new
+      slab if the newest one is full.  Slabs double in size up to
+      ARENA_MAX_SLAB_SIZE, so small tables stay small. */
+   uSize = (uClass + 1) * ARENA_ALIGNMENT;
+   if ((size_t)(psArena->pcSlabEnd - psArena->pcSlabFree) < uSize)
+   {
+      psSlab = (struct SymTableSlab*)
+         malloc(ARENA_ALIGNMENT + psArena->uNextSlabSize);
+      if (psSlab == NULL)
+         return NULL;
+      psSlab->psNextSlab = psArena->psSlabs;
+      psArena->psSlabs = psSlab;
+      psArena->pcSlabFree = (char*)psSlab + ARENA_ALIGNMENT;
+      psArena->pcSlabEnd = psArena->pcSlabFree + psArena->uNextSlabSize;
+      if (psArena->uNextSlabSize < ARENA_MAX_SLAB_SIZE)
+         psArena->uNextSlabSize *= 2;
+   }
+
+   psNode = (struct SymTableNode*)psArena->pcSlabFree;
+   psArena->pcSlabFree += uSize;
+   return psNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return psNode, which psArena owns, to psArena for reuse. */
+
+static void SymTable_arenaFree(struct SymTableArena *psArena,
+                               struct SymTableNode *psNode)
+{
+   struct SymTableBigNode *psBig;
+   size_t uSize;
+   size_t uClass;
+
+   assert(psArena != NULL && psNode != NULL);
+
+   uSize = SymTable_nodeSize(psNode->uLength);
+
+   /* Unlink a big node and free it individually. */
+   if (uSize > ARENA_MAX_POOLED_SIZE)
+   {
+      psBig = (struct SymTableBigNode*)((char*)psNode - ARENA_ALIGNMENT);
+      if (psBig->psPrevBig != NULL)
+         psBig->psPrevBig->psNextBig = psBig->psNextBig;
+      else
+         psArena->psBigNodes = psBig->psNextBig;
+      if (psBig->psNextBig != NULL)
+         psBig->psNextBig->psPrevBig = psBig->psPrevBig;
+      free(psBig);
+      return;
+   }
+
+   uClass = (uSize - 1) / ARENA_ALIGNMENT;
+   psNode->psNextNode = psArena->apsFreeNodes[uClass];
+   psArena->apsFreeNodes[uClass] = psNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new node of oSymTable for a key of length uLength, or NULL
+   if insufficient memory is available. */
+
+static struct SymTableNode *SymTable_allocNode(SymTable_T oSymTable,
+                                               size_t uLength)
+{
+   assert(oSymTable != NULL);
+
+   if (oSymTable->psArena != NULL)
+      return (struct SymTableNode*)
+         SymTable_arenaAlloc(oSymTable->psArena, SymTable_nodeSize(uLength));
+   return (struct SymTableNode*)malloc(SymTable_nodeSize(uLength));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free psNode, a node of oSymTable. */
+
+static void SymTable_freeNode(SymTable_T oSymTable,
+                              struct SymTableNode *psNode)
+{
+   assert(oSymTable != NULL && psNode != NULL);
+
+   if (oSymTable->psArena != NULL)
+      SymTable_arenaFree(oSymTable->psArena, psNode);
+   else
+      free(psNode);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bindings at which a bucket array of
+   uBucketCount buckets grows under load factor dMaxLoadFactor.  The
+   inline bucket of a small SymTable is scanned linearly, so it ignores
+   the load factor. */
+
+static size_t SymTable_expandAt(size_t uBucketCount,
+                                double dMaxLoadFactor)
+{
+   double dExpandAt = (double)uBucketCount * dMaxLoadFactor;
+
+   if (uBucketCount == 1)
+      return SMALL_TABLE_SIZE;
+
+   if (dExpandAt < 1.0)
+      return 1;
+   if (dExpandAt >= (double)((size_t)-1))
+      return (size_t)-1;
+   return (size_t)dExpandAt;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return uRehashStep, raised if need be so that the bindings that a
+   table of maximum load factor dMaxLoadFactor gains between one
+   doubling and the next migrate every old bucket.  There are about the
+   old bucket count times dMaxLoadFactor of those bindings, less one
+   for the rounding of SymTable_expandAt, and each migrates the step,
+   so a step above 1 / dMaxLoadFactor suffices. */
+
+static size_t SymTable_rehashStepFor(size_t uRehashStep,
+                                     double dMaxLoadFactor)
+{
+   double dMinStep = 1.0 / dMaxLoadFactor;
+   size_t uMinStep;
+
+   assert(dMaxLoadFactor > 0.0);
+
+   if (uRehashStep == 0)
+      return 0;
+   if (dMinStep >= (double)((size_t)-1))
+      return (size_t)-1;
+   uMinStep = (size_t)dMinStep + 1;
+   return uRehashStep < uMinStep ? uMinStep : uRehashStep;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the smallest power-of-two bucket count that holds uCount
+   bindings under load factor dMaxLoadFactor without growing, which is
+   1 if the inline bucket suffices. */
+
+static size_t SymTable_bucketCountFor(size_t uCount, double dMaxLoadFactor)
+{
+   size_t uBucketCount = 1;
+
+   while (SymTable_expandAt(uBucketCount, dMaxLoadFactor) < uCount &&
+          uBucketCount <= ((size_t)-1) / sizeof(struct SymTableNode*) / 2)
+      uBucketCount *= 2;
+   return uBucketCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a bucket array of uBucketCount empty buckets for oSymTable,
+   or NULL if insufficient memory is available.  An array of one
+   bucket is the inline bucket of oSymTable, which must not be in
+   use. */
+
+static struct SymTableNode **SymTable_newBucketArray(SymTable_T oSymTable,
+                                                     size_t uBucketCount)
+{
+   assert(oSymTable != NULL && uBucketCount > 0);
+
+   if (uBucketCount == 1)
+   {
+      oSymTable->psSmallBucket = NULL;
+      return &oSymTable->psSmallBucket;
+   }
+   return (struct SymTableNode**)
+      calloc(uBucketCount, sizeof(struct SymTableNode*));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free psBuckets, a bucket array of oSymTable, unless it is the inline
+   bucket of oSymTable. */
+
+static void SymTable_freeBucketArray(SymTable_T oSymTable,
+                                     struct SymTableNode **psBuckets)
+{
+   assert(oSymTable != NULL && psBuckets != NULL);
+
+   if (psBuckets != &oSymTable->psSmallBucket)
+      free(psBuckets);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if psNode holds the key pcKey, whose hash code is
+   uHash and whose length is uLength.  Otherwise return 0 (FALSE).
+   The key bytes are compared only when the cached hash codes and
+   lengths agree. */
+
+static int SymTable_matches(const struct SymTableNode *psNode,
+                            const char *pcKey, size_t uHash,
+                            size_t uLength)
+{
+   assert(psNode != NULL && pcKey != NULL);
+
+   return psNode->uHash == uHash && psNode->uLength == uLength &&
+      memcmp(psNode->acKey, pcKey, uLength) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Search the bucket of psBuckets, an array of uBucketCount buckets,
+   that holds keys with hash code uHash for the node whose key is pcKey.
+   Return the address of the link (the bucket itself or a psNextNode
+   field) that points to that node, or NULL if there is no such node. */
+
+static struct SymTableNode **SymTable_findInBuckets(
+   struct SymTableNode **psBuckets, size_t uBucketCount,
+   const char *pcKey, size_t uHash, size_t uLength)
+{
+   struct SymTableNode **ppsLink;
+
+   assert(psBuckets != NULL && pcKey != NULL);
+
+   for (ppsLink = &psBuckets[uHash & (uBucketCount - 1)];
+        *ppsLink != NULL;
+        ppsLink = &(*ppsLink)->psNextNode)
+   {
+      if (SymTable_matches(*ppsLink, pcKey, uHash, uLength))
+         return ppsLink;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the address of the link that points to the node of oSymTable
+   whose key is pcKey, or NULL if there is no such node.  While
+   oSymTable grows incrementally, the node may be in either bucket
+   array. */
+
+static struct SymTableNode **SymTable_findLink(SymTable_T oSymTable,
+   const char *pcKey, size_t uHash, size_t uLength)
+{
+   struct SymTableNode **ppsLink;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (oSymTable->psOldBuckets != NULL)
+   {
+      ppsLink = SymTable_findInBuckets(oSymTable->psOldBuckets,
+                                       oSymTable->uOldBucketCount,
+                                       pcKey, uHash, uLength);
+      if (ppsLink != NULL)
+         return ppsLink;
+   }
+   return SymTable_findInBuckets(oSymTable->psBuckets,
+                                 oSymTable->uBucketCount,
+                                 pcKey, uHash, uLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the slot, among uSlotCount slots, of a key whose hash code is
+   uHash in a frozen group whose displacement is uDisplacement. */
+
+static size_t SymTable_displace(size_t uHash, size_t uDisplacement,
+                                size_t uSlotCount)
+{
+   size_t u;
+
+   assert(uSlotCount > 0);
+
+   /* Mix every bit of the hash code and the displacement, so that the
+      keys of one group land independently. */
+   u = uHash + uDisplacement * (size_t)0x9e3779b97f4a7c15ULL;
+   u ^= u >> 15;
+   u *= (size_t)0xd6e8feb86659fd93ULL;
+   u ^= u >> 16;
+   return u % uSlotCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the offset in the pool of keys of psFrozen of the key of slot
+   uSlot, or the size of the pool if uSlot is the number of slots. */
+
+static size_t SymTable_keyOffset(const struct SymTableFrozen *psFrozen,
+                                 size_t uSlot)
+{
+   assert(psFrozen != NULL);
+
+   if (psFrozen->psFileSlots != NULL)
+      return psFrozen->psFileSlots[uSlot].uKeyOffset;
+   return psFrozen->psSlots[uSlot].uKeyOffset;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the value of slot uSlot of psFrozen, which for a table opened
+   from a snapshot is the address of its bytes in the mapping, or NULL
+   if the snapshot places them outside its pool of values. */
+
+static void *SymTable_slotValue(const struct SymTableFrozen *psFrozen,
+                                size_t uSlot)
+{
+   size_t uValueOffset;
+
+   assert(psFrozen != NULL);
+
+   if (psFrozen->psFileSlots == NULL)
+      return (void*)psFrozen->psSlots[uSlot].pvValue;
+   uValueOffset = psFrozen->psFileSlots[uSlot].uValueOffset;
+   if (uValueOffset > psFrozen->uValuesSize)
+      return NULL;
+   return psFrozen->pcValues + uValueOffset;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the slot of the frozen oSymTable, which is not empty, to
+   which its minimal perfect hash function maps the hash code uHash,
+   or oSymTable->num if the group of uHash names a slot beyond the
+   last, as only that of a corrupt snapshot can. */
+
+static size_t SymTable_frozenSlot(SymTable_T oSymTable, size_t uHash)
+{
+   const struct SymTableFrozen *psFrozen;
+   size_t uDisplacement;
+   size_t uSlot;
+
+   assert(oSymTable != NULL && oSymTable->psFrozen != NULL);
+   assert(oSymTable->num > 0);
+
+   psFrozen = oSymTable->psFrozen;
+   uDisplacement =
+      psFrozen->auDisplacements[uHash & (psFrozen->uGroupCount - 1)];
+   if (uDisplacement & DIRECT_SLOT)
+   {
+      uSlot = uDisplacement & ~DIRECT_SLOT;
+      return uSlot < oSymTable->num ? uSlot : oSymTable->num;
+   }
+   return SymTable_displace(uHash, uDisplacement, oSymTable->num);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if slot uSlot of the frozen oSymTable, which may be
+   oSymTable->num, holds the key of length uLength at pcKey.  Otherwise
+   return 0 (FALSE). */
+
+static int SymTable_frozenMatches(SymTable_T oSymTable, size_t uSlot,
+                                  const char *pcKey, size_t uLength)
+{
+   const struct SymTableFrozen *psFrozen;
+   size_t uOffset;
+   size_t uEnd;
+
+   assert(oSymTable != NULL && oSymTable->psFrozen != NULL);
+   assert(uSlot <= oSymTable->num && pcKey != NULL);
+
+   if (uSlot == oSymTable->num)
+      return 0;
+
+   /* The offsets of adjacent slots give the key's length, with its
+      '\0'.  Those of a snapshot are checked against each other and
+      the pool, so that no key is read from outside it. */
+   psFrozen = oSymTable->psFrozen;
+   uOffset = SymTable_keyOffset(psFrozen, uSlot);
+   uEnd = SymTable_keyOffset(psFrozen, uSlot + 1);
+   return uOffset <= uEnd && uEnd <= psFrozen->uKeysSize
+      && uEnd - uOffset == uLength + 1
+      && memcmp(psFrozen->pcKeys + uOffset, pcKey, uLength) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the slot of the frozen oSymTable that holds the key of length
+   uLength at pcKey, whose hash code is uHash, or oSymTable->num if
+   there is no such key.  Only that slot's key is compared. */
+
+static size_t SymTable_frozenFind(SymTable_T oSymTable, const char *pcKey,
+                                  size_t uHash, size_t uLength)
+{
+   size_t uSlot;
+
+   assert(oSymTable != NULL && oSymTable->psFrozen != NULL);
+   assert(pcKey != NULL);
+
+   if (oSymTable->num == 0)
+      return 0;
+
+   uSlot = SymTable_frozenSlot(oSymTable, uHash);
+   if (! SymTable_frozenMatches(oSymTable, uSlot, pcKey, uLength))
+      return oSymTable->num;
+   return uSlot;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move every node of bucket psBucket into the bucket array psBuckets,
+   which has uBucketCount buckets, and leave psBucket empty. */
+
+static void SymTable_moveBucket(struct SymTableNode **psBucket,
+                                struct SymTableNode **psBuckets,
+                                size_t uBucketCount)
+{
+   struct SymTableNode *psCurrentNode;
+   struct SymTableNode *psNextNode;
+   size_t hashKey;
+
+   assert(psBucket != NULL && psBuckets != NULL);
+
+   for (psCurrentNode = *psBucket;
+        psCurrentNode != NULL;
+        psCurrentNode = psNextNode)
+   {
+      hashKey = psCurrentNode->uHash & (uBucketCount - 1);
+      psNextNode = psCurrentNode->psNextNode;
+      psCurrentNode->psNextNode = psBuckets[hashKey];
+      psBuckets[hashKey] = psCurrentNode;
+   }
+   *psBucket = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Migrate up to uBuckets buckets of the old bucket array of oSymTable
+   into its new bucket array.  Free the old bucket array once every
+   old bucket has migrated. */
+
+static void SymTable_rehashStep(SymTable_T oSymTable, size_t uBuckets)
+{
+   assert(oSymTable != NULL && oSymTable->psOldBuckets != NULL);
+
+   while (uBuckets > 0 &&
+          oSymTable->uRehashIndex < oSymTable->uOldBucketCount)
+   {
+      SymTable_moveBucket(
+         &oSymTable->psOldBuckets[oSymTable->uRehashIndex],
+         oSymTable->psBuckets, oSymTable->uBucketCount);
+      oSymTable->uRehashIndex++;
+      uBuckets--;
+   }
+
+   if (oSymTable->uRehashIndex == oSymTable->uOldBucketCount)
+   {
+      SymTable_freeBucketArray(oSymTable, oSymTable->psOldBuckets);
+      oSymTable->psOldBuckets = NULL;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Let an operation on oSymTable carry an incremental growth forward
+   by a bounded number of buckets. */
+
+static void SymTable_step(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+
+   if (oSymTable->psOldBuckets != NULL)
+      SymTable_rehashStep(oSymTable, oSymTable->uRehashStep);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index of the shard of the sharded SymTable oSymTable
+   that holds the keys whose hash code is uHash. */
+
+static size_t SymTable_shardIndex(SymTable_T oSymTable, size_t uHash)
+{
+   assert(oSymTable != NULL && oSymTable->psShards != NULL);
+
+   /* A shift by the full width of size_t would be undefined. */
+   if (oSymTable->uShardCount == 1)
+      return 0;
+   return uHash >> oSymTable->iShardShift;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if a map holds the lock of psShard for the calling
+   thread, or 0 (FALSE) otherwise. */
+
+static int SymTable_isMapped(const struct SymTableShard *psShard)
+{
+   const struct SymTableMapFrame *psFrame;
+
+   assert(psShard != NULL);
+
+   for (psFrame = psMapFrame; psFrame != NULL;
+        psFrame = psFrame->psOuterFrame)
+      if (psFrame->psShard == psShard)
+         return 1;
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lock psShard, alone if iWrite is nonzero or shared otherwise,
+   unless a map already holds its lock for the calling thread. */
+
+static void SymTable_acquireShard(struct SymTableShard *psShard,
+                                  int iWrite)
+{
+   assert(psShard != NULL);
+
+   if (SymTable_isMapped(psShard))
+      return;
+   if (iWrite)
+      pthread_rwlock_wrlock(&psShard->sLock);
+   else
+      pthread_rwlock_rdlock(&psShard->sLock);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Unlock psShard, which SymTable_acquireShard locked, unless a map
+   holds its lock for the calling thread. */
+
+static void SymTable_releaseShard(struct SymTableShard *psShard)
+{
+   assert(psShard != NULL);
+
+   if (! SymTable_isMapped(psShard))
+      pthread_rwlock_unlock(&psShard->sLock);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the table that holds the keys of oSymTable whose hash code is
+   uHash: oSymTable itself, or if oSymTable is sharded, the table of
+   the shard of uHash, after locking that shard, alone if iWrite is
+   nonzero or shared otherwise. */
+
+static SymTable_T SymTable_lockShard(SymTable_T oSymTable, size_t uHash,
+                                     int iWrite)
+{
+   struct SymTableShard *psShard;
+
+   assert(oSymTable != NULL);
+
+   if (oSymTable->psShards == NULL)
+      return oSymTable;
+
+   psShard = &oSymTable->psShards[SymTable_shardIndex(oSymTable, uHash)];
+   SymTable_acquireShard(psShard, iWrite);
+   return psShard->oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Unlock the shard that SymTable_lockShard locked for uHash, if
+   oSymTable is sharded. */
+
+static void SymTable_unlockShard(SymTable_T oSymTable, size_t uHash)
+{
+   assert(oSymTable != NULL);
+
+   if (oSymTable->psShards != NULL)
+      SymTable_releaseShard(
+         &oSymTable->psShards[SymTable_shardIndex(oSymTable, uHash)]);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+   return SymTable_newWithOptions(NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithOptions(const struct SymTableOptions *psOptions)
+{
+   SymTable_T oSymTable;
+
+   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->dMaxLoadFactor = DEFAULT_MAX_LOAD_FACTOR;
+   oSymTable->uRehashStep = 0;
+   oSymTable->pfHash = StrHash_forOption(SYMTABLE_HASH_DEFAULT);
+   oSymTable->uBucketCount = 1;
+   if (psOptions != NULL)
+   {
+      if (psOptions->dMaxLoadFactor > 0.0)
+         oSymTable->dMaxLoadFactor = psOptions->dMaxLoadFactor;
+      oSymTable->uRehashStep = SymTable_rehashStepFor(
+         psOptions->uRehashStep, oSymTable->dMaxLoadFactor);
+      oSymTable->pfHash = StrHash_forOption(psOptions->eHash);
+      if (psOptions->uCapacity > 0)
+         oSymTable->uBucketCount = SymTable_bucketCountFor(
+            psOptions->uCapacity, oSymTable->dMaxLoadFactor);
+   }
+   if (psOptions != NULL && psOptions->iFixedSeed)
+      oSymTable->uSeed = psOptions->uSeed;
+   else
+      oSymTable->uSeed = StrHash_randomSeed();
+
+   oSymTable->psBuckets =
+      SymTable_newBucketArray(oSymTable, oSymTable->uBucketCount);
+   if (oSymTable->psBuckets == NULL)
+   {
+    free(oSymTable);
+    return NULL;
+   }
+
+   oSymTable->psArena = NULL;
+   if (psOptions != NULL && psOptions->iUseArena)
+   {
+      oSymTable->psArena = SymTable_newArena();
+      if (oSymTable->psArena == NULL)
+      {
+         SymTable_freeBucketArray(oSymTable, oSymTable->psBuckets);
+         free(oSymTable);
+         return NULL;
+      }
+   }
+
+   oSymTable->psOldBuckets = NULL;
+   oSymTable->uOldBucketCount = 0;
+   oSymTable->uRehashIndex = 0;
+   oSymTable->psShards = NULL;
+   oSymTable->uShardCount = 0;
+   oSymTable->iShardShift = 0;
+   oSymTable->psFrozen = NULL;
+   oSymTable->uExpandAt = SymTable_expandAt(oSymTable->uBucketCount,
+                                            oSymTable->dMaxLoadFactor);
+   oSymTable->num = 0;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+   struct SymTableOptions sOptions;
+
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.uCapacity = uCapacity;
+   return SymTable_newWithOptions(&sOptions);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the tables of the first uShardCount shards of psShards, and
+   destroy their locks. */
+
+static void SymTable_freeShards(struct SymTableShard *psShards,
+                                size_t uShardCount)
+{
+   size_t u;
+
+   assert(psShards != NULL || uShardCount == 0);
+
+   for (u = 0; u < uShardCount; u++)
+   {
+      SymTable_free(psShards[u].oSymTable);
+      pthread_rwlock_destroy(&psShards[u].sLock);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newSharded(size_t uShardCount)
+{
+   struct SymTableOptions sOptions;
+   struct SymTableShard *psShards;
+   SymTable_T oSymTable;
+   size_t uCount = 1;
+   int iShift = (int)(sizeof(size_t) * CHAR_BIT);
+   size_t u;
+
+   /* Round the shard count up to a power of two, so that a shard index
+      is the top bits of a hash code. */
+   while (uCount < uShardCount && uCount < MAX_SHARD_COUNT)
+   {
+      uCount *= 2;
+      iShift--;
+   }
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return NULL;
+   psShards = (struct SymTableShard*)
+      calloc(uCount, sizeof(struct SymTableShard));
+   if (psShards == NULL)
+   {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+
+   /* Every shard hashes as the front table does, so a key is hashed
+      once, both to choose its shard and its bucket. */
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.iFixedSeed = 1;
+   sOptions.uSeed = oSymTable->uSeed;
+   for (u = 0; u < uCount; u++)
+   {
+      psShards[u].oSymTable = SymTable_newWithOptions(&sOptions);
+      if (psShards[u].oSymTable == NULL ||
+          pthread_rwlock_init(&psShards[u].sLock, NULL) != 0)
+      {
+         if (psShards[u].oSymTable != NULL)
+            SymTable_free(psShards[u].oSymTable);
+         SymTable_freeShards(psShards, u);
+         free(psShards);
+         SymTable_free(oSymTable);
+         return NULL;
+      }
+      psShards[u].oSymTable->pfHash = oSymTable->pfHash;
+   }
+
+   oSymTable->psShards = psShards;
+   oSymTable->uShardCount = uCount;
+   oSymTable->iShardShift = iShift;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free every node in psBuckets, an array of uBucketCount buckets, but
+   not the array itself. */
+
+static void SymTable_freeBuckets(struct SymTableNode **psBuckets,
+                                 size_t uBucketCount)
+{
+   struct SymTableNode *psCurrentNode;
+   struct SymTableNode *psNextNode;
+   size_t i;
+
+   assert(psBuckets != NULL);
+
+   for(i = 0; i < uBucketCount; i++)
+   {
+    /* Iterate through the linked list to free all nodes in bucket i. */
+    for (psCurrentNode = psBuckets[i];
+            psCurrentNode != NULL;
+            psCurrentNode = psNextNode)
+    {
+        psNextNode = psCurrentNode->psNextNode;
+        psBuckets[i] = psNextNode;
+        free(psCurrentNode);
+    }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free every node and bucket array of oSymTable, and its arena, but
+   not oSymTable itself. */
+
+static void SymTable_freeNodes(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+
+   /* An arena releases all nodes at once, without visiting them. */
+   if (oSymTable->psArena != NULL)
+   {
+      if (oSymTable->psOldBuckets != NULL)
+         SymTable_freeBucketArray(oSymTable, oSymTable->psOldBuckets);
+      SymTable_freeBucketArray(oSymTable, oSymTable->psBuckets);
+      SymTable_freeArena(oSymTable->psArena);
+      return;
+   }
+
+   if (oSymTable->psOldBuckets != NULL)
+   {
+      SymTable_freeBuckets(oSymTable->psOldBuckets,
+                           oSymTable->uOldBucketCount);
+      SymTable_freeBucketArray(oSymTable, oSymTable->psOldBuckets);
+   }
+   SymTable_freeBuckets(oSymTable->psBuckets, oSymTable->uBucketCount);
+   SymTable_freeBucketArray(oSymTable, oSymTable->psBuckets);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free psFrozen, the immutable form of a frozen SymTable. */
+
+static void SymTable_freeFrozen(struct SymTableFrozen *psFrozen)
+{
+   assert(psFrozen != NULL);
+
+   if (psFrozen->pvMapping != NULL)
+   {
+      munmap(psFrozen->pvMapping, psFrozen->uMappingSize);
+      free(psFrozen);
+      return;
+   }
+
+   free(psFrozen->auDisplacements);
+   free(psFrozen->psSlots);
+   free(psFrozen->pcKeys);
+   free(psFrozen);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+
+   if (oSymTable->psShards != NULL)
+   {
+      SymTable_freeShards(oSymTable->psShards, oSymTable->uShardCount);
+      free(oSymTable->psShards);
+   }
+
+   if (oSymTable->psFrozen != NULL)
+      SymTable_freeFrozen(oSymTable->psFrozen);
+   SymTable_freeNodes(oSymTable);
+   free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+   struct SymTableShard *psShard;
+   size_t uLength = 0;
+   size_t u;
+
+   assert(oSymTable != NULL);
+
+   if (oSymTable->psShards == NULL)
+      return oSymTable->num;
+
+   for (u = 0; u < oSymTable->uShardCount; u++)
+   {
+      psShard = &oSymTable->psShards[u];
+      SymTable_acquireShard(psShard, 0);
+      uLength += psShard->oSymTable->num;
+      SymTable_releaseShard(psShard);
+   }
+   return uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Give the oSymTable object a bucket array of uNewCount buckets, which
+   may be more or fewer than it has now.  If oSymTable grows
+   incrementally, only allocate the new bucket array; later operations
+   migrate the old buckets.  Return 1 (TRUE) if successful, or 0
+   (FALSE) if insufficient memory is available, in which case leave
+   oSymTable unchanged. */
+
+static int SymTable_resize(SymTable_T oSymTable, size_t uNewCount)
+{
+   struct SymTableNode **psNewBuckets;
+   size_t i;
+
+   assert(oSymTable != NULL && uNewCount > 0);
+
+   /* Finish any previous incremental resize before starting another. */
+   if (oSymTable->psOldBuckets != NULL)
+      SymTable_rehashStep(oSymTable, oSymTable->uOldBucketCount);
+
+   psNewBuckets = SymTable_newBucketArray(oSymTable, uNewCount);
+   if (psNewBuckets == NULL)
+   {
+      return 0;
+   }
+
+   if (oSymTable->uRehashStep > 0)
+   {
+      oSymTable->psOldBuckets = oSymTable->psBuckets;
+      oSymTable->uOldBucketCount = oSymTable->uBucketCount;
+      oSymTable->uRehashIndex = 0;
+   }
+   else
+   {
+      /* Re-hash all nodes at once, then free old buckets. */
+      for(i = 0; i < oSymTable->uBucketCount; i++)
+         SymTable_moveBucket(&oSymTable->psBuckets[i], psNewBuckets,
+                             uNewCount);
+      SymTable_freeBucketArray(oSymTable, oSymTable->psBuckets);
+   }
+
+   /* Update the SymTable. */
+   oSymTable->psBuckets = psNewBuckets;
+   oSymTable->uBucketCount = uNewCount;
+   oSymTable->uExpandAt = SymTable_expandAt(uNewCount,
+                                            oSymTable->dMaxLoadFactor);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Double the number of buckets of the oSymTable object.  If
+   insufficient memory is available, leave oSymTable unchanged. */
+
+static void SymTable_expand(SymTable_T oSymTable)
+{
+   size_t uNewCount;
+
+   assert(oSymTable != NULL);
+
+   /* A small SymTable moves straight to a bucket array that holds
+      twice as many bindings as its inline bucket. */
+   if (oSymTable->uBucketCount == 1)
+      uNewCount = SymTable_bucketCountFor(2 * SMALL_TABLE_SIZE,
+                                          oSymTable->dMaxLoadFactor);
+   else
+      uNewCount = oSymTable->uBucketCount * 2;
+
+   /* Stop growing only when the bucket array could not be indexed. */
+   if (uNewCount > ((size_t)-1) / sizeof(struct SymTableNode*))
+   {
+      oSymTable->uExpandAt = (size_t)-1;
+      return;
+   }
+
+   (void)SymTable_resize(oSymTable, uNewCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount)
+{
+   struct SymTableShard *psShard;
+   size_t uNewCount;
+   size_t uShare;
+   size_t u;
+   int iSuccessful = 1;
+
+   assert(oSymTable != NULL);
+
+   if (oSymTable->psFrozen != NULL)
+      return 0;
+
+   /* Give each shard an even share of the count, plus an eighth for
+      keys that spread unevenly. */
+   if (oSymTable->psShards != NULL)
+   {
+      uShare = uCount / oSymTable->uShardCount;
+      uShare += uShare / 8 + 1;
+      for (u = 0; u < oSymTable->uShardCount; u++)
+      {
+         psShard = &oSymTable->psShards[u];
+         SymTable_acquireShard(psShard, 1);
+         if (! SymTable_reserve(psShard->oSymTable, uShare))
+            iSuccessful = 0;
+         SymTable_releaseShard(psShard);
+      }
+      return iSuccessful;
+   }
+
+   SymTable_step(oSymTable);
+
+   if (uCount <= oSymTable->uExpandAt)
+      return 1;
+
+   uNewCount = SymTable_bucketCountFor(uCount, oSymTable->dMaxLoadFactor);
+   if (uNewCount <= oSymTable->uBucketCount)
+      return 1;
+   return SymTable_resize(oSymTable, uNewCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_shrink(SymTable_T oSymTable)
+{
+   struct SymTableShard *psShard;
+   size_t uNewCount;
+   size_t u;
+
+   assert(oSymTable != NULL);
+
+   /* A frozen table is already as small as it can be. */
+   if (oSymTable->psFrozen != NULL)
+      return;
+
+   if (oSymTable->psShards != NULL)
+   {
+      for (u = 0; u < oSymTable->uShardCount; u++)
+      {
+         psShard = &oSymTable->psShards[u];
+         SymTable_acquireShard(psShard, 1);
+         SymTable_shrink(psShard->oSymTable);
+         SymTable_releaseShard(psShard);
+      }
+      return;
+   }
+
+   SymTable_step(oSymTable);
+
+   uNewCount = SymTable_bucketCountFor(oSymTable->num,
+                                       oSymTable->dMaxLoadFactor);
+   if (uNewCount < oSymTable->uBucketCount)
+      (void)SymTable_resize(oSymTable, uNewCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableGroup is a displacement group of a SymTable that is being
+   frozen. */
+
+struct SymTableGroup
+{
+   /* The number of keys in the group. */
+   size_t uSize;
+
+   /* The index of the group. */
+   size_t uGroup;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the SymTableGroups at pvFirst and pvSecond, so that larger
+   groups sort first and groups of equal size sort by index. */
+
+static int SymTable_compareGroups(const void *pvFirst,
+                                  const void *pvSecond)
+{
+   const struct SymTableGroup *psFirst;
+   const struct SymTableGroup *psSecond;
+
+   assert(pvFirst != NULL && pvSecond != NULL);
+
+   psFirst = (const struct SymTableGroup*)pvFirst;
+   psSecond = (const struct SymTableGroup*)pvSecond;
+   if (psFirst->uSize != psSecond->uSize)
+      return psFirst->uSize > psSecond->uSize ? -1 : 1;
+   if (psFirst->uGroup != psSecond->uGroup)
+      return psFirst->uGroup < psSecond->uGroup ? -1 : 1;
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Find a displacement for each of the uGroupCount groups, a power of
+   two, of the uCount keys whose hash codes are in auHashes, so that the
+   keys fill uCount slots one to one.  Store the displacements in
+   auDisplacements and the slot of each key in auSlots.  Return 1
+   (TRUE) if successful, or 0 (FALSE) if some group has no
+   displacement, because keys of the group share their hash codes, or
+   if insufficient memory is available. */
+
+static int SymTable_placeGroups(const size_t *auHashes, size_t uCount,
+                                size_t uGroupCount,
+                                size_t *auDisplacements, size_t *auSlots)
+{
+   struct SymTableGroup *psGroups;
+   size_t *auStarts;
+   size_t *auMembers;
+   char *acTaken;
+   const size_t *puMembers;
+   size_t uDisplacement;
+   size_t uGroup;
+   size_t uSize;
+   size_t uFree = 0;
+   size_t u;
+   size_t v;
+   int iPlaced = 1;
+
+   assert(auHashes != NULL && auDisplacements != NULL);
+   assert(auSlots != NULL && uGroupCount > 0);
+   assert((uGroupCount & (uGroupCount - 1)) == 0);
+
+   psGroups = (struct SymTableGroup*)
+      malloc(uGroupCount * sizeof(struct SymTableGroup));
+   auStarts = (size_t*)calloc(uGroupCount + 1, sizeof(size_t));
+   auMembers = (size_t*)malloc((uCount + 1) * sizeof(size_t));
+   acTaken = (char*)calloc(uCount + 1, 1);
+   if (psGroups == NULL || auStarts == NULL || auMembers == NULL ||
+       acTaken == NULL)
+   {
+      free(psGroups);
+      free(auStarts);
+      free(auMembers);
+      free(acTaken);
+      return 0;
+   }
+
+   /* Sort the keys by group, counting the keys of each group. */
+   for (u = 0; u < uCount; u++)
+      auStarts[(auHashes[u] & (uGroupCount - 1)) + 1]++;
+   for (u = 0; u < uGroupCount; u++)
+   {
+      auStarts[u + 1] += auStarts[u];
+      psGroups[u].uSize = 0;
+      psGroups[u].uGroup = u;
+   }
+   for (u = 0; u < uCount; u++)
+   {
+      uGroup = auHashes[u] & (uGroupCount - 1);
+      auMembers[auStarts[uGroup] + psGroups[uGroup].uSize++] = u;
+   }
+
+   /* Place the largest groups first, while most slots are free and a
+      displacement that suits all their keys is easy to find. */
+   qsort(psGroups, uGroupCount, sizeof(struct SymTableGroup),
+         SymTable_compareGroups);
+
+   for (u = 0; u < uGroupCount && iPlaced; u++)
+   {
+      uGroup = psGroups[u].uGroup;
+      uSize = psGroups[u].uSize;
+      puMembers = &auMembers[auStarts[uGroup]];
+
+      /* A group of one key, or none, takes any free slot directly,
+         which fills the last slots without a search. */
+      if (uSize <= 1)
+      {
+         auDisplacements[uGroup] = 0;
+         if (uSize == 0)
+            continue;
+         while (acTaken[uFree])
+            uFree++;
+         acTaken[uFree] = 1;
+         auSlots[puMembers[0]] = uFree;
+         auDisplacements[uGroup] = uFree | DIRECT_SLOT;
+         continue;
+      }
+
+      /* Try displacements until every key of the group lands in a
+         distinct free slot, releasing the slots of a failed try. */
+      iPlaced = 0;
+      for (uDisplacement = 0;
+           uDisplacement < MAX_DISPLACEMENT_COUNT && ! iPlaced;
+           uDisplacement++)
+      {
+         for (v = 0; v < uSize; v++)
+         {
+            auSlots[puMembers[v]] = SymTable_displace(
+               auHashes[puMembers[v]], uDisplacement, uCount);
+            if (acTaken[auSlots[puMembers[v]]])
+               break;
+            acTaken[auSlots[puMembers[v]]] = 1;
+         }
+         if (v == uSize)
+         {
+            auDisplacements[uGroup] = uDisplacement;
+            iPlaced = 1;
+         }
+         else
+            while (v > 0)
+               acTaken[auSlots[puMembers[--v]]] = 0;
+      }
+   }
+
+   free(psGroups);
+   free(auStarts);
+   free(auMembers);
+   free(acTaken);
+   return iPlaced;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Lay the bindings of oSymTable out in psFrozen, whose arrays are
+   allocated, using apsNodes, auHashes and auSlots, arrays of one
+   element per binding, for scratch.  Store in *puSeed the seed under
+   which psFrozen hashes its keys.  Return 1 (TRUE) if successful, or 0
+   (FALSE) if no minimal perfect hash function was found or
+   insufficient memory is available. */
+
+static int SymTable_buildFrozen(SymTable_T oSymTable,
+                                struct SymTableFrozen *psFrozen,
+                                struct SymTableNode **apsNodes,
+                                size_t *auHashes, size_t *auSlots,
+                                size_t *puSeed)
+{
+   struct SymTableNode *psNode;
+   size_t uCount;
+   size_t uPoolSize = 1;  /* A spare byte, as for the arrays. */
+   size_t uOffset;
+   size_t uSize;
+   size_t uBucket;
+   size_t u;
+   int iAttempt;
+
+   assert(oSymTable != NULL && psFrozen != NULL && apsNodes != NULL);
+   assert(auHashes != NULL && auSlots != NULL && puSeed != NULL);
+
+   uCount = 0;
+   for (uBucket = 0; uBucket < oSymTable->uBucketCount; uBucket++)
+      for (psNode = oSymTable->psBuckets[uBucket]; psNode != NULL;
+           psNode = psNode->psNextNode)
+      {
+         apsNodes[uCount] = psNode;
+         auHashes[uCount] = psNode->uHash;
+         uPoolSize += psNode->uLength + 1;
+         uCount++;
+      }
+   assert(uCount == oSymTable->num);
+
+   psFrozen->pcKeys = (char*)malloc(uPoolSize);
+   if (psFrozen->pcKeys == NULL)
+      return 0;
+
+   /* Keys whose hash codes are equal cannot be told apart by any
+      displacement, so on failure hash all the keys again under a new
+      seed, which lookups then use. */
+   *puSeed = oSymTable->uSeed;
+   for (iAttempt = 0; ; iAttempt++)
+   {
+      if (iAttempt == MAX_FREEZE_ATTEMPT_COUNT)
+         return 0;
+      if (iAttempt > 0)
+      {
+         *puSeed += (size_t)0x9e3779b97f4a7c15ULL;
+         for (u = 0; u < uCount; u++)
+            auHashes[u] = (*oSymTable->pfHash)(apsNodes[u]->acKey,
+                                               apsNodes[u]->uLength,
+                                               *puSeed);
+      }
+      if (SymTable_placeGroups(auHashes, uCount, psFrozen->uGroupCount,
+                               psFrozen->auDisplacements, auSlots))
+         break;
+   }
+
+   /* Lay the keys out in slot order: record the size of each key at
+      its slot, turn the sizes into offsets, then copy the keys. */
+   for (u = 0; u < uCount; u++)
+   {
+      psFrozen->psSlots[auSlots[u]].uKeyOffset = apsNodes[u]->uLength + 1;
+      psFrozen->psSlots[auSlots[u]].pvValue = apsNodes[u]->pvValue;
+   }
+   uOffset = 0;
+   for (u = 0; u < uCount; u++)
+   {
+      uSize = psFrozen->psSlots[u].uKeyOffset;
+      psFrozen->psSlots[u].uKeyOffset = uOffset;
+      uOffset += uSize;
+   }
+   psFrozen->psSlots[uCount].uKeyOffset = uOffset;
+   psFrozen->psSlots[uCount].pvValue = NULL;
+   psFrozen->uKeysSize = uOffset;
+   for (u = 0; u < uCount; u++)
+      memcpy(psFrozen->pcKeys + psFrozen->psSlots[auSlots[u]].uKeyOffset,
+             apsNodes[u]->acKey, apsNodes[u]->uLength + 1);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the immutable form of the bindings of oSymTable, which is
+   neither sharded nor frozen, and store in *puSeed the seed under
+   which it hashes its keys.  Leave oSymTable unchanged, except that
+   any incremental growth is finished.  Return NULL if no minimal
+   perfect hash function was found or insufficient memory is
+   available. */
+
+static struct SymTableFrozen *SymTable_newFrozen(SymTable_T oSymTable,
+                                                 size_t *puSeed)
+{
+   struct SymTableFrozen *psFrozen;
+   struct SymTableNode **apsNodes;
+   size_t *auHashes;
+   size_t *auSlots;
+   size_t uCount;
+   int iSuccessful = 0;
+
+   assert(oSymTable != NULL && puSeed != NULL);
+   assert(oSymTable->psShards == NULL && oSymTable->psFrozen == NULL);
+
+   if (oSymTable->psOldBuckets != NULL)
+      SymTable_rehashStep(oSymTable, oSymTable->uOldBucketCount);
+
+   /* Each array has room for one element more than the bindings need,
+      so that an empty table allocates no zero-byte blocks. */
+   uCount = oSymTable->num;
+   psFrozen = (struct SymTableFrozen*)
+      calloc(1, sizeof(struct SymTableFrozen));
+   if (psFrozen == NULL)
+      return NULL;
+   psFrozen->uGroupCount = 1;
+   while (psFrozen->uGroupCount * FROZEN_GROUP_SIZE <= uCount)
+      psFrozen->uGroupCount *= 2;
+   psFrozen->auDisplacements = (size_t*)
+      malloc(psFrozen->uGroupCount * sizeof(size_t));
+   psFrozen->psSlots = (struct SymTableSlot*)
+      malloc((uCount + 1) * sizeof(struct SymTableSlot));
+   apsNodes = (struct SymTableNode**)
+      malloc((uCount + 1) * sizeof(struct SymTableNode*));
+   auHashes = (size_t*)malloc((uCount + 1) * sizeof(size_t));
+   auSlots = (size_t*)malloc((uCount + 1) * sizeof(size_t));
+
+   if (psFrozen->auDisplacements != NULL && psFrozen->psSlots != NULL &&
+       apsNodes != NULL && auHashes != NULL && auSlots != NULL)
+      iSuccessful = SymTable_buildFrozen(oSymTable, psFrozen, apsNodes,
+                                         auHashes, auSlots, puSeed);
+   free(apsNodes);
+   free(auHashes);
+   free(auSlots);
+   if (! iSuccessful)
+   {
+      SymTable_freeFrozen(psFrozen);
+      return NULL;
+   }
+   return psFrozen;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_freeze(SymTable_T oSymTable)
+{
+   struct SymTableFrozen *psFrozen;
+   size_t uSeed;
+
+   assert(oSymTable != NULL);
+
+   if (oSymTable->psShards != NULL)
+      return 0;
+   if (oSymTable->psFrozen != NULL)
+      return 1;
+
+   psFrozen = SymTable_newFrozen(oSymTable, &uSeed);
+   if (psFrozen == NULL)
+      return 0;
+
+   /* Release the nodes, leaving an empty inline bucket that no
+      operation reads. */
+   SymTable_freeNodes(oSymTable);
+   oSymTable->psArena = NULL;
+   oSymTable->psBuckets = SymTable_newBucketArray(oSymTable, 1);
+   oSymTable->uBucketCount = 1;
+   oSymTable->uSeed = uSeed;
+   oSymTable->psFrozen = psFrozen;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the uSize bytes at pv to psFile, and add uSize to *puFileSize,
+   the number of bytes written so far.  Return 1 (TRUE) if successful,
+   or 0 (FALSE) if not. */
+
+static int SymTable_writeBytes(FILE *psFile, const void *pv, size_t uSize,
+                               size_t *puFileSize)
+{
+   assert(psFile != NULL && puFileSize != NULL);
+   assert(pv != NULL || uSize == 0);
+
+   if (uSize > 0 && fwrite(pv, 1, uSize, psFile) != uSize)
+      return 0;
+   *puFileSize += uSize;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write zeros to psFile until *puFileSize, the number of bytes written
+   so far, is a multiple of SNAPSHOT_ALIGNMENT.  Return 1 (TRUE) if
+   successful, or 0 (FALSE) if not. */
+
+static int SymTable_writePadding(FILE *psFile, size_t *puFileSize)
+{
+   static const char acZeros[SNAPSHOT_ALIGNMENT] = {0};
+
+   assert(psFile != NULL && puFileSize != NULL);
+
+   return SymTable_writeBytes(psFile, acZeros,
+      (SNAPSHOT_ALIGNMENT - *puFileSize % SNAPSHOT_ALIGNMENT)
+      % SNAPSHOT_ALIGNMENT, puFileSize);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash function of oSymTable as an enum SymTableHash. */
+
+static enum SymTableHash SymTable_hashId(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+
+   if (oSymTable->pfHash == StrHash_multiplicative)
+      return SYMTABLE_HASH_MULTIPLICATIVE;
+   if (oSymTable->pfHash == StrHash_siphash)
+      return SYMTABLE_HASH_SIPHASH;
+   return SYMTABLE_HASH_WYHASH;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to psFile a snapshot of psFrozen, the immutable form of the
+   bindings of oSymTable, whose keys hash under seed uSeed, serializing
+   each value with *pfSerialize.  auValueOffsets is scratch space of
+   one element per binding.  Return 1 (TRUE) if successful, or 0
+   (FALSE) if not. */
+
+static int SymTable_writeSnapshot(SymTable_T oSymTable,
+   const struct SymTableFrozen *psFrozen, size_t uSeed, FILE *psFile,
+   const void *(*pfSerialize)(const void *pvValue, size_t *puLength),
+   size_t *auValueOffsets)
+{
+   struct SymTableSnapshotHeader sHeader;
+   struct SymTableFileSlot sSlot;
+   const void *pvBytes;
+   size_t uFileSize = 0;
+   size_t uLength;
+   size_t u;
+
+   assert(oSymTable != NULL && psFrozen != NULL && psFile != NULL);
+   assert(pfSerialize != NULL && auValueOffsets != NULL);
+
+   memset(&sHeader, 0, sizeof(sHeader));
+   memcpy(sHeader.acMagic, SNAPSHOT_MAGIC, sizeof(sHeader.acMagic) - 2);
+   sHeader.acMagic[sizeof(sHeader.acMagic) - 2] = SNAPSHOT_VERSION;
+   sHeader.acMagic[sizeof(sHeader.acMagic) - 1] = (char)sizeof(size_t);
+   sHeader.uByteOrderMark = BYTE_ORDER_MARK;
+   sHeader.uHash = (size_t)SymTable_hashId(oSymTable);
+   sHeader.uSeed = uSeed;
+   sHeader.uCount = oSymTable->num;
+   sHeader.uGroupCount = psFrozen->uGroupCount;
+
+   /* Write the header once to reserve its place, and again when the
+      offsets of the sections are known.  The slots go last, since they
+      hold the offsets of the serialized values. */
+   if (! SymTable_writeBytes(psFile, &sHeader, sizeof(sHeader),
+                             &uFileSize) ||
+       ! SymTable_writePadding(psFile, &uFileSize))
+      return 0;
+
+   sHeader.uDisplacementsOffset = uFileSize;
+   if (! SymTable_writeBytes(psFile, psFrozen->auDisplacements,
+                             psFrozen->uGroupCount * sizeof(size_t),
+                             &uFileSize) ||
+       ! SymTable_writePadding(psFile, &uFileSize))
+      return 0;
+
+   sHeader.uKeysOffset = uFileSize;
+   if (! SymTable_writeBytes(psFile, psFrozen->pcKeys,
+                             SymTable_keyOffset(psFrozen, oSymTable->num),
+                             &uFileSize) ||
+       ! SymTable_writePadding(psFile, &uFileSize))
+      return 0;
+
+   /* Align each value's bytes, so that values that hold structures can
+      be read in place. */
+   sHeader.uValuesOffset = uFileSize;
+   for (u = 0; u < oSymTable->num; u++)
+   {
+      uLength = 0;
+      pvBytes = (*pfSerialize)(SymTable_slotValue(psFrozen, u), &uLength);
+      auValueOffsets[u] = uFileSize - sHeader.uValuesOffset;
+      if (! SymTable_writeBytes(psFile, pvBytes, uLength, &uFileSize) ||
+          ! SymTable_writePadding(psFile, &uFileSize))
+         return 0;
+   }
+
+   sHeader.uSlotsOffset = uFileSize;
+   for (u = 0; u <= oSymTable->num; u++)
+   {
+      sSlot.uKeyOffset = SymTable_keyOffset(psFrozen, u);
+      sSlot.uValueOffset = u < oSymTable->num ? auValueOffsets[u]
+         : sHeader.uSlotsOffset - sHeader.uValuesOffset;
+      if (! SymTable_writeBytes(psFile, &sSlot, sizeof(sSlot),
+                                &uFileSize))
+         return 0;
+   }
+
+   sHeader.uFileSize = uFileSize;
+   return fseek(psFile, 0L, SEEK_SET) == 0 &&
+      fwrite(&sHeader, sizeof(sHeader), 1, psFile) == 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_save(SymTable_T oSymTable, const char *pcPath,
+   const void *(*pfSerialize)(const void *pvValue, size_t *puLength))
+{
+   static const char acSuffix[] = ".tmp";
+   struct SymTableFrozen *psFrozen;
+   size_t *auValueOffsets;
+   char *pcTempPath;
+   size_t uSeed;
+   FILE *psFile = NULL;
+   int iSuccessful = 0;
+
+   assert(oSymTable != NULL && pcPath != NULL && pfSerialize != NULL);
+
+   if (oSymTable->psShards != NULL)
+      return 0;
+
+   /* A table that is not frozen is laid out for the snapshot alone,
+      and keeps its nodes. */
+   psFrozen = oSymTable->psFrozen;
+   uSeed = oSymTable->uSeed;
+   if (psFrozen == NULL)
+   {
+      psFrozen = SymTable_newFrozen(oSymTable, &uSeed);
+      if (psFrozen == NULL)
+         return 0;
+   }
+
+   /* Write beside pcPath and rename over it, so that the file is
+      replaced whole, and tables mapped from the old file keep it. */
+   auValueOffsets = (size_t*)
+      malloc((oSymTable->num + 1) * sizeof(size_t));
+   pcTempPath = (char*)malloc(strlen(pcPath) + sizeof(acSuffix));
+   if (pcTempPath != NULL)
+   {
+      strcpy(pcTempPath, pcPath);
+      strcat(pcTempPath, acSuffix);
+      psFile = fopen(pcTempPath, "wb");
+   }
+   if (auValueOffsets != NULL && psFile != NULL)
+      iSuccessful = SymTable_writeSnapshot(oSymTable, psFrozen, uSeed,
+                                           psFile, pfSerialize,
+                                           auValueOffsets);
+   if (psFile != NULL && fclose(psFile) != 0)
+      iSuccessful = 0;
+   if (iSuccessful && rename(pcTempPath, pcPath) != 0)
+      iSuccessful = 0;
+   if (psFile != NULL && ! iSuccessful)
+      (void)remove(pcTempPath);
+
+   free(pcTempPath);
+   free(auValueOffsets);
+   if (psFrozen != oSymTable->psFrozen)
+      SymTable_freeFrozen(psFrozen);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if the uSize bytes at psHeader begin with the header
+   of a snapshot that this build of the module can map, and every
+   section of the snapshot lies within them.  Otherwise return 0
+   (FALSE).  The contents of the sections are not checked. */
+
+static int SymTable_isSnapshot(const struct SymTableSnapshotHeader *psHeader,
+                               size_t uSize)
+{
+   const struct SymTableFileSlot *psEnd;
+
+   assert(psHeader != NULL && uSize >= sizeof(*psHeader));
+
+   if (memcmp(psHeader->acMagic, SNAPSHOT_MAGIC,
+              sizeof(psHeader->acMagic) - 2) != 0 ||
+       psHeader->acMagic[sizeof(psHeader->acMagic) - 2]
+          != SNAPSHOT_VERSION ||
+       psHeader->acMagic[sizeof(psHeader->acMagic) - 1]
+          != (char)sizeof(size_t) ||
+       psHeader->uByteOrderMark != BYTE_ORDER_MARK ||
+       psHeader->uHash > (size_t)SYMTABLE_HASH_SIPHASH ||
+       psHeader->uFileSize != uSize)
+      return 0;
+
+   /* Each section starts on an aligned offset and fits in the file.
+      The divisions keep the size checks from overflowing. */
+   if (psHeader->uGroupCount == 0 ||
+       (psHeader->uGroupCount & (psHeader->uGroupCount - 1)) != 0 ||
+       psHeader->uCount >= DIRECT_SLOT ||
+       psHeader->uDisplacementsOffset % SNAPSHOT_ALIGNMENT != 0 ||
+       psHeader->uKeysOffset % SNAPSHOT_ALIGNMENT != 0 ||
+       psHeader->uValuesOffset % SNAPSHOT_ALIGNMENT != 0 ||
+       psHeader->uSlotsOffset % SNAPSHOT_ALIGNMENT != 0 ||
+       psHeader->uDisplacementsOffset > uSize ||
+       psHeader->uKeysOffset > uSize ||
+       psHeader->uValuesOffset > uSize ||
+       psHeader->uSlotsOffset > uSize ||
+       (uSize - psHeader->uDisplacementsOffset) / sizeof(size_t)
+          < psHeader->uGroupCount ||
+       (uSize - psHeader->uSlotsOffset) / sizeof(struct SymTableFileSlot)
+          <= psHeader->uCount)
+      return 0;
+
+   /* The extra slot at the end bounds the keys and the values. */
+   psEnd = (const struct SymTableFileSlot*)
+      ((const char*)psHeader + psHeader->uSlotsOffset) + psHeader->uCount;
+   return psEnd->uKeyOffset <= uSize - psHeader->uKeysOffset &&
+      psEnd->uValueOffset <= uSize - psHeader->uValuesOffset;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_openMapped(const char *pcPath)
+{
+   struct SymTableOptions sOptions;
+   const struct SymTableSnapshotHeader *psHeader;
+   struct SymTableFrozen *psFrozen;
+   SymTable_T oSymTable;
+   struct stat sStat;
+   void *pvMapping;
+   char *pcMapping;
+   size_t uSize;
+   int iFile;
+
+   assert(pcPath != NULL);
+
+   iFile = open(pcPath, O_RDONLY);
+   if (iFile < 0)
+      return NULL;
+   if (fstat(iFile, &sStat) != 0 ||
+       sStat.st_size < (off_t)sizeof(struct SymTableSnapshotHeader))
+   {
+      (void)close(iFile);
+      return NULL;
+   }
+
+   /* The mapping outlives the descriptor. */
+   uSize = (size_t)sStat.st_size;
+   pvMapping = mmap(NULL, uSize, PROT_READ, MAP_SHARED, iFile, 0);
+   (void)close(iFile);
+   if (pvMapping == MAP_FAILED)
+      return NULL;
+
+   psHeader = (const struct SymTableSnapshotHeader*)pvMapping;
+   if (! SymTable_isSnapshot(psHeader, uSize))
+   {
+      munmap(pvMapping, uSize);
+      return NULL;
+   }
+
+   /* The table hashes as the saved one did, so that lookups follow the
+      saved minimal perfect hash function. */
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.eHash = (enum SymTableHash)psHeader->uHash;
+   sOptions.iFixedSeed = 1;
+   sOptions.uSeed = psHeader->uSeed;
+   oSymTable = SymTable_newWithOptions(&sOptions);
+   psFrozen = (struct SymTableFrozen*)
+      calloc(1, sizeof(struct SymTableFrozen));
+   if (oSymTable == NULL || psFrozen == NULL)
+   {
+      if (oSymTable != NULL)
+         SymTable_free(oSymTable);
+      free(psFrozen);
+      munmap(pvMapping, uSize);
+      return NULL;
+   }
+
+   /* Every section is answered from the mapping in place. */
+   pcMapping = (char*)pvMapping;
+   psFrozen->uGroupCount = psHeader->uGroupCount;
+   psFrozen->auDisplacements =
+      (size_t*)(pcMapping + psHeader->uDisplacementsOffset);
+   psFrozen->pcKeys = pcMapping + psHeader->uKeysOffset;
+   psFrozen->psFileSlots =
+      (struct SymTableFileSlot*)(pcMapping + psHeader->uSlotsOffset);
+   psFrozen->pcValues = pcMapping + psHeader->uValuesOffset;
+   psFrozen->uKeysSize = psFrozen->psFileSlots[psHeader->uCount].uKeyOffset;
+   psFrozen->uValuesSize =
+      psFrozen->psFileSlots[psHeader->uCount].uValueOffset;
+   psFrozen->pvMapping = pvMapping;
+   psFrozen->uMappingSize = uSize;
+
+   oSymTable->psFrozen = psFrozen;
+   oSymTable->num = psHeader->uCount;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add a new node to oSymTable holding the key of length uLength at
+   pcKey, whose hash code is uHash, and value pvValue, without checking
+   whether oSymTable already contains that key.  Return the new node,
+   or NULL if insufficient memory is available. */
+
+static struct SymTableNode *SymTable_addNode(SymTable_T oSymTable,
+                                             const char *pcKey,
+                                             size_t uHash, size_t uLength,
+                                             const void *pvValue)
+{
+   struct SymTableNode *psNewNode;
+   size_t hashKey;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   /* Expand the SymTable object's bucket count upon reaching capacity. */
+   if (oSymTable->num >= oSymTable->uExpandAt)
+   {
+      SymTable_expand(oSymTable);
+   }
+
+   /* Allocate memory for the new node and its key. Return NULL if
+   insufficient memory is available. */
+   psNewNode = SymTable_allocNode(oSymTable, uLength);
+   if (psNewNode == NULL)
+   {
+      return NULL;
+   }
+
+   /* Make a defensive copy of pcKey, which need not end in '\0'. */
+   memcpy(psNewNode->acKey, pcKey, uLength);
+   psNewNode->acKey[uLength] = '\0';
+
+   /* Update pvValue and insert the node to the front of its bucket in
+   the new bucket array. */
+   hashKey = uHash & (oSymTable->uBucketCount - 1);
+   psNewNode->pvValue = pvValue;
+   psNewNode->uHash = uHash;
+   psNewNode->uLength = uLength;
+   psNewNode->psNextNode = oSymTable->psBuckets[hashKey];
+
+   /* Update the SymTable. */
+   oSymTable->psBuckets[hashKey] = psNewNode;
+   oSymTable->num++;
+
+   return psNewNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add a new binding to oSymTable consisting of key pcKey, whose hash
+   code is uHash and whose length is uLength, and value pvValue and
+   return 1 (TRUE).  Return 0 (FALSE) if oSymTable already contains a
+   binding with key pcKey or insufficient memory is available. */
+
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+                           size_t uHash, size_t uLength,
+                           const void *pvValue)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   /* Return 0 if matching key is found. */
+   if (SymTable_findLink(oSymTable, pcKey, uHash, uLength) != NULL)
+      return 0;
+
+   return SymTable_addNode(oSymTable, pcKey, uHash, uLength,
+                           pvValue) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                  const void *pvValue)
+{
+   SymTable_T oShard;
+   size_t uHash;
+   int iAdded;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (oSymTable->psFrozen != NULL)
+      return 0;
+
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   oShard = SymTable_lockShard(oSymTable, uHash, 1);
+   SymTable_step(oShard);
+   iAdded = SymTable_insert(oShard, pcKey, uHash, uLength, pvValue);
+   SymTable_unlockShard(oSymTable, uHash);
+   return iAdded;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+{
+   struct SymTableNode **ppsLink;
+   SymTable_T oShard;
+   void *pvOldValue = NULL;
+   size_t uHash;
+   size_t uLength;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (oSymTable->psFrozen != NULL)
+      return NULL;
+
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   oShard = SymTable_lockShard(oSymTable, uHash, 1);
+   SymTable_step(oShard);
+   ppsLink = SymTable_findLink(oShard, pcKey, uHash, uLength);
+   if (ppsLink != NULL)
+   {
+      pvOldValue = (void*)(*ppsLink)->pvValue;
+      (*ppsLink)->pvValue = pvValue;
+   }
+   SymTable_unlockShard(oSymTable, uHash);
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                      const void *pvValue)
+{
+   struct SymTableNode **ppsLink;
+   SymTable_T oShard;
+   void *pvOldValue = NULL;
+   size_t uHash;
+   size_t uLength;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (oSymTable->psFrozen != NULL)
+      return NULL;
+
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   oShard = SymTable_lockShard(oSymTable, uHash, 1);
+   SymTable_step(oShard);
+   ppsLink = SymTable_findLink(oShard, pcKey, uHash, uLength);
+   if (ppsLink == NULL)
+      (void)SymTable_addNode(oShard, pcKey, uHash, uLength, pvValue);
+   else
+   {
+      pvOldValue = (void*)(*ppsLink)->pvValue;
+      (*ppsLink)->pvValue = pvValue;
+   }
+   SymTable_unlockShard(oSymTable, uHash);
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+const void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                               const void *pvValue)
+{
+   struct SymTableNode **ppsLink;
+   struct SymTableNode *psNode;
+   SymTable_T oShard;
+   size_t uHash;
+   size_t uLength;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (oSymTable->psFrozen != NULL)
+      return NULL;
+
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   oShard = SymTable_lockShard(oSymTable, uHash, 1);
+   SymTable_step(oShard);
+   ppsLink = SymTable_findLink(oShard, pcKey, uHash, uLength);
+   if (ppsLink != NULL)
+      psNode = *ppsLink;
+   else
+      psNode = SymTable_addNode(oShard, pcKey, uHash, uLength, pvValue);
+   SymTable_unlockShard(oSymTable, uHash);
+
+   if (psNode == NULL)
+      return NULL;
+   return &psNode->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   SymTable_T oShard;
+   size_t uHash;
+   int iFound;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   if (oSymTable->psFrozen != NULL)
+      return SymTable_frozenFind(oSymTable, pcKey, uHash, uLength)
+         != oSymTable->num;
+
+   oShard = SymTable_lockShard(oSymTable, uHash, 0);
+   SymTable_step(oShard);
+   iFound = SymTable_findLink(oShard, pcKey, uHash, uLength) != NULL;
+   SymTable_unlockShard(oSymTable, uHash);
+   return iFound;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+                    size_t uLength)
+{
+   struct SymTableNode **ppsLink;
+   SymTable_T oShard;
+   void *pvValue = NULL;
+   size_t uHash;
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   if (oSymTable->psFrozen != NULL)
+   {
+      uSlot = SymTable_frozenFind(oSymTable, pcKey, uHash, uLength);
+      if (uSlot == oSymTable->num)
+         return NULL;
+      return SymTable_slotValue(oSymTable->psFrozen, uSlot);
+   }
+
+   oShard = SymTable_lockShard(oSymTable, uHash, 0);
+   SymTable_step(oShard);
+   ppsLink = SymTable_findLink(oShard, pcKey, uHash, uLength);
+   if (ppsLink != NULL)
+      pvValue = (void*)(*ppsLink)->pvValue;
+   SymTable_unlockShard(oSymTable, uHash);
+   return pvValue;
+}
 
 /*--------------------------------------------------------------------*/
 
-/* The bucket counts array. */
-static const size_t auBucketCounts[] = {509, 1021, 2039, 4093, 8191, 
-                                        16381, 32746, 65521}; 
+/* Hash the uCount keys in apcKeys, at most BATCH_SIZE of them, into
+   auHashes and auLengths, and prefetch the buckets of oSymTable that
+   hold them and then the first node of each of those buckets, so that
+   the memory accesses of all the keys overlap. */
+
+static void SymTable_prefetchBatch(SymTable_T oSymTable,
+                                   const char **apcKeys, size_t uCount,
+                                   size_t *auHashes, size_t *auLengths)
+{
+   size_t uMask = oSymTable->uBucketCount - 1;
+   size_t uOldMask = oSymTable->uOldBucketCount - 1;
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL);
+   assert(auHashes != NULL && auLengths != NULL);
+   assert(uCount <= BATCH_SIZE);
+
+   for (u = 0; u < uCount; u++)
+   {
+      auLengths[u] = strlen(apcKeys[u]);
+      auHashes[u] = SymTable_hash(oSymTable, apcKeys[u], auLengths[u]);
+      PREFETCH(&oSymTable->psBuckets[auHashes[u] & uMask]);
+      if (oSymTable->psOldBuckets != NULL)
+         PREFETCH(&oSymTable->psOldBuckets[auHashes[u] & uOldMask]);
+   }
 
-/* The number of bucket counts. */
-static const size_t numBucketCounts =
-sizeof(auBucketCounts)/sizeof(auBucketCounts[0]);
+   for (u = 0; u < uCount; u++)
+   {
+      PREFETCH(oSymTable->psBuckets[auHashes[u] & uMask]);
+      if (oSymTable->psOldBuckets != NULL)
+         PREFETCH(oSymTable->psOldBuckets[auHashes[u] & uOldMask]);
+   }
+}
 
 /*--------------------------------------------------------------------*/
 
-/* Each key and value is stored in a SymTableNode.  SymTableNodes are 
-   linked to form a list.  */
+/* Look up the uCount keys in apcKeys in the frozen oSymTable, storing
+   their values, or NULL, in apvValues.  Each key's lookup is a chain
+   of dependent reads, of its displacement, its slot and its key, so
+   take each batch through the chain one link at a time, prefetching
+   the next link of every key before any is read. */
 
-struct SymTableNode
+static void SymTable_getFrozenBatch(SymTable_T oSymTable,
+                                    const char **apcKeys, size_t uCount,
+                                    void **apvValues)
 {
-   /* The key. */
-   const char *pcKey;
+   const struct SymTableFrozen *psFrozen;
+   size_t auHashes[BATCH_SIZE];
+   size_t auLengths[BATCH_SIZE];
+   size_t auSlots[BATCH_SIZE];
+   size_t uStart;
+   size_t uBatch;
+   size_t u;
 
-   /* The value. */
-   const void *pvValue;
+   assert(oSymTable != NULL && oSymTable->psFrozen != NULL);
+   assert(apcKeys != NULL && apvValues != NULL);
 
-   /* The address of the next SymtableNode. */
-   struct SymTableNode *psNextNode;
-};
+   psFrozen = oSymTable->psFrozen;
+   if (oSymTable->num == 0)
+   {
+      for (u = 0; u < uCount; u++)
+         apvValues[u] = NULL;
+      return;
+   }
 
-/*--------------------------------------------------------------------*/
+   for (uStart = 0; uStart < uCount; uStart += uBatch)
+   {
+      uBatch = uCount - uStart < BATCH_SIZE ? uCount - uStart : BATCH_SIZE;
+      for (u = 0; u < uBatch; u++)
+      {
+         auLengths[u] = strlen(apcKeys[uStart + u]);
+         auHashes[u] = SymTable_hash(oSymTable, apcKeys[uStart + u],
+                                     auLengths[u]);
+         PREFETCH(&psFrozen->auDisplacements[
+            auHashes[u] & (psFrozen->uGroupCount - 1)]);
+      }
+      for (u = 0; u < uBatch; u++)
+      {
+         auSlots[u] = SymTable_frozenSlot(oSymTable, auHashes[u]);
+         if (psFrozen->psFileSlots != NULL)
+            PREFETCH(&psFrozen->psFileSlots[auSlots[u]]);
+         else
+            PREFETCH(&psFrozen->psSlots[auSlots[u]]);
+      }
+      for (u = 0; u < uBatch; u++)
+         PREFETCH(psFrozen->pcKeys
+                  + SymTable_keyOffset(psFrozen, auSlots[u]));
+      for (u = 0; u < uBatch; u++)
+         apvValues[uStart + u] =
+            SymTable_frozenMatches(oSymTable, auSlots[u],
+                                   apcKeys[uStart + u], auLengths[u])
+            ? SymTable_slotValue(psFrozen, auSlots[u]) : NULL;
+   }
+}
 
-/* A SymTable is a "dummy" node that points to the first SymtableNode, 
-store the current bucket counts, and number of bindings in the SymTable. */
+/*--------------------------------------------------------------------*/
 
-struct SymTable
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+                       size_t uCount, void **apvValues)
 {
-   /* The pointer to the bucket array of pointers to nodes. */
-   struct SymTableNode **psBuckets;
+   struct SymTableNode *apsNodes[BATCH_SIZE];
+   struct SymTableNode **ppsLink;
+   size_t auHashes[BATCH_SIZE];
+   size_t auLengths[BATCH_SIZE];
+   size_t uStart;
+   size_t uBatch;
+   size_t u;
+   int iWalking;
 
-   /* The index of the current bucket count. */
-   size_t index;
+   assert(oSymTable != NULL && apcKeys != NULL && apvValues != NULL);
 
-   /* The number of bindings. */
-   size_t num;
-};
+   if (oSymTable->psFrozen != NULL)
+   {
+      SymTable_getFrozenBatch(oSymTable, apcKeys, uCount, apvValues);
+      return;
+   }
 
-/*--------------------------------------------------------------------*/
+   /* The keys of a batch may fall in different shards, so a sharded
+      table looks each key up on its own. */
+   if (oSymTable->psShards != NULL)
+   {
+      for (u = 0; u < uCount; u++)
+         apvValues[u] = SymTable_get(oSymTable, apcKeys[u]);
+      return;
+   }
+
+   SymTable_step(oSymTable);
+
+   for (uStart = 0; uStart < uCount; uStart += uBatch)
+   {
+      uBatch = uCount - uStart < BATCH_SIZE ? uCount - uStart : BATCH_SIZE;
+      SymTable_prefetchBatch(oSymTable, apcKeys + uStart, uBatch,
+                             auHashes, auLengths);
+
+      /* While the table grows incrementally, a node may be in either
+         bucket array, so search each key in turn. */
+      if (oSymTable->psOldBuckets != NULL)
+      {
+         for (u = 0; u < uBatch; u++)
+         {
+            ppsLink = SymTable_findLink(oSymTable, apcKeys[uStart + u],
+                                        auHashes[u], auLengths[u]);
+            apvValues[uStart + u] =
+               ppsLink == NULL ? NULL : (void*)(*ppsLink)->pvValue;
+         }
+         continue;
+      }
 
-/* Return a hash code for pcKey that is between 0 and uBucketCount-1,
-   inclusive. */
+      /* Otherwise walk all the chains in step, one node per chain per
+         pass, prefetching each chain's next node while the other
+         chains are examined. */
+      for (u = 0; u < uBatch; u++)
+      {
+         apsNodes[u] = oSymTable->psBuckets[auHashes[u] &
+                                            (oSymTable->uBucketCount - 1)];
+         apvValues[uStart + u] = NULL;
+      }
+      do
+      {
+         iWalking = 0;
+         for (u = 0; u < uBatch; u++)
+         {
+            if (apsNodes[u] == NULL)
+               continue;
+            if (SymTable_matches(apsNodes[u], apcKeys[uStart + u],
+                                 auHashes[u], auLengths[u]))
+            {
+               apvValues[uStart + u] = (void*)apsNodes[u]->pvValue;
+               apsNodes[u] = NULL;
+               continue;
+            }
+            apsNodes[u] = apsNodes[u]->psNextNode;
+            if (apsNodes[u] != NULL)
+            {
+               PREFETCH(apsNodes[u]);
+               iWalking = 1;
+            }
+         }
+      } while (iWalking);
+   }
+}
+
+/*--------------------------------------------------------------------*/
 
-static size_t SymTable_hash(const char *pcKey, size_t uBucketCount)
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+                         size_t uCount, const void **apvValues)
 {
-   const size_t HASH_MULTIPLIER = 65599;
+   size_t auHashes[BATCH_SIZE];
+   size_t auLengths[BATCH_SIZE];
+   size_t uAdded = 0;
+   size_t uStart;
+   size_t uBatch;
    size_t u;
-   size_t uHash = 0;
 
-   assert(pcKey != NULL);
+   assert(oSymTable != NULL && apcKeys != NULL && apvValues != NULL);
 
-   for (u = 0; pcKey[u] != '\0'; u++)
-      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+   if (oSymTable->psFrozen != NULL)
+      return 0;
+
+   if (oSymTable->psShards != NULL)
+   {
+      for (u = 0; u < uCount; u++)
+         uAdded += (size_t)SymTable_put(oSymTable, apcKeys[u],
+                                        apvValues[u]);
+      return uAdded;
+   }
 
-   return uHash % uBucketCount;
+   SymTable_step(oSymTable);
+
+   for (uStart = 0; uStart < uCount; uStart += uBatch)
+   {
+      uBatch = uCount - uStart < BATCH_SIZE ? uCount - uStart : BATCH_SIZE;
+      SymTable_prefetchBatch(oSymTable, apcKeys + uStart, uBatch,
+                             auHashes, auLengths);
+
+      /* Insert in order, so that a key repeated within the batch is
+         added once.  An insertion may grow the table, which only
+         wastes the remaining prefetches. */
+      for (u = 0; u < uBatch; u++)
+         uAdded += (size_t)SymTable_insert(oSymTable, apcKeys[uStart + u],
+                                           auHashes[u], auLengths[u],
+                                           apvValues[uStart + u]);
+   }
+   return uAdded;
 }
 
 /*--------------------------------------------------------------------*/
 
-SymTable_T SymTable_new(void)
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
 {
-   SymTable_T oSymTable;
+   assert(oSymTable != NULL && pcKey != NULL);
 
-   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
-   if (oSymTable == NULL)
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   struct SymTableNode **ppsLink;
+   struct SymTableNode *psCurrentNode;
+   SymTable_T oShard;
+   void *pvOldValue = NULL;
+   size_t uHash;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (oSymTable->psFrozen != NULL)
       return NULL;
 
-   oSymTable->psBuckets = (struct SymTableNode**)
-      calloc(auBucketCounts[0], sizeof(struct SymTableNode*));
-   if (oSymTable->psBuckets == NULL) 
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   oShard = SymTable_lockShard(oSymTable, uHash, 1);
+   SymTable_step(oShard);
+   ppsLink = SymTable_findLink(oShard, pcKey, uHash, uLength);
+   if (ppsLink != NULL)
    {
-    free(oSymTable);
-    return NULL;
+      /* Unlink the node of matched key and return its old value. */
+      psCurrentNode = *ppsLink;
+      pvOldValue = (void*)psCurrentNode->pvValue;
+      *ppsLink = psCurrentNode->psNextNode;
+      oShard->num--;
+      SymTable_freeNode(oShard, psCurrentNode);
    }
-
-   oSymTable->num = 0;
-   oSymTable->index = 0;
-   return oSymTable;
+   SymTable_unlockShard(oSymTable, uHash);
+   return pvOldValue;
 }
 
 /*--------------------------------------------------------------------*/
 
-void SymTable_free(SymTable_T oSymTable)
+/* Apply function *pfApply to each binding in psBuckets, an array of
+   uBucketCount buckets, passing pvExtra as an extra parameter. */
+
+static void SymTable_mapBuckets(struct SymTableNode **psBuckets,
+    size_t uBucketCount,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
 {
    struct SymTableNode *psCurrentNode;
-   struct SymTableNode *psNextNode;
    size_t i;
 
-   assert(oSymTable != NULL);
+   assert(psBuckets != NULL && pfApply != NULL);
 
-   for(i = 0; i < auBucketCounts[oSymTable->index]; i++)
+   for(i = 0; i < uBucketCount; i++)
    {
-    /* Iterate through the linked list to free all nodes in bucket i. */
-    for (psCurrentNode = oSymTable->psBuckets[i];
-            psCurrentNode != NULL;
-            psCurrentNode = psNextNode)
-    {
-        psNextNode = psCurrentNode->psNextNode;
-        oSymTable->psBuckets[i] = psNextNode;
-        free((char*)psCurrentNode->pcKey);
-        free(psCurrentNode);
-    }
+    for (psCurrentNode = psBuckets[i];
+         psCurrentNode != NULL;
+         psCurrentNode = psCurrentNode->psNextNode)
+         {
+            (*pfApply)(psCurrentNode->acKey, (void*)psCurrentNode->pvValue, (void*)pvExtra);
+         }
    }
-
-   free(oSymTable->psBuckets);
-   free(oSymTable);
 }
 
 /*--------------------------------------------------------------------*/
 
-size_t SymTable_getLength(SymTable_T oSymTable)
+/* Apply function *pfApply to the bindings in slots uBegin up to but not
+   including uEnd of the frozen oSymTable, passing pvExtra as an extra
+   parameter. */
+
+static void SymTable_mapFrozen(SymTable_T oSymTable, size_t uBegin,
+    size_t uEnd,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
 {
-   assert(oSymTable != NULL);
-   return oSymTable->num;
+   const struct SymTableFrozen *psFrozen;
+   size_t u;
+
+   assert(oSymTable != NULL && oSymTable->psFrozen != NULL);
+   assert(pfApply != NULL && uEnd <= oSymTable->num);
+
+   psFrozen = oSymTable->psFrozen;
+   for (u = uBegin; u < uEnd; u++)
+      (*pfApply)(psFrozen->pcKeys + SymTable_keyOffset(psFrozen, u),
+                 SymTable_slotValue(psFrozen, u), (void*)pvExtra);
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Increase the number of buckets of the oSymTable object. */
-static void SymTable_expand(SymTable_T oSymTable)
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
 {
-   struct SymTableNode *psCurrentNode;
-   struct SymTableNode *psNextNode;
-   struct SymTableNode **psNewBuckets;
-   size_t i;
-   size_t hashKey;
-   size_t newIndex = oSymTable->index + 1;
+   struct SymTableMapFrame sFrame;
+   struct SymTableShard *psShard;
+   size_t u;
 
-   /* Keep newIndex value within the size of bucket counts array. */
-   if (newIndex > numBucketCounts - 1)
-   {
-      return;
-   }
+   assert(oSymTable != NULL && pfApply != NULL);
 
-   psNewBuckets = (struct SymTableNode**)
-      calloc(auBucketCounts[newIndex], sizeof(struct SymTableNode*));
-   if (psNewBuckets == NULL) 
+   /* Share the lock of one shard at a time, so that writers to other
+      shards need not wait for the whole map, and record the shard in a
+      frame, so that *pfApply may use it without locking it again. */
+   if (oSymTable->psShards != NULL)
    {
+      sFrame.psOuterFrame = psMapFrame;
+      for (u = 0; u < oSymTable->uShardCount; u++)
+      {
+         psShard = &oSymTable->psShards[u];
+         SymTable_acquireShard(psShard, 0);
+         sFrame.psShard = psShard;
+         psMapFrame = &sFrame;
+         SymTable_map(psShard->oSymTable, pfApply, pvExtra);
+         psMapFrame = sFrame.psOuterFrame;
+         SymTable_releaseShard(psShard);
+      }
       return;
    }
 
-   for(i = 0; i < auBucketCounts[newIndex - 1]; i++)
+   if (oSymTable->psFrozen != NULL)
    {
-
-    /* Iterate through the linked list to re-hash all nodes in bucket i. */
-    for (psCurrentNode = oSymTable->psBuckets[i];
-            psCurrentNode != NULL;
-            psCurrentNode = psNextNode)
-    {
-      hashKey = SymTable_hash(psCurrentNode->pcKey, auBucketCounts[newIndex]);
-      psNextNode = psCurrentNode->psNextNode; 
-      psCurrentNode->psNextNode = psNewBuckets[hashKey]; 
-      psNewBuckets[hashKey] = psCurrentNode;
-    }
+      SymTable_mapFrozen(oSymTable, 0, oSymTable->num, pfApply, pvExtra);
+      return;
    }
 
-   /* Free old buckets. */
-   free(oSymTable->psBuckets);
-
-   /* Update the SymTable. */
-   oSymTable->psBuckets = psNewBuckets;
-   oSymTable->index = newIndex;
+   /* Finish any incremental growth, so that lookups from *pfApply
+      cannot move bindings between bucket arrays or free the one being
+      walked. */
+   if (oSymTable->psOldBuckets != NULL)
+      SymTable_rehashStep(oSymTable, oSymTable->uOldBucketCount);
+   SymTable_mapBuckets(oSymTable->psBuckets, oSymTable->uBucketCount,
+                       pfApply, pvExtra);
 }
 
 /*--------------------------------------------------------------------*/
 
-int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+void SymTable_iterBegin(SymTable_T oSymTable, struct SymTableIter *psIter)
 {
-   struct SymTableNode *psNewNode;
-   struct SymTableNode *psNextNode;
-   size_t hashKey;
+   SymTable_T oShard;
+   size_t u;
 
-   assert(oSymTable != NULL && pcKey != NULL);
+   assert(oSymTable != NULL && psIter != NULL);
 
-   /* Expand the SymTable object's bucket count upon reaching capacity. */
-   if (oSymTable->num == auBucketCounts[oSymTable->index])
-   { 
-      SymTable_expand(oSymTable);
-   }
-   
-   hashKey = SymTable_hash(pcKey, auBucketCounts[oSymTable->index]);
+   psIter->oSymTable = oSymTable;
+   psIter->uIndex = 0;
+   psIter->uRemaining = 0;
+   psIter->pvPosition = NULL;
 
-   /* Iterates through all nodes in the linked list. Return 0 if 
-   matching key is found. */
-   for (psNewNode = oSymTable->psBuckets[hashKey];
-        psNewNode != NULL;
-        psNewNode = psNextNode)
+   /* Finish any incremental growth, so that lookups during the
+      iteration cannot move bindings between bucket arrays. */
+   if (oSymTable->psShards == NULL)
    {
-      psNextNode = psNewNode->psNextNode;
-      if (strcmp(psNewNode->pcKey, pcKey) == 0) {
-         return 0;
-      }
+      if (oSymTable->psOldBuckets != NULL)
+         SymTable_rehashStep(oSymTable, oSymTable->uOldBucketCount);
+      psIter->uRemaining = oSymTable->num;
+      return;
    }
 
-   /* Allocate memory for the new node and its key. Return 0 if 
-   insufficient memory is available. */
-   psNewNode = (struct SymTableNode*)malloc(sizeof(struct SymTableNode));
-   if (psNewNode == NULL)
+   for (u = 0; u < oSymTable->uShardCount; u++)
    {
-      return 0;
+      oShard = oSymTable->psShards[u].oSymTable;
+      if (oShard->psOldBuckets != NULL)
+         SymTable_rehashStep(oShard, oShard->uOldBucketCount);
+      psIter->uRemaining += oShard->num;
    }
+}
 
-   psNewNode->pcKey = (const char*)malloc(strlen(pcKey) + 1);
-   if (psNewNode->pcKey == NULL) {
-      free(psNewNode); 
-      return 0;
-   }
+/*--------------------------------------------------------------------*/
 
-   strcpy((char*)psNewNode->pcKey, pcKey); /* Make a defensive copy of pcKey. */
-   
-   /* Update pvValue and insert the node to the front. */
-   psNewNode->pvValue = pvValue;
-   psNewNode->psNextNode = oSymTable->psBuckets[hashKey];
+/* Return the first node at or after bucket uBucket of shard uShard of
+   the sharded SymTable of *psIter, and record its shard in
+   psIter->uIndex.  The bucket of a node follows from its hash code, so
+   the cursor need not record it. */
 
-   /* Update the SymTable. */
-   oSymTable->psBuckets[hashKey] = psNewNode;
-   oSymTable->num++;
+static struct SymTableNode *SymTable_iterShards(struct SymTableIter *psIter,
+                                                size_t uShard,
+                                                size_t uBucket)
+{
+   SymTable_T oShard;
 
-   return 1;
+   assert(psIter != NULL && psIter->oSymTable != NULL);
+
+   /* Some later bucket is nonempty, so the scan of the shards needs no
+      bounds check. */
+   for (;;)
+   {
+      assert(uShard < psIter->oSymTable->uShardCount);
+      oShard = psIter->oSymTable->psShards[uShard].oSymTable;
+      for (; uBucket < oShard->uBucketCount; uBucket++)
+         if (oShard->psBuckets[uBucket] != NULL)
+         {
+            psIter->uIndex = uShard;
+            return oShard->psBuckets[uBucket];
+         }
+      uShard++;
+      uBucket = 0;
+   }
 }
 
 /*--------------------------------------------------------------------*/
 
-void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue)
+int SymTable_iterNext(struct SymTableIter *psIter)
 {
-   struct SymTableNode *psCurrentNode;
-   struct SymTableNode *psNextNode;
-   void *pvOldValue;
-   size_t hashKey;
+   const struct SymTableFrozen *psFrozen;
+   struct SymTableNode **psBuckets;
+   struct SymTableNode *psNode;
+   SymTable_T oShard;
+   size_t uIndex;
 
-   assert(oSymTable != NULL && pcKey != NULL);
+   assert(psIter != NULL && psIter->oSymTable != NULL);
 
-   hashKey = SymTable_hash(pcKey, auBucketCounts[oSymTable->index]);
+   /* Stop as soon as every binding has been visited, rather than
+      scanning the empty buckets that follow the last one. */
+   if (psIter->uRemaining == 0)
+      return 0;
 
-   for (psCurrentNode = oSymTable->psBuckets[hashKey];
-        psCurrentNode != NULL;
-        psCurrentNode = psNextNode)
+   /* The slots of a frozen table are dense, so the cursor counts
+      them, and its position is the current key. */
+   psFrozen = psIter->oSymTable->psFrozen;
+   if (psFrozen != NULL)
    {
-      psNextNode = psCurrentNode->psNextNode;
-      if (strcmp(psCurrentNode->pcKey, pcKey) == 0) {
-         pvOldValue = (void*)psCurrentNode->pvValue;
-         psCurrentNode->pvValue = pvValue;
-         return pvOldValue;
+      psIter->uIndex = psIter->oSymTable->num - psIter->uRemaining;
+      psIter->uRemaining--;
+      psIter->pvPosition = psFrozen->pcKeys
+         + SymTable_keyOffset(psFrozen, psIter->uIndex);
+      return 1;
+   }
+
+   psNode = (struct SymTableNode*)psIter->pvPosition;
+   if (psNode != NULL && psNode->psNextNode != NULL)
+      psNode = psNode->psNextNode;
+   else if (psIter->oSymTable->psShards != NULL)
+   {
+      uIndex = 0;
+      if (psNode != NULL)
+      {
+         oShard = psIter->oSymTable->psShards[psIter->uIndex].oSymTable;
+         uIndex = (psNode->uHash & (oShard->uBucketCount - 1)) + 1;
       }
+      psNode = SymTable_iterShards(psIter, psIter->uIndex, uIndex);
    }
-   return NULL;
+   else
+   {
+      /* Some later bucket is nonempty, so the scan needs no bounds
+         check. */
+      psBuckets = psIter->oSymTable->psBuckets;
+      uIndex = psIter->uIndex;
+      if (psNode != NULL)
+         uIndex++;
+      while (psBuckets[uIndex] == NULL)
+         uIndex++;
+      assert(uIndex < psIter->oSymTable->uBucketCount);
+      psIter->uIndex = uIndex;
+      psNode = psBuckets[uIndex];
+   }
+
+   psIter->uRemaining--;
+   psIter->pvPosition = psNode;
+   return 1;
 }
 
 /*--------------------------------------------------------------------*/
 
-int SymTable_contains(SymTable_T oSymTable, const char *pcKey) 
+const char *SymTable_iterKey(const struct SymTableIter *psIter)
 {
-   struct SymTableNode *psCurrentNode;
-   struct SymTableNode *psNextNode;
-   size_t hashKey;
+   assert(psIter != NULL && psIter->pvPosition != NULL);
 
-   assert(oSymTable != NULL && pcKey != NULL);
+   if (psIter->oSymTable->psFrozen != NULL)
+      return (const char*)psIter->pvPosition;
+   return ((const struct SymTableNode*)psIter->pvPosition)->acKey;
+}
 
-   hashKey = SymTable_hash(pcKey, auBucketCounts[oSymTable->index]);
+/*--------------------------------------------------------------------*/
 
-   for (psCurrentNode = oSymTable->psBuckets[hashKey];
-        psCurrentNode != NULL;
-        psCurrentNode = psNextNode)
-   {
-      psNextNode = psCurrentNode->psNextNode;
-      if (strcmp(psCurrentNode->pcKey, pcKey) == 0) {
-         return 1;
-      }
-   }
-   return 0;
+void *SymTable_iterValue(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   if (psIter->oSymTable->psFrozen != NULL)
+      return SymTable_slotValue(psIter->oSymTable->psFrozen,
+                                psIter->uIndex);
+   return (void*)((const struct SymTableNode*)psIter->pvPosition)->pvValue;
 }
 
 /*--------------------------------------------------------------------*/
 
-void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+/* A SymTableMapJob describes a parallel map to each of its tasks. */
+
+struct SymTableMapJob
 {
-   struct SymTableNode *psCurrentNode;
-   struct SymTableNode *psNextNode;
-   size_t hashKey;
+   /* The SymTable object. */
+   SymTable_T oSymTable;
 
-   assert(oSymTable != NULL && pcKey != NULL);
+   /* The function to apply to each binding. */
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
 
-   hashKey = SymTable_hash(pcKey, auBucketCounts[oSymTable->index]);
+   /* The extra parameter of *pfApply, or NULL if each worker passes
+      its own accumulator instead. */
+   const void *pvExtra;
 
-   for (psCurrentNode = oSymTable->psBuckets[hashKey];
-        psCurrentNode != NULL;
-        psCurrentNode = psNextNode)
+   /* The accumulators of the workers, or NULL. */
+   void **apvAccumulators;
+
+   /* The innermost map frame of the thread that runs the job, which
+      each worker adopts while it runs a task. */
+   const struct SymTableMapFrame *psMapFrame;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Apply the function of pvJob, a SymTableMapJob, to each binding in
+   chunk uTask of its bucket array, passing the accumulator of worker
+   iWorker if the job has accumulators.  Adopt the map frames of the
+   thread that runs the job meanwhile, so that the function may look
+   up the shards that its maps hold. */
+
+static void SymTable_mapTask(size_t uTask, int iWorker, void *pvJob)
+{
+   const struct SymTableMapFrame *psOuterFrame;
+   struct SymTableMapJob *psJob;
+   size_t uBegin;
+   size_t uEnd;
+   void *pvExtra;
+
+   assert(pvJob != NULL);
+
+   psJob = (struct SymTableMapJob*)pvJob;
+   if (psJob->apvAccumulators != NULL)
+      pvExtra = psJob->apvAccumulators[iWorker];
+   else
+      pvExtra = (void*)psJob->pvExtra;
+
+   psOuterFrame = psMapFrame;
+   psMapFrame = psJob->psMapFrame;
+
+   /* A frozen table divides its slots rather than its buckets. */
+   uBegin = uTask * MAP_CHUNK_SIZE;
+   if (psJob->oSymTable->psFrozen != NULL)
    {
-      psNextNode = psCurrentNode->psNextNode;
-      if (strcmp(psCurrentNode->pcKey, pcKey) == 0) {
-         return (void*)psCurrentNode->pvValue;
-      }
+      uEnd = psJob->oSymTable->num - uBegin;
+      if (uEnd > MAP_CHUNK_SIZE)
+         uEnd = MAP_CHUNK_SIZE;
+      SymTable_mapFrozen(psJob->oSymTable, uBegin, uBegin + uEnd,
+                         psJob->pfApply, pvExtra);
    }
-   return NULL;
+   else
+   {
+      uEnd = psJob->oSymTable->uBucketCount - uBegin;
+      if (uEnd > MAP_CHUNK_SIZE)
+         uEnd = MAP_CHUNK_SIZE;
+      SymTable_mapBuckets(psJob->oSymTable->psBuckets + uBegin, uEnd,
+                          psJob->pfApply, pvExtra);
+   }
+
+   psMapFrame = psOuterFrame;
 }
 
 /*--------------------------------------------------------------------*/
 
-void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
-{
-   struct SymTableNode *psCurrentNode;
-   struct SymTableNode *psPrevNode;
-   void *pvOldValue;
-   size_t hashKey;
+/* Run the parallel map psJob on up to iThreadCount threads. */
 
-   assert(oSymTable != NULL && pcKey != NULL);
+static void SymTable_runMapJob(struct SymTableMapJob *psJob,
+                               int iThreadCount)
+{
+   struct SymTableMapJob sShardJob;
+   struct SymTableMapFrame sFrame;
+   struct SymTableShard *psShard;
+   SymTable_T oSymTable;
+   ThreadPool_T oThreadPool = NULL;
+   size_t uTaskCount;
+   size_t u;
 
-   hashKey = SymTable_hash(pcKey, auBucketCounts[oSymTable->index]);
+   assert(psJob != NULL && psJob->oSymTable != NULL);
 
-   /* Handle empty SymTable object. */
-   if (oSymTable->psBuckets[hashKey] == NULL)
+   /* Map a sharded table one shard at a time, holding its lock and
+      recording it in a frame, as SymTable_map does. */
+   oSymTable = psJob->oSymTable;
+   if (oSymTable->psShards != NULL)
    {
-      return NULL;
+      sShardJob = *psJob;
+      sFrame.psOuterFrame = psMapFrame;
+      for (u = 0; u < oSymTable->uShardCount; u++)
+      {
+         psShard = &oSymTable->psShards[u];
+         sShardJob.oSymTable = psShard->oSymTable;
+         SymTable_acquireShard(psShard, 0);
+         sFrame.psShard = psShard;
+         psMapFrame = &sFrame;
+         SymTable_runMapJob(&sShardJob, iThreadCount);
+         psMapFrame = sFrame.psOuterFrame;
+         SymTable_releaseShard(psShard);
+      }
+      return;
    }
 
-   /* Remove the first node of matched key. */
-   if (strcmp(oSymTable->psBuckets[hashKey]->pcKey, pcKey) == 0) {
-      psCurrentNode = oSymTable->psBuckets[hashKey];
-      pvOldValue = (void*)psCurrentNode->pvValue;
-      oSymTable->psBuckets[hashKey] = psCurrentNode->psNextNode;
-      oSymTable->num--;
-      free((char*)psCurrentNode->pcKey);
-      free(psCurrentNode);
-      return pvOldValue;
+   /* Finish any incremental growth, so that every binding is in the
+      one bucket array that the tasks divide. */
+   if (oSymTable->psOldBuckets != NULL)
+      SymTable_rehashStep(oSymTable, oSymTable->uOldBucketCount);
+   psJob->psMapFrame = psMapFrame;
+
+   if (oSymTable->psFrozen != NULL)
+      uTaskCount = (oSymTable->num + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+   else
+      uTaskCount = (oSymTable->uBucketCount + MAP_CHUNK_SIZE - 1)
+         / MAP_CHUNK_SIZE;
+   if (iThreadCount > 1 && uTaskCount > 1)
+      oThreadPool = ThreadPool_getShared(iThreadCount);
+
+   if (oThreadPool == NULL)
+   {
+      for (u = 0; u < uTaskCount; u++)
+         SymTable_mapTask(u, 0, psJob);
+      return;
    }
 
-   /* Iterates through all nodes in the linked list until finding 
-   matching key. Remove the node and return its old value. */
-   for (psPrevNode = oSymTable->psBuckets[hashKey], 
-        psCurrentNode = psPrevNode->psNextNode;
-        psCurrentNode != NULL;
-        psPrevNode = psCurrentNode, 
-        psCurrentNode = psCurrentNode->psNextNode)
-   {
-      if (strcmp(psCurrentNode->pcKey, pcKey) == 0) {
-         pvOldValue = (void*)psCurrentNode->pvValue;
-         psPrevNode->psNextNode = psCurrentNode->psNextNode;
-         oSymTable->num--;
-         free((char*)psCurrentNode->pcKey);
-         free(psCurrentNode);
-         return pvOldValue;
-      }
-   }
-   return NULL;
+   if (iThreadCount > ThreadPool_getWorkerCount(oThreadPool))
+      iThreadCount = ThreadPool_getWorkerCount(oThreadPool);
+   ThreadPool_run(oThreadPool, uTaskCount, iThreadCount,
+                  SymTable_mapTask, psJob);
 }
 
 /*--------------------------------------------------------------------*/
 
-void SymTable_map(SymTable_T oSymTable,
+void SymTable_mapParallel(SymTable_T oSymTable,
     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
-    const void *pvExtra)
+    const void *pvExtra, int iThreadCount)
 {
-   struct SymTableNode *psCurrentNode;
-   size_t i;
+   struct SymTableMapJob sJob;
 
    assert(oSymTable != NULL && pfApply != NULL);
 
-   for(i = 0; i < auBucketCounts[oSymTable->index]; i++)
-   {
-    for (psCurrentNode = oSymTable->psBuckets[i];
-         psCurrentNode != NULL;
-         psCurrentNode = psCurrentNode->psNextNode) 
-         {
-            (*pfApply)(psCurrentNode->pcKey, (void*)psCurrentNode->pvValue, (void*)pvExtra);
-         }
-   }
-}
\ No newline at end of file
+   sJob.oSymTable = oSymTable;
+   sJob.pfApply = pfApply;
+   sJob.pvExtra = pvExtra;
+   sJob.apvAccumulators = NULL;
+   sJob.psMapFrame = NULL;
+   SymTable_runMapJob(&sJob, iThreadCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_reduceParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue,
+                    void *pvAccumulator),
+    void **apvAccumulators, int iThreadCount)
+{
+   struct SymTableMapJob sJob;
+
+   assert(oSymTable != NULL && pfApply != NULL);
+   assert(apvAccumulators != NULL && iThreadCount > 0);
+
+   sJob.oSymTable = oSymTable;
+   sJob.pfApply = pfApply;
+   sJob.pvExtra = NULL;
+   sJob.apvAccumulators = apvAccumulators;
+   sJob.psMapFrame = NULL;
+   SymTable_runMapJob(&sJob, iThreadCount);
+}
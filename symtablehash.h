@@ -0,0 +1,115 @@
+/*--------------------------------------------------------------------*/
+/* symtablehash.h                                                     */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLEHASH_INCLUDED
+#define SYMTABLEHASH_INCLUDED
+#include "symtable.h"
+
+/*--------------------------------------------------------------------*/
+/* The functions below extend symtable.h with operations that only
+the hash table implementation (symtablehash.c) provides. */
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new SymTable object that contains no bindings and routes
+each key by the high bits of its hash code to one of uShardCount
+independent tables, rounded up to a power of two, or NULL if
+insufficient memory is available. Each shard has its own lock and grows
+on its own, so threads that add keys of different shards neither wait
+for each other nor for one large resize. Every function of symtable.h
+may be called on the table concurrently, except SymTable_free and the
+iterator functions, which require that no other thread uses it. A
+value address that SymTable_getOrPut returns is not guarded by any
+lock. SymTable_reserve gives each shard an even share of the count.
+SymTable_map and SymTable_mapParallel share the lock of one shard at a
+time with lookups. The function they apply, on whichever thread, may
+look up the table's bindings and map the table again, and the function
+that SymTable_map applies may also replace the value of the binding
+that it is passed, which is then, like a value address that
+SymTable_getOrPut returns, not guarded by the lock. A uShardCount of 0
+is taken as 1, which gives one table behind one lock. */
+
+SymTable_T SymTable_newSharded(size_t uShardCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Like SymTable_map, but split the buckets of oSymTable into ranges
+and apply *pfApply to them on up to iThreadCount threads of a shared
+thread pool. *pfApply must be safe to call from several threads at
+once, and must not change oSymTable. Small tables, and an iThreadCount
+of 1 or less, are mapped on the calling thread alone, as is a parallel
+map or reduction that *pfApply starts on any table. */
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, int iThreadCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Like SymTable_mapParallel, but give each thread a private
+accumulator: a thread that applies *pfApply passes apvAccumulators[i]
+as the third argument, where i is less than iThreadCount and no other
+thread uses the same i at the same time. The caller combines the
+iThreadCount accumulators afterwards; some may be left untouched. */
+
+void SymTable_reduceParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue,
+                    void *pvAccumulator),
+    void **apvAccumulators, int iThreadCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Make oSymTable immutable and rebuild it around a minimal perfect
+hash function over its keys, with the keys packed into one pool and
+the values into a dense array. Afterwards each lookup reads one
+displacement and one slot and compares one key, and SymTable_put,
+SymTable_putN, SymTable_putBatch, SymTable_replace, SymTable_upsert,
+SymTable_getOrPut, SymTable_remove, SymTable_removeN and
+SymTable_reserve fail, returning 0 or NULL and leaving the table
+unchanged, while SymTable_shrink does nothing. Return 1 (TRUE) if
+successful or oSymTable is already frozen, or 0 (FALSE) if insufficient
+memory is available, oSymTable is sharded, or too many keys share
+their hash codes, in which case oSymTable is unchanged. */
+
+int SymTable_freeze(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+
+/* Write to the file whose name is pcPath a snapshot of the bindings of
+oSymTable laid out as SymTable_freeze would lay them out, with offsets
+in place of pointers. The snapshot is written to pcPath followed by
+".tmp" and then renamed to pcPath, replacing any file there whole, so
+tables already opened from that file keep their bindings. The value of
+each binding is stored as the *puLength bytes at the address that
+(*pfSerialize)(pvValue, puLength) returns. oSymTable keeps its
+bindings and need not be frozen. Return 1 (TRUE) if successful, or 0
+(FALSE) if oSymTable is sharded, too many keys share their hash codes,
+insufficient memory is available, or the file cannot be written, in
+which case any file at pcPath is unchanged. */
+
+int SymTable_save(SymTable_T oSymTable, const char *pcPath,
+    const void *(*pfSerialize)(const void *pvValue, size_t *puLength));
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new frozen SymTable object that maps the snapshot in the
+file whose name is pcPath into memory and answers lookups from the
+mapping in place, without reading or copying its bindings. The value
+of each binding is the address of its serialized bytes in the
+mapping, aligned to 16 bytes, which must not be written. The snapshot
+must have been saved on a machine of the same byte order and word
+size, and the file must not change while the table is in use. Return
+NULL if the file cannot be mapped, its header is not that of such a
+snapshot, or insufficient memory is available. Only the header and
+the bounds of the sections are checked when the file is opened, so the
+file must be trusted. Lookups also check, in constant time, that the
+slot and the offsets they follow lie within their sections, and miss
+rather than read outside them. */
+
+SymTable_T SymTable_openMapped(const char *pcPath);
+
+/*--------------------------------------------------------------------*/
+
+#endif
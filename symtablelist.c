@@ -11,18 +11,19 @@
 /*--------------------------------------------------------------------*/
 
 /* Each key and value is stored in a SymTableNode.  SymTableNodes are 
-   linked to form a list.  */
+   linked to form a list.  The key is stored inline at the end of its
+   SymTableNode, so a node and its key take a single allocation.  */
 
 struct SymTableNode
 {
-   /* The key. */
-   const char *pcKey;
-
    /* The value. */
    const void *pvValue;
 
    /* The address of the next SymTableNode. */
    struct SymTableNode *psNextNode;
+
+   /* The key, a defensive copy of the caller's key. */
+   char acKey[];
 };
 
 /*--------------------------------------------------------------------*/
@@ -37,6 +38,9 @@ struct SymTable
 
    /* The number of bindings. */
    size_t num;
+
+   /* How a successful lookup reorders the nodes. */
+   enum SymTableReorder eReorder;
 };
 
 /*--------------------------------------------------------------------*/
@@ -51,11 +55,54 @@ SymTable_T SymTable_new(void)
 
    oSymTable->psFirstNode = NULL;
    oSymTable->num = 0;
+   oSymTable->eReorder = SYMTABLE_REORDER_NONE;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithOptions(const struct SymTableOptions *psOptions)
+{
+   SymTable_T oSymTable;
+
+   /* A linked list has no load factor or hash function, so only the
+      reordering option applies. */
+   oSymTable = SymTable_new();
+   if (oSymTable != NULL && psOptions != NULL)
+      oSymTable->eReorder = psOptions->eReorder;
    return oSymTable;
 }
 
 /*--------------------------------------------------------------------*/
 
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+   /* A linked list allocates one node per binding, so there is no
+      room to reserve. */
+   (void)uCapacity;
+   return SymTable_new();
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount)
+{
+   assert(oSymTable != NULL);
+
+   (void)uCount;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_shrink(SymTable_T oSymTable)
+{
+   /* A linked list frees each node as its binding is removed. */
+   assert(oSymTable != NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
 void SymTable_free(SymTable_T oSymTable)
 {
    struct SymTableNode *psCurrentNode;
@@ -68,7 +115,6 @@ void SymTable_free(SymTable_T oSymTable)
         psCurrentNode = psNextNode)
    {
       psNextNode = psCurrentNode->psNextNode;
-      free((char*)psCurrentNode->pcKey);
       free(psCurrentNode);
    }
 
@@ -85,8 +131,34 @@ size_t SymTable_getLength(SymTable_T oSymTable)
 
 /*--------------------------------------------------------------------*/
 
+/* Return 1 (TRUE) if pcNodeKey, a key stored in a node, equals the key
+   of length uLength at pcKey.  Otherwise return 0 (FALSE).  strncmp
+   stops at the end of pcNodeKey, so pcNodeKey is at least uLength
+   bytes long when it returns 0. */
+
+static int SymTable_keyEquals(const char *pcNodeKey, const char *pcKey,
+                              size_t uLength)
+{
+   assert(pcNodeKey != NULL && pcKey != NULL);
+
+   return strncmp(pcNodeKey, pcKey, uLength) == 0 &&
+      pcNodeKey[uLength] == '\0';
+}
+
+/*--------------------------------------------------------------------*/
+
 int SymTable_put(SymTable_T oSymTable, const char *pcKey, 
                  const void *pvValue)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                  const void *pvValue)
 {
    struct SymTableNode *psNewNode;
    struct SymTableNode *psNextNode;
@@ -100,26 +172,23 @@ int SymTable_put(SymTable_T oSymTable, const char *pcKey,
         psNewNode = psNextNode)
    {
       psNextNode = psNewNode->psNextNode;
-      if (strcmp(psNewNode->pcKey, pcKey) == 0) {
+      if (SymTable_keyEquals(psNewNode->acKey, pcKey, uLength)) {
          return 0;
       }
    }
 
    /* Allocate memory for the new node and its key. Return 0 if 
    insufficient memory is available. */
-   psNewNode = (struct SymTableNode*)malloc(sizeof(struct SymTableNode));
+   psNewNode = (struct SymTableNode*)
+      malloc(sizeof(struct SymTableNode) + uLength + 1);
    if (psNewNode == NULL)
    {
       return 0;
    }
 
-   psNewNode->pcKey = (const char*)malloc(strlen(pcKey) + 1);
-   if (psNewNode->pcKey == NULL) {
-      free(psNewNode); 
-      return 0;
-   }
-
-   strcpy((char*)psNewNode->pcKey, pcKey); /* Make a defensive copy of pcKey. */
+   /* Make a defensive copy of pcKey, which need not end in '\0'. */
+   memcpy(psNewNode->acKey, pcKey, uLength);
+   psNewNode->acKey[uLength] = '\0';
    
    /* Update pvValue and insert the node to the front. */
    psNewNode->pvValue = pvValue;
@@ -149,7 +218,7 @@ void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvVa
         psCurrentNode = psNextNode)
    {
       psNextNode = psCurrentNode->psNextNode;
-      if (strcmp(psCurrentNode->pcKey, pcKey) == 0) {
+      if (strcmp(psCurrentNode->acKey, pcKey) == 0) {
          pvOldValue = (void*)psCurrentNode->pvValue;
          psCurrentNode->pvValue = pvValue;
          return pvOldValue;
@@ -160,49 +229,216 @@ void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvVa
 
 /*--------------------------------------------------------------------*/
 
-int SymTable_contains(SymTable_T oSymTable, const char *pcKey) 
+/* Return the node of oSymTable whose key is pcKey, adding a new node
+   with key pcKey and value pvValue at the front if there is none.
+   Store 1 (TRUE) in *piAdded if the node is new, or 0 (FALSE) if not.
+   Return NULL if insufficient memory is available. */
+
+static struct SymTableNode *SymTable_findOrAdd(SymTable_T oSymTable,
+                                               const char *pcKey,
+                                               const void *pvValue,
+                                               int *piAdded)
 {
-   struct SymTableNode *psCurrentNode;
-   struct SymTableNode *psNextNode;
+   struct SymTableNode *psNode;
+   size_t uLength;
 
-   assert(oSymTable != NULL && pcKey != NULL);
+   assert(oSymTable != NULL && pcKey != NULL && piAdded != NULL);
 
-   for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-        psCurrentNode = psNextNode)
+   *piAdded = 0;
+   for (psNode = oSymTable->psFirstNode;
+        psNode != NULL;
+        psNode = psNode->psNextNode)
    {
-      psNextNode = psCurrentNode->psNextNode;
-      if (strcmp(psCurrentNode->pcKey, pcKey) == 0) {
-         return 1;
-      }
+      if (strcmp(psNode->acKey, pcKey) == 0)
+         return psNode;
    }
-   return 0;
+
+   uLength = strlen(pcKey);
+   psNode = (struct SymTableNode*)
+      malloc(sizeof(struct SymTableNode) + uLength + 1);
+   if (psNode == NULL)
+      return NULL;
+
+   memcpy(psNode->acKey, pcKey, uLength + 1);
+   psNode->pvValue = pvValue;
+   psNode->psNextNode = oSymTable->psFirstNode;
+   oSymTable->psFirstNode = psNode;
+   oSymTable->num++;
+   *piAdded = 1;
+   return psNode;
 }
 
 /*--------------------------------------------------------------------*/
 
-void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                      const void *pvValue)
 {
-   struct SymTableNode *psCurrentNode;
-   struct SymTableNode *psNextNode;
+   struct SymTableNode *psNode;
+   void *pvOldValue;
+   int iAdded;
 
    assert(oSymTable != NULL && pcKey != NULL);
 
-   for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-        psCurrentNode = psNextNode)
+   psNode = SymTable_findOrAdd(oSymTable, pcKey, pvValue, &iAdded);
+   if (psNode == NULL || iAdded)
+      return NULL;
+
+   pvOldValue = (void*)psNode->pvValue;
+   psNode->pvValue = pvValue;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+const void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                               const void *pvValue)
+{
+   struct SymTableNode *psNode;
+   int iAdded;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   psNode = SymTable_findOrAdd(oSymTable, pcKey, pvValue, &iAdded);
+   if (psNode == NULL)
+      return NULL;
+   return &psNode->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the node of oSymTable whose key is the key of length uLength
+   at pcKey, or NULL if there is no such node.  Reorder the nodes as
+   oSymTable->eReorder directs when the node is found. */
+
+static struct SymTableNode *SymTable_lookup(SymTable_T oSymTable,
+                                            const char *pcKey,
+                                            size_t uLength)
+{
+   struct SymTableNode **ppsLink;
+   struct SymTableNode **ppsPrevLink = NULL;
+   struct SymTableNode *psNode;
+   struct SymTableNode *psPrevNode;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   for (ppsLink = &oSymTable->psFirstNode;
+        (psNode = *ppsLink) != NULL;
+        ppsLink = &psNode->psNextNode)
    {
-      psNextNode = psCurrentNode->psNextNode;
-      if (strcmp(psCurrentNode->pcKey, pcKey) == 0) {
-         return (void*)psCurrentNode->pvValue;
-      }
+      if (SymTable_keyEquals(psNode->acKey, pcKey, uLength))
+         break;
+      ppsPrevLink = ppsLink;
    }
-   return NULL;
+   if (psNode == NULL || ppsPrevLink == NULL)
+      return psNode;
+
+   switch (oSymTable->eReorder)
+   {
+      case SYMTABLE_REORDER_MOVE_TO_FRONT:
+         /* Unlink the node and relink it first. */
+         *ppsLink = psNode->psNextNode;
+         psNode->psNextNode = oSymTable->psFirstNode;
+         oSymTable->psFirstNode = psNode;
+         break;
+      case SYMTABLE_REORDER_TRANSPOSE:
+         /* Swap the node with the node before it. */
+         psPrevNode = *ppsPrevLink;
+         psPrevNode->psNextNode = psNode->psNextNode;
+         psNode->psNextNode = psPrevNode;
+         *ppsPrevLink = psNode;
+         break;
+      case SYMTABLE_REORDER_NONE:
+      default:
+         break;
+   }
+   return psNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) 
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_lookup(oSymTable, pcKey, uLength) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+                    size_t uLength)
+{
+   struct SymTableNode *psNode;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   psNode = SymTable_lookup(oSymTable, pcKey, uLength);
+   if (psNode == NULL)
+      return NULL;
+   return (void*)psNode->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+                       size_t uCount, void **apvValues)
+{
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL && apvValues != NULL);
+
+   /* A list walk has no independent memory accesses to overlap. */
+   for (u = 0; u < uCount; u++)
+      apvValues[u] = SymTable_get(oSymTable, apcKeys[u]);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+                         size_t uCount, const void **apvValues)
+{
+   size_t uAdded = 0;
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL && apvValues != NULL);
+
+   for (u = 0; u < uCount; u++)
+      uAdded += (size_t)SymTable_put(oSymTable, apcKeys[u], apvValues[u]);
+   return uAdded;
 }
 
 /*--------------------------------------------------------------------*/
 
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
 {
    struct SymTableNode *psCurrentNode;
    struct SymTableNode *psPrevNode;
@@ -216,12 +452,11 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
    }
 
    /* Remove the first node of matched key. */
-   if (strcmp(oSymTable->psFirstNode->pcKey, pcKey) == 0) {
+   if (SymTable_keyEquals(oSymTable->psFirstNode->acKey, pcKey, uLength)) {
       psCurrentNode = oSymTable->psFirstNode;
       pvOldValue = (void*)psCurrentNode->pvValue;
       oSymTable->psFirstNode = psCurrentNode->psNextNode;
       oSymTable->num--;
-      free((char*)psCurrentNode->pcKey);
       free(psCurrentNode);
       return pvOldValue;
    }
@@ -232,11 +467,10 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
         psCurrentNode != NULL;
         psPrevNode = psCurrentNode, psCurrentNode = psCurrentNode->psNextNode)
    {
-      if (strcmp(psCurrentNode->pcKey, pcKey) == 0) {
+      if (SymTable_keyEquals(psCurrentNode->acKey, pcKey, uLength)) {
          pvOldValue = (void*)psCurrentNode->pvValue;
          psPrevNode->psNextNode = psCurrentNode->psNextNode;
          oSymTable->num--;
-         free((char*)psCurrentNode->pcKey);
          free(psCurrentNode);
          return pvOldValue;
       }
@@ -258,6 +492,59 @@ void SymTable_map(SymTable_T oSymTable,
         psCurrentNode != NULL;
         psCurrentNode = psCurrentNode->psNextNode) 
         {
-         (*pfApply)(psCurrentNode->pcKey, (void*)psCurrentNode->pvValue, (void*)pvExtra);
+         (*pfApply)(psCurrentNode->acKey, (void*)psCurrentNode->pvValue, (void*)pvExtra);
         }
-}
\ No newline at end of file
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_iterBegin(SymTable_T oSymTable, struct SymTableIter *psIter)
+{
+   assert(oSymTable != NULL && psIter != NULL);
+
+   psIter->oSymTable = oSymTable;
+   psIter->uIndex = 0;
+   psIter->uRemaining = oSymTable->num;
+   psIter->pvPosition = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_iterNext(struct SymTableIter *psIter)
+{
+   struct SymTableNode *psNode;
+
+   assert(psIter != NULL && psIter->oSymTable != NULL);
+
+   if (psIter->uRemaining == 0)
+      return 0;
+
+   psNode = (struct SymTableNode*)psIter->pvPosition;
+   if (psNode == NULL)
+      psNode = psIter->oSymTable->psFirstNode;
+   else
+      psNode = psNode->psNextNode;
+   assert(psNode != NULL);
+
+   psIter->uRemaining--;
+   psIter->pvPosition = psNode;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *SymTable_iterKey(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   return ((const struct SymTableNode*)psIter->pvPosition)->acKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_iterValue(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   return (void*)((const struct SymTableNode*)psIter->pvPosition)->pvValue;
+}
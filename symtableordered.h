@@ -0,0 +1,43 @@
+/*--------------------------------------------------------------------*/
+/* symtableordered.h                                                  */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLEORDERED_INCLUDED
+#define SYMTABLEORDERED_INCLUDED
+#include "symtable.h"
+
+/*--------------------------------------------------------------------*/
+/* The functions below extend symtable.h with queries that only an
+implementation that keeps its keys sorted (symtabletree.c and
+symtableart.c) provides.
+Keys are ordered byte by byte as unsigned chars, a key that is a
+prefix of another coming first, as strcmp orders them. Such an
+implementation also visits bindings in ascending key order in
+SymTable_map and the SymTable_iter functions. */
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each binding in oSymTable whose key is
+at least pcLow and less than pcHigh, in ascending key order, passing
+pvExtra as an extra parameter. A NULL pcLow or pcHigh leaves that end
+of the range open. *pfApply must not change oSymTable. */
+
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+    const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each binding in oSymTable whose key
+begins with pcPrefix, in ascending key order, passing pvExtra as an
+extra parameter. *pfApply must not change oSymTable. */
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+#endif
@@ -0,0 +1,766 @@
+/*--------------------------------------------------------------------*/
+/* symtablerobin.c                                                    */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "strhash.h"
+#include "prefetch.h"
+
+/*--------------------------------------------------------------------*/
+
+/* The number of keys that a batch operation hashes and prefetches
+   before it resolves any of them. */
+enum {BATCH_SIZE = 16};
+
+/* The number of slots in a new SymTable. */
+enum {INITIAL_CAPACITY = 8};
+
+/* The highest fraction of slots that may be filled.  Robin Hood
+   probing keeps probe lengths short up to high loads, but lookups and
+   insertions rely on some slot being empty. */
+static const double MAX_LOAD_FACTOR = 0.875;
+
+/*--------------------------------------------------------------------*/
+
+/* Each key and value is stored in a SymTableSlot, together with the
+   full hash code of the key, so that growing never rehashes a key
+   and most mismatched keys are never compared, and with the distance
+   of the slot from the key's home slot. */
+
+struct SymTableSlot
+{
+   /* The key. */
+   const char *pcKey;
+
+   /* The value. */
+   const void *pvValue;
+
+   /* The hash code of the key. */
+   size_t uHash;
+
+   /* 1 more than the number of slots between the key's home slot and
+      this one, or 0 if the slot is empty. */
+   size_t uDistance;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTable is a flat array of SymTableSlots that is probed linearly
+   from the home slot that the low bits of a key's hash code select.
+   An insertion takes the slot of any key that is closer to its home
+   than the new key is to its own, and carries that key on, so that
+   keys stay sorted by home slot along each run and probe lengths stay
+   even.  A lookup can stop as soon as it passes a key closer to its
+   home than the sought key would be, and a removal shifts the rest of
+   the run back by one, so that no tombstones are needed. */
+
+struct SymTable
+{
+   /* The slots. */
+   struct SymTableSlot *psSlots;
+
+   /* The number of slots, a power of two. */
+   size_t uCapacity;
+
+   /* The maximum fraction of slots that may be filled. */
+   double dMaxLoadFactor;
+
+   /* The hash function. */
+   StrHash_T pfHash;
+
+   /* The seed of the hash function. */
+   size_t uSeed;
+
+   /* The number of bindings. */
+   size_t num;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash code for the key of length uLength at pcKey under
+   the hash function and seed of oSymTable. */
+
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+                            size_t uLength)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return (*oSymTable->pfHash)(pcKey, uLength, oSymTable->uSeed);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bindings oSymTable may hold in uCapacity slots
+   before it must grow.  The result is at least 1 and leaves at least
+   one slot empty. */
+
+static size_t SymTable_maxLoad(SymTable_T oSymTable, size_t uCapacity)
+{
+   size_t uMaxLoad;
+
+   assert(oSymTable != NULL);
+
+   uMaxLoad = (size_t)(oSymTable->dMaxLoadFactor * (double)uCapacity);
+   if (uMaxLoad > uCapacity - uCapacity / 8)
+      uMaxLoad = uCapacity - uCapacity / 8;
+   if (uMaxLoad == 0)
+      uMaxLoad = 1;
+   return uMaxLoad;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the smallest capacity, a power of two that is at least
+   INITIAL_CAPACITY, in which oSymTable may hold uCount bindings. */
+
+static size_t SymTable_capacityFor(SymTable_T oSymTable, size_t uCount)
+{
+   size_t uCapacity = INITIAL_CAPACITY;
+
+   assert(oSymTable != NULL);
+
+   while (SymTable_maxLoad(oSymTable, uCapacity) < uCount &&
+          uCapacity <= ((size_t)-1) / sizeof(struct SymTableSlot) / 2)
+      uCapacity *= 2;
+   return uCapacity;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Search oSymTable for a binding whose key is the uLength bytes at
+   pcKey and whose key has hash code uHash.  Store its slot index in
+   *puSlot and return 1 (TRUE) if found.  Otherwise return 0
+   (FALSE). */
+
+static int SymTable_find(SymTable_T oSymTable, const char *pcKey,
+                         size_t uLength, size_t uHash, size_t *puSlot)
+{
+   const struct SymTableSlot *psSlot;
+   size_t uMask;
+   size_t uSlot;
+   size_t uDistance;
+
+   assert(oSymTable != NULL && pcKey != NULL && puSlot != NULL);
+
+   uMask = oSymTable->uCapacity - 1;
+   uSlot = uHash & uMask;
+
+   /* The sought key would have displaced any key that is closer to
+      its home, so such a key, or an empty slot, ends the search. */
+   for (uDistance = 1; ; uDistance++)
+   {
+      psSlot = &oSymTable->psSlots[uSlot];
+      if (psSlot->uDistance < uDistance)
+         return 0;
+
+      /* strncmp stops at the end of the stored key, so the stored key
+         is at least uLength bytes long when it returns 0. */
+      if (psSlot->uHash == uHash &&
+          strncmp(psSlot->pcKey, pcKey, uLength) == 0 &&
+          psSlot->pcKey[uLength] == '\0')
+      {
+         *puSlot = uSlot;
+         return 1;
+      }
+      uSlot = (uSlot + 1) & uMask;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Place sSlot, whose uDistance is ignored, in psSlots, an array of
+   uCapacity slots with at least one empty, which must not already
+   hold its key.  Return the index of the slot where it lands. */
+
+static size_t SymTable_place(struct SymTableSlot *psSlots,
+                             size_t uCapacity, struct SymTableSlot sSlot)
+{
+   struct SymTableSlot sDisplaced;
+   size_t uMask = uCapacity - 1;
+   size_t uSlot;
+   size_t uPlaced = uCapacity;
+
+   assert(psSlots != NULL);
+
+   uSlot = sSlot.uHash & uMask;
+   sSlot.uDistance = 1;
+   for (;;)
+   {
+      if (psSlots[uSlot].uDistance == 0)
+      {
+         psSlots[uSlot] = sSlot;
+         return uPlaced == uCapacity ? uSlot : uPlaced;
+      }
+
+      /* Take from the rich: a key nearer its home yields its slot and
+         moves on in place of the carried key. */
+      if (psSlots[uSlot].uDistance < sSlot.uDistance)
+      {
+         sDisplaced = psSlots[uSlot];
+         psSlots[uSlot] = sSlot;
+         sSlot = sDisplaced;
+         if (uPlaced == uCapacity)
+            uPlaced = uSlot;
+      }
+      uSlot = (uSlot + 1) & uMask;
+      sSlot.uDistance++;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Rebuild oSymTable with uCapacity slots.  Return 1 (TRUE) if
+   successful, or 0 (FALSE) if insufficient memory is available, in
+   which case oSymTable is unchanged. */
+
+static int SymTable_rehash(SymTable_T oSymTable, size_t uCapacity)
+{
+   struct SymTableSlot *psNewSlots;
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(SymTable_maxLoad(oSymTable, uCapacity) >= oSymTable->num);
+
+   /* Zeroed memory holds only empty slots. */
+   psNewSlots = (struct SymTableSlot*)
+      calloc(uCapacity, sizeof(struct SymTableSlot));
+   if (psNewSlots == NULL)
+      return 0;
+
+   for (i = 0; i < oSymTable->uCapacity; i++)
+      if (oSymTable->psSlots[i].uDistance != 0)
+         (void)SymTable_place(psNewSlots, uCapacity,
+                              oSymTable->psSlots[i]);
+
+   free(oSymTable->psSlots);
+   oSymTable->psSlots = psNewSlots;
+   oSymTable->uCapacity = uCapacity;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+   return SymTable_newWithOptions(NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithOptions(const struct SymTableOptions *psOptions)
+{
+   SymTable_T oSymTable;
+
+   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->dMaxLoadFactor = MAX_LOAD_FACTOR;
+   if (psOptions != NULL && psOptions->dMaxLoadFactor > 0.0 &&
+       psOptions->dMaxLoadFactor < MAX_LOAD_FACTOR)
+      oSymTable->dMaxLoadFactor = psOptions->dMaxLoadFactor;
+
+   oSymTable->uCapacity = INITIAL_CAPACITY;
+   if (psOptions != NULL && psOptions->uCapacity > 0)
+      oSymTable->uCapacity =
+         SymTable_capacityFor(oSymTable, psOptions->uCapacity);
+
+   oSymTable->psSlots = (struct SymTableSlot*)
+      calloc(oSymTable->uCapacity, sizeof(struct SymTableSlot));
+   if (oSymTable->psSlots == NULL)
+   {
+      free(oSymTable);
+      return NULL;
+   }
+
+   oSymTable->pfHash = StrHash_forOption(
+      psOptions != NULL ? psOptions->eHash : SYMTABLE_HASH_DEFAULT);
+   if (psOptions != NULL && psOptions->iFixedSeed)
+      oSymTable->uSeed = psOptions->uSeed;
+   else
+      oSymTable->uSeed = StrHash_randomSeed();
+
+   oSymTable->num = 0;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+   struct SymTableOptions sOptions;
+
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.uCapacity = uCapacity;
+   return SymTable_newWithOptions(&sOptions);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount)
+{
+   assert(oSymTable != NULL);
+
+   if (uCount <= SymTable_maxLoad(oSymTable, oSymTable->uCapacity))
+      return 1;
+   return SymTable_rehash(oSymTable,
+                          SymTable_capacityFor(oSymTable, uCount));
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_shrink(SymTable_T oSymTable)
+{
+   size_t uCapacity;
+
+   assert(oSymTable != NULL);
+
+   /* Removals leave no tombstones, so only a smaller capacity
+      reclaims anything. */
+   uCapacity = SymTable_capacityFor(oSymTable, oSymTable->num);
+   if (uCapacity < oSymTable->uCapacity)
+      (void)SymTable_rehash(oSymTable, uCapacity);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+   size_t i;
+
+   assert(oSymTable != NULL);
+
+   for (i = 0; i < oSymTable->uCapacity; i++)
+   {
+      if (oSymTable->psSlots[i].uDistance != 0)
+         free((char*)oSymTable->psSlots[i].pcKey);
+   }
+
+   free(oSymTable->psSlots);
+   free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+   return oSymTable->num;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Fill a slot of oSymTable with the key of length uLength at pcKey,
+   whose hash code is uHash, and value pvValue, without checking
+   whether oSymTable already contains that key.  Return the slot, or
+   NULL if insufficient memory is available. */
+
+static struct SymTableSlot *SymTable_addSlot(SymTable_T oSymTable,
+                                             const char *pcKey,
+                                             size_t uLength, size_t uHash,
+                                             const void *pvValue)
+{
+   struct SymTableSlot sSlot;
+   char *pcKeyCopy;
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   /* Make a defensive copy of pcKey, which need not end in '\0'.
+      Return NULL if insufficient memory is available. */
+   pcKeyCopy = (char*)malloc(uLength + 1);
+   if (pcKeyCopy == NULL)
+      return NULL;
+   memcpy(pcKeyCopy, pcKey, uLength);
+   pcKeyCopy[uLength] = '\0';
+
+   if (oSymTable->num >= SymTable_maxLoad(oSymTable,
+                                          oSymTable->uCapacity) &&
+       ! SymTable_rehash(oSymTable, oSymTable->uCapacity * 2))
+   {
+      free(pcKeyCopy);
+      return NULL;
+   }
+
+   sSlot.pcKey = pcKeyCopy;
+   sSlot.pvValue = pvValue;
+   sSlot.uHash = uHash;
+   uSlot = SymTable_place(oSymTable->psSlots, oSymTable->uCapacity,
+                          sSlot);
+   oSymTable->num++;
+
+   return &oSymTable->psSlots[uSlot];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add a new binding to oSymTable consisting of the key of length
+   uLength at pcKey, whose hash code is uHash, and value pvValue and
+   return 1 (TRUE).  Return 0 (FALSE) if oSymTable already contains a
+   binding with that key or insufficient memory is available. */
+
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+                           size_t uLength, size_t uHash,
+                           const void *pvValue)
+{
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (SymTable_find(oSymTable, pcKey, uLength, uHash, &uSlot))
+      return 0;
+
+   return SymTable_addSlot(oSymTable, pcKey, uLength, uHash,
+                           pvValue) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+                 const void *pvValue)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                  const void *pvValue)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_insert(oSymTable, pcKey, uLength,
+                          SymTable_hash(oSymTable, pcKey, uLength),
+                          pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+                       const void *pvValue)
+{
+   struct SymTableSlot *psSlot;
+   void *pvOldValue;
+   size_t uLength;
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   if (! SymTable_find(oSymTable, pcKey, uLength,
+                       SymTable_hash(oSymTable, pcKey, uLength), &uSlot))
+      return NULL;
+
+   psSlot = &oSymTable->psSlots[uSlot];
+   pvOldValue = (void*)psSlot->pvValue;
+   psSlot->pvValue = pvValue;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                      const void *pvValue)
+{
+   struct SymTableSlot *psSlot;
+   void *pvOldValue;
+   size_t uLength;
+   size_t uHash;
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   if (! SymTable_find(oSymTable, pcKey, uLength, uHash, &uSlot))
+   {
+      (void)SymTable_addSlot(oSymTable, pcKey, uLength, uHash, pvValue);
+      return NULL;
+   }
+
+   psSlot = &oSymTable->psSlots[uSlot];
+   pvOldValue = (void*)psSlot->pvValue;
+   psSlot->pvValue = pvValue;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+const void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                               const void *pvValue)
+{
+   struct SymTableSlot *psSlot;
+   size_t uLength;
+   size_t uHash;
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   if (SymTable_find(oSymTable, pcKey, uLength, uHash, &uSlot))
+      return &oSymTable->psSlots[uSlot].pvValue;
+
+   psSlot = SymTable_addSlot(oSymTable, pcKey, uLength, uHash, pvValue);
+   if (psSlot == NULL)
+      return NULL;
+   return &psSlot->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_find(oSymTable, pcKey, uLength,
+                        SymTable_hash(oSymTable, pcKey, uLength), &uSlot);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+                    size_t uLength)
+{
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (! SymTable_find(oSymTable, pcKey, uLength,
+                       SymTable_hash(oSymTable, pcKey, uLength), &uSlot))
+      return NULL;
+   return (void*)oSymTable->psSlots[uSlot].pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Hash the uCount keys in apcKeys, at most BATCH_SIZE of them, into
+   auHashes and auLengths, and prefetch the home slot of each key, so
+   that the memory accesses of all the keys overlap. */
+
+static void SymTable_prefetchBatch(SymTable_T oSymTable,
+                                   const char **apcKeys, size_t uCount,
+                                   size_t *auHashes, size_t *auLengths)
+{
+   size_t uMask = oSymTable->uCapacity - 1;
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL);
+   assert(auHashes != NULL && auLengths != NULL);
+   assert(uCount <= BATCH_SIZE);
+
+   for (u = 0; u < uCount; u++)
+   {
+      auLengths[u] = strlen(apcKeys[u]);
+      auHashes[u] = SymTable_hash(oSymTable, apcKeys[u], auLengths[u]);
+      PREFETCH(oSymTable->psSlots + (auHashes[u] & uMask));
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+                       size_t uCount, void **apvValues)
+{
+   size_t auHashes[BATCH_SIZE];
+   size_t auLengths[BATCH_SIZE];
+   size_t uStart;
+   size_t uBatch;
+   size_t uSlot;
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL && apvValues != NULL);
+
+   for (uStart = 0; uStart < uCount; uStart += uBatch)
+   {
+      uBatch = uCount - uStart < BATCH_SIZE ? uCount - uStart : BATCH_SIZE;
+      SymTable_prefetchBatch(oSymTable, apcKeys + uStart, uBatch,
+                             auHashes, auLengths);
+      for (u = 0; u < uBatch; u++)
+      {
+         if (SymTable_find(oSymTable, apcKeys[uStart + u], auLengths[u],
+                           auHashes[u], &uSlot))
+            apvValues[uStart + u] =
+               (void*)oSymTable->psSlots[uSlot].pvValue;
+         else
+            apvValues[uStart + u] = NULL;
+      }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+                         size_t uCount, const void **apvValues)
+{
+   size_t auHashes[BATCH_SIZE];
+   size_t auLengths[BATCH_SIZE];
+   size_t uAdded = 0;
+   size_t uStart;
+   size_t uBatch;
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL && apvValues != NULL);
+
+   for (uStart = 0; uStart < uCount; uStart += uBatch)
+   {
+      uBatch = uCount - uStart < BATCH_SIZE ? uCount - uStart : BATCH_SIZE;
+      SymTable_prefetchBatch(oSymTable, apcKeys + uStart, uBatch,
+                             auHashes, auLengths);
+
+      /* Insert in order, so that a key repeated within the batch is
+         added once. */
+      for (u = 0; u < uBatch; u++)
+         uAdded += (size_t)SymTable_insert(oSymTable, apcKeys[uStart + u],
+                                           auLengths[u], auHashes[u],
+                                           apvValues[uStart + u]);
+   }
+   return uAdded;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   struct SymTableSlot *psSlots;
+   void *pvOldValue;
+   size_t uMask;
+   size_t uSlot;
+   size_t uNext;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (! SymTable_find(oSymTable, pcKey, uLength,
+                       SymTable_hash(oSymTable, pcKey, uLength), &uSlot))
+      return NULL;
+
+   psSlots = oSymTable->psSlots;
+   pvOldValue = (void*)psSlots[uSlot].pvValue;
+   free((char*)psSlots[uSlot].pcKey);
+   oSymTable->num--;
+
+   /* Shift back each following key of the run that is not in its home
+      slot, which brings it one step nearer home, until an empty slot
+      or a key at home ends the run. */
+   uMask = oSymTable->uCapacity - 1;
+   for (uNext = (uSlot + 1) & uMask; psSlots[uNext].uDistance > 1;
+        uNext = (uNext + 1) & uMask)
+   {
+      psSlots[uSlot] = psSlots[uNext];
+      psSlots[uSlot].uDistance--;
+      uSlot = uNext;
+   }
+   psSlots[uSlot].uDistance = 0;
+
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   size_t i;
+
+   assert(oSymTable != NULL && pfApply != NULL);
+
+   for (i = 0; i < oSymTable->uCapacity; i++)
+   {
+      if (oSymTable->psSlots[i].uDistance != 0)
+         (*pfApply)(oSymTable->psSlots[i].pcKey,
+                    (void*)oSymTable->psSlots[i].pvValue, (void*)pvExtra);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_iterBegin(SymTable_T oSymTable, struct SymTableIter *psIter)
+{
+   assert(oSymTable != NULL && psIter != NULL);
+
+   /* uIndex is the first slot that the cursor has yet to examine. */
+   psIter->oSymTable = oSymTable;
+   psIter->uIndex = 0;
+   psIter->uRemaining = oSymTable->num;
+   psIter->pvPosition = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_iterNext(struct SymTableIter *psIter)
+{
+   SymTable_T oSymTable;
+   size_t uSlot;
+
+   assert(psIter != NULL && psIter->oSymTable != NULL);
+
+   if (psIter->uRemaining == 0)
+      return 0;
+
+   /* Some later slot is full, so the scan needs no bounds check. */
+   oSymTable = psIter->oSymTable;
+   for (uSlot = psIter->uIndex; oSymTable->psSlots[uSlot].uDistance == 0;
+        uSlot++)
+      assert(uSlot + 1 < oSymTable->uCapacity);
+
+   psIter->uIndex = uSlot + 1;
+   psIter->uRemaining--;
+   psIter->pvPosition = &oSymTable->psSlots[uSlot];
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *SymTable_iterKey(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   return ((const struct SymTableSlot*)psIter->pvPosition)->pcKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_iterValue(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   return (void*)((const struct SymTableSlot*)psIter->pvPosition)->pvValue;
+}
@@ -0,0 +1,933 @@
+/*--------------------------------------------------------------------*/
+/* symtableswiss.c                                                    */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "strhash.h"
+#include "prefetch.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* The number of slots whose control bytes are probed together. */
+enum {GROUP_WIDTH = 16};
+
+/* The number of keys that a batch operation hashes and prefetches
+   before it resolves any of them. */
+enum {BATCH_SIZE = 16};
+
+/* The number of slots in a new SymTable. */
+enum {INITIAL_CAPACITY = GROUP_WIDTH};
+
+/* The highest fraction of slots that may be filled; probing relies on
+   every table keeping some slots empty. */
+static const double MAX_LOAD_FACTOR = 0.875;
+
+/* Control byte of a slot that has never held a binding. */
+static const signed char CTRL_EMPTY = -128;
+
+/* Control byte of a slot whose binding was removed (a tombstone). */
+static const signed char CTRL_DELETED = -2;
+
+/*--------------------------------------------------------------------*/
+
+/* Each key and value is stored in a SymTableSlot, together with the
+   full hash code of the key so that growing never rehashes a key. */
+
+struct SymTableSlot
+{
+   /* The key. */
+   const char *pcKey;
+
+   /* The value. */
+   const void *pvValue;
+
+   /* The hash code of the key. */
+   size_t uHash;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTable is a flat array of SymTableSlots with a parallel array
+   of control bytes.  The control byte of a full slot holds the low 7
+   bits of its key's hash code; empty and deleted slots have the high
+   bit set.  Slots are probed a group of GROUP_WIDTH at a time. */
+
+struct SymTable
+{
+   /* The control bytes, one per slot. */
+   signed char *pcCtrl;
+
+   /* The slots. */
+   struct SymTableSlot *psSlots;
+
+   /* The number of slots, a power of two that is at least
+      GROUP_WIDTH. */
+   size_t uCapacity;
+
+   /* The maximum fraction of slots that may be filled. */
+   double dMaxLoadFactor;
+
+   /* The hash function. */
+   StrHash_T pfHash;
+
+   /* The seed of the hash function. */
+   size_t uSeed;
+
+   /* The number of empty slots that may still be filled before the
+      table must be rebuilt. */
+   size_t uGrowthLeft;
+
+   /* The number of bindings. */
+   size_t num;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash code for the key of length uLength at pcKey under
+   the hash function and seed of oSymTable.  All bits of the result are
+   mixed, so both the low bits (the control byte) and the high bits
+   (the starting group) are well distributed. */
+
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+                            size_t uLength)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return (*oSymTable->pfHash)(pcKey, uLength, oSymTable->uSeed);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the control byte that marks a slot holding a key whose hash
+   code is uHash. */
+
+static signed char SymTable_ctrlOf(size_t uHash)
+{
+   return (signed char)(uHash & 0x7F);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a bit mask with bit i set iff pcGroup[i] == cCtrl, for the
+   GROUP_WIDTH control bytes starting at pcGroup. */
+
+static unsigned int SymTable_matchCtrl(const signed char *pcGroup,
+                                       signed char cCtrl)
+{
+#if defined(__SSE2__)
+   __m128i group = _mm_loadu_si128((const __m128i*)pcGroup);
+   return (unsigned int)
+      _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(cCtrl)));
+#else
+   unsigned int uMask = 0;
+   int i;
+   for (i = 0; i < GROUP_WIDTH; i++)
+      if (pcGroup[i] == cCtrl)
+         uMask |= 1u << i;
+   return uMask;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a bit mask with bit i set iff slot i of the group starting
+   at pcGroup is empty or deleted. */
+
+static unsigned int SymTable_matchFree(const signed char *pcGroup)
+{
+#if defined(__SSE2__)
+   __m128i group = _mm_loadu_si128((const __m128i*)pcGroup);
+   return (unsigned int)_mm_movemask_epi8(group);
+#else
+   unsigned int uMask = 0;
+   int i;
+   for (i = 0; i < GROUP_WIDTH; i++)
+      if (pcGroup[i] < 0)
+         uMask |= 1u << i;
+   return uMask;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index of the lowest set bit of uMask, which must not be
+   0. */
+
+static size_t SymTable_lowestBit(unsigned int uMask)
+{
+#if defined(__GNUC__)
+   return (size_t)__builtin_ctz(uMask);
+#else
+   size_t u = 0;
+   assert(uMask != 0);
+   while ((uMask & 1u) == 0)
+   {
+      uMask >>= 1;
+      u++;
+   }
+   return u;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bindings oSymTable may hold in uCapacity slots
+   before it must grow.  The result is at least 1 and leaves at least
+   1/8 of the slots empty. */
+
+static size_t SymTable_maxLoad(SymTable_T oSymTable, size_t uCapacity)
+{
+   size_t uMaxLoad;
+
+   assert(oSymTable != NULL);
+
+   uMaxLoad = (size_t)(oSymTable->dMaxLoadFactor * (double)uCapacity);
+   if (uMaxLoad > uCapacity - uCapacity / 8)
+      uMaxLoad = uCapacity - uCapacity / 8;
+   if (uMaxLoad == 0)
+      uMaxLoad = 1;
+   return uMaxLoad;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the smallest capacity, a power of two that is at least
+   GROUP_WIDTH, in which oSymTable may hold uCount bindings. */
+
+static size_t SymTable_capacityFor(SymTable_T oSymTable, size_t uCount)
+{
+   size_t uCapacity = INITIAL_CAPACITY;
+
+   assert(oSymTable != NULL);
+
+   while (SymTable_maxLoad(oSymTable, uCapacity) < uCount &&
+          uCapacity <= ((size_t)-1) / sizeof(struct SymTableSlot) / 2)
+      uCapacity *= 2;
+   return uCapacity;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Allocate uCapacity empty slots and their control bytes, and store
+   them in *ppcCtrl and *ppsSlots.  Return 1 (TRUE) if successful, or
+   0 (FALSE) if insufficient memory is available. */
+
+static int SymTable_allocSlots(size_t uCapacity, signed char **ppcCtrl,
+                               struct SymTableSlot **ppsSlots)
+{
+   assert(ppcCtrl != NULL && ppsSlots != NULL);
+
+   *ppcCtrl = (signed char*)malloc(uCapacity);
+   if (*ppcCtrl == NULL)
+      return 0;
+
+   *ppsSlots = (struct SymTableSlot*)
+      malloc(uCapacity * sizeof(struct SymTableSlot));
+   if (*ppsSlots == NULL)
+   {
+      free(*ppcCtrl);
+      return 0;
+   }
+
+   memset(*ppcCtrl, CTRL_EMPTY, uCapacity);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index of the first empty or deleted slot on the probe
+   sequence of uHash in a table whose control bytes are pcCtrl and
+   whose capacity is uCapacity. */
+
+static size_t SymTable_findFree(const signed char *pcCtrl,
+                                size_t uCapacity, size_t uHash)
+{
+   size_t uGroupMask = uCapacity / GROUP_WIDTH - 1;
+   size_t uGroup = (uHash >> 7) & uGroupMask;
+   size_t uProbe;
+   unsigned int uMask;
+
+   /* Visit groups in triangular order, which reaches every group
+      because the number of groups is a power of two. */
+   for (uProbe = 1; ; uProbe++)
+   {
+      uMask = SymTable_matchFree(pcCtrl + uGroup * GROUP_WIDTH);
+      if (uMask != 0)
+         return uGroup * GROUP_WIDTH + SymTable_lowestBit(uMask);
+      uGroup = (uGroup + uProbe) & uGroupMask;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Search oSymTable for a binding whose key is the uLength bytes at
+   pcKey and whose key has hash code uHash.  Store its slot index in
+   *puSlot and return 1 (TRUE) if found.  Otherwise return 0
+   (FALSE). */
+
+static int SymTable_find(SymTable_T oSymTable, const char *pcKey,
+                         size_t uLength, size_t uHash, size_t *puSlot)
+{
+   size_t uGroupMask;
+   size_t uGroup;
+   size_t uProbe;
+   size_t uSlot;
+   unsigned int uMatch;
+   const signed char *pcGroup;
+   signed char cCtrl = SymTable_ctrlOf(uHash);
+
+   assert(oSymTable != NULL && pcKey != NULL && puSlot != NULL);
+
+   uGroupMask = oSymTable->uCapacity / GROUP_WIDTH - 1;
+   uGroup = (uHash >> 7) & uGroupMask;
+
+   for (uProbe = 1; ; uProbe++)
+   {
+      pcGroup = oSymTable->pcCtrl + uGroup * GROUP_WIDTH;
+
+      /* Compare keys only in slots whose control byte matches. */
+      for (uMatch = SymTable_matchCtrl(pcGroup, cCtrl);
+           uMatch != 0;
+           uMatch &= uMatch - 1)
+      {
+         uSlot = uGroup * GROUP_WIDTH + SymTable_lowestBit(uMatch);
+         /* strncmp stops at the end of the stored key, so the stored
+            key is at least uLength bytes long when it returns 0. */
+         if (oSymTable->psSlots[uSlot].uHash == uHash &&
+             strncmp(oSymTable->psSlots[uSlot].pcKey, pcKey,
+                     uLength) == 0 &&
+             oSymTable->psSlots[uSlot].pcKey[uLength] == '\0')
+         {
+            *puSlot = uSlot;
+            return 1;
+         }
+      }
+
+      /* An empty slot ends the probe sequence. */
+      if (SymTable_matchCtrl(pcGroup, CTRL_EMPTY) != 0)
+         return 0;
+
+      uGroup = (uGroup + uProbe) & uGroupMask;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Rebuild oSymTable with uCapacity slots, dropping all deleted slots.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
+   is available, in which case oSymTable is unchanged. */
+
+static int SymTable_rehash(SymTable_T oSymTable, size_t uCapacity)
+{
+   signed char *pcNewCtrl;
+   struct SymTableSlot *psNewSlots;
+   size_t i;
+   size_t uSlot;
+
+   assert(oSymTable != NULL);
+   assert(SymTable_maxLoad(oSymTable, uCapacity) >= oSymTable->num);
+
+   if (! SymTable_allocSlots(uCapacity, &pcNewCtrl, &psNewSlots))
+      return 0;
+
+   for (i = 0; i < oSymTable->uCapacity; i++)
+   {
+      if (oSymTable->pcCtrl[i] < 0)
+         continue;
+      uSlot = SymTable_findFree(pcNewCtrl, uCapacity,
+                                oSymTable->psSlots[i].uHash);
+      pcNewCtrl[uSlot] = oSymTable->pcCtrl[i];
+      psNewSlots[uSlot] = oSymTable->psSlots[i];
+   }
+
+   free(oSymTable->pcCtrl);
+   free(oSymTable->psSlots);
+
+   oSymTable->pcCtrl = pcNewCtrl;
+   oSymTable->psSlots = psNewSlots;
+   oSymTable->uCapacity = uCapacity;
+   oSymTable->uGrowthLeft =
+      SymTable_maxLoad(oSymTable, uCapacity) - oSymTable->num;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make room in oSymTable for at least one more binding in an empty
+   slot.  If most of the used slots are tombstones, rebuild at the
+   same capacity; otherwise double the capacity.  Return 1 (TRUE) if
+   successful, or 0 (FALSE) if insufficient memory is available. */
+
+static int SymTable_grow(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+
+   if (oSymTable->num < SymTable_maxLoad(oSymTable,
+                                         oSymTable->uCapacity) / 2)
+      return SymTable_rehash(oSymTable, oSymTable->uCapacity);
+   return SymTable_rehash(oSymTable, oSymTable->uCapacity * 2);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+   return SymTable_newWithOptions(NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithOptions(const struct SymTableOptions *psOptions)
+{
+   SymTable_T oSymTable;
+
+   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->dMaxLoadFactor = MAX_LOAD_FACTOR;
+   if (psOptions != NULL && psOptions->dMaxLoadFactor > 0.0 &&
+       psOptions->dMaxLoadFactor < MAX_LOAD_FACTOR)
+      oSymTable->dMaxLoadFactor = psOptions->dMaxLoadFactor;
+
+   oSymTable->uCapacity = INITIAL_CAPACITY;
+   if (psOptions != NULL && psOptions->uCapacity > 0)
+      oSymTable->uCapacity =
+         SymTable_capacityFor(oSymTable, psOptions->uCapacity);
+
+   if (! SymTable_allocSlots(oSymTable->uCapacity, &oSymTable->pcCtrl,
+                             &oSymTable->psSlots))
+   {
+      free(oSymTable);
+      return NULL;
+   }
+
+   oSymTable->pfHash = StrHash_forOption(
+      psOptions != NULL ? psOptions->eHash : SYMTABLE_HASH_DEFAULT);
+   if (psOptions != NULL && psOptions->iFixedSeed)
+      oSymTable->uSeed = psOptions->uSeed;
+   else
+      oSymTable->uSeed = StrHash_randomSeed();
+
+   oSymTable->uGrowthLeft =
+      SymTable_maxLoad(oSymTable, oSymTable->uCapacity);
+   oSymTable->num = 0;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+   struct SymTableOptions sOptions;
+
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.uCapacity = uCapacity;
+   return SymTable_newWithOptions(&sOptions);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount)
+{
+   size_t uCapacity;
+
+   assert(oSymTable != NULL);
+
+   /* Every binding beyond the current ones may need an empty slot. */
+   if (uCount <= oSymTable->num ||
+       uCount - oSymTable->num <= oSymTable->uGrowthLeft)
+      return 1;
+
+   uCapacity = SymTable_capacityFor(oSymTable, uCount);
+   if (uCapacity < oSymTable->uCapacity)
+      uCapacity = oSymTable->uCapacity;
+   return SymTable_rehash(oSymTable, uCapacity);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_shrink(SymTable_T oSymTable)
+{
+   size_t uCapacity;
+
+   assert(oSymTable != NULL);
+
+   /* Rebuild at the smallest capacity that fits, which also clears
+      the tombstones, unless nothing would be reclaimed. */
+   uCapacity = SymTable_capacityFor(oSymTable, oSymTable->num);
+   if (uCapacity < oSymTable->uCapacity ||
+       oSymTable->num + oSymTable->uGrowthLeft <
+       SymTable_maxLoad(oSymTable, uCapacity))
+      (void)SymTable_rehash(oSymTable, uCapacity);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+   size_t i;
+
+   assert(oSymTable != NULL);
+
+   for (i = 0; i < oSymTable->uCapacity; i++)
+   {
+      if (oSymTable->pcCtrl[i] >= 0)
+         free((char*)oSymTable->psSlots[i].pcKey);
+   }
+
+   free(oSymTable->pcCtrl);
+   free(oSymTable->psSlots);
+   free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+   return oSymTable->num;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Fill a slot of oSymTable with the key of length uLength at pcKey,
+   whose hash code is uHash, and value pvValue, without checking
+   whether oSymTable already contains that key.  Return the slot, or
+   NULL if insufficient memory is available. */
+
+static struct SymTableSlot *SymTable_addSlot(SymTable_T oSymTable,
+                                             const char *pcKey,
+                                             size_t uLength, size_t uHash,
+                                             const void *pvValue)
+{
+   struct SymTableSlot *psSlot;
+   char *pcKeyCopy;
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   /* Make a defensive copy of pcKey, which need not end in '\0'.
+      Return NULL if insufficient memory is available. */
+   pcKeyCopy = (char*)malloc(uLength + 1);
+   if (pcKeyCopy == NULL)
+      return NULL;
+   memcpy(pcKeyCopy, pcKey, uLength);
+   pcKeyCopy[uLength] = '\0';
+
+   /* A tombstone may be reused freely, but filling an empty slot
+      consumes the growth budget. */
+   uSlot = SymTable_findFree(oSymTable->pcCtrl, oSymTable->uCapacity,
+                             uHash);
+   while (oSymTable->pcCtrl[uSlot] == CTRL_EMPTY &&
+          oSymTable->uGrowthLeft == 0)
+   {
+      if (! SymTable_grow(oSymTable))
+      {
+         free(pcKeyCopy);
+         return NULL;
+      }
+      uSlot = SymTable_findFree(oSymTable->pcCtrl,
+                                oSymTable->uCapacity, uHash);
+   }
+   if (oSymTable->pcCtrl[uSlot] == CTRL_EMPTY)
+      oSymTable->uGrowthLeft--;
+
+   oSymTable->pcCtrl[uSlot] = SymTable_ctrlOf(uHash);
+   psSlot = &oSymTable->psSlots[uSlot];
+   psSlot->pcKey = pcKeyCopy;
+   psSlot->pvValue = pvValue;
+   psSlot->uHash = uHash;
+   oSymTable->num++;
+
+   return psSlot;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add a new binding to oSymTable consisting of the key of length
+   uLength at pcKey, whose hash code is uHash, and value pvValue and
+   return 1 (TRUE).  Return 0 (FALSE) if oSymTable already contains a
+   binding with that key or insufficient memory is available. */
+
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+                           size_t uLength, size_t uHash,
+                           const void *pvValue)
+{
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (SymTable_find(oSymTable, pcKey, uLength, uHash, &uSlot))
+      return 0;
+
+   return SymTable_addSlot(oSymTable, pcKey, uLength, uHash,
+                           pvValue) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+                 const void *pvValue)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                  const void *pvValue)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_insert(oSymTable, pcKey, uLength,
+                          SymTable_hash(oSymTable, pcKey, uLength),
+                          pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+                       const void *pvValue)
+{
+   struct SymTableSlot *psSlot;
+   void *pvOldValue;
+   size_t uLength;
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   if (! SymTable_find(oSymTable, pcKey, uLength,
+                       SymTable_hash(oSymTable, pcKey, uLength), &uSlot))
+      return NULL;
+
+   psSlot = &oSymTable->psSlots[uSlot];
+   pvOldValue = (void*)psSlot->pvValue;
+   psSlot->pvValue = pvValue;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                      const void *pvValue)
+{
+   struct SymTableSlot *psSlot;
+   void *pvOldValue;
+   size_t uLength;
+   size_t uHash;
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   if (! SymTable_find(oSymTable, pcKey, uLength, uHash, &uSlot))
+   {
+      (void)SymTable_addSlot(oSymTable, pcKey, uLength, uHash, pvValue);
+      return NULL;
+   }
+
+   psSlot = &oSymTable->psSlots[uSlot];
+   pvOldValue = (void*)psSlot->pvValue;
+   psSlot->pvValue = pvValue;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+const void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                               const void *pvValue)
+{
+   struct SymTableSlot *psSlot;
+   size_t uLength;
+   size_t uHash;
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   if (SymTable_find(oSymTable, pcKey, uLength, uHash, &uSlot))
+      return &oSymTable->psSlots[uSlot].pvValue;
+
+   psSlot = SymTable_addSlot(oSymTable, pcKey, uLength, uHash, pvValue);
+   if (psSlot == NULL)
+      return NULL;
+   return &psSlot->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_find(oSymTable, pcKey, uLength,
+                        SymTable_hash(oSymTable, pcKey, uLength), &uSlot);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+                    size_t uLength)
+{
+   size_t uSlot;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (! SymTable_find(oSymTable, pcKey, uLength,
+                       SymTable_hash(oSymTable, pcKey, uLength), &uSlot))
+      return NULL;
+   return (void*)oSymTable->psSlots[uSlot].pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Hash the uCount keys in apcKeys, at most BATCH_SIZE of them, into
+   auHashes and auLengths, and prefetch the control bytes and slots of
+   the first group that each key probes, so that the memory accesses of
+   all the keys overlap. */
+
+static void SymTable_prefetchBatch(SymTable_T oSymTable,
+                                   const char **apcKeys, size_t uCount,
+                                   size_t *auHashes, size_t *auLengths)
+{
+   size_t uGroupMask = oSymTable->uCapacity / GROUP_WIDTH - 1;
+   size_t uSlot;
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL);
+   assert(auHashes != NULL && auLengths != NULL);
+   assert(uCount <= BATCH_SIZE);
+
+   for (u = 0; u < uCount; u++)
+   {
+      auLengths[u] = strlen(apcKeys[u]);
+      auHashes[u] = SymTable_hash(oSymTable, apcKeys[u], auLengths[u]);
+      uSlot = ((auHashes[u] >> 7) & uGroupMask) * GROUP_WIDTH;
+      PREFETCH(oSymTable->pcCtrl + uSlot);
+      PREFETCH(oSymTable->psSlots + uSlot);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+                       size_t uCount, void **apvValues)
+{
+   size_t auHashes[BATCH_SIZE];
+   size_t auLengths[BATCH_SIZE];
+   size_t uStart;
+   size_t uBatch;
+   size_t uSlot;
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL && apvValues != NULL);
+
+   for (uStart = 0; uStart < uCount; uStart += uBatch)
+   {
+      uBatch = uCount - uStart < BATCH_SIZE ? uCount - uStart : BATCH_SIZE;
+      SymTable_prefetchBatch(oSymTable, apcKeys + uStart, uBatch,
+                             auHashes, auLengths);
+      for (u = 0; u < uBatch; u++)
+      {
+         if (SymTable_find(oSymTable, apcKeys[uStart + u], auLengths[u],
+                           auHashes[u], &uSlot))
+            apvValues[uStart + u] =
+               (void*)oSymTable->psSlots[uSlot].pvValue;
+         else
+            apvValues[uStart + u] = NULL;
+      }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+                         size_t uCount, const void **apvValues)
+{
+   size_t auHashes[BATCH_SIZE];
+   size_t auLengths[BATCH_SIZE];
+   size_t uAdded = 0;
+   size_t uStart;
+   size_t uBatch;
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL && apvValues != NULL);
+
+   for (uStart = 0; uStart < uCount; uStart += uBatch)
+   {
+      uBatch = uCount - uStart < BATCH_SIZE ? uCount - uStart : BATCH_SIZE;
+      SymTable_prefetchBatch(oSymTable, apcKeys + uStart, uBatch,
+                             auHashes, auLengths);
+
+      /* Insert in order, so that a key repeated within the batch is
+         added once. */
+      for (u = 0; u < uBatch; u++)
+         uAdded += (size_t)SymTable_insert(oSymTable, apcKeys[uStart + u],
+                                           auLengths[u], auHashes[u],
+                                           apvValues[uStart + u]);
+   }
+   return uAdded;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   void *pvOldValue;
+   size_t uSlot;
+   const signed char *pcGroup;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (! SymTable_find(oSymTable, pcKey, uLength,
+                       SymTable_hash(oSymTable, pcKey, uLength), &uSlot))
+      return NULL;
+
+   pvOldValue = (void*)oSymTable->psSlots[uSlot].pvValue;
+   free((char*)oSymTable->psSlots[uSlot].pcKey);
+   oSymTable->num--;
+
+   /* If the slot's group still has an empty slot, no probe sequence
+      has ever passed through it, so the slot can become empty again.
+      Otherwise leave a tombstone so later groups stay reachable. */
+   pcGroup = oSymTable->pcCtrl + uSlot / GROUP_WIDTH * GROUP_WIDTH;
+   if (SymTable_matchCtrl(pcGroup, CTRL_EMPTY) != 0)
+   {
+      oSymTable->pcCtrl[uSlot] = CTRL_EMPTY;
+      oSymTable->uGrowthLeft++;
+   }
+   else
+      oSymTable->pcCtrl[uSlot] = CTRL_DELETED;
+
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   size_t i;
+
+   assert(oSymTable != NULL && pfApply != NULL);
+
+   for (i = 0; i < oSymTable->uCapacity; i++)
+   {
+      if (oSymTable->pcCtrl[i] >= 0)
+         (*pfApply)(oSymTable->psSlots[i].pcKey,
+                    (void*)oSymTable->psSlots[i].pvValue, (void*)pvExtra);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_iterBegin(SymTable_T oSymTable, struct SymTableIter *psIter)
+{
+   assert(oSymTable != NULL && psIter != NULL);
+
+   /* uIndex is the first slot that the cursor has yet to examine. */
+   psIter->oSymTable = oSymTable;
+   psIter->uIndex = 0;
+   psIter->uRemaining = oSymTable->num;
+   psIter->pvPosition = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_iterNext(struct SymTableIter *psIter)
+{
+   const unsigned int GROUP_MASK = (1u << GROUP_WIDTH) - 1;
+   SymTable_T oSymTable;
+   unsigned int uMask;
+   size_t uGroup;
+   size_t uSlot;
+
+   assert(psIter != NULL && psIter->oSymTable != NULL);
+
+   if (psIter->uRemaining == 0)
+      return 0;
+
+   /* Skip a whole group of empty and deleted slots per test.  Some
+      later slot is full, so the scan needs no bounds check. */
+   oSymTable = psIter->oSymTable;
+   uGroup = psIter->uIndex & ~(size_t)(GROUP_WIDTH - 1);
+   uMask = ~SymTable_matchFree(oSymTable->pcCtrl + uGroup) & GROUP_MASK
+      & (GROUP_MASK << (psIter->uIndex - uGroup));
+   while (uMask == 0)
+   {
+      uGroup += GROUP_WIDTH;
+      assert(uGroup < oSymTable->uCapacity);
+      uMask = ~SymTable_matchFree(oSymTable->pcCtrl + uGroup)
+         & GROUP_MASK;
+   }
+   uSlot = uGroup + SymTable_lowestBit(uMask);
+
+   psIter->uIndex = uSlot + 1;
+   psIter->uRemaining--;
+   psIter->pvPosition = &oSymTable->psSlots[uSlot];
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *SymTable_iterKey(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   return ((const struct SymTableSlot*)psIter->pvPosition)->pcKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_iterValue(const struct SymTableIter *psIter)
+{
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   return (void*)((const struct SymTableSlot*)psIter->pvPosition)->pvValue;
+}
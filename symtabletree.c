@@ -0,0 +1,1098 @@
+/*--------------------------------------------------------------------*/
+/* symtabletree.c                                                     */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+#include "symtableordered.h"
+
+/*--------------------------------------------------------------------*/
+
+/* The minimum degree of the B-tree.  Every node but the root holds at
+   least MIN_DEGREE - 1 keys, and every node at most MAX_KEY_COUNT. */
+enum {MIN_DEGREE = 16};
+enum {MAX_KEY_COUNT = 2 * MIN_DEGREE - 1};
+
+/* The number of leading bytes of each key that a node keeps beside
+   the key's address, packed into one size_t. */
+enum {PREFIX_SIZE = sizeof(size_t)};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableNode is a node of the B-tree.  Its keys are kept in
+   ascending order in parallel arrays, and the packed leading bytes of
+   each key sit together, so that a search within the node mostly
+   compares integers in a few cache lines and follows a key's address
+   only to break a tie.  An internal node has one more child than it
+   has keys; child i holds the keys between keys i - 1 and i.  Only an
+   internal node is allocated with room for its children. */
+
+struct SymTableNode
+{
+   /* The number of keys. */
+   int iCount;
+
+   /* 1 (TRUE) if the node is a leaf, or 0 (FALSE) if not. */
+   int iLeaf;
+
+   /* The first PREFIX_SIZE bytes of each key, big-endian and padded
+      with '\0', so that they order as the keys do. */
+   size_t auPrefixes[MAX_KEY_COUNT];
+
+   /* The lengths of the keys. */
+   size_t auLengths[MAX_KEY_COUNT];
+
+   /* The keys, defensive copies of the callers' keys. */
+   char *apcKeys[MAX_KEY_COUNT];
+
+   /* The values. */
+   const void *apvValues[MAX_KEY_COUNT];
+
+   /* The MAX_KEY_COUNT + 1 children of an internal node. */
+   struct SymTableNode *apsChildren[];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTable is a "dummy" node that points to the root of the B-tree
+and stores the number of bindings in the SymTable. */
+
+struct SymTable
+{
+   /* The root, or NULL while the SymTable is empty. */
+   struct SymTableNode *psRoot;
+
+   /* The number of bindings. */
+   size_t num;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the first PREFIX_SIZE bytes of the key of length uLength at
+   pcKey, packed big-endian and padded with '\0'. */
+
+static size_t SymTable_prefix(const char *pcKey, size_t uLength)
+{
+   size_t uPrefix = 0;
+   size_t u;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; u < PREFIX_SIZE; u++)
+   {
+      uPrefix <<= 8;
+      if (u < uLength)
+         uPrefix |= (unsigned char)pcKey[u];
+   }
+   return uPrefix;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a negative number, 0, or a positive number as key i of
+   psNode is less than, equal to, or greater than the key of length
+   uLength at pcKey, whose packed prefix is uPrefix. */
+
+static int SymTable_compare(const struct SymTableNode *psNode, int i,
+                            const char *pcKey, size_t uPrefix,
+                            size_t uLength)
+{
+   size_t uNodeLength;
+   int iCompare;
+
+   assert(psNode != NULL && pcKey != NULL);
+   assert(i >= 0 && i < psNode->iCount);
+
+   if (psNode->auPrefixes[i] != uPrefix)
+      return psNode->auPrefixes[i] < uPrefix ? -1 : 1;
+
+   /* Keys contain no '\0', so equal prefixes of keys that differ in
+      length both extend past PREFIX_SIZE bytes. */
+   uNodeLength = psNode->auLengths[i];
+   if (uNodeLength > PREFIX_SIZE && uLength > PREFIX_SIZE)
+   {
+      iCompare = memcmp(psNode->apcKeys[i] + PREFIX_SIZE,
+                        pcKey + PREFIX_SIZE,
+                        (uNodeLength < uLength ? uNodeLength : uLength)
+                        - PREFIX_SIZE);
+      if (iCompare != 0)
+         return iCompare;
+   }
+   if (uNodeLength != uLength)
+      return uNodeLength < uLength ? -1 : 1;
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index of the first key of psNode that is not less than
+   the key of length uLength at pcKey, whose packed prefix is uPrefix,
+   or psNode->iCount if there is none.  Store 1 (TRUE) in *piFound if
+   that key equals pcKey, or 0 (FALSE) if not. */
+
+static int SymTable_search(const struct SymTableNode *psNode,
+                           const char *pcKey, size_t uPrefix,
+                           size_t uLength, int *piFound)
+{
+   int iLow = 0;
+   int iHigh;
+   int iMid;
+
+   assert(psNode != NULL && pcKey != NULL && piFound != NULL);
+
+   iHigh = psNode->iCount;
+   while (iLow < iHigh)
+   {
+      iMid = iLow + (iHigh - iLow) / 2;
+      if (SymTable_compare(psNode, iMid, pcKey, uPrefix, uLength) < 0)
+         iLow = iMid + 1;
+      else
+         iHigh = iMid;
+   }
+   *piFound = iLow < psNode->iCount &&
+      SymTable_compare(psNode, iLow, pcKey, uPrefix, uLength) == 0;
+   return iLow;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new node with no keys, a leaf if iLeaf is nonzero, or NULL
+   if insufficient memory is available. */
+
+static struct SymTableNode *SymTable_newNode(int iLeaf)
+{
+   struct SymTableNode *psNode;
+   size_t uSize;
+
+   uSize = sizeof(struct SymTableNode);
+   if (! iLeaf)
+      uSize += (MAX_KEY_COUNT + 1) * sizeof(struct SymTableNode*);
+   psNode = (struct SymTableNode*)malloc(uSize);
+   if (psNode == NULL)
+      return NULL;
+
+   psNode->iCount = 0;
+   psNode->iLeaf = iLeaf;
+   return psNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free psNode, its keys, and all of its descendants. */
+
+static void SymTable_freeNode(struct SymTableNode *psNode)
+{
+   int i;
+
+   assert(psNode != NULL);
+
+   for (i = 0; i < psNode->iCount; i++)
+      free(psNode->apcKeys[i]);
+   if (! psNode->iLeaf)
+      for (i = 0; i <= psNode->iCount; i++)
+         SymTable_freeNode(psNode->apsChildren[i]);
+   free(psNode);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Copy iCount keys, with their prefixes, lengths and values, from
+   psSrc starting at index iSrc to psDst starting at index iDst.  The
+   ranges may overlap. */
+
+static void SymTable_moveKeys(struct SymTableNode *psDst, int iDst,
+                              struct SymTableNode *psSrc, int iSrc,
+                              int iCount)
+{
+   size_t uCount;
+
+   assert(psDst != NULL && psSrc != NULL && iCount >= 0);
+
+   uCount = (size_t)iCount;
+   memmove(&psDst->auPrefixes[iDst], &psSrc->auPrefixes[iSrc],
+           uCount * sizeof(size_t));
+   memmove(&psDst->auLengths[iDst], &psSrc->auLengths[iSrc],
+           uCount * sizeof(size_t));
+   memmove(&psDst->apcKeys[iDst], &psSrc->apcKeys[iSrc],
+           uCount * sizeof(char*));
+   memmove(&psDst->apvValues[iDst], &psSrc->apvValues[iSrc],
+           uCount * sizeof(const void*));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Copy iCount children from psSrc starting at index iSrc to psDst
+   starting at index iDst, both internal nodes.  The ranges may
+   overlap. */
+
+static void SymTable_moveChildren(struct SymTableNode *psDst, int iDst,
+                                  struct SymTableNode *psSrc, int iSrc,
+                                  int iCount)
+{
+   assert(psDst != NULL && psSrc != NULL && iCount >= 0);
+   assert(! psDst->iLeaf && ! psSrc->iLeaf);
+
+   memmove(&psDst->apsChildren[iDst], &psSrc->apsChildren[iSrc],
+           (size_t)iCount * sizeof(struct SymTableNode*));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Split child i of psParent, which is full, around its middle key:
+   the middle key moves up into psParent at index i, and the keys after
+   it move to a new child i + 1.  psParent must not be full.  Return 1
+   (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+   available, in which case leave psParent unchanged. */
+
+static int SymTable_splitChild(struct SymTableNode *psParent, int i)
+{
+   struct SymTableNode *psLeft;
+   struct SymTableNode *psRight;
+
+   assert(psParent != NULL && ! psParent->iLeaf);
+   assert(psParent->iCount < MAX_KEY_COUNT);
+
+   psLeft = psParent->apsChildren[i];
+   assert(psLeft->iCount == MAX_KEY_COUNT);
+
+   psRight = SymTable_newNode(psLeft->iLeaf);
+   if (psRight == NULL)
+      return 0;
+
+   SymTable_moveKeys(psRight, 0, psLeft, MIN_DEGREE, MIN_DEGREE - 1);
+   if (! psLeft->iLeaf)
+      SymTable_moveChildren(psRight, 0, psLeft, MIN_DEGREE, MIN_DEGREE);
+   psRight->iCount = MIN_DEGREE - 1;
+   psLeft->iCount = MIN_DEGREE - 1;
+
+   SymTable_moveKeys(psParent, i + 1, psParent, i, psParent->iCount - i);
+   SymTable_moveChildren(psParent, i + 2, psParent, i + 1,
+                         psParent->iCount - i);
+   SymTable_moveKeys(psParent, i, psLeft, MIN_DEGREE - 1, 1);
+   psParent->apsChildren[i + 1] = psRight;
+   psParent->iCount++;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the address of the value of the binding of oSymTable whose
+   key is the key of length uLength at pcKey, or NULL if there is no
+   such binding. */
+
+static const void **SymTable_find(SymTable_T oSymTable, const char *pcKey,
+                                  size_t uLength)
+{
+   struct SymTableNode *psNode;
+   size_t uPrefix;
+   int iFound;
+   int i;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   uPrefix = SymTable_prefix(pcKey, uLength);
+   for (psNode = oSymTable->psRoot; psNode != NULL;
+        psNode = psNode->apsChildren[i])
+   {
+      i = SymTable_search(psNode, pcKey, uPrefix, uLength, &iFound);
+      if (iFound)
+         return &psNode->apvValues[i];
+      if (psNode->iLeaf)
+         break;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the address of the value of the binding of oSymTable whose
+   key is the key of length uLength at pcKey, first adding a binding
+   with that key and value pvValue if there is none.  Store 1 (TRUE)
+   in *piAdded if the binding is new, or 0 (FALSE) if not.  Return NULL
+   if insufficient memory is available, in which case the bindings of
+   oSymTable are unchanged. */
+
+static const void **SymTable_findOrAdd(SymTable_T oSymTable,
+                                       const char *pcKey, size_t uLength,
+                                       const void *pvValue, int *piAdded)
+{
+   struct SymTableNode *psNode;
+   struct SymTableNode *psRoot;
+   char *pcCopy;
+   size_t uPrefix;
+   int iFound;
+   int i;
+
+   assert(oSymTable != NULL && pcKey != NULL && piAdded != NULL);
+
+   *piAdded = 0;
+   if (oSymTable->psRoot == NULL)
+   {
+      oSymTable->psRoot = SymTable_newNode(1);
+      if (oSymTable->psRoot == NULL)
+         return NULL;
+   }
+
+   /* Split a full root first, so that the tree grows at the top. */
+   if (oSymTable->psRoot->iCount == MAX_KEY_COUNT)
+   {
+      psRoot = SymTable_newNode(0);
+      if (psRoot == NULL)
+         return NULL;
+      psRoot->apsChildren[0] = oSymTable->psRoot;
+      if (! SymTable_splitChild(psRoot, 0))
+      {
+         free(psRoot);
+         return NULL;
+      }
+      oSymTable->psRoot = psRoot;
+   }
+
+   /* Descend, splitting each full child before entering it, so that
+      the leaf has room for the key and no split propagates upward.
+      A split that is followed by a lack of memory leaves the bindings
+      as they were. */
+   uPrefix = SymTable_prefix(pcKey, uLength);
+   psNode = oSymTable->psRoot;
+   for (;;)
+   {
+      i = SymTable_search(psNode, pcKey, uPrefix, uLength, &iFound);
+      if (iFound)
+         return &psNode->apvValues[i];
+      if (psNode->iLeaf)
+         break;
+
+      if (psNode->apsChildren[i]->iCount == MAX_KEY_COUNT)
+      {
+         if (! SymTable_splitChild(psNode, i))
+            return NULL;
+         iFound = SymTable_compare(psNode, i, pcKey, uPrefix, uLength);
+         if (iFound == 0)
+            return &psNode->apvValues[i];
+         if (iFound < 0)
+            i++;
+      }
+      psNode = psNode->apsChildren[i];
+   }
+
+   /* Make a defensive copy of pcKey, which need not end in '\0'. */
+   pcCopy = (char*)malloc(uLength + 1);
+   if (pcCopy == NULL)
+      return NULL;
+   memcpy(pcCopy, pcKey, uLength);
+   pcCopy[uLength] = '\0';
+
+   SymTable_moveKeys(psNode, i + 1, psNode, i, psNode->iCount - i);
+   psNode->auPrefixes[i] = uPrefix;
+   psNode->auLengths[i] = uLength;
+   psNode->apcKeys[i] = pcCopy;
+   psNode->apvValues[i] = pvValue;
+   psNode->iCount++;
+   oSymTable->num++;
+   *piAdded = 1;
+   return &psNode->apvValues[i];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Merge child i + 1 of psParent and key i of psParent into child i,
+   both of which hold MIN_DEGREE - 1 keys, and free child i + 1. */
+
+static void SymTable_merge(struct SymTableNode *psParent, int i)
+{
+   struct SymTableNode *psLeft;
+   struct SymTableNode *psRight;
+
+   assert(psParent != NULL && ! psParent->iLeaf);
+   assert(i >= 0 && i < psParent->iCount);
+
+   psLeft = psParent->apsChildren[i];
+   psRight = psParent->apsChildren[i + 1];
+   assert(psLeft->iCount + psRight->iCount + 1 <= MAX_KEY_COUNT);
+
+   SymTable_moveKeys(psLeft, psLeft->iCount, psParent, i, 1);
+   SymTable_moveKeys(psLeft, psLeft->iCount + 1, psRight, 0,
+                     psRight->iCount);
+   if (! psLeft->iLeaf)
+      SymTable_moveChildren(psLeft, psLeft->iCount + 1, psRight, 0,
+                            psRight->iCount + 1);
+   psLeft->iCount += psRight->iCount + 1;
+   free(psRight);
+
+   SymTable_moveKeys(psParent, i, psParent, i + 1,
+                     psParent->iCount - i - 1);
+   SymTable_moveChildren(psParent, i + 1, psParent, i + 2,
+                         psParent->iCount - i - 1);
+   psParent->iCount--;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make sure that child i of psParent holds at least MIN_DEGREE keys,
+   so that a key can be removed below it without leaving it short, by
+   borrowing a key through psParent from a sibling that can spare one
+   or else merging the child with a sibling.  Return the index of the
+   child that now covers the keys of child i. */
+
+static int SymTable_fillChild(struct SymTableNode *psParent, int i)
+{
+   struct SymTableNode *psChild;
+   struct SymTableNode *psSibling;
+
+   assert(psParent != NULL && ! psParent->iLeaf);
+   assert(i >= 0 && i <= psParent->iCount);
+
+   psChild = psParent->apsChildren[i];
+   if (psChild->iCount >= MIN_DEGREE)
+      return i;
+
+   /* Rotate the last key of the left sibling up into psParent, and key
+      i - 1 of psParent down into the child. */
+   if (i > 0 && psParent->apsChildren[i - 1]->iCount >= MIN_DEGREE)
+   {
+      psSibling = psParent->apsChildren[i - 1];
+      SymTable_moveKeys(psChild, 1, psChild, 0, psChild->iCount);
+      SymTable_moveKeys(psChild, 0, psParent, i - 1, 1);
+      SymTable_moveKeys(psParent, i - 1, psSibling,
+                        psSibling->iCount - 1, 1);
+      if (! psChild->iLeaf)
+      {
+         SymTable_moveChildren(psChild, 1, psChild, 0,
+                               psChild->iCount + 1);
+         psChild->apsChildren[0] =
+            psSibling->apsChildren[psSibling->iCount];
+      }
+      psChild->iCount++;
+      psSibling->iCount--;
+      return i;
+   }
+
+   /* Rotate the first key of the right sibling up into psParent, and
+      key i of psParent down into the child. */
+   if (i < psParent->iCount &&
+       psParent->apsChildren[i + 1]->iCount >= MIN_DEGREE)
+   {
+      psSibling = psParent->apsChildren[i + 1];
+      SymTable_moveKeys(psChild, psChild->iCount, psParent, i, 1);
+      SymTable_moveKeys(psParent, i, psSibling, 0, 1);
+      SymTable_moveKeys(psSibling, 0, psSibling, 1,
+                        psSibling->iCount - 1);
+      if (! psChild->iLeaf)
+      {
+         psChild->apsChildren[psChild->iCount + 1] =
+            psSibling->apsChildren[0];
+         SymTable_moveChildren(psSibling, 0, psSibling, 1,
+                               psSibling->iCount);
+      }
+      psChild->iCount++;
+      psSibling->iCount--;
+      return i;
+   }
+
+   if (i < psParent->iCount)
+   {
+      SymTable_merge(psParent, i);
+      return i;
+   }
+   SymTable_merge(psParent, i - 1);
+   return i - 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the greatest key of the subtree rooted at psNode if iGreatest
+   is nonzero, or its least key if not, and store it with its prefix,
+   length and value at index iSlot of psDst in place of the key there.
+   psNode must hold at least MIN_DEGREE keys. */
+
+static void SymTable_takeExtreme(struct SymTableNode *psNode,
+                                 int iGreatest,
+                                 struct SymTableNode *psDst, int iSlot)
+{
+   int i;
+
+   assert(psNode != NULL && psDst != NULL);
+
+   while (! psNode->iLeaf)
+   {
+      i = SymTable_fillChild(psNode, iGreatest ? psNode->iCount : 0);
+      psNode = psNode->apsChildren[i];
+   }
+
+   if (iGreatest)
+      SymTable_moveKeys(psDst, iSlot, psNode, psNode->iCount - 1, 1);
+   else
+   {
+      SymTable_moveKeys(psDst, iSlot, psNode, 0, 1);
+      SymTable_moveKeys(psNode, 0, psNode, 1, psNode->iCount - 1);
+   }
+   psNode->iCount--;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+   SymTable_T oSymTable;
+
+   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+   if (oSymTable == NULL)
+      return NULL;
+
+   oSymTable->psRoot = NULL;
+   oSymTable->num = 0;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithOptions(const struct SymTableOptions *psOptions)
+{
+   /* A B-tree neither hashes nor reorders, so no option applies. */
+   (void)psOptions;
+   return SymTable_new();
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+   /* A B-tree allocates its nodes as it grows, so there is no room
+      to reserve. */
+   (void)uCapacity;
+   return SymTable_new();
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCount)
+{
+   assert(oSymTable != NULL);
+
+   (void)uCount;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_shrink(SymTable_T oSymTable)
+{
+   /* A B-tree merges its nodes as bindings are removed. */
+   assert(oSymTable != NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+
+   if (oSymTable->psRoot != NULL)
+      SymTable_freeNode(oSymTable->psRoot);
+   free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+   assert(oSymTable != NULL);
+   return oSymTable->num;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+                 const void *pvValue)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey, size_t uLength,
+                  const void *pvValue)
+{
+   int iAdded;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   (void)SymTable_findOrAdd(oSymTable, pcKey, uLength, pvValue, &iAdded);
+   return iAdded;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+                       const void *pvValue)
+{
+   const void **ppvValue;
+   void *pvOldValue;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   ppvValue = SymTable_find(oSymTable, pcKey, strlen(pcKey));
+   if (ppvValue == NULL)
+      return NULL;
+
+   pvOldValue = (void*)*ppvValue;
+   *ppvValue = pvValue;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                      const void *pvValue)
+{
+   const void **ppvValue;
+   void *pvOldValue;
+   int iAdded;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   ppvValue = SymTable_findOrAdd(oSymTable, pcKey, strlen(pcKey),
+                                 pvValue, &iAdded);
+   if (ppvValue == NULL || iAdded)
+      return NULL;
+
+   pvOldValue = (void*)*ppvValue;
+   *ppvValue = pvValue;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+const void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                               const void *pvValue)
+{
+   int iAdded;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_findOrAdd(oSymTable, pcKey, strlen(pcKey), pvValue,
+                             &iAdded);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_find(oSymTable, pcKey, uLength) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+                    size_t uLength)
+{
+   const void **ppvValue;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   ppvValue = SymTable_find(oSymTable, pcKey, uLength);
+   if (ppvValue == NULL)
+      return NULL;
+   return (void*)*ppvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+                       size_t uCount, void **apvValues)
+{
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL && apvValues != NULL);
+
+   /* Each level of a descent depends on the one above, so there are
+      no independent memory accesses to overlap. */
+   for (u = 0; u < uCount; u++)
+      apvValues[u] = SymTable_get(oSymTable, apcKeys[u]);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+                         size_t uCount, const void **apvValues)
+{
+   size_t uAdded = 0;
+   size_t u;
+
+   assert(oSymTable != NULL && apcKeys != NULL && apvValues != NULL);
+
+   for (u = 0; u < uCount; u++)
+      uAdded += (size_t)SymTable_put(oSymTable, apcKeys[u], apvValues[u]);
+   return uAdded;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+                       size_t uLength)
+{
+   struct SymTableNode *psNode;
+   void *pvOldValue = NULL;
+   char *pcOldKey;
+   size_t uPrefix;
+   int iFound;
+   int i;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+
+   if (oSymTable->psRoot == NULL)
+      return NULL;
+
+   /* Descend, filling each child to at least MIN_DEGREE keys before
+      entering it, so that removing a key never leaves a node short
+      and no fix-up propagates upward. */
+   uPrefix = SymTable_prefix(pcKey, uLength);
+   psNode = oSymTable->psRoot;
+   for (;;)
+   {
+      i = SymTable_search(psNode, pcKey, uPrefix, uLength, &iFound);
+      if (iFound && psNode->iLeaf)
+      {
+         pvOldValue = (void*)psNode->apvValues[i];
+         free(psNode->apcKeys[i]);
+         SymTable_moveKeys(psNode, i, psNode, i + 1,
+                           psNode->iCount - i - 1);
+         psNode->iCount--;
+         oSymTable->num--;
+         break;
+      }
+      if (iFound)
+      {
+         /* Replace the key by its predecessor or successor from a
+            child that can spare a key, or else merge the two children
+            around it and remove it from the merged child. */
+         pvOldValue = (void*)psNode->apvValues[i];
+         pcOldKey = psNode->apcKeys[i];
+         if (psNode->apsChildren[i]->iCount >= MIN_DEGREE)
+            SymTable_takeExtreme(psNode->apsChildren[i], 1, psNode, i);
+         else if (psNode->apsChildren[i + 1]->iCount >= MIN_DEGREE)
+            SymTable_takeExtreme(psNode->apsChildren[i + 1], 0,
+                                 psNode, i);
+         else
+         {
+            SymTable_merge(psNode, i);
+            psNode = psNode->apsChildren[i];
+            continue;
+         }
+         free(pcOldKey);
+         oSymTable->num--;
+         break;
+      }
+      if (psNode->iLeaf)
+         break;
+      psNode = psNode->apsChildren[SymTable_fillChild(psNode, i)];
+   }
+
+   /* A merge below the root may have emptied it. */
+   psNode = oSymTable->psRoot;
+   if (psNode->iCount == 0)
+   {
+      oSymTable->psRoot = psNode->iLeaf ? NULL : psNode->apsChildren[0];
+      free(psNode);
+   }
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each binding in the subtree rooted at
+   psNode in ascending key order, passing pvExtra as an extra
+   parameter. */
+
+static void SymTable_mapNode(struct SymTableNode *psNode,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   int i;
+
+   assert(psNode != NULL && pfApply != NULL);
+
+   for (i = 0; i < psNode->iCount; i++)
+   {
+      if (! psNode->iLeaf)
+         SymTable_mapNode(psNode->apsChildren[i], pfApply, pvExtra);
+      (*pfApply)(psNode->apcKeys[i], (void*)psNode->apvValues[i],
+                 (void*)pvExtra);
+   }
+   if (! psNode->iLeaf)
+      SymTable_mapNode(psNode->apsChildren[i], pfApply, pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   assert(oSymTable != NULL && pfApply != NULL);
+
+   if (oSymTable->psRoot != NULL)
+      SymTable_mapNode(oSymTable->psRoot, pfApply, pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Find the first key of oSymTable that is greater than the key of
+   length uLength at pcKey if iAfter is nonzero, or not less than it if
+   iAfter is zero.  Store its node in *ppsNode and its index in *piSlot
+   and return 1 (TRUE), or return 0 (FALSE) if there is no such key. */
+
+static int SymTable_seek(SymTable_T oSymTable, const char *pcKey,
+                         size_t uLength, int iAfter,
+                         struct SymTableNode **ppsNode, int *piSlot)
+{
+   struct SymTableNode *psNode;
+   size_t uPrefix;
+   int iFound = 0;
+   int iFound2;
+   int i;
+
+   assert(oSymTable != NULL && pcKey != NULL);
+   assert(ppsNode != NULL && piSlot != NULL);
+
+   /* The deepest key that qualifies is the first, since the keys of a
+      child lie before the key that follows the child. */
+   uPrefix = SymTable_prefix(pcKey, uLength);
+   for (psNode = oSymTable->psRoot; psNode != NULL;
+        psNode = psNode->apsChildren[i])
+   {
+      i = SymTable_search(psNode, pcKey, uPrefix, uLength, &iFound2);
+      if (iFound2 && ! iAfter)
+      {
+         *ppsNode = psNode;
+         *piSlot = i;
+         return 1;
+      }
+      if (iFound2)
+         i++;
+      if (i < psNode->iCount)
+      {
+         *ppsNode = psNode;
+         *piSlot = i;
+         iFound = 1;
+      }
+      if (psNode->iLeaf)
+         break;
+   }
+   return iFound;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Advance *ppsNode and *piSlot from a key of oSymTable to the next
+   key in ascending order.  Return 1 (TRUE) if there is one, or 0
+   (FALSE) if not. */
+
+static int SymTable_advance(SymTable_T oSymTable,
+                            struct SymTableNode **ppsNode, int *piSlot)
+{
+   struct SymTableNode *psNode;
+   int i;
+
+   assert(oSymTable != NULL && ppsNode != NULL && piSlot != NULL);
+
+   psNode = *ppsNode;
+   i = *piSlot;
+
+   /* The next key of an internal node is the least key of the child
+      that follows it. */
+   if (! psNode->iLeaf)
+   {
+      psNode = psNode->apsChildren[i + 1];
+      while (! psNode->iLeaf)
+         psNode = psNode->apsChildren[0];
+      *ppsNode = psNode;
+      *piSlot = 0;
+      return 1;
+   }
+   if (i + 1 < psNode->iCount)
+   {
+      *piSlot = i + 1;
+      return 1;
+   }
+
+   /* The next key after a leaf is in an ancestor, which the nodes do
+      not record, so search for it from the root.  This happens once
+      per leaf. */
+   return SymTable_seek(oSymTable, psNode->apcKeys[i],
+                        psNode->auLengths[i], 1, ppsNode, piSlot);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+    const char *pcHigh,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   struct SymTableNode *psNode;
+   size_t uHighPrefix = 0;
+   size_t uHighLength = 0;
+   int iMore;
+   int i;
+
+   assert(oSymTable != NULL && pfApply != NULL);
+
+   if (pcLow == NULL)
+      pcLow = "";
+   if (pcHigh != NULL)
+   {
+      uHighLength = strlen(pcHigh);
+      uHighPrefix = SymTable_prefix(pcHigh, uHighLength);
+   }
+
+   for (iMore = SymTable_seek(oSymTable, pcLow, strlen(pcLow), 0,
+                              &psNode, &i);
+        iMore;
+        iMore = SymTable_advance(oSymTable, &psNode, &i))
+   {
+      if (pcHigh != NULL &&
+          SymTable_compare(psNode, i, pcHigh, uHighPrefix,
+                           uHighLength) >= 0)
+         break;
+      (*pfApply)(psNode->apcKeys[i], (void*)psNode->apvValues[i],
+                 (void*)pvExtra);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+   struct SymTableNode *psNode;
+   size_t uLength;
+   int iMore;
+   int i;
+
+   assert(oSymTable != NULL && pcPrefix != NULL && pfApply != NULL);
+
+   /* The keys that begin with pcPrefix follow pcPrefix itself in one
+      run. */
+   uLength = strlen(pcPrefix);
+   for (iMore = SymTable_seek(oSymTable, pcPrefix, uLength, 0,
+                              &psNode, &i);
+        iMore;
+        iMore = SymTable_advance(oSymTable, &psNode, &i))
+   {
+      if (psNode->auLengths[i] < uLength ||
+          memcmp(psNode->apcKeys[i], pcPrefix, uLength) != 0)
+         break;
+      (*pfApply)(psNode->apcKeys[i], (void*)psNode->apvValues[i],
+                 (void*)pvExtra);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_iterBegin(SymTable_T oSymTable, struct SymTableIter *psIter)
+{
+   assert(oSymTable != NULL && psIter != NULL);
+
+   psIter->oSymTable = oSymTable;
+   psIter->uIndex = 0;
+   psIter->uRemaining = oSymTable->num;
+   psIter->pvPosition = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_iterNext(struct SymTableIter *psIter)
+{
+   struct SymTableNode *psNode;
+   int iMore;
+   int i;
+
+   assert(psIter != NULL && psIter->oSymTable != NULL);
+
+   if (psIter->uRemaining == 0)
+      return 0;
+
+   /* Bindings are visited in ascending key order, starting at the
+      leftmost leaf. */
+   psNode = (struct SymTableNode*)psIter->pvPosition;
+   if (psNode == NULL)
+   {
+      psNode = psIter->oSymTable->psRoot;
+      while (! psNode->iLeaf)
+         psNode = psNode->apsChildren[0];
+      i = 0;
+   }
+   else
+   {
+      i = (int)psIter->uIndex;
+      iMore = SymTable_advance(psIter->oSymTable, &psNode, &i);
+      assert(iMore);
+      (void)iMore;
+   }
+
+   psIter->uRemaining--;
+   psIter->pvPosition = psNode;
+   psIter->uIndex = (size_t)i;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *SymTable_iterKey(const struct SymTableIter *psIter)
+{
+   const struct SymTableNode *psNode;
+
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   psNode = (const struct SymTableNode*)psIter->pvPosition;
+   return psNode->apcKeys[psIter->uIndex];
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_iterValue(const struct SymTableIter *psIter)
+{
+   const struct SymTableNode *psNode;
+
+   assert(psIter != NULL && psIter->pvPosition != NULL);
+
+   psNode = (const struct SymTableNode*)psIter->pvPosition;
+   return (void*)psNode->apvValues[psIter->uIndex];
+}
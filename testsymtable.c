@@ -431,6 +431,82 @@ static void testMap(void)
 
 /*--------------------------------------------------------------------*/
 
+/* A MapVisit tracks a SymTable_map() of a table from within whose
+   callback the table is searched. */
+
+struct MapVisit
+{
+   /* The SymTable object being mapped. */
+   SymTable_T oSymTable;
+
+   /* The number of bindings visited so far. */
+   size_t uVisits;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Check that the table of the MapVisit pvExtra binds pcKey to pvValue,
+   by way of lookups that may carry an incremental growth forward, and
+   count the visit. */
+
+static void lookUpBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   struct MapVisit *psVisit = (struct MapVisit*)pvExtra;
+
+   assert(pcKey != NULL);
+   assert(psVisit != NULL);
+
+   ASSURE(SymTable_get(psVisit->oSymTable, pcKey) == pvValue);
+   ASSURE(SymTable_contains(psVisit->oSymTable, "0"));
+   psVisit->uVisits++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_map() on a table that grows incrementally, with
+   lookups from within the mapped function.  The map must visit each
+   binding exactly once, whatever the lookups do to the growth. */
+
+static void testMapLookups(void)
+{
+   enum {BINDING_COUNT = 1025};
+   enum {MAX_KEY_LENGTH = 10};
+
+   static char acValues[BINDING_COUNT];
+   struct SymTableOptions sOptions;
+   struct MapVisit sVisit;
+   char acKey[MAX_KEY_LENGTH];
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing lookups from within SymTable_map().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.uRehashStep = 1;
+   sVisit.oSymTable = SymTable_newWithOptions(&sOptions);
+   ASSURE(sVisit.oSymTable != NULL);
+
+   /* Map after every addition, so that some maps start in the middle
+      of a growth. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(sVisit.oSymTable, acKey, &acValues[i]);
+      ASSURE(iSuccessful);
+      sVisit.uVisits = 0;
+      SymTable_map(sVisit.oSymTable, lookUpBinding, &sVisit);
+      ASSURE(sVisit.uVisits == (size_t)i + 1);
+   }
+
+   SymTable_free(sVisit.oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test a SymTable object that contains no bindings. */
 
 static void testEmptyTable(void)
@@ -778,6 +854,820 @@ static void testCollisions(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Test a SymTable object whose keys all have the same multiplicative
+   hash code under every seed.  Each key concatenates BLOCK_COUNT
+   Thue-Morse blocks of BLOCK_LENGTH characters, or their complements,
+   which is long enough for the hash codes to collide in all 64
+   bits. */
+
+static void testCollidingHashes(void)
+{
+   enum {BLOCK_LENGTH = 2048};
+   enum {BLOCK_COUNT = 5};
+   enum {KEY_COUNT = 1 << BLOCK_COUNT};
+   enum {KEY_SIZE = BLOCK_COUNT * BLOCK_LENGTH + 1};
+
+   static char acKeys[KEY_COUNT][KEY_SIZE];
+   static const char *apcKeys[KEY_COUNT];
+   static const void *apvValues[KEY_COUNT];
+   struct SymTableOptions sOptions;
+   SymTable_T oSymTable;
+   char *pcValue;
+   size_t uAdded;
+   int iSuccessful;
+   int iFound;
+   int iParity;
+   int iBits;
+   int iKey;
+   int iBlock;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing keys whose hash codes all collide.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (iKey = 0; iKey < KEY_COUNT; iKey++)
+   {
+      for (iBlock = 0; iBlock < BLOCK_COUNT; iBlock++)
+         for (i = 0; i < BLOCK_LENGTH; i++)
+         {
+            /* The parity of the bits of i, flipped in complemented
+               blocks. */
+            iParity = (iKey >> iBlock) & 1;
+            for (iBits = i; iBits != 0; iBits &= iBits - 1)
+               iParity ^= 1;
+            acKeys[iKey][iBlock * BLOCK_LENGTH + i] =
+               (char)(iParity ? 'B' : 'A');
+         }
+      acKeys[iKey][KEY_SIZE - 1] = '\0';
+      apcKeys[iKey] = acKeys[iKey];
+      apvValues[iKey] = acKeys[iKey];
+   }
+
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.eHash = SYMTABLE_HASH_MULTIPLICATIVE;
+   sOptions.iFixedSeed = 1;
+   oSymTable = SymTable_newWithOptions(&sOptions);
+   ASSURE(oSymTable != NULL);
+
+   /* Insert half the keys one at a time and the rest in a batch. */
+   for (iKey = 0; iKey < KEY_COUNT / 2; iKey++)
+   {
+      iSuccessful = SymTable_put(oSymTable, apcKeys[iKey],
+                                 apvValues[iKey]);
+      ASSURE(iSuccessful);
+   }
+   uAdded = SymTable_putBatch(oSymTable, apcKeys, KEY_COUNT, apvValues);
+   ASSURE(uAdded == KEY_COUNT / 2);
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT);
+
+   for (iKey = 0; iKey < KEY_COUNT; iKey++)
+   {
+      pcValue = (char*)SymTable_get(oSymTable, apcKeys[iKey]);
+      ASSURE(pcValue == apvValues[iKey]);
+   }
+
+   /* Remove the even keys. */
+   for (iKey = 0; iKey < KEY_COUNT; iKey += 2)
+   {
+      pcValue = (char*)SymTable_remove(oSymTable, apcKeys[iKey]);
+      ASSURE(pcValue == apvValues[iKey]);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT / 2);
+   for (iKey = 0; iKey < KEY_COUNT; iKey++)
+   {
+      iFound = SymTable_contains(oSymTable, apcKeys[iKey]);
+      ASSURE(iFound == (iKey % 2 == 1));
+   }
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The keys of a SymTable object in the order SymTable_map() visits
+   them, for tables whose keys are the decimal integers 0 through
+   ORDER_KEY_COUNT - 1. */
+
+enum {ORDER_KEY_COUNT = 64};
+
+struct Order
+{
+   /* The number of keys visited so far. */
+   size_t uCount;
+
+   /* The keys visited, as integers, in the order visited. */
+   int aiKeys[ORDER_KEY_COUNT];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Append the integer value of pcKey to the Order pvExtra.  pvValue is
+   unused. */
+
+static void recordOrder(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   struct Order *psOrder = (struct Order*)pvExtra;
+
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(psOrder != NULL);
+   assert(psOrder->uCount < ORDER_KEY_COUNT);
+
+   psOrder->aiKeys[psOrder->uCount] = atoi(pcKey);
+   psOrder->uCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store in *psOrder the order in which SymTable_map() visits the keys
+   of oSymTable. */
+
+static void getOrder(SymTable_T oSymTable, struct Order *psOrder)
+{
+   assert(oSymTable != NULL);
+   assert(psOrder != NULL);
+
+   psOrder->uCount = 0;
+   SymTable_map(oSymTable, recordOrder, psOrder);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that repeated lookups of the last key that SymTable_map()
+   visits reorder a table created with eReorder as eReorder directs:
+   moving the key to the front, moving it one position earlier per
+   lookup, or leaving it in place.  Only the list implementation
+   prepends new bindings, so only a table whose first map order is the
+   reverse of the order of insertion is expected to reorder. */
+
+static void testReorder(enum SymTableReorder eReorder)
+{
+   enum {MAX_KEY_LENGTH = 10};
+
+   static char acValues[ORDER_KEY_COUNT];
+   struct SymTableOptions sOptions;
+   SymTable_T oSymTable;
+   struct Order sExpected;
+   struct Order sActual;
+   char acKey[MAX_KEY_LENGTH];
+   char *pcValue;
+   size_t uPos;
+   size_t u;
+   int iSuccessful;
+   int iFound;
+   int iIsList;
+   int iTailKey;
+   int iLookup;
+   int i;
+
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.iFixedSeed = 1;
+   sOptions.eReorder = eReorder;
+   oSymTable = SymTable_newWithOptions(&sOptions);
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < ORDER_KEY_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &acValues[i]);
+      ASSURE(iSuccessful);
+   }
+
+   getOrder(oSymTable, &sExpected);
+   ASSURE(sExpected.uCount == ORDER_KEY_COUNT);
+   iIsList = 1;
+   for (u = 0; u < ORDER_KEY_COUNT; u++)
+      if (sExpected.aiKeys[u] != ORDER_KEY_COUNT - 1 - (int)u)
+         iIsList = 0;
+
+   /* Look up the tail key once per position, alternating between
+      SymTable_get() and SymTable_contains(). */
+   iTailKey = sExpected.aiKeys[ORDER_KEY_COUNT - 1];
+   sprintf(acKey, "%d", iTailKey);
+   for (iLookup = 0; iLookup < ORDER_KEY_COUNT; iLookup++)
+   {
+      if (iLookup % 2 == 0)
+      {
+         pcValue = (char*)SymTable_get(oSymTable, acKey);
+         ASSURE(pcValue == &acValues[iTailKey]);
+      }
+      else
+      {
+         iFound = SymTable_contains(oSymTable, acKey);
+         ASSURE(iFound);
+      }
+
+      for (uPos = 0; sExpected.aiKeys[uPos] != iTailKey; uPos++)
+         ;
+      if (iIsList && uPos > 0)
+      {
+         if (eReorder == SYMTABLE_REORDER_MOVE_TO_FRONT)
+         {
+            for (u = uPos; u > 0; u--)
+               sExpected.aiKeys[u] = sExpected.aiKeys[u - 1];
+            sExpected.aiKeys[0] = iTailKey;
+         }
+         else if (eReorder == SYMTABLE_REORDER_TRANSPOSE)
+         {
+            sExpected.aiKeys[uPos] = sExpected.aiKeys[uPos - 1];
+            sExpected.aiKeys[uPos - 1] = iTailKey;
+         }
+      }
+
+      getOrder(oSymTable, &sActual);
+      ASSURE(sActual.uCount == ORDER_KEY_COUNT);
+      for (u = 0; u < ORDER_KEY_COUNT; u++)
+         ASSURE(sActual.aiKeys[u] == sExpected.aiKeys[u]);
+   }
+
+   /* By now a reordering list visits the key first, and any other
+      table still visits it last. */
+   if (iIsList && eReorder != SYMTABLE_REORDER_NONE)
+      ASSURE(sActual.aiKeys[0] == iTailKey);
+   else
+      ASSURE(sActual.aiKeys[ORDER_KEY_COUNT - 1] == iTailKey);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable objects whose load factors, rehash steps, allocation
+   modes, hash functions, seeds, and reordering are set through
+   SymTable_newWithOptions(). */
+
+static void testOptions(void)
+{
+   enum {BINDING_COUNT = 5000};
+   enum {MAX_KEY_LENGTH = 10};
+   enum {LONG_KEY_SIZE = 1000};
+   enum {FACTOR_COUNT = 5};
+   enum {STEP_COUNT = 3};
+   enum {HASH_COUNT = 4};
+   enum {REORDER_COUNT = 3};
+
+   static const double adLoadFactors[FACTOR_COUNT] =
+      {0.0, 0.25, 0.5, 4.0, 16.0};
+   static const size_t auRehashSteps[STEP_COUNT] = {0, 1, 64};
+   static char acValues[BINDING_COUNT];
+   char acLongKey[LONG_KEY_SIZE];
+   struct SymTableOptions sOptions;
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char *pcValue;
+   size_t uConfig;
+   size_t uLength;
+   int iSuccessful;
+   int iFound;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable objects created with options.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* NULL options select the defaults. */
+   oSymTable = SymTable_newWithOptions(NULL);
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_put(oSymTable, "Jeter", acValues);
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "Jeter");
+   ASSURE(pcValue == acValues);
+   SymTable_free(oSymTable);
+
+   memset(acLongKey, 'k', LONG_KEY_SIZE - 1);
+   acLongKey[LONG_KEY_SIZE - 1] = '\0';
+
+   /* Try every combination of load factor, rehash step, and
+      allocation mode, cycling through the hash functions, the
+      reorderings, and between fixed and random seeds. */
+   for (uConfig = 0; uConfig < FACTOR_COUNT * STEP_COUNT * 2; uConfig++)
+   {
+      memset(&sOptions, 0, sizeof(sOptions));
+      sOptions.dMaxLoadFactor = adLoadFactors[uConfig % FACTOR_COUNT];
+      sOptions.uRehashStep =
+         auRehashSteps[uConfig / FACTOR_COUNT % STEP_COUNT];
+      sOptions.iUseArena = (int)(uConfig / (FACTOR_COUNT * STEP_COUNT));
+      sOptions.eHash = (enum SymTableHash)(uConfig % HASH_COUNT);
+      sOptions.iFixedSeed = (int)(uConfig % 2);
+      sOptions.uSeed = uConfig;
+      sOptions.eReorder = (enum SymTableReorder)(uConfig % REORDER_COUNT);
+      oSymTable = SymTable_newWithOptions(&sOptions);
+      ASSURE(oSymTable != NULL);
+
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iSuccessful = SymTable_put(oSymTable, acKey, &acValues[i]);
+         ASSURE(iSuccessful);
+      }
+      uLength = SymTable_getLength(oSymTable);
+      ASSURE(uLength == BINDING_COUNT);
+
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         pcValue = (char*)SymTable_get(oSymTable, acKey);
+         ASSURE(pcValue == &acValues[i]);
+      }
+
+      /* Remove the even keys. */
+      for (i = 0; i < BINDING_COUNT; i += 2)
+      {
+         sprintf(acKey, "%d", i);
+         pcValue = (char*)SymTable_remove(oSymTable, acKey);
+         ASSURE(pcValue == &acValues[i]);
+      }
+      uLength = SymTable_getLength(oSymTable);
+      ASSURE(uLength == BINDING_COUNT / 2);
+
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iFound = SymTable_contains(oSymTable, acKey);
+         ASSURE(iFound == (i % 2 == 1));
+      }
+
+      /* Reinsert the even keys, which may reuse removed memory. */
+      for (i = 0; i < BINDING_COUNT; i += 2)
+      {
+         sprintf(acKey, "%d", i);
+         iSuccessful = SymTable_put(oSymTable, acKey, &acValues[i]);
+         ASSURE(iSuccessful);
+      }
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         pcValue = (char*)SymTable_get(oSymTable, acKey);
+         ASSURE(pcValue == &acValues[i]);
+      }
+
+      /* Long keys take a different path through an arena. */
+      iSuccessful = SymTable_put(oSymTable, acLongKey, acValues);
+      ASSURE(iSuccessful);
+      pcValue = (char*)SymTable_get(oSymTable, acLongKey);
+      ASSURE(pcValue == acValues);
+      pcValue = (char*)SymTable_remove(oSymTable, acLongKey);
+      ASSURE(pcValue == acValues);
+      iSuccessful = SymTable_put(oSymTable, acLongKey, acValues);
+      ASSURE(iSuccessful);
+
+      SymTable_free(oSymTable);
+   }
+
+   /* Lookups reorder a list as the options direct. */
+   for (i = 0; i < REORDER_COUNT; i++)
+      testReorder((enum SymTableReorder)i);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newWithCapacity(), SymTable_reserve(), and
+   SymTable_shrink(), in a table that resizes all at once and in one
+   that resizes incrementally. */
+
+static void testCapacity(void)
+{
+   enum {BINDING_COUNT = 5000};
+   enum {KEPT_COUNT = 100};
+   enum {MAX_KEY_LENGTH = 10};
+
+   static char acValues[BINDING_COUNT];
+   struct SymTableOptions sOptions;
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char *pcValue;
+   size_t uLength;
+   int iSuccessful;
+   int iStep;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing capacity reservation and shrinking.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newWithCapacity(0);
+   ASSURE(oSymTable != NULL);
+   SymTable_shrink(oSymTable);
+   iSuccessful = SymTable_put(oSymTable, "Gehrig", acValues);
+   ASSURE(iSuccessful);
+   SymTable_free(oSymTable);
+
+   for (iStep = 0; iStep <= 1; iStep++)
+   {
+      memset(&sOptions, 0, sizeof(sOptions));
+      sOptions.uCapacity = BINDING_COUNT / 4;
+      sOptions.uRehashStep = (size_t)iStep;
+      oSymTable = SymTable_newWithOptions(&sOptions);
+      ASSURE(oSymTable != NULL);
+
+      /* Fill past the initial capacity, then reserve the rest. */
+      for (i = 0; i < BINDING_COUNT / 2; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iSuccessful = SymTable_put(oSymTable, acKey, &acValues[i]);
+         ASSURE(iSuccessful);
+      }
+      iSuccessful = SymTable_reserve(oSymTable, BINDING_COUNT);
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_reserve(oSymTable, 1);
+      ASSURE(iSuccessful);
+      for (i = BINDING_COUNT / 2; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iSuccessful = SymTable_put(oSymTable, acKey, &acValues[i]);
+         ASSURE(iSuccessful);
+      }
+
+      /* Remove all but a few bindings, then shrink. */
+      for (i = KEPT_COUNT; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         pcValue = (char*)SymTable_remove(oSymTable, acKey);
+         ASSURE(pcValue == &acValues[i]);
+      }
+      SymTable_shrink(oSymTable);
+      uLength = SymTable_getLength(oSymTable);
+      ASSURE(uLength == KEPT_COUNT);
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         pcValue = (char*)SymTable_get(oSymTable, acKey);
+         ASSURE(pcValue == (i < KEPT_COUNT ? &acValues[i] : NULL));
+      }
+
+      /* The shrunken table grows again as needed. */
+      for (i = KEPT_COUNT; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iSuccessful = SymTable_put(oSymTable, acKey, &acValues[i]);
+         ASSURE(iSuccessful);
+      }
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         pcValue = (char*)SymTable_get(oSymTable, acKey);
+         ASSURE(pcValue == &acValues[i]);
+      }
+
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a SymTable object that repeatedly grows past a handful of
+   bindings and shrinks back, as an implementation that stores small
+   tables specially must handle. */
+
+static void testSmallTable(void)
+{
+   enum {BINDING_COUNT = 20};
+   enum {ROUND_COUNT = 3};
+   enum {MAX_KEY_LENGTH = 10};
+
+   static char acValues[BINDING_COUNT];
+   struct SymTableOptions sOptions;
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char *pcValue;
+   int iSuccessful;
+   int iStep;
+   int iRound;
+   int iCount;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a table that grows and shrinks while small.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (iStep = 0; iStep <= 1; iStep++)
+   {
+      memset(&sOptions, 0, sizeof(sOptions));
+      sOptions.uRehashStep = (size_t)iStep;
+      oSymTable = SymTable_newWithOptions(&sOptions);
+      ASSURE(oSymTable != NULL);
+
+      for (iRound = 0; iRound < ROUND_COUNT; iRound++)
+         for (iCount = 1; iCount <= BINDING_COUNT; iCount++)
+         {
+            /* Grow to iCount bindings, then shrink to none. */
+            for (i = 0; i < iCount; i++)
+            {
+               sprintf(acKey, "%d", i);
+               iSuccessful = SymTable_put(oSymTable, acKey, &acValues[i]);
+               ASSURE(iSuccessful);
+            }
+            ASSURE(SymTable_getLength(oSymTable) == (size_t)iCount);
+            for (i = 0; i < BINDING_COUNT; i++)
+            {
+               sprintf(acKey, "%d", i);
+               pcValue = (char*)SymTable_get(oSymTable, acKey);
+               ASSURE(pcValue == (i < iCount ? &acValues[i] : NULL));
+            }
+            for (i = iCount - 1; i >= 0; i--)
+            {
+               sprintf(acKey, "%d", i);
+               pcValue = (char*)SymTable_remove(oSymTable, acKey);
+               ASSURE(pcValue == &acValues[i]);
+               if (i % 4 == 0)
+                  SymTable_shrink(oSymTable);
+            }
+            ASSURE(SymTable_getLength(oSymTable) == 0);
+         }
+
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_iter functions. */
+
+static void testIterator(void)
+{
+   enum {BINDING_COUNT = 2000};
+   enum {MAX_KEY_LENGTH = 10};
+
+   static char acValues[BINDING_COUNT];
+   static int aiVisits[BINDING_COUNT];
+   struct SymTableOptions sOptions;
+   struct SymTableIter sIter;
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   const char *pcKey;
+   char *pcValue;
+   int iSuccessful;
+   int iStep;
+   int iCount;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_iter functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   SymTable_iterBegin(oSymTable, &sIter);
+   ASSURE(! SymTable_iterNext(&sIter));
+   SymTable_free(oSymTable);
+
+   for (iStep = 0; iStep <= 1; iStep++)
+   {
+      /* With a rehash step, the table is still growing incrementally
+         when the iteration begins. */
+      memset(&sOptions, 0, sizeof(sOptions));
+      sOptions.uRehashStep = (size_t)iStep;
+      oSymTable = SymTable_newWithOptions(&sOptions);
+      ASSURE(oSymTable != NULL);
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iSuccessful = SymTable_put(oSymTable, acKey, &acValues[i]);
+         ASSURE(iSuccessful);
+      }
+
+      /* Visit every binding exactly once, looking up and replacing
+         values along the way. */
+      memset(aiVisits, 0, sizeof(aiVisits));
+      iCount = 0;
+      SymTable_iterBegin(oSymTable, &sIter);
+      while (SymTable_iterNext(&sIter))
+      {
+         pcKey = SymTable_iterKey(&sIter);
+         pcValue = (char*)SymTable_iterValue(&sIter);
+         i = atoi(pcKey);
+         ASSURE(pcValue == &acValues[i]);
+         ASSURE(SymTable_get(oSymTable, pcKey) == pcValue);
+         pcValue = (char*)SymTable_replace(oSymTable, pcKey, acKey);
+         ASSURE(pcValue == &acValues[i]);
+         ASSURE(SymTable_iterValue(&sIter) == acKey);
+         aiVisits[i]++;
+         iCount++;
+      }
+      ASSURE(iCount == BINDING_COUNT);
+      ASSURE(! SymTable_iterNext(&sIter));
+      for (i = 0; i < BINDING_COUNT; i++)
+         ASSURE(aiVisits[i] == 1);
+
+      /* Stop at the first binding found. */
+      SymTable_iterBegin(oSymTable, &sIter);
+      iSuccessful = SymTable_iterNext(&sIter);
+      ASSURE(iSuccessful);
+      ASSURE(SymTable_contains(oSymTable, SymTable_iterKey(&sIter)));
+
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_upsert() and SymTable_getOrPut(). */
+
+static void testUpsert(void)
+{
+   enum {WORD_COUNT = 2000};
+   enum {DISTINCT_COUNT = 37};
+   enum {MAX_KEY_LENGTH = 10};
+
+   /* A value acCounts + n stands for the count n. */
+   static char acCounts[WORD_COUNT + 1];
+   SymTable_T oSymTable;
+   const void **ppvValue;
+   char acKey[MAX_KEY_LENGTH];
+   char *pcValue;
+   size_t uLength;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_upsert and SymTable_getOrPut.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   pcValue = (char*)SymTable_upsert(oSymTable, "Ruth", "60");
+   ASSURE(pcValue == NULL);
+   pcValue = (char*)SymTable_upsert(oSymTable, "Ruth", "714");
+   ASSURE(pcValue != NULL && strcmp(pcValue, "60") == 0);
+   pcValue = (char*)SymTable_get(oSymTable, "Ruth");
+   ASSURE(pcValue != NULL && strcmp(pcValue, "714") == 0);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 1);
+
+   /* getOrPut leaves an existing value alone. */
+   ppvValue = SymTable_getOrPut(oSymTable, "Ruth", "0");
+   ASSURE(ppvValue != NULL && strcmp((const char*)*ppvValue, "714") == 0);
+   *ppvValue = "715";
+   pcValue = (char*)SymTable_get(oSymTable, "Ruth");
+   ASSURE(pcValue != NULL && strcmp(pcValue, "715") == 0);
+   SymTable_remove(oSymTable, "Ruth");
+
+   /* Count words through the value slots. */
+   for (i = 0; i < WORD_COUNT; i++)
+   {
+      sprintf(acKey, "w%d", i % DISTINCT_COUNT);
+      ppvValue = SymTable_getOrPut(oSymTable, acKey, acCounts);
+      ASSURE(ppvValue != NULL);
+      *ppvValue = (const char*)*ppvValue + 1;
+   }
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == DISTINCT_COUNT);
+   for (i = 0; i < DISTINCT_COUNT; i++)
+   {
+      sprintf(acKey, "w%d", i);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue - acCounts ==
+             WORD_COUNT / DISTINCT_COUNT + (i < WORD_COUNT % DISTINCT_COUNT));
+   }
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_putN(), SymTable_getN(), SymTable_containsN(), and
+   SymTable_removeN() on keys that lie inside a larger buffer. */
+
+static void testLengthKeys(void)
+{
+   static const char acBuffer[] = "alphabet alpha alp beta";
+   SymTable_T oSymTable;
+   char *pcValue;
+   int iSuccessful;
+   int iFound;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing length-delimited keys.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Insert "alpha" and "alp" straight from the buffer. */
+   iSuccessful = SymTable_putN(oSymTable, acBuffer + 9, 5, "second");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, acBuffer + 15, 3, "third");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, acBuffer, 5, "duplicate");
+   ASSURE(! iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+
+   /* Stored keys end in '\0', so the NUL-terminated API finds them. */
+   pcValue = (char*)SymTable_get(oSymTable, "alpha");
+   ASSURE(pcValue != NULL && strcmp(pcValue, "second") == 0);
+   pcValue = (char*)SymTable_get(oSymTable, "alp");
+   ASSURE(pcValue != NULL && strcmp(pcValue, "third") == 0);
+
+   /* Prefixes and extensions of stored keys are different keys. */
+   pcValue = (char*)SymTable_getN(oSymTable, acBuffer, 8);
+   ASSURE(pcValue == NULL);
+   pcValue = (char*)SymTable_getN(oSymTable, acBuffer, 4);
+   ASSURE(pcValue == NULL);
+   pcValue = (char*)SymTable_getN(oSymTable, acBuffer, 3);
+   ASSURE(pcValue != NULL && strcmp(pcValue, "third") == 0);
+   iFound = SymTable_containsN(oSymTable, acBuffer + 19, 4);
+   ASSURE(! iFound);
+   iFound = SymTable_containsN(oSymTable, acBuffer, 5);
+   ASSURE(iFound);
+
+   /* The empty key may be any zero-length slice. */
+   iSuccessful = SymTable_putN(oSymTable, acBuffer + 4, 0, "empty");
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "");
+   ASSURE(pcValue != NULL && strcmp(pcValue, "empty") == 0);
+
+   pcValue = (char*)SymTable_removeN(oSymTable, acBuffer + 9, 5);
+   ASSURE(pcValue != NULL && strcmp(pcValue, "second") == 0);
+   pcValue = (char*)SymTable_removeN(oSymTable, acBuffer + 9, 5);
+   ASSURE(pcValue == NULL);
+   iFound = SymTable_contains(oSymTable, "alpha");
+   ASSURE(! iFound);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_getBatch() and SymTable_putBatch(), in a table that
+   grows all at once and in one that grows incrementally. */
+
+static void testBatch(void)
+{
+   enum {KEY_COUNT = 3000};
+   enum {MAX_KEY_LENGTH = 10};
+
+   static char acKeys[KEY_COUNT][MAX_KEY_LENGTH];
+   static const char *apcKeys[KEY_COUNT];
+   static const void *apvValues[KEY_COUNT];
+   static void *apvFound[KEY_COUNT];
+   struct SymTableOptions sOptions;
+   SymTable_T oSymTable;
+   size_t uAdded;
+   int iStep;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing batched lookups and insertions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Every third key repeats the key before it. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKeys[i], "%d", i % 3 == 2 ? i - 1 : i);
+      apcKeys[i] = acKeys[i];
+      apvValues[i] = acKeys[i];
+   }
+
+   for (iStep = 0; iStep <= 1; iStep++)
+   {
+      memset(&sOptions, 0, sizeof(sOptions));
+      sOptions.uRehashStep = (size_t)iStep;
+      oSymTable = SymTable_newWithOptions(&sOptions);
+      ASSURE(oSymTable != NULL);
+
+      /* Insert the first half, then all keys, in batches. */
+      uAdded = SymTable_putBatch(oSymTable, apcKeys, KEY_COUNT / 2,
+                                 apvValues);
+      ASSURE(uAdded == KEY_COUNT / 3);
+      uAdded = SymTable_putBatch(oSymTable, apcKeys, KEY_COUNT,
+                                 apvValues);
+      ASSURE(uAdded == KEY_COUNT / 3);
+      ASSURE(SymTable_getLength(oSymTable) == 2 * KEY_COUNT / 3);
+
+      /* A repeated key keeps the value of its first occurrence. */
+      SymTable_getBatch(oSymTable, apcKeys, KEY_COUNT, apvFound);
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         ASSURE(apvFound[i] == (i % 3 == 2 ? apvValues[i - 1]
+                                           : apvValues[i]));
+         ASSURE(apvFound[i] == SymTable_get(oSymTable, apcKeys[i]));
+      }
+
+      /* Missing keys yield NULL. */
+      for (i = 0; i < KEY_COUNT; i += 2)
+         SymTable_remove(oSymTable, apcKeys[i]);
+      SymTable_getBatch(oSymTable, apcKeys, KEY_COUNT, apvFound);
+      for (i = 0; i < KEY_COUNT; i++)
+         ASSURE(apvFound[i] == SymTable_get(oSymTable, apcKeys[i]));
+
+      SymTable_getBatch(oSymTable, apcKeys, 0, apvFound);
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the ability of a SymTable object to be large, that is, to
    contain iBindingCount bindings. Write the time consumed to stdout. */
 
@@ -914,6 +1804,13 @@ static void testLargeTable(int iBindingCount)
    iFinalClock = clock();
    printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
       ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+
+   /* With constant-time operations the cost per binding stays flat
+      as iBindingCount grows. */
+   if (iBindingCount > 0)
+      printf("CPU time per binding:  %f microseconds\n",
+         ((double)(iFinalClock - iInitialClock)) * 1000000.0
+         / CLOCKS_PER_SEC / iBindingCount);
    fflush(stdout);
 }
 
@@ -956,12 +1853,21 @@ int main(int argc, char *argv[])
    testKeyOwnership();
    testRemove();
    testMap();
+   testMapLookups();
    testEmptyTable();
    testEmptyKey();
    testNullValue();
    testLongKey();
    testTableOfTables();
    testCollisions();
+   testCollidingHashes();
+   testOptions();
+   testBatch();
+   testLengthKeys();
+   testUpsert();
+   testCapacity();
+   testSmallTable();
+   testIterator();
    testLargeTable(iBindingCount);
 
    printf("------------------------------------------------------\n");
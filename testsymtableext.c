@@ -0,0 +1,970 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableext.c                                                  */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "symtablehash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* The thread counts with which each parallel operation is tested. */
+static const int aiThreadCounts[] = {1, 2, 3, 8};
+enum {THREAD_COUNT_COUNT = sizeof(aiThreadCounts) / sizeof(int)};
+
+/* The most threads that any test uses. */
+enum {MAX_THREAD_COUNT = 8};
+
+/* The longest key of a test, including the terminating '\0'. */
+enum {MAX_KEY_LENGTH = 12};
+
+/* The shard counts with which sharded tables are tested. */
+static const size_t auShardCounts[] = {1, 3, 16};
+enum {SHARD_COUNT_COUNT = sizeof(auShardCounts) / sizeof(size_t)};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new SymTable object that binds the decimal digits of each
+   i less than iBindingCount to &acValues[i], growing incrementally
+   if iIncremental is nonzero.  Exit with EXIT_FAILURE if insufficient
+   memory is available. */
+
+static SymTable_T newTable(int iBindingCount, char *acValues,
+                           int iIncremental)
+{
+   struct SymTableOptions sOptions;
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   int iSuccessful;
+   int i;
+
+   assert(acValues != NULL || iBindingCount == 0);
+
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.uRehashStep = (size_t)iIncremental;
+   oSymTable = SymTable_newWithOptions(&sOptions);
+   if (oSymTable == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &acValues[i]);
+      ASSURE(iSuccessful);
+   }
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new SymTable object with uShardCount shards that binds the
+   decimal digits of each i less than iBindingCount to &acValues[i].
+   Exit with EXIT_FAILURE if insufficient memory is available. */
+
+static SymTable_T newShardedTable(int iBindingCount, char *acValues,
+                                  size_t uShardCount)
+{
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   int iSuccessful;
+   int i;
+
+   assert(acValues != NULL || iBindingCount == 0);
+
+   oSymTable = SymTable_newSharded(uShardCount);
+   if (oSymTable == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &acValues[i]);
+      ASSURE(iSuccessful);
+   }
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count a visit to the binding whose value is pvValue, a char.  pcKey
+   and pvExtra are unused.  Distinct bindings have distinct values, so
+   concurrent calls touch distinct chars. */
+
+static void countVisit(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL && pvValue != NULL);
+   (void)pvExtra;
+
+   (*(char*)pvValue)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count in pvCount, a size_t, a visit to the binding whose value is
+   pvValue.  pcKey is unused.  Unlike countVisit, leave the value
+   unchanged. */
+
+static void countBinding(const char *pcKey, void *pvValue, void *pvCount)
+{
+   assert(pcKey != NULL && pvValue != NULL && pvCount != NULL);
+
+   (*(size_t*)pvCount)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count a visit to the binding of pvSymTable, a SymTable, whose key is
+   pcKey and whose value is pvValue, as countVisit does, after looking
+   the binding up.  For some keys, also map pvSymTable again in
+   parallel from within the map, and check that the nested map visits
+   every binding. */
+
+static void mapNested(const char *pcKey, void *pvValue, void *pvSymTable)
+{
+   SymTable_T oSymTable;
+   size_t uVisits = 0;
+
+   assert(pcKey != NULL && pvValue != NULL && pvSymTable != NULL);
+
+   oSymTable = (SymTable_T)pvSymTable;
+   ASSURE(SymTable_get(oSymTable, pcKey) == pvValue);
+   countVisit(pcKey, pvValue, NULL);
+   if (atoi(pcKey) % 1009 == 0)
+   {
+      SymTable_mapParallel(oSymTable, countBinding, &uVisits,
+                           MAX_THREAD_COUNT);
+      ASSURE(uVisits == SymTable_getLength(oSymTable));
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that the binding of pvSymTable, a SymTable, whose key is pcKey
+   has the value pvValue, both by looking it up and by replacing its
+   value with itself, and that pvSymTable binds "0".  For some keys,
+   also map pvSymTable again from within the map, and check that the
+   nested map visits every binding. */
+
+static void lookUpNested(const char *pcKey, void *pvValue,
+                         void *pvSymTable)
+{
+   SymTable_T oSymTable;
+   size_t uVisits = 0;
+
+   assert(pcKey != NULL && pvValue != NULL && pvSymTable != NULL);
+
+   oSymTable = (SymTable_T)pvSymTable;
+   ASSURE(SymTable_get(oSymTable, pcKey) == pvValue);
+   ASSURE(SymTable_replace(oSymTable, pcKey, pvValue) == pvValue);
+   ASSURE(SymTable_contains(oSymTable, "0"));
+   if (atoi(pcKey) % 1009 == 0)
+   {
+      SymTable_map(oSymTable, countBinding, &uVisits);
+      ASSURE(uVisits == SymTable_getLength(oSymTable));
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* A Totals is the private accumulator of one thread of a reduction. */
+
+struct Totals
+{
+   /* The number of bindings visited. */
+   size_t uCount;
+
+   /* The sum of the numbers that the keys spell. */
+   size_t uKeySum;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Add the binding whose key is pcKey to pvTotals, a Totals.  pvValue
+   is unused. */
+
+static void addTotals(const char *pcKey, void *pvValue, void *pvTotals)
+{
+   struct Totals *psTotals;
+
+   assert(pcKey != NULL && pvTotals != NULL);
+   (void)pvValue;
+
+   psTotals = (struct Totals*)pvTotals;
+   psTotals->uCount++;
+   psTotals->uKeySum += (size_t)atoi(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_mapParallel() on a table of iBindingCount bindings. */
+
+static void testMapParallel(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char *acValues;
+   int iKind;
+   int iThreads;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_mapParallel().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   acValues = (char*)calloc((size_t)iBindingCount + 1, 1);
+   ASSURE(acValues != NULL);
+
+   /* Map a table that grows at once, one that grows incrementally, and
+      one of two shards. */
+   for (iKind = 0; iKind <= 2; iKind++)
+   {
+      memset(acValues, 0, (size_t)iBindingCount);
+      if (iKind < 2)
+         oSymTable = newTable(iBindingCount, acValues, iKind);
+      else
+         oSymTable = newShardedTable(iBindingCount, acValues, 2);
+
+      /* Each round visits each binding exactly once. */
+      for (iThreads = 0; iThreads < THREAD_COUNT_COUNT; iThreads++)
+         SymTable_mapParallel(oSymTable, countVisit, NULL,
+                              aiThreadCounts[iThreads]);
+      for (i = 0; i < iBindingCount; i++)
+         ASSURE(acValues[i] == THREAD_COUNT_COUNT);
+
+      /* A map started from within a map runs to completion. */
+      SymTable_mapParallel(oSymTable, mapNested, oSymTable,
+                           MAX_THREAD_COUNT);
+      for (i = 0; i < iBindingCount; i++)
+         ASSURE(acValues[i] == THREAD_COUNT_COUNT + 1);
+
+      SymTable_free(oSymTable);
+   }
+
+   free(acValues);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_reduceParallel() on a table of iBindingCount
+   bindings. */
+
+static void testReduceParallel(int iBindingCount)
+{
+   struct Totals asTotals[MAX_THREAD_COUNT];
+   void *apvAccumulators[MAX_THREAD_COUNT];
+   SymTable_T oSymTable;
+   char *acValues;
+   size_t uCount;
+   size_t uKeySum;
+   int iThreads;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_reduceParallel().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   acValues = (char*)calloc((size_t)iBindingCount + 1, 1);
+   ASSURE(acValues != NULL);
+   oSymTable = newTable(iBindingCount, acValues, 0);
+
+   for (iThreads = 0; iThreads < THREAD_COUNT_COUNT; iThreads++)
+   {
+      memset(asTotals, 0, sizeof(asTotals));
+      for (i = 0; i < MAX_THREAD_COUNT; i++)
+         apvAccumulators[i] = &asTotals[i];
+      SymTable_reduceParallel(oSymTable, addTotals, apvAccumulators,
+                              aiThreadCounts[iThreads]);
+
+      /* Combine the accumulators of the threads. */
+      uCount = 0;
+      uKeySum = 0;
+      for (i = 0; i < MAX_THREAD_COUNT; i++)
+      {
+         ASSURE(i < aiThreadCounts[iThreads] || asTotals[i].uCount == 0);
+         uCount += asTotals[i].uCount;
+         uKeySum += asTotals[i].uKeySum;
+      }
+      ASSURE(uCount == (size_t)iBindingCount);
+      ASSURE(uKeySum == (size_t)iBindingCount
+             * (size_t)(iBindingCount - 1) / 2);
+   }
+
+   /* An empty table leaves every accumulator untouched. */
+   SymTable_free(oSymTable);
+   oSymTable = newTable(0, NULL, 0);
+   memset(asTotals, 0, sizeof(asTotals));
+   SymTable_reduceParallel(oSymTable, addTotals, apvAccumulators,
+                           MAX_THREAD_COUNT);
+   for (i = 0; i < MAX_THREAD_COUNT; i++)
+      ASSURE(asTotals[i].uCount == 0);
+   SymTable_free(oSymTable);
+
+   free(acValues);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that the frozen oSymTable binds the decimal digits of each i
+   less than iBindingCount to &acValues[i], and nothing else, and that
+   every function that would change it fails. */
+
+static void checkFrozen(SymTable_T oSymTable, int iBindingCount,
+                        char *acValues)
+{
+   struct SymTableIter sIter;
+   char acKey[MAX_KEY_LENGTH];
+   const char *apcKeys[2];
+   const void *apvPut[2];
+   void *apvValues[2];
+   int iVisits;
+   int i;
+
+   assert(oSymTable != NULL);
+   assert(acValues != NULL || iBindingCount == 0);
+
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == &acValues[i]);
+      ASSURE(SymTable_containsN(oSymTable, acKey, strlen(acKey)));
+   }
+   ASSURE(SymTable_get(oSymTable, "-1") == NULL);
+   ASSURE(! SymTable_contains(oSymTable, ""));
+   sprintf(acKey, "%d", iBindingCount);
+   ASSURE(SymTable_get(oSymTable, acKey) == NULL);
+
+   /* Every mutator fails, whether or not its key is present. */
+   ASSURE(! SymTable_put(oSymTable, acKey, acValues));
+   ASSURE(SymTable_upsert(oSymTable, acKey, acValues) == NULL);
+   ASSURE(SymTable_getOrPut(oSymTable, acKey, acValues) == NULL);
+   ASSURE(SymTable_get(oSymTable, acKey) == NULL);
+   if (iBindingCount > 0)
+   {
+      ASSURE(! SymTable_put(oSymTable, "0", acValues));
+      ASSURE(SymTable_replace(oSymTable, "0", NULL) == NULL);
+      ASSURE(SymTable_upsert(oSymTable, "0", NULL) == NULL);
+      ASSURE(SymTable_getOrPut(oSymTable, "0", NULL) == NULL);
+      ASSURE(SymTable_remove(oSymTable, "0") == NULL);
+      ASSURE(SymTable_get(oSymTable, "0") == &acValues[0]);
+   }
+   apcKeys[0] = acKey;
+   apcKeys[1] = "0";
+   apvPut[0] = acValues;
+   apvPut[1] = acValues;
+   ASSURE(SymTable_putBatch(oSymTable, apcKeys, 2, apvPut) == 0);
+   ASSURE(! SymTable_reserve(oSymTable, (size_t)iBindingCount * 2 + 1));
+   SymTable_shrink(oSymTable);
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+
+   apvValues[0] = acValues;
+   SymTable_getBatch(oSymTable, apcKeys, 2, apvValues);
+   ASSURE(apvValues[0] == NULL);
+   ASSURE(apvValues[1] == (iBindingCount > 0 ? &acValues[0] : NULL));
+
+   /* The map, the iterator and a parallel map each visit every binding
+      once. */
+   memset(acValues, 0, (size_t)iBindingCount);
+   SymTable_map(oSymTable, countVisit, NULL);
+   iVisits = 0;
+   SymTable_iterBegin(oSymTable, &sIter);
+   while (SymTable_iterNext(&sIter))
+   {
+      ASSURE(SymTable_get(oSymTable, SymTable_iterKey(&sIter))
+             == SymTable_iterValue(&sIter));
+      countVisit(SymTable_iterKey(&sIter), SymTable_iterValue(&sIter),
+                 NULL);
+      iVisits++;
+   }
+   ASSURE(iVisits == iBindingCount);
+   SymTable_mapParallel(oSymTable, countVisit, NULL, MAX_THREAD_COUNT);
+   for (i = 0; i < iBindingCount; i++)
+      ASSURE(acValues[i] == 3);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_freeze() on tables of up to iBindingCount bindings. */
+
+static void testFreeze(int iBindingCount)
+{
+   struct SymTableOptions sOptions;
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char *acValues;
+   int iIncremental;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_freeze().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   acValues = (char*)calloc((size_t)iBindingCount + 1, 1);
+   ASSURE(acValues != NULL);
+
+   for (iIncremental = 0; iIncremental <= 1; iIncremental++)
+   {
+      oSymTable = newTable(iBindingCount, acValues, iIncremental);
+      ASSURE(SymTable_freeze(oSymTable));
+      checkFrozen(oSymTable, iBindingCount, acValues);
+      ASSURE(SymTable_freeze(oSymTable));
+      checkFrozen(oSymTable, iBindingCount, acValues);
+      SymTable_free(oSymTable);
+   }
+
+   /* Tables that are empty, tiny, or own their nodes through an
+      arena also freeze. */
+   oSymTable = newTable(0, NULL, 0);
+   ASSURE(SymTable_freeze(oSymTable));
+   checkFrozen(oSymTable, 0, acValues);
+   SymTable_free(oSymTable);
+
+   oSymTable = newTable(iBindingCount < 3 ? iBindingCount : 3, acValues,
+                        0);
+   ASSURE(SymTable_freeze(oSymTable));
+   checkFrozen(oSymTable, iBindingCount < 3 ? iBindingCount : 3,
+               acValues);
+   SymTable_free(oSymTable);
+
+   memset(&sOptions, 0, sizeof(sOptions));
+   sOptions.iUseArena = 1;
+   oSymTable = SymTable_newWithOptions(&sOptions);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, &acValues[i]));
+   }
+   ASSURE(SymTable_freeze(oSymTable));
+   checkFrozen(oSymTable, iBindingCount, acValues);
+   SymTable_free(oSymTable);
+
+   /* A sharded table cannot be frozen, and stays usable. */
+   oSymTable = SymTable_newSharded(4);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "0", acValues));
+   ASSURE(! SymTable_freeze(oSymTable));
+   ASSURE(SymTable_remove(oSymTable, "0") == acValues);
+   SymTable_free(oSymTable);
+
+   free(acValues);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* A ShardWorker describes the share of one thread in a test of a
+   sharded table. */
+
+struct ShardWorker
+{
+   /* The table. */
+   SymTable_T oSymTable;
+
+   /* The values, one per key. */
+   char *acValues;
+
+   /* The number of keys. */
+   int iBindingCount;
+
+   /* The index of the thread, which owns every key i with
+      i % iThreadCount == iThread. */
+   int iThread;
+
+   /* The number of threads. */
+   int iThreadCount;
+
+   /* If nonzero, remove the thread's odd keys rather than adding all
+      its keys. */
+   int iRemove;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Add or remove the keys of pvWorker, a ShardWorker.  Return NULL. */
+
+static void *runShardWorker(void *pvWorker)
+{
+   struct ShardWorker *psWorker;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+
+   assert(pvWorker != NULL);
+
+   psWorker = (struct ShardWorker*)pvWorker;
+   for (i = psWorker->iThread; i < psWorker->iBindingCount;
+        i += psWorker->iThreadCount)
+   {
+      sprintf(acKey, "%d", i);
+      if (! psWorker->iRemove)
+         ASSURE(SymTable_put(psWorker->oSymTable, acKey,
+                             &psWorker->acValues[i]));
+      else if (i % 2 == 1)
+         ASSURE(SymTable_remove(psWorker->oSymTable, acKey)
+                == &psWorker->acValues[i]);
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run MAX_THREAD_COUNT ShardWorkers on oSymTable, which add the
+   iBindingCount keys bound to acValues if iRemove is zero, and remove
+   the odd ones otherwise. */
+
+static void runShardWorkers(SymTable_T oSymTable, char *acValues,
+                            int iBindingCount, int iRemove)
+{
+   struct ShardWorker asWorkers[MAX_THREAD_COUNT];
+   pthread_t asThreads[MAX_THREAD_COUNT];
+   int i;
+
+   for (i = 0; i < MAX_THREAD_COUNT; i++)
+   {
+      asWorkers[i].oSymTable = oSymTable;
+      asWorkers[i].acValues = acValues;
+      asWorkers[i].iBindingCount = iBindingCount;
+      asWorkers[i].iThread = i;
+      asWorkers[i].iThreadCount = MAX_THREAD_COUNT;
+      asWorkers[i].iRemove = iRemove;
+      if (pthread_create(&asThreads[i], NULL, runShardWorker,
+                         &asWorkers[i]) != 0)
+      {
+         fprintf(stderr, "Cannot create thread\n");
+         exit(EXIT_FAILURE);
+      }
+   }
+   for (i = 0; i < MAX_THREAD_COUNT; i++)
+      pthread_join(asThreads[i], NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newSharded() with iBindingCount bindings that several
+   threads add and remove at once. */
+
+static void testSharded(int iBindingCount)
+{
+   struct SymTableIter sIter;
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char *acValues;
+   const char *apcKeys[2];
+   void *apvValues[2];
+   int iShards;
+   int iVisits;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_newSharded().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   acValues = (char*)calloc((size_t)iBindingCount + 1, 1);
+   ASSURE(acValues != NULL);
+
+   for (iShards = 0; iShards < SHARD_COUNT_COUNT; iShards++)
+   {
+      memset(acValues, 0, (size_t)iBindingCount);
+      oSymTable = SymTable_newSharded(auShardCounts[iShards]);
+      ASSURE(oSymTable != NULL);
+      ASSURE(SymTable_reserve(oSymTable, (size_t)iBindingCount));
+
+      runShardWorkers(oSymTable, acValues, iBindingCount, 0);
+      ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+      for (i = 0; i < iBindingCount; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_get(oSymTable, acKey) == &acValues[i]);
+      }
+
+      /* The map and the iterator each visit every binding once. */
+      SymTable_map(oSymTable, countVisit, NULL);
+      iVisits = 0;
+      SymTable_iterBegin(oSymTable, &sIter);
+      while (SymTable_iterNext(&sIter))
+      {
+         ASSURE(SymTable_get(oSymTable, SymTable_iterKey(&sIter))
+                == SymTable_iterValue(&sIter));
+         countVisit(SymTable_iterKey(&sIter),
+                    SymTable_iterValue(&sIter), NULL);
+         iVisits++;
+      }
+      ASSURE(iVisits == iBindingCount);
+      SymTable_mapParallel(oSymTable, countVisit, NULL, MAX_THREAD_COUNT);
+      for (i = 0; i < iBindingCount; i++)
+         ASSURE(acValues[i] == 3);
+
+      /* A map's function may use the shard that the map holds. */
+      SymTable_map(oSymTable, lookUpNested, oSymTable);
+
+      runShardWorkers(oSymTable, acValues, iBindingCount, 1);
+      SymTable_shrink(oSymTable);
+      ASSURE(SymTable_getLength(oSymTable)
+             == (size_t)(iBindingCount + 1) / 2);
+
+      /* A batch may span shards. */
+      apcKeys[0] = "0";
+      apcKeys[1] = "1";
+      apvValues[0] = NULL;
+      apvValues[1] = &acValues[0];
+      SymTable_getBatch(oSymTable, apcKeys, 2, apvValues);
+      ASSURE(apvValues[0] == (iBindingCount > 0 ? &acValues[0] : NULL));
+      ASSURE(apvValues[1] == NULL);
+
+      SymTable_free(oSymTable);
+   }
+
+   free(acValues);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store in *puLength the length of the value pvValue, a char, and
+   return its address, so that a snapshot holds the char itself. */
+
+static const void *serializeChar(const void *pvValue, size_t *puLength)
+{
+   assert(pvValue != NULL && puLength != NULL);
+
+   *puLength = 1;
+   return pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that oSymTable, opened from a snapshot, binds the decimal
+   digits of each i less than iBindingCount to a copy of acValues[i],
+   and nothing else, and that every function that would change it
+   fails. */
+
+static void checkMapped(SymTable_T oSymTable, int iBindingCount,
+                        const char *acValues)
+{
+   struct SymTableIter sIter;
+   char acKey[MAX_KEY_LENGTH];
+   const char *apcKeys[2];
+   void *apvValues[2];
+   const char *pcValue;
+   size_t uVisits;
+   int i;
+
+   assert(oSymTable != NULL);
+   assert(acValues != NULL || iBindingCount == 0);
+
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (const char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue != NULL && *pcValue == acValues[i]);
+   }
+   ASSURE(SymTable_get(oSymTable, "-1") == NULL);
+   sprintf(acKey, "%d", iBindingCount);
+   ASSURE(SymTable_get(oSymTable, acKey) == NULL);
+
+   ASSURE(! SymTable_put(oSymTable, acKey, acValues));
+   ASSURE(SymTable_remove(oSymTable, "0") == NULL);
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+
+   apcKeys[0] = acKey;
+   apcKeys[1] = "0";
+   SymTable_getBatch(oSymTable, apcKeys, 2, apvValues);
+   ASSURE(apvValues[0] == NULL);
+   ASSURE(apvValues[1] == SymTable_get(oSymTable, "0"));
+
+   uVisits = 0;
+   SymTable_map(oSymTable, countBinding, &uVisits);
+   ASSURE(uVisits == (size_t)iBindingCount);
+   uVisits = 0;
+   SymTable_iterBegin(oSymTable, &sIter);
+   while (SymTable_iterNext(&sIter))
+   {
+      ASSURE(SymTable_get(oSymTable, SymTable_iterKey(&sIter))
+             == SymTable_iterValue(&sIter));
+      uVisits++;
+   }
+   ASSURE(uVisits == (size_t)iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_save() and SymTable_openMapped() on tables of up to
+   iBindingCount bindings, using a temporary file in the current
+   directory. */
+
+static void testSnapshot(int iBindingCount)
+{
+   static const char acPath[] = "testsymtableext.tmp";
+   SymTable_T oSymTable;
+   SymTable_T oMapped;
+   char acKey[MAX_KEY_LENGTH];
+   char *acValues;
+   FILE *psFile;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_save() and SymTable_openMapped().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   acValues = (char*)calloc((size_t)iBindingCount + 1, 1);
+   ASSURE(acValues != NULL);
+   for (i = 0; i < iBindingCount; i++)
+      acValues[i] = (char)(i % 127 + 1);
+
+   /* A table keeps its bindings when saved, and saves the same whether
+      or not it is frozen. */
+   oSymTable = newTable(iBindingCount, acValues, 1);
+   ASSURE(SymTable_save(oSymTable, acPath, serializeChar));
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+   ASSURE(SymTable_put(oSymTable, "-1", acValues));
+   ASSURE(SymTable_remove(oSymTable, "-1") == acValues);
+   oMapped = SymTable_openMapped(acPath);
+   ASSURE(oMapped != NULL);
+   if (oMapped != NULL)
+   {
+      checkMapped(oMapped, iBindingCount, acValues);
+      SymTable_free(oMapped);
+   }
+
+   ASSURE(SymTable_freeze(oSymTable));
+   ASSURE(SymTable_save(oSymTable, acPath, serializeChar));
+   SymTable_free(oSymTable);
+   oMapped = SymTable_openMapped(acPath);
+   ASSURE(oMapped != NULL);
+   if (oMapped != NULL)
+   {
+      /* A mapped table saves again. */
+      checkMapped(oMapped, iBindingCount, acValues);
+      ASSURE(SymTable_save(oMapped, acPath, serializeChar));
+      SymTable_free(oMapped);
+   }
+   oMapped = SymTable_openMapped(acPath);
+   ASSURE(oMapped != NULL);
+   if (oMapped != NULL)
+   {
+      checkMapped(oMapped, iBindingCount, acValues);
+      SymTable_free(oMapped);
+   }
+
+   oSymTable = newTable(0, NULL, 0);
+   ASSURE(SymTable_save(oSymTable, acPath, serializeChar));
+   SymTable_free(oSymTable);
+   oMapped = SymTable_openMapped(acPath);
+   ASSURE(oMapped != NULL);
+   if (oMapped != NULL)
+   {
+      checkMapped(oMapped, 0, acValues);
+      SymTable_free(oMapped);
+   }
+
+   /* Missing, empty and foreign files do not open, and a sharded table
+      does not save. */
+   ASSURE(remove(acPath) == 0);
+   ASSURE(SymTable_openMapped(acPath) == NULL);
+   psFile = fopen(acPath, "wb");
+   ASSURE(psFile != NULL);
+   if (psFile != NULL)
+      ASSURE(fclose(psFile) == 0);
+   ASSURE(SymTable_openMapped(acPath) == NULL);
+   psFile = fopen(acPath, "wb");
+   ASSURE(psFile != NULL);
+   if (psFile != NULL)
+   {
+      for (i = 0; i < 1000; i++)
+      {
+         sprintf(acKey, "%d", i);
+         fputs(acKey, psFile);
+      }
+      ASSURE(fclose(psFile) == 0);
+   }
+   ASSURE(SymTable_openMapped(acPath) == NULL);
+   ASSURE(remove(acPath) == 0);
+
+   oSymTable = SymTable_newSharded(4);
+   ASSURE(oSymTable != NULL);
+   ASSURE(! SymTable_save(oSymTable, acPath, serializeChar));
+   SymTable_free(oSymTable);
+   ASSURE(SymTable_openMapped(acPath) == NULL);
+
+   free(acValues);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that lookups in a table opened from a snapshot whose slots are
+   corrupt miss rather than read outside the mapping.  The test knows
+   the layout of a snapshot: an eight-byte magic, then size_ts of which
+   the fifth through ninth are the number of groups and the offsets of
+   the displacements, keys, values and slots, and each slot is a key
+   offset followed by a value offset. */
+
+static void testCorruptSnapshot(void)
+{
+   enum {BINDING_COUNT = 4};
+   enum {CORRUPTION_COUNT = 3};
+   enum {GROUPS_FIELD = 4, DISPLACEMENTS_FIELD = 5, SLOTS_FIELD = 8};
+
+   static const char acPath[] = "testsymtableext.tmp";
+   static char acValues[BINDING_COUNT];
+   const size_t uHuge = (size_t)-1 / 4;
+   const char *apcKeys[BINDING_COUNT];
+   void *apvValues[BINDING_COUNT];
+   char aacKeys[BINDING_COUNT][MAX_KEY_LENGTH];
+   size_t auHeader[SLOTS_FIELD + 1];
+   SymTable_T oSymTable;
+   char *pcSaved;
+   char *pcFile;
+   size_t uFileSize;
+   size_t uField;
+   size_t u;
+   FILE *psFile;
+   int iCorruption;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing lookups in corrupt snapshots.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = newTable(BINDING_COUNT, acValues, 0);
+   ASSURE(SymTable_save(oSymTable, acPath, serializeChar));
+   SymTable_free(oSymTable);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(aacKeys[i], "%d", i);
+      apcKeys[i] = aacKeys[i];
+   }
+
+   psFile = fopen(acPath, "rb");
+   ASSURE(psFile != NULL);
+   if (psFile == NULL)
+      return;
+   ASSURE(fseek(psFile, 0L, SEEK_END) == 0);
+   uFileSize = (size_t)ftell(psFile);
+   rewind(psFile);
+   pcSaved = (char*)malloc(uFileSize);
+   pcFile = (char*)malloc(uFileSize);
+   ASSURE(pcSaved != NULL && pcFile != NULL);
+   if (pcSaved == NULL || pcFile == NULL)
+      exit(EXIT_FAILURE);
+   ASSURE(fread(pcSaved, 1, uFileSize, psFile) == uFileSize);
+   ASSURE(fclose(psFile) == 0);
+   memcpy(auHeader, pcSaved + 8, sizeof(auHeader));
+
+   for (iCorruption = 0; iCorruption < CORRUPTION_COUNT; iCorruption++)
+   {
+      /* Point every group at a slot beyond the last, every key
+         offset beyond the pool of keys, or every value offset beyond
+         the pool of values. */
+      memcpy(pcFile, pcSaved, uFileSize);
+      if (iCorruption == 0)
+         for (u = 0; u < auHeader[GROUPS_FIELD]; u++)
+         {
+            uField = ((size_t)-1 >> 1) + 1 + uHuge;
+            memcpy(pcFile + auHeader[DISPLACEMENTS_FIELD]
+                   + u * sizeof(size_t), &uField, sizeof(size_t));
+         }
+      else
+         for (u = 0; u < BINDING_COUNT; u++)
+         {
+            uField = uHuge + 2 * u;
+            memcpy(pcFile + auHeader[SLOTS_FIELD]
+                   + (2 * u + (size_t)(iCorruption - 1))
+                   * sizeof(size_t), &uField, sizeof(size_t));
+         }
+
+      psFile = fopen(acPath, "wb");
+      ASSURE(psFile != NULL);
+      if (psFile == NULL)
+         break;
+      ASSURE(fwrite(pcFile, 1, uFileSize, psFile) == uFileSize);
+      ASSURE(fclose(psFile) == 0);
+
+      oSymTable = SymTable_openMapped(acPath);
+      ASSURE(oSymTable != NULL);
+      if (oSymTable == NULL)
+         continue;
+      for (i = 0; i < BINDING_COUNT; i++)
+         ASSURE(SymTable_get(oSymTable, apcKeys[i]) == NULL);
+      SymTable_getBatch(oSymTable, apcKeys, BINDING_COUNT, apvValues);
+      for (i = 0; i < BINDING_COUNT; i++)
+         ASSURE(apvValues[i] == NULL);
+      SymTable_free(oSymTable);
+   }
+
+   ASSURE(remove(acPath) == 0);
+   free(pcFile);
+   free(pcSaved);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the extensions that symtablehash.h declares.  As always, argc
+   is the command-line argument count and argv contains the
+   command-line arguments.  argv[1] is the number of bindings of the
+   large tables.  Exit with EXIT_FAILURE if argv[1] is missing or
+   negative.  Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testMapParallel(iBindingCount);
+   testReduceParallel(iBindingCount);
+   testSharded(iBindingCount);
+   testFreeze(iBindingCount);
+   testSnapshot(iBindingCount);
+   testCorruptSnapshot();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,316 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableordered.c                                              */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#include "symtableordered.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* The longest key of a test, including the terminating '\0'. */
+enum {MAX_KEY_LENGTH = 40};
+
+/*--------------------------------------------------------------------*/
+
+/* A Visits records the bindings that a map visits. */
+
+struct Visits
+{
+   /* The number of bindings visited. */
+   size_t uCount;
+
+   /* The key of the last binding visited, or NULL before the first. */
+   const char *pcLastKey;
+
+   /* 1 (TRUE) if every key visited followed the one before it in
+      ascending order, or 0 (FALSE) if not. */
+   int iOrdered;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Initialize *psVisits to record no visits. */
+
+static void beginVisits(struct Visits *psVisits)
+{
+   assert(psVisits != NULL);
+
+   psVisits->uCount = 0;
+   psVisits->pcLastKey = NULL;
+   psVisits->iOrdered = 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Record in pvVisits, a Visits, a visit to the binding whose key is
+   pcKey.  The key of each binding is also its value, so check that
+   pvValue equals pcKey. */
+
+static void recordVisit(const char *pcKey, void *pvValue, void *pvVisits)
+{
+   struct Visits *psVisits;
+
+   assert(pcKey != NULL && pvVisits != NULL);
+
+   psVisits = (struct Visits*)pvVisits;
+   ASSURE(strcmp(pcKey, (const char*)pvValue) == 0);
+   if (psVisits->pcLastKey != NULL &&
+       strcmp(psVisits->pcLastKey, pcKey) >= 0)
+      psVisits->iOrdered = 0;
+   psVisits->pcLastKey = pcKey;
+   psVisits->uCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of the iKeyCount keys of apcKeys that are at least
+   pcLow and less than pcHigh, either of which may be NULL to leave
+   that end of the range open. */
+
+static size_t countRange(char **apcKeys, int iKeyCount, const char *pcLow,
+                         const char *pcHigh)
+{
+   size_t uCount = 0;
+   int i;
+
+   assert(apcKeys != NULL);
+
+   for (i = 0; i < iKeyCount; i++)
+      if (apcKeys[i] != NULL &&
+          (pcLow == NULL || strcmp(apcKeys[i], pcLow) >= 0) &&
+          (pcHigh == NULL || strcmp(apcKeys[i], pcHigh) < 0))
+         uCount++;
+   return uCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of the iKeyCount keys of apcKeys that begin with
+   pcPrefix. */
+
+static size_t countPrefix(char **apcKeys, int iKeyCount,
+                          const char *pcPrefix)
+{
+   size_t uCount = 0;
+   size_t uLength;
+   int i;
+
+   assert(apcKeys != NULL && pcPrefix != NULL);
+
+   uLength = strlen(pcPrefix);
+   for (i = 0; i < iKeyCount; i++)
+      if (apcKeys[i] != NULL &&
+          strncmp(apcKeys[i], pcPrefix, uLength) == 0)
+         uCount++;
+   return uCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that oSymTable binds to itself exactly each of the iKeyCount
+   keys of apcKeys that is not NULL, and that its map, its iterator and
+   its range and prefix queries visit those keys in ascending order. */
+
+static void checkTable(SymTable_T oSymTable, char **apcKeys,
+                       int iKeyCount)
+{
+   static const char *apcBounds[][2] = {
+      {NULL, NULL}, {"1", "2"}, {"5", NULL}, {NULL, "3"}, {"42", "43"},
+      {"9", "1"}, {"", "0"}, {"123", "123"}, {"9", "\xc3"},
+      {"pkg.mod.Class.m2", "pkg.mod.Class.m3"}, {"pkg.mod", "pkg.n"}};
+   enum {BOUND_COUNT = sizeof(apcBounds) / sizeof(apcBounds[0])};
+   static const char *apcPrefixes[] = {
+      "", "1", "12", "99", "100", "7x", "\xc3", "pkg.mod.Class.m",
+      "pkg.mod.Class.m1", "pkg.mod.Class.m12", "pkg.mod.Klass"};
+   enum {PREFIX_COUNT = sizeof(apcPrefixes) / sizeof(apcPrefixes[0])};
+
+   struct SymTableIter sIter;
+   struct Visits sVisits;
+   size_t uLength;
+   int i;
+
+   assert(oSymTable != NULL && apcKeys != NULL);
+
+   uLength = countRange(apcKeys, iKeyCount, NULL, NULL);
+   ASSURE(SymTable_getLength(oSymTable) == uLength);
+   for (i = 0; i < iKeyCount; i++)
+      if (apcKeys[i] != NULL)
+         ASSURE(SymTable_get(oSymTable, apcKeys[i]) == apcKeys[i]);
+
+   beginVisits(&sVisits);
+   SymTable_map(oSymTable, recordVisit, &sVisits);
+   ASSURE(sVisits.uCount == uLength);
+   ASSURE(sVisits.iOrdered);
+
+   beginVisits(&sVisits);
+   SymTable_iterBegin(oSymTable, &sIter);
+   while (SymTable_iterNext(&sIter))
+      recordVisit(SymTable_iterKey(&sIter), SymTable_iterValue(&sIter),
+                  &sVisits);
+   ASSURE(sVisits.uCount == uLength);
+   ASSURE(sVisits.iOrdered);
+
+   for (i = 0; i < BOUND_COUNT; i++)
+   {
+      beginVisits(&sVisits);
+      SymTable_mapRange(oSymTable, apcBounds[i][0], apcBounds[i][1],
+                        recordVisit, &sVisits);
+      ASSURE(sVisits.uCount == countRange(apcKeys, iKeyCount,
+                                          apcBounds[i][0],
+                                          apcBounds[i][1]));
+      ASSURE(sVisits.iOrdered);
+   }
+
+   for (i = 0; i < PREFIX_COUNT; i++)
+   {
+      beginVisits(&sVisits);
+      SymTable_mapPrefix(oSymTable, apcPrefixes[i], recordVisit,
+                         &sVisits);
+      ASSURE(sVisits.uCount == countPrefix(apcKeys, iKeyCount,
+                                           apcPrefixes[i]));
+      ASSURE(sVisits.iOrdered);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the ordered queries on a SymTable object whose keys are the
+   decimal digits of each i less than iBindingCount, some of them
+   followed by a byte above 127 that must order after every digit and
+   some of them preceded by a long shared path, as the bindings are
+   added and then removed in an order unrelated to theirs. */
+
+static void testOrdered(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char **apcKeys;
+   char **apcBound;
+   char acKey[MAX_KEY_LENGTH];
+   int iSuccessful;
+   int iStep;
+   int i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_mapRange() and SymTable_mapPrefix().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   apcKeys = (char**)malloc(((size_t)iBindingCount + 1) * sizeof(char*));
+   apcBound = (char**)calloc((size_t)iBindingCount + 1, sizeof(char*));
+   if (apcKeys == NULL || apcBound == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      if (i % 5 == 1)
+         sprintf(acKey, "pkg.mod.Class.m%d", i);
+      else
+         sprintf(acKey, i % 7 == 3 ? "%d\xc3" : "%d", i);
+      apcKeys[i] = (char*)malloc(strlen(acKey) + 1);
+      if (apcKeys[i] == NULL)
+      {
+         fprintf(stderr, "Insufficient memory\n");
+         exit(EXIT_FAILURE);
+      }
+      strcpy(apcKeys[i], acKey);
+   }
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   checkTable(oSymTable, apcBound, iBindingCount);
+
+   /* Add the keys in a prime stride, which visits each once unless it
+      divides their number, so that the tree grows at every position. */
+   iStep = iBindingCount % 7919 == 0 ? 1 : 7919;
+
+   for (i = 0, j = 0; i < iBindingCount; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, apcKeys[j], apcKeys[j]);
+      ASSURE(iSuccessful);
+      apcBound[j] = apcKeys[j];
+      j = (j + iStep) % iBindingCount;
+   }
+   checkTable(oSymTable, apcBound, iBindingCount);
+
+   /* Remove every other binding, then the rest. */
+   for (i = 0; i < iBindingCount; i += 2)
+   {
+      ASSURE(SymTable_remove(oSymTable, apcKeys[i]) == apcKeys[i]);
+      apcBound[i] = NULL;
+   }
+   checkTable(oSymTable, apcBound, iBindingCount);
+   for (i = iBindingCount - 1; i >= 0; i--)
+   {
+      if (apcBound[i] != NULL)
+         ASSURE(SymTable_remove(oSymTable, apcKeys[i]) == apcKeys[i]);
+      apcBound[i] = NULL;
+   }
+   checkTable(oSymTable, apcBound, iBindingCount);
+
+   SymTable_free(oSymTable);
+   for (i = 0; i < iBindingCount; i++)
+      free(apcKeys[i]);
+   free(apcBound);
+   free(apcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the extensions that symtableordered.h declares.  As always,
+   argc is the command-line argument count and argv contains the
+   command-line arguments.  argv[1] is the number of bindings of the
+   large tables.  Exit with EXIT_FAILURE if argv[1] is missing or
+   negative.  Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testOrdered(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,473 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablethreads.c                                              */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+/* Tests of a SymTable implementation that many threads may use at
+   once.  Building with FLAGS=-fsanitize=thread also checks the runs
+   for data races. */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* The number of threads of each test. */
+enum {THREAD_COUNT = 8};
+
+/* The longest key of a test, including the terminating '\0'. */
+enum {MAX_KEY_LENGTH = 12};
+
+/* The number of operations between the resizes that a thread
+   forces. */
+enum {RESIZE_INTERVAL = 256};
+
+/* The number of times that each writer of a test of concurrent
+   readers adds and removes all of its keys. */
+enum {CHURN_ROUND_COUNT = 3};
+
+/*--------------------------------------------------------------------*/
+
+/* The phases of a test of concurrent writers.  Each thread adds all of
+   its keys, then removes its odd keys, then removes the rest. */
+
+enum Phase {PHASE_ADD, PHASE_REMOVE_ODD, PHASE_REMOVE_EVEN};
+
+/*--------------------------------------------------------------------*/
+
+/* A Writer describes the share of one thread in a phase of a test of
+   concurrent writers. */
+
+struct Writer
+{
+   /* The table. */
+   SymTable_T oSymTable;
+
+   /* The values, one per key. */
+   char *acValues;
+
+   /* The number of keys. */
+   int iBindingCount;
+
+   /* The index of the thread, which owns every key i with
+      i % iThreadCount == iThread. */
+   int iThread;
+
+   /* The number of writer threads. */
+   int iThreadCount;
+
+   /* The phase. */
+   enum Phase ePhase;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A ReaderState is shared by the readers of a test of concurrent
+   readers and the thread that tells them to stop. */
+
+struct ReaderState
+{
+   /* The table. */
+   SymTable_T oSymTable;
+
+   /* The values, one per key. */
+   char *acValues;
+
+   /* The number of keys. */
+   int iBindingCount;
+
+   /* The lock that guards iStopping. */
+   pthread_mutex_t sMutex;
+
+   /* 1 (TRUE) once the readers must stop. */
+   int iStopping;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that oSymTable binds the decimal digits of each i less than
+   iBindingCount to &acValues[i] if i is odd and iOdd is nonzero, or if
+   i is even and iEven is nonzero, and binds nothing else. */
+
+static void checkTable(SymTable_T oSymTable, char *acValues,
+                       int iBindingCount, int iEven, int iOdd)
+{
+   char acKey[MAX_KEY_LENGTH];
+   size_t uLength = 0;
+   int iBound;
+   int i;
+
+   assert(oSymTable != NULL && acValues != NULL);
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iBound = i % 2 == 0 ? iEven : iOdd;
+      ASSURE(SymTable_get(oSymTable, acKey)
+             == (iBound ? &acValues[i] : NULL));
+      ASSURE(SymTable_contains(oSymTable, acKey) == iBound);
+      if (iBound)
+         uLength++;
+   }
+   ASSURE(SymTable_getLength(oSymTable) == uLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Force oSymTable to resize: grow it if iGrow is nonzero, or shrink it
+   to fit its bindings otherwise. */
+
+static void forceResize(SymTable_T oSymTable, int iGrow)
+{
+   assert(oSymTable != NULL);
+
+   if (iGrow)
+      ASSURE(SymTable_reserve(oSymTable,
+                              SymTable_getLength(oSymTable) * 4 + 64));
+   else
+      SymTable_shrink(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run phase ePhase of psWriter on its keys, checking each key as it
+   changes and resizing the table now and then. */
+
+static void writeKeys(struct Writer *psWriter, enum Phase ePhase)
+{
+   char acKey[MAX_KEY_LENGTH];
+   void *pvValue;
+   int iOperations = 0;
+   int i;
+
+   assert(psWriter != NULL);
+
+   for (i = psWriter->iThread; i < psWriter->iBindingCount;
+        i += psWriter->iThreadCount)
+   {
+      sprintf(acKey, "%d", i);
+      pvValue = &psWriter->acValues[i];
+      switch (ePhase)
+      {
+         case PHASE_ADD:
+            ASSURE(SymTable_put(psWriter->oSymTable, acKey, pvValue));
+            ASSURE(! SymTable_put(psWriter->oSymTable, acKey, NULL));
+            ASSURE(SymTable_get(psWriter->oSymTable, acKey) == pvValue);
+            break;
+         case PHASE_REMOVE_ODD:
+            if (i % 2 == 0)
+               continue;
+            ASSURE(SymTable_remove(psWriter->oSymTable, acKey)
+                   == pvValue);
+            ASSURE(! SymTable_contains(psWriter->oSymTable, acKey));
+            break;
+         case PHASE_REMOVE_EVEN:
+            if (i % 2 == 1)
+               continue;
+            ASSURE(SymTable_remove(psWriter->oSymTable, acKey)
+                   == pvValue);
+            ASSURE(SymTable_get(psWriter->oSymTable, acKey) == NULL);
+            break;
+      }
+
+      /* Half the threads grow the table and half shrink it, so
+         resizes of both kinds overlap the other threads' writes. */
+      if (++iOperations % RESIZE_INTERVAL == 0)
+         forceResize(psWriter->oSymTable, psWriter->iThread % 2 == 0);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run the phase of pvWriter, a Writer.  Return NULL. */
+
+static void *runWriter(void *pvWriter)
+{
+   struct Writer *psWriter;
+
+   assert(pvWriter != NULL);
+
+   psWriter = (struct Writer*)pvWriter;
+   writeKeys(psWriter, psWriter->ePhase);
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add and remove all the keys of pvWriter, a Writer,
+   CHURN_ROUND_COUNT times, then add them again and remove the odd
+   ones.  Return NULL. */
+
+static void *runChurningWriter(void *pvWriter)
+{
+   struct Writer *psWriter;
+   int iRound;
+
+   assert(pvWriter != NULL);
+
+   psWriter = (struct Writer*)pvWriter;
+   for (iRound = 0; iRound < CHURN_ROUND_COUNT; iRound++)
+   {
+      writeKeys(psWriter, PHASE_ADD);
+      writeKeys(psWriter, PHASE_REMOVE_ODD);
+      writeKeys(psWriter, PHASE_REMOVE_EVEN);
+   }
+   writeKeys(psWriter, PHASE_ADD);
+   writeKeys(psWriter, PHASE_REMOVE_ODD);
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if the readers of psState must stop, or 0 (FALSE)
+   if not. */
+
+static int isStopping(struct ReaderState *psState)
+{
+   int iStopping;
+
+   assert(psState != NULL);
+
+   pthread_mutex_lock(&psState->sMutex);
+   iStopping = psState->iStopping;
+   pthread_mutex_unlock(&psState->sMutex);
+   return iStopping;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look up every key of pvState, a ReaderState, over and over until
+   its readers must stop, checking that each lookup finds either the
+   key's own value or nothing.  Return NULL. */
+
+static void *runReader(void *pvState)
+{
+   struct ReaderState *psState;
+   char acKey[MAX_KEY_LENGTH];
+   void *pvValue;
+   int iContains;
+   int i;
+
+   assert(pvState != NULL);
+
+   psState = (struct ReaderState*)pvState;
+   do
+   {
+      for (i = 0; i < psState->iBindingCount; i++)
+      {
+         sprintf(acKey, "%d", i);
+         pvValue = SymTable_get(psState->oSymTable, acKey);
+         ASSURE(pvValue == NULL || pvValue == &psState->acValues[i]);
+         iContains = SymTable_contains(psState->oSymTable, acKey);
+         ASSURE(iContains == 0 || iContains == 1);
+      }
+      ASSURE(SymTable_get(psState->oSymTable, "-1") == NULL);
+   } while (! isStopping(psState));
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run THREAD_COUNT Writers of phase ePhase on oSymTable, whose keys
+   are the decimal digits of each i less than iBindingCount, bound to
+   &acValues[i], and wait for them to finish. */
+
+static void runWriters(SymTable_T oSymTable, char *acValues,
+                       int iBindingCount, enum Phase ePhase)
+{
+   struct Writer asWriters[THREAD_COUNT];
+   pthread_t asThreads[THREAD_COUNT];
+   int i;
+
+   assert(oSymTable != NULL && acValues != NULL);
+
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      asWriters[i].oSymTable = oSymTable;
+      asWriters[i].acValues = acValues;
+      asWriters[i].iBindingCount = iBindingCount;
+      asWriters[i].iThread = i;
+      asWriters[i].iThreadCount = THREAD_COUNT;
+      asWriters[i].ePhase = ePhase;
+      if (pthread_create(&asThreads[i], NULL, runWriter,
+                         &asWriters[i]) != 0)
+      {
+         fprintf(stderr, "Cannot create thread\n");
+         exit(EXIT_FAILURE);
+      }
+   }
+   for (i = 0; i < THREAD_COUNT; i++)
+      pthread_join(asThreads[i], NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test iBindingCount bindings that THREAD_COUNT threads add, look up
+   and remove at once, while the table grows and shrinks under
+   them. */
+
+static void testWriters(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char *acValues;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing concurrent SymTable_put() and SymTable_remove().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   acValues = (char*)calloc((size_t)iBindingCount + 1, 1);
+   oSymTable = SymTable_new();
+   if (acValues == NULL || oSymTable == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   runWriters(oSymTable, acValues, iBindingCount, PHASE_ADD);
+   checkTable(oSymTable, acValues, iBindingCount, 1, 1);
+   runWriters(oSymTable, acValues, iBindingCount, PHASE_REMOVE_ODD);
+   checkTable(oSymTable, acValues, iBindingCount, 1, 0);
+   runWriters(oSymTable, acValues, iBindingCount, PHASE_REMOVE_EVEN);
+   checkTable(oSymTable, acValues, iBindingCount, 0, 0);
+
+   /* The emptied table still works. */
+   SymTable_shrink(oSymTable);
+   runWriters(oSymTable, acValues, iBindingCount, PHASE_ADD);
+   checkTable(oSymTable, acValues, iBindingCount, 1, 1);
+
+   SymTable_free(oSymTable);
+   free(acValues);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test iBindingCount bindings that half of THREAD_COUNT threads add
+   and remove over and over, forcing resizes as they go, while the
+   other half look them up. */
+
+static void testReaders(int iBindingCount)
+{
+   enum {WRITER_COUNT = THREAD_COUNT / 2};
+   enum {READER_COUNT = THREAD_COUNT - WRITER_COUNT};
+
+   struct ReaderState sState;
+   struct Writer asWriters[WRITER_COUNT];
+   pthread_t asWriterThreads[WRITER_COUNT];
+   pthread_t asReaderThreads[READER_COUNT];
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_get() during concurrent writes.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   sState.acValues = (char*)calloc((size_t)iBindingCount + 1, 1);
+   sState.oSymTable = SymTable_new();
+   if (sState.acValues == NULL || sState.oSymTable == NULL)
+   {
+      fprintf(stderr, "Insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   sState.iBindingCount = iBindingCount;
+   pthread_mutex_init(&sState.sMutex, NULL);
+   sState.iStopping = 0;
+
+   for (i = 0; i < READER_COUNT; i++)
+      if (pthread_create(&asReaderThreads[i], NULL, runReader,
+                         &sState) != 0)
+      {
+         fprintf(stderr, "Cannot create thread\n");
+         exit(EXIT_FAILURE);
+      }
+   for (i = 0; i < WRITER_COUNT; i++)
+   {
+      asWriters[i].oSymTable = sState.oSymTable;
+      asWriters[i].acValues = sState.acValues;
+      asWriters[i].iBindingCount = iBindingCount;
+      asWriters[i].iThread = i;
+      asWriters[i].iThreadCount = WRITER_COUNT;
+      asWriters[i].ePhase = PHASE_ADD;
+      if (pthread_create(&asWriterThreads[i], NULL, runChurningWriter,
+                         &asWriters[i]) != 0)
+      {
+         fprintf(stderr, "Cannot create thread\n");
+         exit(EXIT_FAILURE);
+      }
+   }
+
+   for (i = 0; i < WRITER_COUNT; i++)
+      pthread_join(asWriterThreads[i], NULL);
+   pthread_mutex_lock(&sState.sMutex);
+   sState.iStopping = 1;
+   pthread_mutex_unlock(&sState.sMutex);
+   for (i = 0; i < READER_COUNT; i++)
+      pthread_join(asReaderThreads[i], NULL);
+
+   checkTable(sState.oSymTable, sState.acValues, iBindingCount, 1, 0);
+
+   pthread_mutex_destroy(&sState.sMutex);
+   SymTable_free(sState.oSymTable);
+   free(sState.acValues);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a SymTable implementation that many threads may use at once.
+   As always, argc is the command-line argument count and argv
+   contains the command-line arguments.  argv[1] is the number of
+   bindings.  Exit with EXIT_FAILURE if argv[1] is missing or
+   negative.  Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testWriters(iBindingCount);
+   testReaders(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
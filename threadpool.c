@@ -0,0 +1,390 @@
+/*--------------------------------------------------------------------*/
+/* threadpool.c                                                       */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "threadpool.h"
+
+#if ! defined(__GNUC__)
+#error "threadpool.c needs __thread"
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* The pool that ThreadPool_getShared returns, and the lock that guards
+   its creation. */
+static ThreadPool_T oSharedPool = NULL;
+static pthread_mutex_t sSharedMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* 1 (TRUE) while the calling thread runs tasks of a job of any pool,
+   or 0 (FALSE) otherwise. */
+static __thread int iRunningTasks = 0;
+
+/*--------------------------------------------------------------------*/
+
+/* Each worker has a ThreadPoolWorker that holds the range of tasks it
+   has yet to run.  The worker takes tasks from the front of its range;
+   other workers steal from the back. */
+
+struct ThreadPoolWorker
+{
+   /* The lock that guards uNext and uEnd. */
+   pthread_mutex_t sMutex;
+
+   /* The next task of the range. */
+   size_t uNext;
+
+   /* One past the last task of the range. */
+   size_t uEnd;
+
+   /* The pool of the worker. */
+   struct ThreadPool *psPool;
+
+   /* The index of the worker within its pool. */
+   int iIndex;
+
+   /* The thread of the worker.  Worker 0 is the caller of
+      ThreadPool_run and has no thread of its own. */
+   pthread_t sThread;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A ThreadPool is an array of workers together with the job that they
+   are running. */
+
+struct ThreadPool
+{
+   /* The lock that lets one job at a time use the pool. */
+   pthread_mutex_t sRunMutex;
+
+   /* The lock that guards the job fields below. */
+   pthread_mutex_t sMutex;
+
+   /* Signaled when a job starts or the pool stops. */
+   pthread_cond_t sStart;
+
+   /* Signaled when the last thread of a job finishes. */
+   pthread_cond_t sDone;
+
+   /* The workers. */
+   struct ThreadPoolWorker *psWorkers;
+
+   /* The number of workers. */
+   int iWorkerCount;
+
+   /* The number of jobs started so far, which tells a thread that
+      wakes up whether a new job has begun. */
+   size_t uJobCount;
+
+   /* The number of workers that take part in the current job. */
+   int iJobWorkerCount;
+
+   /* The number of threads of the current job that have not
+      finished. */
+   int iBusyCount;
+
+   /* The task function of the current job. */
+   void (*pfTask)(size_t uTask, int iWorker, void *pvExtra);
+
+   /* The extra parameter of the current job. */
+   const void *pvExtra;
+
+   /* 1 (TRUE) once the threads must exit. */
+   int iStopping;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Move the back half of the remaining tasks of some other worker of
+   psWorker's pool to psWorker, whose own range is empty.  Return 1
+   (TRUE) if successful, or 0 (FALSE) if no worker of the current job
+   has tasks left.  At most one lock is held at a time. */
+
+static int ThreadPool_steal(struct ThreadPoolWorker *psWorker)
+{
+   struct ThreadPool *psPool;
+   struct ThreadPoolWorker *psVictim;
+   size_t uBegin;
+   size_t uEnd;
+   int i;
+
+   assert(psWorker != NULL);
+
+   psPool = psWorker->psPool;
+   for (i = 1; i < psPool->iJobWorkerCount; i++)
+   {
+      psVictim = &psPool->psWorkers[(psWorker->iIndex + i)
+                                    % psPool->iJobWorkerCount];
+      pthread_mutex_lock(&psVictim->sMutex);
+      uEnd = psVictim->uEnd;
+      uBegin = uEnd - (uEnd - psVictim->uNext + 1) / 2;
+      psVictim->uEnd = uBegin;
+      pthread_mutex_unlock(&psVictim->sMutex);
+
+      if (uBegin < uEnd)
+      {
+         pthread_mutex_lock(&psWorker->sMutex);
+         psWorker->uNext = uBegin;
+         psWorker->uEnd = uEnd;
+         pthread_mutex_unlock(&psWorker->sMutex);
+         return 1;
+      }
+   }
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run tasks of the current job as psWorker until no worker has any
+   left. */
+
+static void ThreadPool_work(struct ThreadPoolWorker *psWorker)
+{
+   struct ThreadPool *psPool;
+   size_t uTask = 0;
+   int iFound;
+
+   assert(psWorker != NULL);
+
+   psPool = psWorker->psPool;
+   iRunningTasks = 1;
+   for (;;)
+   {
+      pthread_mutex_lock(&psWorker->sMutex);
+      iFound = psWorker->uNext < psWorker->uEnd;
+      if (iFound)
+         uTask = psWorker->uNext++;
+      pthread_mutex_unlock(&psWorker->sMutex);
+
+      if (iFound)
+         (*psPool->pfTask)(uTask, psWorker->iIndex,
+                           (void*)psPool->pvExtra);
+      else if (! ThreadPool_steal(psWorker))
+         break;
+   }
+   iRunningTasks = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run each job of the pool of pvWorker, a ThreadPoolWorker, in which
+   the worker takes part, until the pool stops.  Return NULL. */
+
+static void *ThreadPool_main(void *pvWorker)
+{
+   struct ThreadPoolWorker *psWorker;
+   struct ThreadPool *psPool;
+   size_t uJobsSeen = 0;
+   int iTakesPart;
+
+   assert(pvWorker != NULL);
+
+   psWorker = (struct ThreadPoolWorker*)pvWorker;
+   psPool = psWorker->psPool;
+   pthread_mutex_lock(&psPool->sMutex);
+   for (;;)
+   {
+      while (! psPool->iStopping && psPool->uJobCount == uJobsSeen)
+         pthread_cond_wait(&psPool->sStart, &psPool->sMutex);
+      if (psPool->iStopping)
+         break;
+      uJobsSeen = psPool->uJobCount;
+      iTakesPart = psWorker->iIndex < psPool->iJobWorkerCount;
+      pthread_mutex_unlock(&psPool->sMutex);
+
+      if (iTakesPart)
+         ThreadPool_work(psWorker);
+
+      pthread_mutex_lock(&psPool->sMutex);
+      if (iTakesPart && --psPool->iBusyCount == 0)
+         pthread_cond_signal(&psPool->sDone);
+   }
+   pthread_mutex_unlock(&psPool->sMutex);
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Stop the first iThreadCount threads of oThreadPool, which have
+   started, and free oThreadPool. */
+
+static void ThreadPool_stop(ThreadPool_T oThreadPool, int iThreadCount)
+{
+   int i;
+
+   assert(oThreadPool != NULL);
+
+   pthread_mutex_lock(&oThreadPool->sMutex);
+   oThreadPool->iStopping = 1;
+   pthread_cond_broadcast(&oThreadPool->sStart);
+   pthread_mutex_unlock(&oThreadPool->sMutex);
+
+   for (i = 1; i <= iThreadCount; i++)
+      pthread_join(oThreadPool->psWorkers[i].sThread, NULL);
+
+   for (i = 0; i < oThreadPool->iWorkerCount; i++)
+      pthread_mutex_destroy(&oThreadPool->psWorkers[i].sMutex);
+   pthread_cond_destroy(&oThreadPool->sDone);
+   pthread_cond_destroy(&oThreadPool->sStart);
+   pthread_mutex_destroy(&oThreadPool->sMutex);
+   pthread_mutex_destroy(&oThreadPool->sRunMutex);
+   free(oThreadPool->psWorkers);
+   free(oThreadPool);
+}
+
+/*--------------------------------------------------------------------*/
+
+ThreadPool_T ThreadPool_new(int iWorkerCount)
+{
+   ThreadPool_T oThreadPool;
+   struct ThreadPoolWorker *psWorker;
+   int i;
+
+   assert(iWorkerCount > 0);
+
+   oThreadPool = (ThreadPool_T)malloc(sizeof(struct ThreadPool));
+   if (oThreadPool == NULL)
+      return NULL;
+
+   oThreadPool->psWorkers = (struct ThreadPoolWorker*)
+      calloc((size_t)iWorkerCount, sizeof(struct ThreadPoolWorker));
+   if (oThreadPool->psWorkers == NULL)
+   {
+      free(oThreadPool);
+      return NULL;
+   }
+
+   pthread_mutex_init(&oThreadPool->sRunMutex, NULL);
+   pthread_mutex_init(&oThreadPool->sMutex, NULL);
+   pthread_cond_init(&oThreadPool->sStart, NULL);
+   pthread_cond_init(&oThreadPool->sDone, NULL);
+   oThreadPool->iWorkerCount = iWorkerCount;
+   oThreadPool->uJobCount = 0;
+   oThreadPool->iJobWorkerCount = 0;
+   oThreadPool->iBusyCount = 0;
+   oThreadPool->pfTask = NULL;
+   oThreadPool->pvExtra = NULL;
+   oThreadPool->iStopping = 0;
+
+   for (i = 0; i < iWorkerCount; i++)
+   {
+      psWorker = &oThreadPool->psWorkers[i];
+      pthread_mutex_init(&psWorker->sMutex, NULL);
+      psWorker->psPool = oThreadPool;
+      psWorker->iIndex = i;
+   }
+
+   for (i = 1; i < iWorkerCount; i++)
+      if (pthread_create(&oThreadPool->psWorkers[i].sThread, NULL,
+                         ThreadPool_main, &oThreadPool->psWorkers[i]) != 0)
+      {
+         ThreadPool_stop(oThreadPool, i - 1);
+         return NULL;
+      }
+
+   return oThreadPool;
+}
+
+/*--------------------------------------------------------------------*/
+
+ThreadPool_T ThreadPool_getShared(int iWorkerCount)
+{
+   long lProcessorCount;
+
+   assert(iWorkerCount > 0);
+
+   pthread_mutex_lock(&sSharedMutex);
+   if (oSharedPool == NULL)
+   {
+      lProcessorCount = sysconf(_SC_NPROCESSORS_ONLN);
+      if (lProcessorCount > iWorkerCount && lProcessorCount < 1024)
+         iWorkerCount = (int)lProcessorCount;
+      oSharedPool = ThreadPool_new(iWorkerCount);
+   }
+   pthread_mutex_unlock(&sSharedMutex);
+   return oSharedPool;
+}
+
+/*--------------------------------------------------------------------*/
+
+void ThreadPool_free(ThreadPool_T oThreadPool)
+{
+   assert(oThreadPool != NULL);
+
+   ThreadPool_stop(oThreadPool, oThreadPool->iWorkerCount - 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+int ThreadPool_getWorkerCount(ThreadPool_T oThreadPool)
+{
+   assert(oThreadPool != NULL);
+
+   return oThreadPool->iWorkerCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+void ThreadPool_run(ThreadPool_T oThreadPool, size_t uTaskCount,
+                    int iWorkerCount,
+                    void (*pfTask)(size_t uTask, int iWorker,
+                                   void *pvExtra),
+                    const void *pvExtra)
+{
+   struct ThreadPoolWorker *psWorker;
+   size_t u;
+   int i;
+
+   assert(oThreadPool != NULL && pfTask != NULL);
+   assert(iWorkerCount > 0 && iWorkerCount <= oThreadPool->iWorkerCount);
+
+   /* A task that starts a job would wait for workers, perhaps itself,
+      that are busy with the job that runs it, so run the new job on
+      the calling thread alone. */
+   if (iRunningTasks)
+   {
+      for (u = 0; u < uTaskCount; u++)
+         (*pfTask)(u, 0, (void*)pvExtra);
+      return;
+   }
+
+   pthread_mutex_lock(&oThreadPool->sRunMutex);
+
+   /* Give each worker an equal share of the tasks.  No thread touches
+      the ranges between jobs. */
+   for (i = 0; i < iWorkerCount; i++)
+   {
+      psWorker = &oThreadPool->psWorkers[i];
+      psWorker->uNext = uTaskCount / (size_t)iWorkerCount * (size_t)i
+         + uTaskCount % (size_t)iWorkerCount * (size_t)i
+           / (size_t)iWorkerCount;
+      if (i > 0)
+         oThreadPool->psWorkers[i - 1].uEnd = psWorker->uNext;
+   }
+   oThreadPool->psWorkers[iWorkerCount - 1].uEnd = uTaskCount;
+
+   pthread_mutex_lock(&oThreadPool->sMutex);
+   oThreadPool->pfTask = pfTask;
+   oThreadPool->pvExtra = pvExtra;
+   oThreadPool->iJobWorkerCount = iWorkerCount;
+   oThreadPool->iBusyCount = iWorkerCount - 1;
+   oThreadPool->uJobCount++;
+   pthread_cond_broadcast(&oThreadPool->sStart);
+   pthread_mutex_unlock(&oThreadPool->sMutex);
+
+   ThreadPool_work(&oThreadPool->psWorkers[0]);
+
+   pthread_mutex_lock(&oThreadPool->sMutex);
+   while (oThreadPool->iBusyCount > 0)
+      pthread_cond_wait(&oThreadPool->sDone, &oThreadPool->sMutex);
+   pthread_mutex_unlock(&oThreadPool->sMutex);
+
+   pthread_mutex_unlock(&oThreadPool->sRunMutex);
+}
@@ -0,0 +1,72 @@
+/*--------------------------------------------------------------------*/
+/* threadpool.h                                                       */
+/* Author: Kok Wei Pua                                                */
+/*--------------------------------------------------------------------*/
+
+#ifndef THREADPOOL_INCLUDED
+#define THREADPOOL_INCLUDED
+#include <stddef.h>
+
+/*--------------------------------------------------------------------*/
+
+/* A ThreadPool_T is a set of worker threads that persist between
+jobs. A job is a numbered range of independent tasks. Each worker
+starts with an equal share of the range and, when it runs out, steals
+half of the tasks that remain to another worker, so the job stays
+balanced even when tasks take unequal times. */
+
+typedef struct ThreadPool *ThreadPool_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new ThreadPool object with iWorkerCount workers, or NULL if
+insufficient memory or threads are available. The calling thread of
+ThreadPool_run is one of the workers, so the pool starts
+iWorkerCount - 1 threads. iWorkerCount must be positive. */
+
+ThreadPool_T ThreadPool_new(int iWorkerCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the ThreadPool object that the whole program shares, creating
+it on the first call with iWorkerCount workers or one per online
+processor, whichever is more. Return NULL if it cannot be created.
+The shared pool is never freed, and its size never changes, so it may
+have fewer than iWorkerCount workers. iWorkerCount must be
+positive. */
+
+ThreadPool_T ThreadPool_getShared(int iWorkerCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Stop the threads of oThreadPool and free it. */
+
+void ThreadPool_free(ThreadPool_T oThreadPool);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of workers of oThreadPool. */
+
+int ThreadPool_getWorkerCount(ThreadPool_T oThreadPool);
+
+/*--------------------------------------------------------------------*/
+
+/* Call (*pfTask)(u, iWorker, pvExtra) once for each u less than
+uTaskCount, where iWorker is the index of the worker that runs the
+task, and return when every task has finished. Only the first
+iWorkerCount workers of oThreadPool take part, so iWorker is less than
+iWorkerCount, which must be positive and at most the pool's worker
+count. Tasks run concurrently, so *pfTask must be safe to call from
+several threads at once. A pool runs one job at a time; concurrent
+calls take turns. A call from within a task, of this pool or any
+other, runs every task on the calling thread as worker 0. */
+
+void ThreadPool_run(ThreadPool_T oThreadPool, size_t uTaskCount,
+                    int iWorkerCount,
+                    void (*pfTask)(size_t uTask, int iWorker,
+                                   void *pvExtra),
+                    const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+#endif